@@ -154,4 +154,32 @@ inline T* index_array(Dyn_Array<T> *array, u64 index) {
 #define CAP_TO_LEN_STATIC_ARRAY(array) \
     cap_to_len_static_array(&array);
 
+// Quicksort of array[start..end] (inclusive), 'before(a, b)' true if 'a' goes first. The middle element is the
+// pivot, so arrays which are mostly in order already, or have long runs of equal keys once ties are broken, do not
+// degrade the sort.
+template<typename T>
+void sort_array(T *array, int start, int end, bool (*before)(T a, T b)) {
+    if (start < end) {
+        T tmp = array[(start + end) / 2];
+        array[(start + end) / 2] = array[end];
+        array[end] = tmp;
+
+        int lower = start - 1;
+        for(int i = start; i < end; ++i) {
+            if (before(array[i], array[end])) {
+                lower++;
+                tmp = array[i];
+                array[i] = array[lower];
+                array[lower] = tmp;
+            }
+        }
+        lower++;
+        tmp = array[lower];
+        array[lower] = array[end];
+        array[end] = tmp;
+        sort_array(array, start, lower - 1, before);
+        sort_array(array, lower + 1, end, before);
+    }
+}
+
 #endif
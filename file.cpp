@@ -1,5 +1,14 @@
 #include "file.hpp"
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <windows.h>
+#endif
+
 const u8* file_read_bin_temp_large(const char *file_name, u64 size) {
     FILE *file = fopen(file_name, "rb");
     ASSERT(file, "Could Not Open File");
@@ -13,6 +22,34 @@ const u8* file_read_bin_temp_large(const char *file_name, u64 size) {
     return ret;
 }
 
+// Read [offset, offset + size) into memory from 'allocate'
+static const u8* file_read_bin_range(const char *file_name, u64 offset, u64 size,
+                                     u8* (*allocate)(u64 size, u64 alignment)) {
+    FILE *file = fopen(file_name, "rb");
+    if (!file) {
+        println("Failed to read file %c", file_name);
+        return NULL;
+    }
+    u8 *ret = allocate(size, 16);
+    fseek(file, offset, SEEK_SET);
+    size_t read = fread(ret, 1, size, file);
+
+    if (read != size) {
+        println("Failed to read file range, %c", file_name);
+        println("    Range Size: %u, Size Read: %u", size, (u64)read);
+    }
+    fclose(file);
+    return ret;
+}
+
+const u8* file_read_bin_temp_range(const char *file_name, u64 offset, u64 size) {
+    return file_read_bin_range(file_name, offset, size, memory_allocate_temp);
+}
+
+const u8* file_read_bin_heap_range(const char *file_name, u64 offset, u64 size) {
+    return file_read_bin_range(file_name, offset, size, memory_allocate_heap);
+}
+
 const u8* file_read_bin_temp(const char *file_name, u64 *size) {
     FILE *file = fopen(file_name, "rb");
 
@@ -180,3 +217,60 @@ const u8* file_read_char_temp_padded(const char *file_name, u64 *size, int pad_s
 
     return (u8*)contents;
 }
+
+#ifndef _WIN32
+u8* file_map_private(const char *file_name, u64 *size) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    *size = info.st_size;
+
+    void *ret = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping holds its own reference to the file
+
+    if (ret == MAP_FAILED) {
+        println("Failed to map file %c", file_name);
+        return NULL;
+    }
+    return (u8*)ret;
+}
+void file_unmap(void *ptr, u64 size) {
+    munmap(ptr, size);
+}
+#else
+u8* file_map_private(const char *file_name, u64 *size) {
+    HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    *size = file_size.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        println("Failed to map file %c", file_name);
+        return NULL;
+    }
+
+    void *ret = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping); // the view holds its own reference to the mapping
+
+    if (!ret)
+        println("Failed to map file %c", file_name);
+    return (u8*)ret;
+}
+void file_unmap(void *ptr, u64 size) {
+    UnmapViewOfFile(ptr);
+}
+#endif
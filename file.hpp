@@ -5,6 +5,9 @@
 
 
 const u8* file_read_bin_temp_large(const char *file_name, u64 size);
+// Read 'size' bytes from 'offset'
+const u8* file_read_bin_temp_range(const char *file_name, u64 offset, u64 size);
+const u8* file_read_bin_heap_range(const char *file_name, u64 offset, u64 size);
 const u8* file_read_bin_temp(const char *file_name, u64 *size);
 const u8* file_read_bin_heap(const char *file_name, u64 *size);
 const u8* file_read_char_temp(const char *file_name, u64 *size);
@@ -12,4 +15,9 @@ const u8* file_read_char_heap(const char *file_name, u64 *size);
 const u8* file_read_char_heap_padded(const char *file_name, u64 *size, int pad_size);
 const u8* file_read_char_temp_padded(const char *file_name, u64 *size, int pad_size);
 
+// Map a file copy-on-write: the mapping is writable, but writes stay private to the process and never
+// reach the file. Returns NULL on failure.
+u8* file_map_private(const char *file_name, u64 *size);
+void file_unmap(void *ptr, u64 size);
+
 #endif // include guard
@@ -3,6 +3,9 @@
 #include "simd.hpp"
 #include "builtin_wrappers.h"
 #include "math.hpp"
+#include "external/wyhash.h"
+
+#include <stddef.h> // offsetof
 
 #if TEST
     #include "test.hpp"
@@ -48,6 +51,38 @@ Gltf_Skin* gltf_parse_skins(const char *data, u64 *offset, int *skin_count);
 Gltf_Texture* gltf_parse_textures(const char *data, u64 *offset, int *texture_count);
 
 /* **Implementation start** */
+
+//
+// Where parsed records go. This is the temp allocator (which also holds the json) other than during
+// parse_gltf_streamed, which points it at the caller's arena; the json never lives there at all.
+//
+static Linear_Allocator *gltf_arena = get_instance_temp();
+
+static inline u8* gltf_allocate(u64 size, u64 alignment) {
+    u8 *ret = linear_allocator_allocate(gltf_arena, size, alignment);
+    ASSERT(gltf_arena->used <= gltf_arena->capacity, "Gltf Arena Overflow");
+    return ret;
+}
+static inline u64 gltf_get_mark() {
+    return gltf_arena->used;
+}
+
+struct Gltf_Section_Counts {
+    int accessor_count;
+    int animation_count;
+    int buffer_count;
+    int buffer_view_count;
+    int camera_count;
+    int image_count;
+    int material_count;
+    int mesh_count;
+    int node_count;
+    int sampler_count;
+    int scene_count;
+    int skin_count;
+    int texture_count;
+};
+static void gltf_build_offsets(Gltf *gltf, Gltf_Section_Counts *counts);
 static inline int gltf_match_int(char c) {
     switch(c) {
     case '0':
@@ -104,6 +139,150 @@ inline u64 gltf_ascii_to_u64(const char *data, u64 *offset) {
     return accum;
 }
 
+//
+// Key dispatch:
+//     Each object type's key set is hashed into a small table at compile time: a seed is searched for
+//     which sends every key in the set to its own slot. Matching a key in the file is then one '"' search
+//     for its length, one multiply, and one compare against the only key that could be in that slot,
+//     rather than walking a chain of simd_strcmp_short until something hits.
+//
+//     The hash is over the key's length and its first 8 bytes. If two keys in a set cannot be separated
+//     by these, building the table calls gltf_key_table_no_perfect_hash(), which is not constexpr, so it
+//     fails at compile time.
+//
+constexpr int GLTF_MAX_KEY_LEN = 32;
+
+// at least twice as many slots as keys, rounded to a power of 2
+constexpr int gltf_key_table_slot_bits(int key_count) {
+    int bits = 2;
+    while((1 << bits) < key_count * 2)
+        bits++;
+    return bits;
+}
+
+template<int key_count>
+struct Gltf_Key_Table {
+    static constexpr int slot_bits  = gltf_key_table_slot_bits(key_count);
+    static constexpr int slot_count = 1 << slot_bits;
+
+    u64  seed;
+    s8   slots[slot_count];  // index into keys, -1 if empty
+    u8   lens[key_count];
+    char keys[key_count][GLTF_MAX_KEY_LEN];
+};
+
+inline void gltf_key_table_no_perfect_hash() {}
+
+constexpr u64 gltf_key_prefix(const char *key, u64 len) {
+    u64 ret = 0;
+    for(u64 i = 0; i < 8 && i < len; ++i)
+        ret |= (u64)(u8)key[i] << (i * 8);
+    return ret;
+}
+constexpr u32 gltf_key_hash(u64 prefix, u64 len, u64 seed, int slot_bits) {
+    return (u32)(((prefix + len) * seed) >> (64 - slot_bits));
+}
+
+template<int key_count>
+constexpr Gltf_Key_Table<key_count> gltf_make_key_table(const char *const (&keys)[key_count]) {
+    using Table = Gltf_Key_Table<key_count>;
+    Table ret = {};
+
+    u64 prefixes[key_count] = {};
+    for(int i = 0; i < key_count; ++i) {
+        int len = 0;
+        while(keys[i][len]) {
+            ret.keys[i][len] = keys[i][len];
+            len++;
+        }
+        if (len >= GLTF_MAX_KEY_LEN)
+            gltf_key_table_no_perfect_hash();
+        for(int j = len; j < GLTF_MAX_KEY_LEN; ++j)
+            ret.keys[i][j] = 'x';
+
+        ret.lens[i]  = (u8)len;
+        prefixes[i] = gltf_key_prefix(keys[i], len);
+    }
+
+    u64 seed = 0x9e3779b97f4a7c15;
+    for(int attempt = 0; attempt < 4096; ++attempt) {
+        bool collision = false;
+        for(int i = 0; i < Table::slot_count; ++i)
+            ret.slots[i] = -1;
+
+        for(int i = 0; i < key_count; ++i) {
+            u32 slot = gltf_key_hash(prefixes[i], ret.lens[i], seed, Table::slot_bits);
+            if (ret.slots[slot] != -1) {
+                collision = true;
+                break;
+            }
+            ret.slots[slot] = (s8)i;
+        }
+        if (!collision) {
+            ret.seed = seed;
+            return ret;
+        }
+        seed = (seed * 6364136223846793005 + 1442695040888963407) | 1;
+    }
+
+    gltf_key_table_no_perfect_hash();
+    return ret;
+}
+
+//
+// 'data' points to the first char of a key (beyond its opening '"'). Returns the key's index in the
+// table's key list, or -1 if it is not in the set.
+//
+template<int key_count>
+static inline int gltf_match_key(const char *data, const Gltf_Key_Table<key_count> *table) {
+    u32 len;
+    u16 mask = simd_match_char(data, '"');
+    if (mask) {
+        len = count_trailing_zeros_u16(mask);
+    } else {
+        mask = simd_match_char(data + 16, '"');
+        if (!mask)
+            return -1;
+        len = 16 + count_trailing_zeros_u16(mask);
+    }
+
+    u64 prefix;
+    memcpy(&prefix, data, 8);
+    if (len < 8)
+        prefix &= ((u64)1 << (len * 8)) - 1;
+
+    int key = table->slots[gltf_key_hash(prefix, len, table->seed, table->slot_bits)];
+    if (key == -1 || table->lens[key] != len)
+        return -1;
+
+    if (len <= 16)
+        return simd_strcmp_short(data, table->keys[key], 16 - len) == 0 ? key : -1;
+    else
+        return simd_strcmp_long(data, table->keys[key], 32 - len) == 0 ? key : -1;
+}
+
+enum Gltf_Key {
+    GLTF_KEY_ACCESSORS,
+    GLTF_KEY_ANIMATIONS,
+    GLTF_KEY_BUFFERS,
+    GLTF_KEY_BUFFER_VIEWS,
+    GLTF_KEY_CAMERAS,
+    GLTF_KEY_IMAGES,
+    GLTF_KEY_MATERIALS,
+    GLTF_KEY_MESHES,
+    GLTF_KEY_NODES,
+    GLTF_KEY_SAMPLERS,
+    GLTF_KEY_SCENES,
+    GLTF_KEY_SKINS,
+    GLTF_KEY_TEXTURES,
+    GLTF_KEY_ASSET,
+    GLTF_KEY_SCENE,
+};
+static constexpr auto GLTF_KEYS = gltf_make_key_table({
+    "accessors", "animations", "buffers", "bufferViews", "cameras", "images", "materials",
+    "meshes", "nodes", "samplers", "scenes", "skins", "textures", "asset", "scene",
+});
+
 Gltf parse_gltf(const char *filename) {
     //
     // Function Method:
@@ -115,76 +294,87 @@ Gltf parse_gltf(const char *filename) {
     //
     u64 size;
     const char *data = (const char*)file_read_char_temp_padded(filename, &size, 16);
-    Gltf gltf;
+    Gltf gltf = {};
     char buf[16];
     u64 offset = 0;
 
-    int accessor_count = 0;
-    int animation_count = 0;
-    int buffer_count = 0;
-    int buffer_view_count = 0;
-    int camera_count = 0;
-    int image_count = 0;
-    int material_count = 0;
-    int mesh_count = 0;
-    int node_count = 0;
-    int sampler_count = 0;
-    int scene_count = 0;
-    int skin_count = 0;
-    int texture_count = 0;
+    gltf_arena = get_instance_temp();
+    Gltf_Section_Counts counts = {};
 
     while (simd_find_char_interrupted(data + offset, '"', '}', &offset)) {
         offset++; // step into key
-        if (simd_strcmp_short(data + offset, "accessorsxxxxxxx", 7) == 0) {
-            gltf.accessors = gltf_parse_accessors(data + offset, &offset, &accessor_count);
+        switch(gltf_match_key(data + offset, &GLTF_KEYS)) {
+        case GLTF_KEY_ACCESSORS:
+            gltf.accessors = gltf_parse_accessors(data + offset, &offset, &counts.accessor_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "animationsxxxxxx", 6) == 0) {
-            gltf.animations = gltf_parse_animations(data + offset, &offset, &animation_count);
+        case GLTF_KEY_ANIMATIONS:
+            gltf.animations = gltf_parse_animations(data + offset, &offset, &counts.animation_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "buffersxxxxxxxxx", 9) == 0) {
-            gltf.buffers = gltf_parse_buffers(data + offset, &offset, &buffer_count);
+        case GLTF_KEY_BUFFERS:
+            gltf.buffers = gltf_parse_buffers(data + offset, &offset, &counts.buffer_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "bufferViewsxxxxx", 5) == 0) {
-            gltf.buffer_views = gltf_parse_buffer_views(data + offset, &offset, &buffer_view_count);
+        case GLTF_KEY_BUFFER_VIEWS:
+            gltf.buffer_views = gltf_parse_buffer_views(data + offset, &offset, &counts.buffer_view_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "camerasxxxxxxxxx", 9) == 0) {
-            gltf.cameras = gltf_parse_cameras(data + offset, &offset, &camera_count);
+        case GLTF_KEY_CAMERAS:
+            gltf.cameras = gltf_parse_cameras(data + offset, &offset, &counts.camera_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "imagesxxxxxxxxxx", 10) == 0) {
-            gltf.images = gltf_parse_images(data + offset, &offset, &image_count);
+        case GLTF_KEY_IMAGES:
+            gltf.images = gltf_parse_images(data + offset, &offset, &counts.image_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "materialsxxxxxxx", 7) == 0) {
-            gltf.materials = gltf_parse_materials(data + offset, &offset, &material_count);
+        case GLTF_KEY_MATERIALS:
+            gltf.materials = gltf_parse_materials(data + offset, &offset, &counts.material_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "meshesxxxxxxxxxx", 10) == 0) {
-            gltf.meshes = gltf_parse_meshes(data + offset, &offset, &mesh_count);
+        case GLTF_KEY_MESHES:
+            gltf.meshes = gltf_parse_meshes(data + offset, &offset, &counts.mesh_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "nodesxxxxxxxxxxx", 11) == 0) {
-            gltf.nodes = gltf_parse_nodes(data + offset, &offset, &node_count);
+        case GLTF_KEY_NODES:
+            gltf.nodes = gltf_parse_nodes(data + offset, &offset, &counts.node_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "samplersxxxxxxxx", 8) == 0) {
-            gltf.samplers = gltf_parse_samplers(data + offset, &offset, &sampler_count);
+        case GLTF_KEY_SAMPLERS:
+            gltf.samplers = gltf_parse_samplers(data + offset, &offset, &counts.sampler_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "scenesxxxxxxxxxx", 10) == 0) {
-            gltf.scenes = gltf_parse_scenes(data + offset, &offset, &scene_count);
+        case GLTF_KEY_SCENES:
+            gltf.scenes = gltf_parse_scenes(data + offset, &offset, &counts.scene_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "skinsxxxxxxxxxxx", 11) == 0) {
-            gltf.skins = gltf_parse_skins(data + offset, &offset, &skin_count);
+        case GLTF_KEY_SKINS:
+            gltf.skins = gltf_parse_skins(data + offset, &offset, &counts.skin_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "texturesxxxxxxxx", 8) == 0) {
-            gltf.textures = gltf_parse_textures(data + offset, &offset, &texture_count);
+        case GLTF_KEY_TEXTURES:
+            gltf.textures = gltf_parse_textures(data + offset, &offset, &counts.texture_count);
             continue;
-        } else if (simd_strcmp_short(data + offset, "assetxxxxxxxxxxx", 11) == 0) {
+        case GLTF_KEY_ASSET:
             simd_skip_passed_char(data + offset, &offset, '}');
             continue;
-        } else if (simd_strcmp_short(data + offset, "scenexxxxxxxxxxx", 11) == 0) {
+        case GLTF_KEY_SCENE:
             gltf.scene = gltf_ascii_to_int(data + offset, &offset);
             continue;
-        } else {
+        default:
             ASSERT(false, "This is not a top level gltf key");
         }
     }
 
+    gltf_build_offsets(&gltf, &counts);
+
+    return gltf;
+}
+
+// Fill the Gltf.X_count arrays: the count at [-1], and the byte offset of each record from [0]
+static void gltf_build_offsets(Gltf *gltf, Gltf_Section_Counts *counts) {
+    int accessor_count = counts->accessor_count;
+    int animation_count = counts->animation_count;
+    int buffer_count = counts->buffer_count;
+    int buffer_view_count = counts->buffer_view_count;
+    int camera_count = counts->camera_count;
+    int image_count = counts->image_count;
+    int material_count = counts->material_count;
+    int mesh_count = counts->mesh_count;
+    int node_count = counts->node_count;
+    int sampler_count = counts->sampler_count;
+    int scene_count = counts->scene_count;
+    int skin_count = counts->skin_count;
+    int texture_count = counts->texture_count;
+
     //
     // OMFG!! I practically have to rewrite this thing!!! One day maybe I will idk...
     // This is sort of hack, sort of not, depending how you look at it (COPIUS-MAXIMUS!?)
@@ -193,156 +383,156 @@ Gltf parse_gltf(const char *filename) {
     //
     int total_stride = 0;
 
-    gltf.accessor_count = (int*)memory_allocate_temp(sizeof(int) * accessor_count + 1, 4);
-    gltf.accessor_count[0] = accessor_count;
-    gltf.accessor_count++;
-    Gltf_Accessor *accessor = gltf.accessors;
+    gltf->accessor_count = (int*)gltf_allocate(sizeof(int) * accessor_count + 1, 4);
+    gltf->accessor_count[0] = accessor_count;
+    gltf->accessor_count++;
+    Gltf_Accessor *accessor = gltf->accessors;
     for(int i = 0; i < accessor_count; ++i) {
-        gltf.accessor_count[i] = total_stride;
+        gltf->accessor_count[i] = total_stride;
         total_stride += accessor->stride;
         accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
     }
 
     total_stride = 0;
 
-    gltf.animation_count = (int*)memory_allocate_temp(sizeof(int) * animation_count + 1, 4);
-    gltf.animation_count[0] = animation_count;
-    gltf.animation_count++;
-    Gltf_Animation *animation = gltf.animations;
+    gltf->animation_count = (int*)gltf_allocate(sizeof(int) * animation_count + 1, 4);
+    gltf->animation_count[0] = animation_count;
+    gltf->animation_count++;
+    Gltf_Animation *animation = gltf->animations;
     for(int i = 0; i < animation_count; ++i) {
-        gltf.animation_count[i] = total_stride;
+        gltf->animation_count[i] = total_stride;
         total_stride += animation->stride;
         animation = (Gltf_Animation*)((u8*)animation + animation->stride);
     }
 
     total_stride = 0;
 
-    gltf.buffer_count = (int*)memory_allocate_temp(sizeof(int) * buffer_count + 1, 4);
-    gltf.buffer_count[0] = buffer_count;
-    gltf.buffer_count++;
-    Gltf_Buffer *buffer = gltf.buffers;
+    gltf->buffer_count = (int*)gltf_allocate(sizeof(int) * buffer_count + 1, 4);
+    gltf->buffer_count[0] = buffer_count;
+    gltf->buffer_count++;
+    Gltf_Buffer *buffer = gltf->buffers;
     for(int i = 0; i < buffer_count; ++i) {
-        gltf.buffer_count[i] = total_stride;
+        gltf->buffer_count[i] = total_stride;
         total_stride += buffer->stride;
         buffer = (Gltf_Buffer*)((u8*)buffer + buffer->stride);
     }
 
     total_stride = 0;
 
-    gltf.buffer_view_count = (int*)memory_allocate_temp(sizeof(int) * buffer_view_count + 1, 4);
-    gltf.buffer_view_count[0] = buffer_view_count;
-    gltf.buffer_view_count++;
-    Gltf_Buffer_View *buffer_view = gltf.buffer_views;
+    gltf->buffer_view_count = (int*)gltf_allocate(sizeof(int) * buffer_view_count + 1, 4);
+    gltf->buffer_view_count[0] = buffer_view_count;
+    gltf->buffer_view_count++;
+    Gltf_Buffer_View *buffer_view = gltf->buffer_views;
     for(int i = 0; i < buffer_view_count; ++i) {
-        gltf.buffer_view_count[i] = total_stride;
+        gltf->buffer_view_count[i] = total_stride;
         total_stride += buffer_view->stride;
         buffer_view = (Gltf_Buffer_View*)((u8*)buffer_view + buffer_view->stride);
     }
 
     total_stride = 0;
 
-    gltf.camera_count = (int*)memory_allocate_temp(sizeof(int) * camera_count + 1, 4);
-    gltf.camera_count[0] = camera_count;
-    gltf.camera_count++;
-    Gltf_Camera *camera = gltf.cameras;
+    gltf->camera_count = (int*)gltf_allocate(sizeof(int) * camera_count + 1, 4);
+    gltf->camera_count[0] = camera_count;
+    gltf->camera_count++;
+    Gltf_Camera *camera = gltf->cameras;
     for(int i = 0; i < camera_count; ++i) {
-        gltf.camera_count[i] = total_stride;
+        gltf->camera_count[i] = total_stride;
         total_stride += camera->stride;
         camera = (Gltf_Camera*)((u8*)camera + camera->stride);
     }
 
     total_stride = 0;
 
-    gltf.image_count = (int*)memory_allocate_temp(sizeof(int) * image_count + 1, 4);
-    gltf.image_count[0] = image_count;
-    gltf.image_count++;
-    Gltf_Image *image = gltf.images;
+    gltf->image_count = (int*)gltf_allocate(sizeof(int) * image_count + 1, 4);
+    gltf->image_count[0] = image_count;
+    gltf->image_count++;
+    Gltf_Image *image = gltf->images;
     for(int i = 0; i < image_count; ++i) {
-        gltf.image_count[i] = total_stride;
+        gltf->image_count[i] = total_stride;
         total_stride += image->stride;
         image = (Gltf_Image*)((u8*)image + image->stride);
     }
 
     total_stride = 0;
 
-    gltf.material_count = (int*)memory_allocate_temp(sizeof(int) * material_count + 1, 4);
-    gltf.material_count[0] = material_count;
-    gltf.material_count++;
-    Gltf_Material *material = gltf.materials;
+    gltf->material_count = (int*)gltf_allocate(sizeof(int) * material_count + 1, 4);
+    gltf->material_count[0] = material_count;
+    gltf->material_count++;
+    Gltf_Material *material = gltf->materials;
     for(int i = 0; i < material_count; ++i) {
-        gltf.material_count[i] = total_stride;
+        gltf->material_count[i] = total_stride;
         total_stride += material->stride;
         material = (Gltf_Material*)((u8*)material + material->stride);
     }
 
     total_stride = 0;
 
-    gltf.mesh_count = (int*)memory_allocate_temp(sizeof(int) * mesh_count + 1, 4);
-    gltf.mesh_count[0] = mesh_count;
-    gltf.mesh_count++;
-    Gltf_Mesh *mesh = gltf.meshes;
+    gltf->mesh_count = (int*)gltf_allocate(sizeof(int) * mesh_count + 1, 4);
+    gltf->mesh_count[0] = mesh_count;
+    gltf->mesh_count++;
+    Gltf_Mesh *mesh = gltf->meshes;
     for(int i = 0; i < mesh_count; ++i) {
-        gltf.mesh_count[i] = total_stride;
+        gltf->mesh_count[i] = total_stride;
         total_stride += mesh->stride;
         mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
     }
 
     total_stride = 0;
 
-    gltf.node_count = (int*)memory_allocate_temp(sizeof(int) * node_count + 1, 4);
-    gltf.node_count[0] = node_count;
-    gltf.node_count++;
-    Gltf_Node *node = gltf.nodes;
+    gltf->node_count = (int*)gltf_allocate(sizeof(int) * node_count + 1, 4);
+    gltf->node_count[0] = node_count;
+    gltf->node_count++;
+    Gltf_Node *node = gltf->nodes;
     for(int i = 0; i < node_count; ++i) {
-        gltf.node_count[i] = total_stride;
+        gltf->node_count[i] = total_stride;
         total_stride += node->stride;
         node = (Gltf_Node*)((u8*)node + node->stride);
     }
 
     total_stride = 0;
 
-    gltf.sampler_count = (int*)memory_allocate_temp(sizeof(int) * sampler_count + 1, 4);
-    gltf.sampler_count[0] = sampler_count;
-    gltf.sampler_count++;
-    Gltf_Sampler *sampler = gltf.samplers;
+    gltf->sampler_count = (int*)gltf_allocate(sizeof(int) * sampler_count + 1, 4);
+    gltf->sampler_count[0] = sampler_count;
+    gltf->sampler_count++;
+    Gltf_Sampler *sampler = gltf->samplers;
     for(int i = 0; i < sampler_count; ++i) {
-        gltf.sampler_count[i] = total_stride;
+        gltf->sampler_count[i] = total_stride;
         total_stride += sampler->stride;
         sampler = (Gltf_Sampler*)((u8*)sampler + sampler->stride);
     }
 
     total_stride = 0;
 
-    gltf.scene_count = (int*)memory_allocate_temp(sizeof(int) * scene_count + 1, 4);
-    gltf.scene_count[0] = scene_count;
-    gltf.scene_count++;
-    Gltf_Scene *scene = gltf.scenes;
+    gltf->scene_count = (int*)gltf_allocate(sizeof(int) * scene_count + 1, 4);
+    gltf->scene_count[0] = scene_count;
+    gltf->scene_count++;
+    Gltf_Scene *scene = gltf->scenes;
     for(int i = 0; i < scene_count; ++i) {
-        gltf.scene_count[i] = total_stride;
+        gltf->scene_count[i] = total_stride;
         total_stride += scene->stride;
         scene = (Gltf_Scene*)((u8*)scene + scene->stride);
     }
 
     total_stride = 0;
 
-    gltf.skin_count = (int*)memory_allocate_temp(sizeof(int) * skin_count + 1, 4);
-    gltf.skin_count[0] = skin_count;
-    gltf.skin_count++;
-    Gltf_Skin *skin = gltf.skins;
+    gltf->skin_count = (int*)gltf_allocate(sizeof(int) * skin_count + 1, 4);
+    gltf->skin_count[0] = skin_count;
+    gltf->skin_count++;
+    Gltf_Skin *skin = gltf->skins;
     for(int i = 0; i < skin_count; ++i) {
-        gltf.skin_count[i] = total_stride;
+        gltf->skin_count[i] = total_stride;
         total_stride += skin->stride;
         skin = (Gltf_Skin*)((u8*)skin + skin->stride);
     }
 
     total_stride = 0;
 
-    gltf.texture_count = (int*)memory_allocate_temp(sizeof(int) * texture_count + 1, 4);
-    gltf.texture_count[0] = texture_count;
-    gltf.texture_count++;
-    Gltf_Texture *texture = gltf.textures;
+    gltf->texture_count = (int*)gltf_allocate(sizeof(int) * texture_count + 1, 4);
+    gltf->texture_count[0] = texture_count;
+    gltf->texture_count++;
+    Gltf_Texture *texture = gltf->textures;
     for(int i = 0; i < texture_count; ++i) {
-        gltf.texture_count[i] = total_stride;
+        gltf->texture_count[i] = total_stride;
         total_stride += texture->stride;
         texture = (Gltf_Texture*)((u8*)texture + texture->stride);
     }
@@ -352,18 +542,448 @@ Gltf parse_gltf(const char *filename) {
     // @Note Idk what to do about stride here. I will wait and see if the validation
     // layers complain about stride being 0 later...
     //
-    accessor = gltf.accessors;
-    for(int i = 0; i < gltf.accessor_count[-1]; ++i) {
+    accessor = gltf->accessors;
+    for(int i = 0; i < gltf->accessor_count[-1]; ++i) {
+        if (accessor->buffer_view < 0) {
+            accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+            continue;
+        }
         buffer_view =
-            (Gltf_Buffer_View*)((u8*)gltf.buffer_views +
-                gltf.buffer_view_count[accessor->buffer_view]);
+            (Gltf_Buffer_View*)((u8*)gltf->buffer_views +
+                gltf->buffer_view_count[accessor->buffer_view]);
 
         if (buffer_view->byte_stride)
             accessor->byte_stride = buffer_view->byte_stride;
 
         accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
     }
+}
+
+// `Sparse
+//
+// The base data is copied in one go when it is already tightly packed, then the sparse indices are widened to
+// byte offsets eight at a time and the values are scattered over it. Element sizes of 4, 8, 12 and 16 cover
+// every float vertex attribute, so they get fixed size copies which compile to plain loads and stores.
+static inline void gltf_sparse_scatter(u8 *dst, const u8 *values, const u32 *offsets, int count, int element_size) {
+    switch(element_size) {
+    case 4:
+        for(int i = 0; i < count; ++i)
+            memcpy(dst + offsets[i], values + i * 4, 4);
+        break;
+    case 8:
+        for(int i = 0; i < count; ++i)
+            memcpy(dst + offsets[i], values + i * 8, 8);
+        break;
+    case 12:
+        for(int i = 0; i < count; ++i)
+            memcpy(dst + offsets[i], values + i * 12, 12);
+        break;
+    case 16:
+        for(int i = 0; i < count; ++i)
+            memcpy(dst + offsets[i], values + i * 16, 16);
+        break;
+    default:
+        for(int i = 0; i < count; ++i)
+            memcpy(dst + offsets[i], values + i * element_size, element_size);
+        break;
+    }
+}
+
+void gltf_resolve_sparse_accessor(Gltf *gltf, Gltf_Accessor *accessor, int element_size, const u8 *buffer, u8 *dst) {
+    Gltf_Buffer_View *view;
+    if (accessor->buffer_view < 0) {
+        memset(dst, 0, (u64)accessor->count * element_size);
+    } else {
+        view = (Gltf_Buffer_View*)((u8*)gltf->buffer_views + gltf->buffer_view_count[accessor->buffer_view]);
+        const u8 *base = buffer + view->byte_offset + accessor->byte_offset;
+
+        int base_stride = accessor->byte_stride ? accessor->byte_stride : element_size;
+        if (base_stride == element_size) {
+            memcpy(dst, base, (u64)accessor->count * element_size);
+        } else {
+            for(int i = 0; i < accessor->count; ++i)
+                memcpy(dst + (u64)i * element_size, base + (u64)i * base_stride, element_size);
+        }
+    }
+
+    if (accessor->sparse_count <= 0)
+        return;
+
+    view = (Gltf_Buffer_View*)((u8*)gltf->buffer_views + gltf->buffer_view_count[accessor->indices_buffer_view]);
+    const u8 *indices = buffer + view->byte_offset + accessor->indices_byte_offset;
+    view = (Gltf_Buffer_View*)((u8*)gltf->buffer_views + gltf->buffer_view_count[accessor->values_buffer_view]);
+    const u8 *values = buffer + view->byte_offset + accessor->values_byte_offset;
+
+    int index_size;
+    switch(accessor->indices_component_type) {
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        index_size = 1;
+        break;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+        index_size = 2;
+        break;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+        index_size = 4;
+        break;
+    default:
+        ASSERT(false, "Invalid sparse indices component type");
+        return;
+    }
+
+    __m256i size = _mm256_set1_epi32(element_size);
+    __m256i wide;
+    alignas(32) u32 offsets[8];
+
+    int i;
+    for(i = 0; i + 8 <= accessor->sparse_count; i += 8) {
+        const u8 *src = indices + i * index_size;
+        switch(index_size) {
+        case 1:
+            wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+            break;
+        case 2:
+            wide = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+            break;
+        default:
+            wide = _mm256_loadu_si256((const __m256i*)src);
+            break;
+        }
+        _mm256_store_si256((__m256i*)offsets, _mm256_mullo_epi32(wide, size));
+
+        for(int j = 0; j < 8; ++j)
+            ASSERT(offsets[j] < (u32)accessor->count * element_size, "Sparse index out of range");
+        gltf_sparse_scatter(dst, values + (u64)i * element_size, offsets, 8, element_size);
+    }
+    for(; i < accessor->sparse_count; ++i) {
+        u32 index;
+        switch(index_size) {
+        case 1:
+            index = indices[i];
+            break;
+        case 2:
+            index = ((const u16*)indices)[i];
+            break;
+        default:
+            index = ((const u32*)indices)[i];
+            break;
+        }
+        ASSERT(index < (u32)accessor->count, "Sparse index out of range");
+        offsets[0] = index * element_size;
+        gltf_sparse_scatter(dst, values + (u64)i * element_size, offsets, 1, element_size);
+    }
+}
+
+// `Streaming
+//
+// The json is read through a fixed size window rather than all at once. Only complete values are handed
+// to the parsers; whatever is cut off at the end of a window (a partial object, key or number) is moved to
+// the front and the window is refilled behind it. A batch of whole array elements is dressed up as a
+// complete array, by writing '[' over the byte before its first element and ']' over the byte after its
+// last, so the section parsers run unchanged. Their records land in the arena back to back across batches,
+// exactly as if the section had been parsed in one go.
+//
+static constexpr u64 GLTF_STREAM_PAD = 32; // simd loads read beyond the end (and can back up before the start)
+
+struct Gltf_Stream {
+    FILE *file;
+    u8   *memory;
+    char *data;
+    u64 capacity; // window size, not counting the padding either side
+    u64 len;      // bytes of json in the window
+    u64 pos;      // parse position in the window
+};
+
+static inline bool gltf_stream_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+//
+// Move everything from 'keep' onwards to the front of the window and read in behind it; 'pos' moves with
+// it. If nothing can be dropped (a single value is bigger than the window), the window doubles. Returns
+// false once the file is exhausted.
+//
+static bool gltf_stream_refill(Gltf_Stream *stream, u64 keep) {
+    u64 tail = stream->len - keep;
+    memmove(stream->data, stream->data + keep, tail);
+    stream->len  = tail;
+    stream->pos -= keep;
+
+    if (stream->len == stream->capacity) {
+        stream->capacity *= 2;
+        stream->memory = memory_reallocate_heap(stream->memory, stream->capacity + GLTF_STREAM_PAD * 2);
+        stream->data   = (char*)stream->memory + GLTF_STREAM_PAD;
+    }
+
+    u64 read = fread(stream->data + stream->len, 1, stream->capacity - stream->len, stream->file);
+    stream->len += read;
+    memset(stream->data + stream->len, 0, GLTF_STREAM_PAD);
+    return read > 0;
+}
+
+// Skip whitespace and separators, refilling as needed. Returns the next meaningful char, or 0 at the end.
+static char gltf_stream_skip(Gltf_Stream *stream) {
+    while(true) {
+        while(stream->pos < stream->len) {
+            char c = stream->data[stream->pos];
+            if (!gltf_stream_is_space(c) && c != ',' && c != ':')
+                return c;
+            stream->pos++;
+        }
+        if (!gltf_stream_refill(stream, stream->pos))
+            return 0;
+    }
+}
+
+//
+// Offset one beyond the end of the value at 'pos', or 0 if it does not end inside the window. Only
+// structure matters here (nesting and strings), the section parsers do the real work.
+//
+static u64 gltf_stream_value_end(const char *data, u64 pos, u64 len) {
+    int depth = 0;
+    bool in_string = false;
+    for(u64 i = pos; i < len; ++i) {
+        char c = data[i];
+        if (in_string) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                in_string = false;
+                if (!depth)
+                    return i + 1;
+            }
+            continue;
+        }
+        switch(c) {
+        case '"':
+            in_string = true;
+            break;
+        case '{':
+        case '[':
+            depth++;
+            break;
+        case '}':
+        case ']':
+            if (!depth)
+                return i; // scalar ended by its container
+            depth--;
+            if (!depth)
+                return i + 1;
+            break;
+        default:
+            if (!depth && (c == ',' || gltf_stream_is_space(c)))
+                return i; // scalar ended by a separator
+            break;
+        }
+    }
+    return 0;
+}
+
+// Make sure the whole value at 'pos' is in the window, and return its end
+static u64 gltf_stream_ensure_value(Gltf_Stream *stream) {
+    u64 end;
+    while(!(end = gltf_stream_value_end(stream->data, stream->pos, stream->len))) {
+        if (!gltf_stream_refill(stream, stream->pos)) {
+            ASSERT(false, "Truncated gltf json");
+            return stream->len;
+        }
+    }
+    return end;
+}
+
+static void* gltf_stream_parse_batch(int key, const char *data, int *count) {
+    u64 offset = 0;
+    switch(key) {
+    case GLTF_KEY_ACCESSORS:
+        return gltf_parse_accessors(data, &offset, count);
+    case GLTF_KEY_ANIMATIONS:
+        return gltf_parse_animations(data, &offset, count);
+    case GLTF_KEY_BUFFERS:
+        return gltf_parse_buffers(data, &offset, count);
+    case GLTF_KEY_BUFFER_VIEWS:
+        return gltf_parse_buffer_views(data, &offset, count);
+    case GLTF_KEY_CAMERAS:
+        return gltf_parse_cameras(data, &offset, count);
+    case GLTF_KEY_IMAGES:
+        return gltf_parse_images(data, &offset, count);
+    case GLTF_KEY_MATERIALS:
+        return gltf_parse_materials(data, &offset, count);
+    case GLTF_KEY_MESHES:
+        return gltf_parse_meshes(data, &offset, count);
+    case GLTF_KEY_NODES:
+        return gltf_parse_nodes(data, &offset, count);
+    case GLTF_KEY_SAMPLERS:
+        return gltf_parse_samplers(data, &offset, count);
+    case GLTF_KEY_SCENES:
+        return gltf_parse_scenes(data, &offset, count);
+    case GLTF_KEY_SKINS:
+        return gltf_parse_skins(data, &offset, count);
+    case GLTF_KEY_TEXTURES:
+        return gltf_parse_textures(data, &offset, count);
+    default:
+        ASSERT(false, "Not a gltf array section");
+        return NULL;
+    }
+}
+
+// Parse the top level array at 'pos' in batches of whole elements. Returns the first record.
+static void* gltf_stream_section(Gltf_Stream *stream, int key, int *section_count) {
+    ASSERT(gltf_stream_skip(stream) == '[', "Expected gltf array");
+
+    void *ret = NULL;
+    int count = 0;
+    int batch_count;
+    void *batch;
+
+    u64 open = stream->pos; // byte to write the batch's '[' over (already consumed)
+    stream->pos++;
+
+    u64 scan;
+    u64 end;
+    u64 batch_end;
+    char saved;
+    bool done = false;
+    while(!done) {
+        // gather as many complete elements as the window holds
+        batch_end = 0;
+        scan = stream->pos;
+        while(true) {
+            while(scan < stream->len && (gltf_stream_is_space(stream->data[scan]) || stream->data[scan] == ','))
+                scan++;
+            if (scan == stream->len)
+                break;
+            if (stream->data[scan] == ']') {
+                done = true;
+                break;
+            }
+            end = gltf_stream_value_end(stream->data, scan, stream->len);
+            if (!end)
+                break;
+            batch_end = end;
+            scan = end;
+        }
+
+        if (batch_end) {
+            saved = stream->data[batch_end];
+            stream->data[open]      = '[';
+            stream->data[batch_end] = ']';
+
+            batch = gltf_stream_parse_batch(key, stream->data + open, &batch_count);
+            if (!ret)
+                ret = batch;
+            count += batch_count;
+
+            stream->data[batch_end] = saved;
+            stream->pos = batch_end;
+            open = batch_end - 1; // the last element's closing brace
+        }
+
+        if (done) {
+            stream->pos = scan + 1;
+        } else if (!gltf_stream_refill(stream, open)) {
+            ASSERT(false, "Truncated gltf json");
+            break;
+        } else {
+            open = 0;
+        }
+    }
+    *section_count = count;
+    return ret;
+}
+
+Gltf parse_gltf_streamed(const char *file_name, Linear_Allocator *arena, u64 window_size) {
+    Gltf gltf = {};
+    Gltf_Section_Counts counts = {};
+    gltf_arena = arena;
+
+    Gltf_Stream stream = {};
+    stream.file = fopen(file_name, "rb");
+    if (!stream.file) {
+        println("FAILED TO READ FILE %c", file_name);
+        gltf_build_offsets(&gltf, &counts);
+        gltf_arena = get_instance_temp();
+        return gltf;
+    }
+
+    window_size     = align(window_size, 16);
+    stream.capacity = window_size;
+    stream.memory   = memory_allocate_heap(window_size + GLTF_STREAM_PAD * 2, 16);
+    stream.data     = (char*)stream.memory + GLTF_STREAM_PAD;
+    memset(stream.memory, 0, GLTF_STREAM_PAD);
+    gltf_stream_refill(&stream, 0);
+
+    ASSERT(gltf_stream_skip(&stream) == '{', "Gltf json must be an object");
+    stream.pos++;
+
+    int key;
+    u64 key_end;
+    u64 value_end;
+    while(gltf_stream_skip(&stream) == '"') {
+        // the whole key has to be in the window (key matching reads beyond it, but into the padding at worst)
+        key_end = gltf_stream_ensure_value(&stream);
+        key = gltf_match_key(stream.data + stream.pos + 1, &GLTF_KEYS);
+        stream.pos = key_end;
+        gltf_stream_skip(&stream);
+
+        switch(key) {
+        case GLTF_KEY_ACCESSORS:
+            gltf.accessors = (Gltf_Accessor*)gltf_stream_section(&stream, key, &counts.accessor_count);
+            continue;
+        case GLTF_KEY_ANIMATIONS:
+            gltf.animations = (Gltf_Animation*)gltf_stream_section(&stream, key, &counts.animation_count);
+            continue;
+        case GLTF_KEY_BUFFERS:
+            gltf.buffers = (Gltf_Buffer*)gltf_stream_section(&stream, key, &counts.buffer_count);
+            continue;
+        case GLTF_KEY_BUFFER_VIEWS:
+            gltf.buffer_views = (Gltf_Buffer_View*)gltf_stream_section(&stream, key, &counts.buffer_view_count);
+            continue;
+        case GLTF_KEY_CAMERAS:
+            gltf.cameras = (Gltf_Camera*)gltf_stream_section(&stream, key, &counts.camera_count);
+            continue;
+        case GLTF_KEY_IMAGES:
+            gltf.images = (Gltf_Image*)gltf_stream_section(&stream, key, &counts.image_count);
+            continue;
+        case GLTF_KEY_MATERIALS:
+            gltf.materials = (Gltf_Material*)gltf_stream_section(&stream, key, &counts.material_count);
+            continue;
+        case GLTF_KEY_MESHES:
+            gltf.meshes = (Gltf_Mesh*)gltf_stream_section(&stream, key, &counts.mesh_count);
+            continue;
+        case GLTF_KEY_NODES:
+            gltf.nodes = (Gltf_Node*)gltf_stream_section(&stream, key, &counts.node_count);
+            continue;
+        case GLTF_KEY_SAMPLERS:
+            gltf.samplers = (Gltf_Sampler*)gltf_stream_section(&stream, key, &counts.sampler_count);
+            continue;
+        case GLTF_KEY_SCENES:
+            gltf.scenes = (Gltf_Scene*)gltf_stream_section(&stream, key, &counts.scene_count);
+            continue;
+        case GLTF_KEY_SKINS:
+            gltf.skins = (Gltf_Skin*)gltf_stream_section(&stream, key, &counts.skin_count);
+            continue;
+        case GLTF_KEY_TEXTURES:
+            gltf.textures = (Gltf_Texture*)gltf_stream_section(&stream, key, &counts.texture_count);
+            continue;
+        case GLTF_KEY_SCENE:
+        {
+            value_end = gltf_stream_ensure_value(&stream);
+            u64 offset = 0;
+            gltf.scene = gltf_ascii_to_int(stream.data + stream.pos, &offset);
+            stream.pos = value_end;
+            continue;
+        }
+        default:
+            // "asset", and anything else parse_gltf would not understand either
+            stream.pos = gltf_stream_ensure_value(&stream);
+            continue;
+        }
+    }
+
+    memory_free_heap(stream.memory);
+    fclose(stream.file);
 
+    gltf_build_offsets(&gltf, &counts);
+    gltf_arena = get_instance_temp();
     return gltf;
 }
 
@@ -460,6 +1080,37 @@ inline Mat4 gltf_ascii_to_mat4(const char *data, u64 *offset) {
 
 
 // `Accessors
+enum Gltf_Accessor_Key {
+    GLTF_ACCESSOR_KEY_BUFFER_VIEW,
+    GLTF_ACCESSOR_KEY_BYTE_OFFSET,
+    GLTF_ACCESSOR_KEY_COUNT,
+    GLTF_ACCESSOR_KEY_COMPONENT_TYPE,
+    GLTF_ACCESSOR_KEY_TYPE,
+    GLTF_ACCESSOR_KEY_NORMALIZED,
+    GLTF_ACCESSOR_KEY_SPARSE,
+    GLTF_ACCESSOR_KEY_MAX,
+    GLTF_ACCESSOR_KEY_MIN,
+};
+static constexpr auto GLTF_ACCESSOR_KEYS = gltf_make_key_table({
+    "bufferView", "byteOffset", "count", "componentType", "type", "normalized", "sparse", "max", "min",
+});
+
+enum Gltf_Accessor_Sparse_Key {
+    GLTF_ACCESSOR_SPARSE_KEY_COUNT,
+    GLTF_ACCESSOR_SPARSE_KEY_INDICES,
+    GLTF_ACCESSOR_SPARSE_KEY_VALUES,
+};
+static constexpr auto GLTF_ACCESSOR_SPARSE_KEYS = gltf_make_key_table({"count", "indices", "values"});
+
+// shared by the sparse 'indices' and 'values' objects ('values' has no componentType)
+enum Gltf_Accessor_Sparse_View_Key {
+    GLTF_ACCESSOR_SPARSE_VIEW_KEY_BUFFER_VIEW,
+    GLTF_ACCESSOR_SPARSE_VIEW_KEY_BYTE_OFFSET,
+    GLTF_ACCESSOR_SPARSE_VIEW_KEY_COMPONENT_TYPE,
+};
+static constexpr auto GLTF_ACCESSOR_SPARSE_VIEW_KEYS =
+    gltf_make_key_table({"bufferView", "byteOffset", "componentType"});
+
 // @Todo check that all defaults are being properly set
 Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor_count) {
     u64 inc = 0; // track position in file
@@ -477,7 +1128,7 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
     Gltf_Accessor_Type accessor_component_type = GLTF_ACCESSOR_TYPE_NONE;
 
     // aligned pointer to return
-    Gltf_Accessor *ret = (Gltf_Accessor*)memory_allocate_temp(0, 8);
+    Gltf_Accessor *ret = (Gltf_Accessor*)gltf_allocate(0, 8);
     // pointer for allocating to in loops
     Gltf_Accessor *accessor;
 
@@ -491,8 +1142,9 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
         count++; // increment accessor count
 
         // Temp allocation made for every accessor struct. Keeps shit packed, linear allocators are fast...
-        accessor = (Gltf_Accessor*)memory_allocate_temp(sizeof(Gltf_Accessor), 8);
+        accessor = (Gltf_Accessor*)gltf_allocate(sizeof(Gltf_Accessor), 8);
         *accessor = {};
+        accessor->buffer_view = -1; // sparse accessors can omit it, meaning zero initialized
         accessor->indices_component_type = GLTF_ACCESSOR_TYPE_NONE;
         accessor->format = GLTF_ACCESSOR_FORMAT_UNKNOWN;
         min_max_len = 0;
@@ -504,28 +1156,26 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
             //simd_skip_passed_char(data + inc, &inc, '"', Max_u64); // skip to beginning of key
 
             //
-            // I do not like all these branch misses, but I cant see a better way. Even if I make a system
-            // to remove options if they have already been chosen, there would still be at least one branch
-            // with no improvement in predictability... (I think)
-            //
-            // ...I think this is just how parsing text goes...
+            // I used to not like all the branch misses here: keys were matched by a chain of strcmps.
+            // Now there is one hash + compare per key (see 'Key dispatch' above) and one jump.
             //
 
             // match keys to parse methods
-            if (simd_strcmp_short(data + inc, "bufferViewxxxxxx",  6) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_KEYS)) {
+            case GLTF_ACCESSOR_KEY_BUFFER_VIEW:
                 accessor->buffer_view = gltf_ascii_to_int(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx",  6) == 0) {
+            case GLTF_ACCESSOR_KEY_BYTE_OFFSET:
                 accessor->byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "countxxxxxxxxxxx", 11) == 0) {
+            case GLTF_ACCESSOR_KEY_COUNT:
                 accessor->count = gltf_ascii_to_int(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "componentTypexxx",  3) == 0) {
+            case GLTF_ACCESSOR_KEY_COMPONENT_TYPE:
                 accessor_component_type = (Gltf_Accessor_Type)gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "typexxxxxxxxxxxx", 12) == 0) {
-
+            case GLTF_ACCESSOR_KEY_TYPE:
+            {
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // jump into value string
 
                 if (simd_strcmp_short(data + inc, "SCALARxxxxxxxxxx", 10) == 0)
@@ -545,7 +1195,8 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
 
                 simd_skip_passed_char(data + inc, &inc, '"'); // skip passed the value string
                 continue;
-            } else if (simd_strcmp_short(data + inc, "normalizedxxxxxx", 6) == 0) {
+            }
+            case GLTF_ACCESSOR_KEY_NORMALIZED:
                 simd_skip_passed_char(data + inc, &inc, ':', Max_u64);
                 simd_skip_whitespace(data + inc, &inc); // go the beginning of 'true' || 'false' ascii string
                 if (simd_strcmp_short(data + inc, "truexxxxxxxxxxxx", 12) == 0) {
@@ -558,24 +1209,26 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
                 }
 
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "sparsexxxxxxxxxx", 10) == 0) {
+            case GLTF_ACCESSOR_KEY_SPARSE:
                 gltf_parse_accessor_sparse(data + inc, &inc, accessor);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "maxxxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_ACCESSOR_KEY_MAX:
                 min_max_len = gltf_parse_float_array(data + inc, &inc, max);
                 max_found = true;
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "minxxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_ACCESSOR_KEY_MIN:
                 min_max_len = gltf_parse_float_array(data + inc, &inc, min);
                 min_found = true;
                 continue; // go to next key
+            default:
+                break;
             }
 
         }
         if (min_found && max_found) {
             // @MemAlign careful here
             temp = align(sizeof(float) * min_max_len * 2, 8);
-            accessor->max = (float*)memory_allocate_temp(temp, 8);
+            accessor->max = (float*)gltf_allocate(temp, 8);
             accessor->min = accessor->max + min_max_len;
 
             memcpy(accessor->max, max, sizeof(float) * min_max_len);
@@ -928,54 +1581,86 @@ void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *ac
     simd_find_char_interrupted(data + inc, '{', '}', &inc); // find sparse start
     while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
         inc++; // go beyond the '"'
-        if (simd_strcmp_short(data + inc, "countxxxxxxxxxxx", 11) == 0)  {
+        switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_SPARSE_KEYS)) {
+        case GLTF_ACCESSOR_SPARSE_KEY_COUNT:
             accessor->sparse_count = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "indicesxxxxxxxxx", 9) == 0) {
+        case GLTF_ACCESSOR_SPARSE_KEY_INDICES:
             simd_find_char_interrupted(data + inc, '{', '}', &inc); // find indices start
             while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                 inc++; // go passed the '"'
-                if (simd_strcmp_short(data + inc, "bufferViewxxxxxx", 6) == 0) {
+                switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_SPARSE_VIEW_KEYS)) {
+                case GLTF_ACCESSOR_SPARSE_VIEW_KEY_BUFFER_VIEW:
                     accessor->indices_buffer_view = gltf_ascii_to_int(data + inc, &inc);
                     continue;
-                }
-                if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx", 6) == 0) {
+                case GLTF_ACCESSOR_SPARSE_VIEW_KEY_BYTE_OFFSET:
                     accessor->indices_byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                     continue;
-                }
-                if (simd_strcmp_short(data + inc, "componentTypexxx", 3) == 0) {
+                case GLTF_ACCESSOR_SPARSE_VIEW_KEY_COMPONENT_TYPE:
                     accessor->indices_component_type = (Gltf_Accessor_Type)gltf_ascii_to_int(data + inc, &inc);
                     continue;
+                default:
+                    break;
                 }
             }
             simd_find_char_interrupted(data + inc, '}', '{', &inc); // find indices end
             inc++; // go beyond
             continue;
-        } else if (simd_strcmp_short(data + inc, "valuesxxxxxxxxx", 10) == 0) {
+        case GLTF_ACCESSOR_SPARSE_KEY_VALUES:
             simd_find_char_interrupted(data + inc, '{', '}', &inc); // find values start
             while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                 inc++; // go passed the '"'
-                if (simd_strcmp_short(data + inc, "bufferViewxxxxxx", 6) == 0) {
+                switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_SPARSE_VIEW_KEYS)) {
+                case GLTF_ACCESSOR_SPARSE_VIEW_KEY_BUFFER_VIEW:
                     accessor->values_buffer_view = gltf_ascii_to_int(data + inc, &inc);
                     continue;
-                }
-                if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx", 6) == 0) {
+                case GLTF_ACCESSOR_SPARSE_VIEW_KEY_BYTE_OFFSET:
                     accessor->values_byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                     continue;
+                default:
+                    break;
                 }
             }
             simd_find_char_interrupted(data + inc, '}', '{', &inc); // find indices end
             inc++; // go beyond
             continue;
+        default:
+            break;
         }
     }
     *offset += inc + 1; // +1 go beyond the last curly brace in sparse object
 }
 
 // `Animations
+enum Gltf_Animation_Channel_Key {
+    GLTF_ANIMATION_CHANNEL_KEY_SAMPLER,
+    GLTF_ANIMATION_CHANNEL_KEY_TARGET,
+};
+static constexpr auto GLTF_ANIMATION_CHANNEL_KEYS = gltf_make_key_table({"sampler", "target"});
+
+enum Gltf_Animation_Target_Key {
+    GLTF_ANIMATION_TARGET_KEY_NODE,
+    GLTF_ANIMATION_TARGET_KEY_PATH,
+};
+static constexpr auto GLTF_ANIMATION_TARGET_KEYS = gltf_make_key_table({"node", "path"});
+
+enum Gltf_Animation_Sampler_Key {
+    GLTF_ANIMATION_SAMPLER_KEY_INPUT,
+    GLTF_ANIMATION_SAMPLER_KEY_OUTPUT,
+    GLTF_ANIMATION_SAMPLER_KEY_INTERPOLATION,
+};
+static constexpr auto GLTF_ANIMATION_SAMPLER_KEYS = gltf_make_key_table({"input", "output", "interpolation"});
+
+enum Gltf_Animation_Key {
+    GLTF_ANIMATION_KEY_NAME,
+    GLTF_ANIMATION_KEY_CHANNELS,
+    GLTF_ANIMATION_KEY_SAMPLERS,
+};
+static constexpr auto GLTF_ANIMATION_KEYS = gltf_make_key_table({"name", "channels", "samplers"});
+
 Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *offset, int *channel_count) {
     // Aligned pointer to return
-    Gltf_Animation_Channel *channels = (Gltf_Animation_Channel*)memory_allocate_temp(0, 8);
+    Gltf_Animation_Channel *channels = (Gltf_Animation_Channel*)gltf_allocate(0, 8);
     // pointer for allocating to in loops
     Gltf_Animation_Channel *channel;
 
@@ -989,23 +1674,25 @@ Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *off
     int count = 0; // track object count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        channel = (Gltf_Animation_Channel*)memory_allocate_temp(sizeof(Gltf_Animation_Channel), 8);
+        channel = (Gltf_Animation_Channel*)gltf_allocate(sizeof(Gltf_Animation_Channel), 8);
         *channel = {};
         count++;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) { // channel loop
             inc++; // go beyond opening '"' in key
-            if (simd_strcmp_short(data + inc, "samplerxxxxxxxxx",  9) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ANIMATION_CHANNEL_KEYS)) {
+            case GLTF_ANIMATION_CHANNEL_KEY_SAMPLER:
                 channel->sampler = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "targetxxxxxxxxxx", 10) == 0) {
+            case GLTF_ANIMATION_CHANNEL_KEY_TARGET:
                 simd_skip_passed_char(data + inc, &inc, '{');
                 // loop through 'target' object's keys
                 while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                     inc++;
-                    if (simd_strcmp_short(data + inc, "nodexxxxxxxxxxxx", 12) == 0) {
+                    switch(gltf_match_key(data + inc, &GLTF_ANIMATION_TARGET_KEYS)) {
+                    case GLTF_ANIMATION_TARGET_KEY_NODE:
                        channel->target_node = gltf_ascii_to_int(data + inc, &inc);
                        continue;
-                    } else if (simd_strcmp_short(data + inc, "pathxxxxxxxxxxxx", 12) == 0) {
+                    case GLTF_ANIMATION_TARGET_KEY_PATH:
 
                         //
                         // string keys + string values are brutal for error proneness...
@@ -1024,9 +1711,15 @@ Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *off
                             channel->path = GLTF_ANIMATION_PATH_WEIGHTS;
                         }
                         simd_skip_passed_char(data + inc, &inc, '"');
+                        continue;
+                    default:
+                        break;
                     }
                 }
                 inc++; // go passed closing brace of 'target' object to avoid early 'channel' loop exit
+                continue;
+            default:
+                break;
             }
         }
     }
@@ -1041,26 +1734,27 @@ Gltf_Animation_Sampler* gltf_parse_animation_samplers(const char *data, u64 *off
     //     outer loop to jump through the list of objects
     //     inner loop to jump through the keys in an object
     //
-    Gltf_Animation_Sampler *samplers = (Gltf_Animation_Sampler*)memory_allocate_temp(0, 8); // get pointer to beginning of sampler allocations
+    Gltf_Animation_Sampler *samplers = (Gltf_Animation_Sampler*)gltf_allocate(0, 8); // get pointer to beginning of sampler allocations
     Gltf_Animation_Sampler *sampler; // temp pointer to allocate to in loops
 
     u64 inc = 0;   // track file pos
     int count = 0; // track sampler count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        sampler = (Gltf_Animation_Sampler*)memory_allocate_temp(sizeof(Gltf_Animation_Sampler), 8);
+        sampler = (Gltf_Animation_Sampler*)gltf_allocate(sizeof(Gltf_Animation_Sampler), 8);
         *sampler = {};
         count++;
         sampler->interp = GLTF_ANIMATION_INTERP_LINEAR;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // go beyond opening '"' of key
-            if (simd_strcmp_short(data + inc, "inputxxxxxxxxxxx", 11) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ANIMATION_SAMPLER_KEYS)) {
+            case GLTF_ANIMATION_SAMPLER_KEY_INPUT:
                 sampler->input = gltf_ascii_to_int(data + inc, &inc);
-                continue; // Idk if continue and else if is destroying some branch predict algorithm, I hope not...
-            } else if (simd_strcmp_short(data + inc, "outputxxxxxxxxxx", 10) == 0) {
+                continue;
+            case GLTF_ANIMATION_SAMPLER_KEY_OUTPUT:
                 sampler->output = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "interpolationxxx", 3) == 0) {
+            case GLTF_ANIMATION_SAMPLER_KEY_INTERPOLATION:
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // jump into value string
                 if (simd_strcmp_short(data + inc, "LINEARxxxxxxxxxx", 10) == 0) {
                     sampler->interp = GLTF_ANIMATION_INTERP_LINEAR;
@@ -1079,6 +1773,8 @@ Gltf_Animation_Sampler* gltf_parse_animation_samplers(const char *data, u64 *off
                 }
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
+            default:
+                break;
             }
         }
     }
@@ -1094,7 +1790,7 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
     //     inner loop jumps through the keys in each object
     //
 
-    Gltf_Animation *animations = (Gltf_Animation*)memory_allocate_temp(0, 8); // get aligned pointer to return
+    Gltf_Animation *animations = (Gltf_Animation*)gltf_allocate(0, 8); // get aligned pointer to return
     Gltf_Animation *animation; // pointer for allocating to in loops
 
     u64 inc = 0;   // track pos in file
@@ -1102,20 +1798,23 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) { // jump to object start
         ++count;
-        animation = (Gltf_Animation*)memory_allocate_temp(sizeof(Gltf_Animation), 8);
+        animation = (Gltf_Animation*)gltf_allocate(sizeof(Gltf_Animation), 8);
         *animation = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // enter the key
-            if (simd_strcmp_short(data + inc, "namexxxxxxxxxxxx", 12) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ANIMATION_KEYS)) {
+            case GLTF_ANIMATION_KEY_NAME:
                 // skip "name" key. Have to jump 3 quotation marks: key end, value both
                 simd_skip_passed_char_count(data + inc, '"', 3, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "channelsxxxxxxxx", 8) == 0) {
+            case GLTF_ANIMATION_KEY_CHANNELS:
                 animation->channels = gltf_parse_animation_channels(data + inc, &inc, &animation->channel_count);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "samplersxxxxxxxx", 8) == 0) {
+            case GLTF_ANIMATION_KEY_SAMPLERS:
                 animation->samplers = gltf_parse_animation_samplers(data + inc, &inc, &animation->sampler_count);
                 continue;
+            default:
+                break;
             }
         }
         animation->stride =  sizeof(Gltf_Animation) +
@@ -1130,8 +1829,14 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
 }
 
 // `Buffers
+enum Gltf_Buffer_Key {
+    GLTF_BUFFER_KEY_BYTE_LENGTH,
+    GLTF_BUFFER_KEY_URI,
+};
+static constexpr auto GLTF_BUFFER_KEYS = gltf_make_key_table({"byteLength", "uri"});
+
 Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count) {
-    Gltf_Buffer *buffers = (Gltf_Buffer*)memory_allocate_temp(0, 8); // pointer to start of array to return
+    Gltf_Buffer *buffers = (Gltf_Buffer*)gltf_allocate(0, 8); // pointer to start of array to return
     Gltf_Buffer *buffer; // temp pointer to allocate to while parsing
 
     u64 inc = 0; // track file pos locally
@@ -1140,21 +1845,24 @@ Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        buffer = (Gltf_Buffer*)memory_allocate_temp(sizeof(Gltf_Buffer), 8);
+        buffer = (Gltf_Buffer*)gltf_allocate(sizeof(Gltf_Buffer), 8);
         *buffer = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // go beyond opening '"'
-            if (simd_strcmp_short(data + inc, "byteLengthxxxxxx", 6) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_BUFFER_KEYS)) {
+            case GLTF_BUFFER_KEY_BYTE_LENGTH:
                 buffer->byte_length = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "urixxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_BUFFER_KEY_URI:
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // step inside value string
                 uri_len = simd_strlen(data + inc, '"') + 1; // +1 for null termination
-                buffer->uri = (char*)memory_allocate_temp(uri_len, 1);
+                buffer->uri = (char*)gltf_allocate(uri_len, 1);
                 memcpy(buffer->uri, data + inc, uri_len);
                 buffer->uri[uri_len - 1] = '\0';
                 simd_skip_passed_char(data + inc, &inc, '"'); // step inside value string
                 continue;
+            default:
+                break;
             }
         }
         buffer->stride = align(sizeof(Gltf_Buffer) + uri_len, 8);
@@ -1166,33 +1874,46 @@ Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count
 }
 
 // `BufferViews
+enum Gltf_Buffer_View_Key {
+    GLTF_BUFFER_VIEW_KEY_BUFFER,
+    GLTF_BUFFER_VIEW_KEY_BYTE_OFFSET,
+    GLTF_BUFFER_VIEW_KEY_BYTE_LENGTH,
+    GLTF_BUFFER_VIEW_KEY_BYTE_STRIDE,
+    GLTF_BUFFER_VIEW_KEY_TARGET,
+};
+static constexpr auto GLTF_BUFFER_VIEW_KEYS =
+    gltf_make_key_table({"buffer", "byteOffset", "byteLength", "byteStride", "target"});
+
 Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *buffer_view_count) {
-    Gltf_Buffer_View *buffer_views = (Gltf_Buffer_View*)memory_allocate_temp(0, 8);
+    Gltf_Buffer_View *buffer_views = (Gltf_Buffer_View*)gltf_allocate(0, 8);
     Gltf_Buffer_View *buffer_view;
     u64 inc = 0;
     int count = 0;
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        buffer_view = (Gltf_Buffer_View*)memory_allocate_temp(sizeof(Gltf_Buffer_View), 8);
+        buffer_view = (Gltf_Buffer_View*)gltf_allocate(sizeof(Gltf_Buffer_View), 8);
         *buffer_view = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step beyond key's opening '"'
-            if (simd_strcmp_short(data + inc, "bufferxxxxxxxxxx", 10) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_BUFFER_VIEW_KEYS)) {
+            case GLTF_BUFFER_VIEW_KEY_BUFFER:
                 buffer_view->buffer = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEY_BYTE_OFFSET:
                 buffer_view->byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteLengthxxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEY_BYTE_LENGTH:
                 buffer_view->byte_length = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteStridexxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEY_BYTE_STRIDE:
                 buffer_view->byte_stride = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "targetxxxxxxxxxx", 10) == 0) {
+            case GLTF_BUFFER_VIEW_KEY_TARGET:
                 buffer_view->buffer_type = (Gltf_Buffer_Type)gltf_ascii_to_int(data + inc, &inc);
                 continue;
+            default:
+                break;
             }
         }
         buffer_view->stride = sizeof(Gltf_Buffer_View);
@@ -1204,19 +1925,39 @@ Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *bu
 }
 
 // `Cameras
+enum Gltf_Camera_Key {
+    GLTF_CAMERA_KEY_TYPE,
+    GLTF_CAMERA_KEY_ORTHOGRAPHIC,
+    GLTF_CAMERA_KEY_PERSPECTIVE,
+};
+static constexpr auto GLTF_CAMERA_KEYS = gltf_make_key_table({"type", "orthographic", "perspective"});
+
+// shared by the 'orthographic' and 'perspective' objects
+enum Gltf_Camera_Projection_Key {
+    GLTF_CAMERA_PROJECTION_KEY_XMAG,
+    GLTF_CAMERA_PROJECTION_KEY_YMAG,
+    GLTF_CAMERA_PROJECTION_KEY_ASPECT_RATIO,
+    GLTF_CAMERA_PROJECTION_KEY_YFOV,
+    GLTF_CAMERA_PROJECTION_KEY_ZFAR,
+    GLTF_CAMERA_PROJECTION_KEY_ZNEAR,
+};
+static constexpr auto GLTF_CAMERA_PROJECTION_KEYS =
+    gltf_make_key_table({"xmag", "ymag", "aspectRatio", "yfov", "zfar", "znear"});
+
 Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count) {
-    Gltf_Camera *cameras = (Gltf_Camera*)memory_allocate_temp(0, 8);
+    Gltf_Camera *cameras = (Gltf_Camera*)gltf_allocate(0, 8);
     Gltf_Camera *camera;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        camera = (Gltf_Camera*)memory_allocate_temp(sizeof(Gltf_Camera), 8);
+        camera = (Gltf_Camera*)gltf_allocate(sizeof(Gltf_Camera), 8);
         *camera = {};
         count++;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "typexxxxxxxxxxxx", 12) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_CAMERA_KEYS)) {
+            case GLTF_CAMERA_KEY_TYPE:
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
                 if (simd_strcmp_short(data + inc, "orthographicxxxx", 4) == 0) {
                     camera->ortho = true;
@@ -1227,42 +1968,34 @@ Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count
                     simd_skip_passed_char(data + inc, &inc, '"');
                     continue;
                 }
-            } else if (simd_strcmp_short(data + inc, "orthographicxxxx", 4) == 0) {
+            case GLTF_CAMERA_KEY_ORTHOGRAPHIC:
+            case GLTF_CAMERA_KEY_PERSPECTIVE:
+                // xmag/aspectRatio and ymag/yfov land in the same fields, so both objects share a loop
                 simd_skip_passed_char(data + inc, &inc, '"');
                 while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                     inc++;
-                    if (simd_strcmp_short(data + inc, "xmagxxxxxxxxxxxx", 12) == 0) {
+                    switch(gltf_match_key(data + inc, &GLTF_CAMERA_PROJECTION_KEYS)) {
+                    case GLTF_CAMERA_PROJECTION_KEY_XMAG:
+                    case GLTF_CAMERA_PROJECTION_KEY_ASPECT_RATIO:
                         camera->x_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "ymagxxxxxxxxxxxx", 12) == 0) {
+                    case GLTF_CAMERA_PROJECTION_KEY_YMAG:
+                    case GLTF_CAMERA_PROJECTION_KEY_YFOV:
                         camera->y_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "zfarxxxxxxxxxxxx", 12) == 0) {
+                    case GLTF_CAMERA_PROJECTION_KEY_ZFAR:
                         camera->zfar = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "znearxxxxxxxxxxx", 11) == 0) {
-                        camera->znear = gltf_ascii_to_float(data + inc, &inc);
-                        continue;
-                    }
-                }
-            } else if (simd_strcmp_short(data + inc, "perspectivexxxxx", 5) == 0) {
-                simd_skip_passed_char(data + inc, &inc, '"');
-                while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
-                    inc++;
-                    if (simd_strcmp_short(data + inc, "aspectRatioxxxxx", 5) == 0) {
-                        camera->x_factor = gltf_ascii_to_float(data + inc, &inc);
-                        continue;
-                    } else if (simd_strcmp_short(data + inc, "yfovxxxxxxxxxxxx", 12) == 0) {
-                        camera->y_factor = gltf_ascii_to_float(data + inc, &inc);
-                        continue;
-                    } else if (simd_strcmp_short(data + inc, "zfarxxxxxxxxxxxx", 12) == 0) {
-                        camera->zfar = gltf_ascii_to_float(data + inc, &inc);
-                        continue;
-                    } else if (simd_strcmp_short(data + inc, "znearxxxxxxxxxxx", 11) == 0) {
+                    case GLTF_CAMERA_PROJECTION_KEY_ZNEAR:
                         camera->znear = gltf_ascii_to_float(data + inc, &inc);
                         continue;
+                    default:
+                        break;
                     }
                 }
+                continue;
+            default:
+                break;
             }
         }
         camera->stride = sizeof(Gltf_Camera);
@@ -1274,8 +2007,15 @@ Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count
 }
 
 // `Images
+enum Gltf_Image_Key {
+    GLTF_IMAGE_KEY_URI,
+    GLTF_IMAGE_KEY_MIME_TYPE,
+    GLTF_IMAGE_KEY_BUFFER_VIEW,
+};
+static constexpr auto GLTF_IMAGE_KEYS = gltf_make_key_table({"uri", "mimeType", "bufferView"});
+
 Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
-    Gltf_Image *images = (Gltf_Image*)memory_allocate_temp(0, 8);
+    Gltf_Image *images = (Gltf_Image*)gltf_allocate(0, 8);
     Gltf_Image *image;
 
     u64 inc = 0;
@@ -1283,19 +2023,20 @@ Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
     int uri_len;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        image = (Gltf_Image*)memory_allocate_temp(sizeof(Gltf_Image), 8);
+        image = (Gltf_Image*)gltf_allocate(sizeof(Gltf_Image), 8);
         *image = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++;
-            if (simd_strcmp_short(data + inc, "urixxxxxxxxxxxxx", 13) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_IMAGE_KEYS)) {
+            case GLTF_IMAGE_KEY_URI:
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
                 uri_len = simd_strlen(data + inc, '"') + 1;
-                image->uri = (char*)memory_allocate_temp(uri_len, 1);
+                image->uri = (char*)gltf_allocate(uri_len, 1);
                 memcpy(image->uri, data + inc, uri_len);
                 image->uri[uri_len - 1] = '\0';
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
-            } else if (simd_strcmp_short(data + inc, "mimeTypexxxxxxxx", 8) == 0) {
+            case GLTF_IMAGE_KEY_MIME_TYPE:
                 uri_len = 0;
                 image->uri = NULL;
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
@@ -1306,9 +2047,11 @@ Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
                 }
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
-            } else if (simd_strcmp_short(data + inc, "bufferViewxxxxxx", 6) == 0) {
+            case GLTF_IMAGE_KEY_BUFFER_VIEW:
                 image->buffer_view = gltf_ascii_to_int(data + inc, &inc);
                 continue;
+            default:
+                break;
             }
         }
         image->stride = align(sizeof(Gltf_Image) + uri_len, 8);
@@ -1319,64 +2062,102 @@ Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
 }
 
 // `Materials
+enum Gltf_Material_Key {
+    GLTF_MATERIAL_KEY_PBR_METALLIC_ROUGHNESS,
+    GLTF_MATERIAL_KEY_NORMAL_TEXTURE,
+    GLTF_MATERIAL_KEY_OCCLUSION_TEXTURE,
+    GLTF_MATERIAL_KEY_EMISSIVE_FACTOR,
+    GLTF_MATERIAL_KEY_EMISSIVE_TEXTURE,
+    GLTF_MATERIAL_KEY_ALPHA_MODE,
+    GLTF_MATERIAL_KEY_ALPHA_CUTOFF,
+    GLTF_MATERIAL_KEY_DOUBLE_SIDED,
+};
+static constexpr auto GLTF_MATERIAL_KEYS = gltf_make_key_table({
+    "pbrMetallicRoughness", "normalTexture", "occlusionTexture", "emissiveFactor", "emissiveTexture",
+    "alphaMode", "alphaCutoff", "doubleSided",
+});
+
+enum Gltf_Material_Pbr_Key {
+    GLTF_MATERIAL_PBR_KEY_BASE_COLOR_FACTOR,
+    GLTF_MATERIAL_PBR_KEY_METALLIC_FACTOR,
+    GLTF_MATERIAL_PBR_KEY_ROUGHNESS_FACTOR,
+    GLTF_MATERIAL_PBR_KEY_BASE_COLOR_TEXTURE,
+    GLTF_MATERIAL_PBR_KEY_METALLIC_ROUGHNESS_TEXTURE,
+};
+static constexpr auto GLTF_MATERIAL_PBR_KEYS = gltf_make_key_table({
+    "baseColorFactor", "metallicFactor", "roughnessFactor", "baseColorTexture", "metallicRoughnessTexture",
+});
+
+enum Gltf_Texture_Info_Key {
+    GLTF_TEXTURE_INFO_KEY_INDEX,
+    GLTF_TEXTURE_INFO_KEY_TEX_COORD,
+    GLTF_TEXTURE_INFO_KEY_SCALE,
+    GLTF_TEXTURE_INFO_KEY_STRENGTH,
+};
+static constexpr auto GLTF_TEXTURE_INFO_KEYS = gltf_make_key_table({"index", "texCoord", "scale", "strength"});
+
 Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material_count) {
-    Gltf_Material *materials = (Gltf_Material*)memory_allocate_temp(0, 8);
+    Gltf_Material *materials = (Gltf_Material*)gltf_allocate(0, 8);
     Gltf_Material *material;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        material = (Gltf_Material*)memory_allocate_temp(sizeof(Gltf_Material), 8);
+        material = (Gltf_Material*)gltf_allocate(sizeof(Gltf_Material), 8);
         *material = {}; // make sure defaults are properly initialized
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++;
-            if (simd_strcmp_long(data + inc, "pbrMetallicRoughnessxxxxxxxxxxxx", 12) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_MATERIAL_KEYS)) {
+            case GLTF_MATERIAL_KEY_PBR_METALLIC_ROUGHNESS:
                 simd_skip_passed_char(data + inc, &inc, '"');
                 while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                     inc++;
-                    if (simd_strcmp_short(data + inc, "baseColorFactorx", 1) == 0) {
+                    switch(gltf_match_key(data + inc, &GLTF_MATERIAL_PBR_KEYS)) {
+                    case GLTF_MATERIAL_PBR_KEY_BASE_COLOR_FACTOR:
                         gltf_parse_float_array(data + inc, &inc, &material->base_color_factor[0]);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "metallicFactorxx", 2) == 0) {
+                    case GLTF_MATERIAL_PBR_KEY_METALLIC_FACTOR:
                         material->metallic_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "roughnessFactorx", 1) == 0) {
+                    case GLTF_MATERIAL_PBR_KEY_ROUGHNESS_FACTOR:
                         material->roughness_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "baseColorTexture", 0) == 0) {
+                    case GLTF_MATERIAL_PBR_KEY_BASE_COLOR_TEXTURE:
                         simd_skip_passed_char(data + inc, &inc, '"');
                         gltf_parse_texture_info(data + inc, &inc, &material->base_color_texture_index,
                                                 &material->base_color_tex_coord, NULL, NULL);
                         continue;
-                    } else if (simd_strcmp_long(data + inc, "metallicRoughnessTexturexxxxxxxx", 8) == 0) {
+                    case GLTF_MATERIAL_PBR_KEY_METALLIC_ROUGHNESS_TEXTURE:
                         simd_skip_passed_char(data + inc, &inc, '"');
                         gltf_parse_texture_info(data + inc, &inc, &material->metallic_roughness_texture_index,
                                                 &material->metallic_roughness_tex_coord, NULL, NULL);
                         continue;
+                    default:
+                        break;
                     }
                 }
                 inc++; // go beyond closing curly
                 continue;
-            } else if (simd_strcmp_short(data + inc, "normalTexturexxx", 3) == 0) {
+            case GLTF_MATERIAL_KEY_NORMAL_TEXTURE:
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->normal_texture_index, &material->normal_tex_coord,
                                         &material->normal_scale, NULL);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "occlusionTexture", 0) == 0) {
+            case GLTF_MATERIAL_KEY_OCCLUSION_TEXTURE:
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->occlusion_texture_index, &material->occlusion_tex_coord,
                                         NULL, &material->occlusion_strength);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "emissiveFactorxx", 2) == 0) {
+            case GLTF_MATERIAL_KEY_EMISSIVE_FACTOR:
                 gltf_parse_float_array(data + inc, &inc, &material->emissive_factor[0]);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "emissiveTexturex", 1) == 0) {
+            case GLTF_MATERIAL_KEY_EMISSIVE_TEXTURE:
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->emissive_texture_index,
                                         &material->emissive_tex_coord, NULL, NULL);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "alphaModexxxxxxx", 7) == 0) {
+            case GLTF_MATERIAL_KEY_ALPHA_MODE:
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
                 if (simd_strcmp_short(data + inc, "OPAQUExxxxxxxxxx", 10) == 0) {
                     material->alpha_mode = GLTF_ALPHA_MODE_OPAQUE;
@@ -1387,10 +2168,10 @@ Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material
                 }
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
-            } else if (simd_strcmp_short(data + inc, "alphaCutoffxxxxx", 5) == 0) {
+            case GLTF_MATERIAL_KEY_ALPHA_CUTOFF:
                 material->alpha_cutoff = gltf_ascii_to_float(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "doubleSidedxxxxx", 5) == 0) {
+            case GLTF_MATERIAL_KEY_DOUBLE_SIDED:
                 simd_skip_passed_char(data + inc, &inc, ':');
                 simd_skip_whitespace(data + inc, &inc);
                 if (simd_strcmp_short(data + inc, "truexxxxxxxxxxxx", 12) == 0) {
@@ -1400,6 +2181,8 @@ Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material
                     material->double_sided = 0;
                     continue;
                 }
+            default:
+                break;
             }
         }
         material->stride = align(sizeof(Gltf_Material), 8);
@@ -1413,26 +2196,45 @@ void gltf_parse_texture_info(const char *data, u64 *offset, int *index, int *tex
     u64 inc = 0;
     while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
         inc++;
-        if (simd_strcmp_short(data + inc, "indexxxxxxxxxxxx", 11) == 0) {
+        switch(gltf_match_key(data + inc, &GLTF_TEXTURE_INFO_KEYS)) {
+        case GLTF_TEXTURE_INFO_KEY_INDEX:
             *index = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "texCoordxxxxxxxx", 8) == 0) {
+        case GLTF_TEXTURE_INFO_KEY_TEX_COORD:
             *tex_coord = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "scalexxxxxxxxxxx", 11) == 0) {
+        case GLTF_TEXTURE_INFO_KEY_SCALE:
             *scale = gltf_ascii_to_float(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "strengthxxxxxxxx", 8) == 0) {
+        case GLTF_TEXTURE_INFO_KEY_STRENGTH:
             *strength = gltf_ascii_to_float(data + inc, &inc);
             continue;
+        default:
+            break;
         }
     }
     *offset += inc + 1; // +1 go beyond closing curly
 }
 
 // `Meshes
+enum Gltf_Mesh_Key {
+    GLTF_MESH_KEY_PRIMITIVES,
+    GLTF_MESH_KEY_WEIGHTS,
+};
+static constexpr auto GLTF_MESH_KEYS = gltf_make_key_table({"primitives", "weights"});
+
+enum Gltf_Mesh_Primitive_Key {
+    GLTF_MESH_PRIMITIVE_KEY_INDICES,
+    GLTF_MESH_PRIMITIVE_KEY_MATERIAL,
+    GLTF_MESH_PRIMITIVE_KEY_MODE,
+    GLTF_MESH_PRIMITIVE_KEY_TARGETS,
+    GLTF_MESH_PRIMITIVE_KEY_ATTRIBUTES,
+};
+static constexpr auto GLTF_MESH_PRIMITIVE_KEYS =
+    gltf_make_key_table({"indices", "material", "mode", "targets", "attributes"});
+
 Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count) {
-    Gltf_Mesh *meshes = (Gltf_Mesh*)memory_allocate_temp(0, 8);
+    Gltf_Mesh *meshes = (Gltf_Mesh*)gltf_allocate(0, 8);
     Gltf_Mesh *mesh;
 
     u64 inc = 0;
@@ -1440,32 +2242,35 @@ Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count) {
     u64 mark;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        mesh = (Gltf_Mesh*)memory_allocate_temp(sizeof(Gltf_Mesh), 8);
+        mark = gltf_get_mark();
+        mesh = (Gltf_Mesh*)gltf_allocate(sizeof(Gltf_Mesh), 8);
         *mesh = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "primitivesxxxxxx", 6) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_MESH_KEYS)) {
+            case GLTF_MESH_KEY_PRIMITIVES:
                 mesh->primitives = gltf_parse_mesh_primitives(data + inc, &inc, &mesh->primitive_count);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "weightsxxxxxxxxx", 9) == 0) {
+            case GLTF_MESH_KEY_WEIGHTS:
                 simd_skip_to_char(data + inc, &inc, '[');
                 mesh->weight_count = simd_get_ascii_array_len(data + inc);
                 // @MemAlign careful with this alignment (the 4 I mean)
                 // Aligning to 4 means I can align the entire stride later, rather than its pieces
-                mesh->weights = (float*)memory_allocate_temp(sizeof(float) * mesh->weight_count, 4);
+                mesh->weights = (float*)gltf_allocate(sizeof(float) * mesh->weight_count, 4);
                 gltf_parse_float_array(data + inc, &inc, mesh->weights);
                 continue;
+            default:
+                break;
             }
         }
-        mesh->stride = align(get_mark_temp() - mark, 8);
+        mesh->stride = align(gltf_get_mark() - mark, 8);
     }
     *offset += inc;
     *mesh_count = count;
     return meshes;
 }
 Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, int *primitive_count) {
-    Gltf_Mesh_Primitive *primitives = (Gltf_Mesh_Primitive*)memory_allocate_temp(0, 8);
+    Gltf_Mesh_Primitive *primitives = (Gltf_Mesh_Primitive*)gltf_allocate(0, 8);
     Gltf_Mesh_Primitive *primitive;
     Gltf_Morph_Target *target;
 
@@ -1477,18 +2282,19 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
     int mode;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        primitive = (Gltf_Mesh_Primitive*)memory_allocate_temp(sizeof(Gltf_Mesh_Primitive), 8);
+        mark = gltf_get_mark();
+        primitive = (Gltf_Mesh_Primitive*)gltf_allocate(sizeof(Gltf_Mesh_Primitive), 8);
         *primitive = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "indicesxxxxxxxxx", 9) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_MESH_PRIMITIVE_KEYS)) {
+            case GLTF_MESH_PRIMITIVE_KEY_INDICES:
                 primitive->indices = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "materialxxxxxxxx", 8) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEY_MATERIAL:
                 primitive->material = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "modexxxxxxxxxxxx", 12) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEY_MODE:
                 mode = gltf_ascii_to_int(data + inc, &inc);
                 switch(mode) {
                 case 0:
@@ -1515,23 +2321,23 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
                     break;
                 }
                 continue;
-            } else if (simd_strcmp_short(data + inc, "targetsxxxxxxxxx", 9) == 0) {
-                primitive->targets = (Gltf_Morph_Target*)memory_allocate_temp(0, 8);
+            case GLTF_MESH_PRIMITIVE_KEY_TARGETS:
+                primitive->targets = (Gltf_Morph_Target*)gltf_allocate(0, 8);
                 target_count = 0;
                 while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
                     target_count++;
 
-                    target_mark = get_mark_temp();
+                    target_mark = gltf_get_mark();
                     target =
-                        (Gltf_Morph_Target*)memory_allocate_temp(sizeof(Gltf_Morph_Target), 8);
+                        (Gltf_Morph_Target*)gltf_allocate(sizeof(Gltf_Morph_Target), 8);
                     target->attributes =
                         gltf_parse_mesh_attributes(data + inc, &inc, &target->attribute_count, true, NULL, NULL, NULL, NULL);
 
-                    target->stride = align(get_mark_temp() - target_mark, 8);
+                    target->stride = align(gltf_get_mark() - target_mark, 8);
                 }
                 primitive->target_count = target_count;
                 continue;
-            } else if (simd_strcmp_short(data + inc, "attributesxxxxxx", 6) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEY_ATTRIBUTES:
                 simd_skip_passed_char(data + inc, &inc, '{');
                 primitive->extra_attributes = gltf_parse_mesh_attributes(data + inc, &inc, &primitive->extra_attribute_count, false,
                 &primitive->position,
@@ -1539,9 +2345,11 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
                 &primitive->normal,
                 &primitive->tex_coord_0);
                 continue;
+            default:
+                break;
             }
         }
-        primitive->stride = align(get_mark_temp() - mark, 8);
+        primitive->stride = align(gltf_get_mark() - mark, 8);
     }
     inc++; // go beyond closing primitives square brace
     *offset += inc;
@@ -1549,7 +2357,7 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
     return primitives;
 }
 Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, int *attribute_count, bool targets /* HACK */, int *position, int *tangent, int *normal, int *tex_coord_0) {
-    Gltf_Mesh_Attribute *attributes = (Gltf_Mesh_Attribute*)memory_allocate_temp(0, 4);
+    Gltf_Mesh_Attribute *attributes = (Gltf_Mesh_Attribute*)gltf_allocate(0, 4);
     Gltf_Mesh_Attribute *attribute;
 
     u64 inc = 0;
@@ -1558,9 +2366,10 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
     while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
         inc++; // step into key
         // aligning to 4 allows for regular indexing
+        // (attribute keys are not hashed: names like 'TEXCOORD_n' carry a set index, so they are prefix matched)
         if      (simd_strcmp_short(data + inc, "NORMALxxxxxxxxxx", 10) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->type           = GLTF_MESH_ATTRIBUTE_TYPE_NORMAL;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
                 count++;
@@ -1571,7 +2380,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         }
         else if (simd_strcmp_short(data + inc, "POSITIONxxxxxxxx",  8) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_POSITION;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
                 count++;
@@ -1582,7 +2391,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         }
         else if (simd_strcmp_short(data + inc, "TANGENTxxxxxxxxx",  9) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_TANGENT;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
                 count++;
@@ -1594,7 +2403,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         else if (simd_strcmp_short(data + inc, "TEXCOORDxxxxxxxx",  8) == 0) {
             n = gltf_ascii_to_int(data + inc, &inc);
             if (n != 0 || targets) {
-                attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_TEXCOORD;
                 attribute->n    = n;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1605,7 +2414,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "COLORxxxxxxxxxxx", 11) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_COLOR;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1613,7 +2422,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "JOINTSxxxxxxxxxx", 10) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_JOINTS;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1621,7 +2430,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "WEIGHTSxxxxxxxxx",  9) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)memory_allocate_temp(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_allocate(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_WEIGHTS;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1637,8 +2446,23 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
 }
 
 // `Nodes
+enum Gltf_Node_Key {
+    GLTF_NODE_KEY_CAMERA,
+    GLTF_NODE_KEY_SKIN,
+    GLTF_NODE_KEY_MESH,
+    GLTF_NODE_KEY_MATRIX,
+    GLTF_NODE_KEY_ROTATION,
+    GLTF_NODE_KEY_SCALE,
+    GLTF_NODE_KEY_TRANSLATION,
+    GLTF_NODE_KEY_CHILDREN,
+    GLTF_NODE_KEY_WEIGHTS,
+};
+static constexpr auto GLTF_NODE_KEYS = gltf_make_key_table({
+    "camera", "skin", "mesh", "matrix", "rotation", "scale", "translation", "children", "weights",
+});
+
 Gltf_Node* gltf_parse_nodes(const char *data, u64 *offset, int *node_count) {
-    Gltf_Node *nodes = (Gltf_Node*)memory_allocate_temp(0, 8);
+    Gltf_Node *nodes = (Gltf_Node*)gltf_allocate(0, 8);
     Gltf_Node *node;
 
     u64 inc = 0;
@@ -1647,57 +2471,68 @@ Gltf_Node* gltf_parse_nodes(const char *data, u64 *offset, int *node_count) {
     float temp_array[4];
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        node = (Gltf_Node*)memory_allocate_temp(sizeof(Gltf_Node), 8);
+        mark = gltf_get_mark();
+        node = (Gltf_Node*)gltf_allocate(sizeof(Gltf_Node), 8);
         *node = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "cameraxxxxxxxxxx", 10) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_NODE_KEYS)) {
+            case GLTF_NODE_KEY_CAMERA:
                 node->camera = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "skinxxxxxxxxxxxx", 12) == 0) {
+            case GLTF_NODE_KEY_SKIN:
                 node->skin = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "meshxxxxxxxxxxxx", 12) == 0) {
+            case GLTF_NODE_KEY_MESH:
                 node->mesh = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "matrixxxxxxxxxxx", 10) == 0) {
+            case GLTF_NODE_KEY_MATRIX:
                 node->matrix = gltf_ascii_to_mat4(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "rotationxxxxxxxx", 8) == 0) {
+            case GLTF_NODE_KEY_ROTATION:
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.rotation = {temp_array[0], temp_array[1], temp_array[2], temp_array[3]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "scalexxxxxxxxxxx", 11) == 0) {
+            case GLTF_NODE_KEY_SCALE:
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.scale = {temp_array[0], temp_array[1], temp_array[2]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "translationxxxxx", 5) == 0) {
+            case GLTF_NODE_KEY_TRANSLATION:
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.translation = {temp_array[0], temp_array[1], temp_array[2]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "childrenxxxxxxxx", 8) == 0) {
+            case GLTF_NODE_KEY_CHILDREN:
                 node->child_count = simd_get_ascii_array_len(data + inc);
-                node->children = (int*)memory_allocate_temp(sizeof(int) * node->child_count, 4);
+                node->children = (int*)gltf_allocate(sizeof(int) * node->child_count, 4);
                 gltf_parse_int_array(data + inc, &inc, node->children);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "weightsxxxxxxxxx", 9) == 0) {
+            case GLTF_NODE_KEY_WEIGHTS:
                 node->weight_count = simd_get_ascii_array_len(data + inc);
-                node->weights = (float*)memory_allocate_temp(sizeof(float) * node->weight_count, 4);
+                node->weights = (float*)gltf_allocate(sizeof(float) * node->weight_count, 4);
                 gltf_parse_float_array(data + inc, &inc, node->weights);
                 continue;
+            default:
+                break;
             }
         }
-        node->stride = align(get_mark_temp() - mark, 8);
+        node->stride = align(gltf_get_mark() - mark, 8);
     }
     *offset += inc;
     *node_count = count;
     return nodes;
 }
 
+enum Gltf_Sampler_Key {
+    GLTF_SAMPLER_KEY_MAG_FILTER,
+    GLTF_SAMPLER_KEY_MIN_FILTER,
+    GLTF_SAMPLER_KEY_WRAP_S,
+    GLTF_SAMPLER_KEY_WRAP_T,
+};
+static constexpr auto GLTF_SAMPLER_KEYS = gltf_make_key_table({"magFilter", "minFilter", "wrapS", "wrapT"});
+
 Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_count) {
     // @MemAlign being dangerous with a 4 align...
-    Gltf_Sampler *samplers = (Gltf_Sampler*)memory_allocate_temp(0, 4);
+    Gltf_Sampler *samplers = (Gltf_Sampler*)gltf_allocate(0, 4);
     Gltf_Sampler *sampler;
 
     u64 inc = 0;
@@ -1705,12 +2540,13 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
     int temp_int;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        sampler = (Gltf_Sampler*)memory_allocate_temp(sizeof(Gltf_Sampler), 4);
+        sampler = (Gltf_Sampler*)gltf_allocate(sizeof(Gltf_Sampler), 4);
         *sampler = {};
         sampler->stride = sizeof(Gltf_Sampler);
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "magFilterxxxxxxx", 7) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_SAMPLER_KEYS)) {
+            case GLTF_SAMPLER_KEY_MAG_FILTER:
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 9728:
@@ -1722,7 +2558,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     ASSERT(false, "This is not a valid filter setting");
                 }
-            } else if (simd_strcmp_short(data + inc, "minFilterxxxxxxx", 7) == 0) {
+                continue;
+            case GLTF_SAMPLER_KEY_MIN_FILTER:
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 9728:
@@ -1746,7 +2583,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     ASSERT(false, "This is not a valid filter setting");
                 }
-            }  else if (simd_strcmp_short(data + inc, "wrapSxxxxxxxxxxx", 11) == 0) {
+                continue;
+            case GLTF_SAMPLER_KEY_WRAP_S:
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 10497:
@@ -1761,7 +2599,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     ASSERT(false, "This is not a valid wrap setting");
                 }
-            }  else if (simd_strcmp_short(data + inc, "wrapTxxxxxxxxxxx", 11) == 0) {
+                continue;
+            case GLTF_SAMPLER_KEY_WRAP_T:
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 10497:
@@ -1776,6 +2615,9 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     ASSERT(false, "This is not a valid wrap setting");
                 }
+                continue;
+            default:
+                break;
             }
         }
     }
@@ -1784,19 +2626,25 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
     return samplers;
 }
 
+enum Gltf_Scene_Key {
+    GLTF_SCENE_KEY_NODES,
+};
+static constexpr auto GLTF_SCENE_KEYS = gltf_make_key_table({"nodes"});
+
 Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
-    Gltf_Scene *scenes = (Gltf_Scene*)memory_allocate_temp(0, 8);
+    Gltf_Scene *scenes = (Gltf_Scene*)gltf_allocate(0, 8);
     Gltf_Scene *scene;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        scene = (Gltf_Scene*)memory_allocate_temp(sizeof(Gltf_Scene), 8);
+        scene = (Gltf_Scene*)gltf_allocate(sizeof(Gltf_Scene), 8);
         *scene = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "nodesxxxxxxxxxxx", 11) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_SCENE_KEYS)) {
+            case GLTF_SCENE_KEY_NODES:
                 // It annoys me that sometimes I have to do look aheads like this. Maybe
                 // I should change the instances of this pattern to just temp allocate for
                 // every array elem, even though they are so small (sizeof int or float); The
@@ -1805,9 +2653,11 @@ Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
                 // really large... (Idk how big nodes get, whether scenes are made up of lots of small
                 // nodes, or a couple big ones. Tbf these are only root nodes so maybe the list isnt that long??)
                 scene->node_count = simd_get_ascii_array_len(data + inc);
-                scene->nodes = (int*)memory_allocate_temp(sizeof(int) * scene->node_count, 4);
+                scene->nodes = (int*)gltf_allocate(sizeof(int) * scene->node_count, 4);
                 gltf_parse_int_array(data + inc, &inc, scene->nodes);
                 continue;
+            default:
+                break;
             }
         }
         scene->stride = align(sizeof(Gltf_Scene) + sizeof(int) * scene->node_count, 8);
@@ -1817,29 +2667,39 @@ Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
     return scenes;
 }
 
+enum Gltf_Skin_Key {
+    GLTF_SKIN_KEY_INVERSE_BIND_MATRICES,
+    GLTF_SKIN_KEY_SKELETON,
+    GLTF_SKIN_KEY_JOINTS,
+};
+static constexpr auto GLTF_SKIN_KEYS = gltf_make_key_table({"inverseBindMatrices", "skeleton", "joints"});
+
 Gltf_Skin* gltf_parse_skins(const char *data, u64 *offset, int *skin_count) {
-    Gltf_Skin *skins = (Gltf_Skin*)memory_allocate_temp(0, 8);
+    Gltf_Skin *skins = (Gltf_Skin*)gltf_allocate(0, 8);
     Gltf_Skin *skin;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        skin = (Gltf_Skin*)memory_allocate_temp(sizeof(Gltf_Skin), 8);
+        skin = (Gltf_Skin*)gltf_allocate(sizeof(Gltf_Skin), 8);
         *skin = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_long(data + inc, "inverseBindMatricesxxxxxxxxxxxxxxxxxxxxx", 13) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_SKIN_KEYS)) {
+            case GLTF_SKIN_KEY_INVERSE_BIND_MATRICES:
                 skin->inverse_bind_matrices = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "skeletonxxxxxxxx", 8) == 0) {
+            case GLTF_SKIN_KEY_SKELETON:
                 skin->skeleton = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "jointsxxxxxxxxxx", 10) == 0) {
+            case GLTF_SKIN_KEY_JOINTS:
                 skin->joint_count = simd_get_ascii_array_len(data + inc);
-                skin->joints = (int*)memory_allocate_temp(sizeof(int) * skin->joint_count, 4);
+                skin->joints = (int*)gltf_allocate(sizeof(int) * skin->joint_count, 4);
                 gltf_parse_int_array(data + inc, &inc, skin->joints);
                 continue;
+            default:
+                break;
             }
         }
         skin->stride = align(sizeof(Gltf_Skin) + skin->joint_count * sizeof(int), 8);
@@ -1849,25 +2709,34 @@ Gltf_Skin* gltf_parse_skins(const char *data, u64 *offset, int *skin_count) {
     return skins;
 }
 
+enum Gltf_Texture_Key {
+    GLTF_TEXTURE_KEY_SAMPLER,
+    GLTF_TEXTURE_KEY_SOURCE,
+};
+static constexpr auto GLTF_TEXTURE_KEYS = gltf_make_key_table({"sampler", "source"});
+
 Gltf_Texture* gltf_parse_textures(const char *data, u64 *offset, int *texture_count) {
-    Gltf_Texture *textures = (Gltf_Texture*)memory_allocate_temp(0, 4);
+    Gltf_Texture *textures = (Gltf_Texture*)gltf_allocate(0, 4);
     Gltf_Texture *texture;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        texture = (Gltf_Texture*)memory_allocate_temp(sizeof(Gltf_Texture), 4);
+        texture = (Gltf_Texture*)gltf_allocate(sizeof(Gltf_Texture), 4);
         *texture = {};
         texture->stride = sizeof(Gltf_Texture);
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "samplerxxxxxxxxx", 9) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_TEXTURE_KEYS)) {
+            case GLTF_TEXTURE_KEY_SAMPLER:
                 texture->sampler = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "sourcexxxxxxxxxx", 10) == 0) {
+            case GLTF_TEXTURE_KEY_SOURCE:
                 texture->source_image = gltf_ascii_to_int(data + inc, &inc);
                 continue;
+            default:
+                break;
             }
         }
     }
@@ -1956,6 +2825,688 @@ int gltf_texture_get_count(Gltf *gltf) {
     return gltf->texture_count[-1];
 }
 
+// `Compact
+//
+// Two walks over the parsed Gltf: the first sizes the pools, the second copies everything out. The layout
+// is run once against a null base to get the allocation size, and once more to hand out the real pointers.
+//
+template<typename T>
+static inline T* gltf_compact_carve(u8 *base, u64 *size, int count) {
+    T *ret = (T*)((u64)base + *size);
+    *size += align(sizeof(T) * count, 8);
+    return ret;
+}
+
+static u64 gltf_compact_layout(Gltf_Compact *c, u8 *base) {
+    u64 size = 0;
+    int count;
+
+    count = c->accessor_count;
+    c->accessors.format      = gltf_compact_carve<Gltf_Accessor_Format>(base, &size, count);
+    c->accessors.buffer_view = gltf_compact_carve<int>(base, &size, count);
+    c->accessors.byte_stride = gltf_compact_carve<int>(base, &size, count);
+    c->accessors.normalized  = gltf_compact_carve<int>(base, &size, count);
+    c->accessors.count       = gltf_compact_carve<int>(base, &size, count);
+    c->accessors.sparse      = gltf_compact_carve<int>(base, &size, count);
+    c->accessors.byte_offset = gltf_compact_carve<u64>(base, &size, count);
+    c->accessors.bounds      = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->animation_count;
+    c->animations.channels = gltf_compact_carve<Gltf_Range>(base, &size, count);
+    c->animations.samplers = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->buffer_count;
+    c->buffers.byte_length = gltf_compact_carve<u64>(base, &size, count);
+    c->buffers.uri         = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->buffer_view_count;
+    c->buffer_views.buffer      = gltf_compact_carve<int>(base, &size, count);
+    c->buffer_views.byte_stride = gltf_compact_carve<int>(base, &size, count);
+    c->buffer_views.byte_offset = gltf_compact_carve<u64>(base, &size, count);
+    c->buffer_views.byte_length = gltf_compact_carve<u64>(base, &size, count);
+
+    count = c->image_count;
+    c->images.jpeg        = gltf_compact_carve<int>(base, &size, count);
+    c->images.buffer_view = gltf_compact_carve<int>(base, &size, count);
+    c->images.uri         = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->mesh_count;
+    c->meshes.primitives = gltf_compact_carve<Gltf_Range>(base, &size, count);
+    c->meshes.weights    = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->primitive_count;
+    c->primitives.indices          = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.material         = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.topology         = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.position         = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.normal           = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.tangent          = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.tex_coord_0      = gltf_compact_carve<int>(base, &size, count);
+    c->primitives.extra_attributes = gltf_compact_carve<Gltf_Range>(base, &size, count);
+    c->primitives.targets          = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    count = c->node_count;
+    c->nodes.camera    = gltf_compact_carve<int>(base, &size, count);
+    c->nodes.skin      = gltf_compact_carve<int>(base, &size, count);
+    c->nodes.mesh      = gltf_compact_carve<int>(base, &size, count);
+    c->nodes.children  = gltf_compact_carve<Gltf_Range>(base, &size, count);
+    c->nodes.weights   = gltf_compact_carve<Gltf_Range>(base, &size, count);
+    c->nodes.transform = gltf_compact_carve<Mat4>(base, &size, count);
+
+    count = c->skin_count;
+    c->skins.inverse_bind_matrices = gltf_compact_carve<int>(base, &size, count);
+    c->skins.skeleton              = gltf_compact_carve<int>(base, &size, count);
+    c->skins.joints                = gltf_compact_carve<Gltf_Range>(base, &size, count);
+
+    c->scenes = gltf_compact_carve<Gltf_Range>(base, &size, c->scene_count);
+
+    c->cameras   = gltf_compact_carve<Gltf_Camera>  (base, &size, c->camera_count);
+    c->materials = gltf_compact_carve<Gltf_Material>(base, &size, c->material_count);
+    c->samplers  = gltf_compact_carve<Gltf_Sampler> (base, &size, c->sampler_count);
+    c->textures  = gltf_compact_carve<Gltf_Texture> (base, &size, c->texture_count);
+
+    c->sparse             = gltf_compact_carve<Gltf_Compact_Sparse>   (base, &size, c->sparse_count);
+    c->ints               = gltf_compact_carve<int>                   (base, &size, c->int_count);
+    c->floats             = gltf_compact_carve<float>                 (base, &size, c->float_count);
+    c->attributes         = gltf_compact_carve<Gltf_Mesh_Attribute>   (base, &size, c->attribute_count);
+    c->targets            = gltf_compact_carve<Gltf_Range>            (base, &size, c->target_count);
+    c->channels           = gltf_compact_carve<Gltf_Animation_Channel>(base, &size, c->channel_count);
+    c->animation_samplers = gltf_compact_carve<Gltf_Animation_Sampler>(base, &size, c->animation_sampler_count);
+    c->strings            = gltf_compact_carve<char>                  (base, &size, c->string_size);
+
+    return size;
+}
+
+// Max and min are allocated together in the accessor's stride: 2 * len floats, which is always a multiple
+// of 8 bytes, so the length falls straight out of the stride.
+static inline int gltf_accessor_bounds_len(Gltf_Accessor *accessor) {
+    return accessor->max ? (accessor->stride - (int)sizeof(Gltf_Accessor)) / 8 : 0;
+}
+
+static inline Gltf_Range gltf_compact_push_string(Gltf_Compact *c, const char *string, int *string_size) {
+    if (!string)
+        return {-1, 0};
+    Gltf_Range ret = {*string_size, (int)strlen(string)};
+    memcpy(c->strings + ret.offset, string, ret.count + 1);
+    *string_size += ret.count + 1;
+    return ret;
+}
+
+Gltf_Compact gltf_compact(Gltf *gltf) {
+    Gltf_Compact c = {};
+    c.scene             = gltf->scene;
+    c.accessor_count    = gltf_accessor_get_count(gltf);
+    c.animation_count   = gltf_animation_get_count(gltf);
+    c.buffer_count      = gltf_buffer_get_count(gltf);
+    c.buffer_view_count = gltf_buffer_view_get_count(gltf);
+    c.camera_count      = gltf_camera_get_count(gltf);
+    c.image_count       = gltf_image_get_count(gltf);
+    c.material_count    = gltf_material_get_count(gltf);
+    c.mesh_count        = gltf_mesh_get_count(gltf);
+    c.node_count        = gltf_node_get_count(gltf);
+    c.sampler_count     = gltf_sampler_get_count(gltf);
+    c.scene_count       = gltf_scene_get_count(gltf);
+    c.skin_count        = gltf_skin_get_count(gltf);
+    c.texture_count     = gltf_texture_get_count(gltf);
+
+    //
+    // Size the pools
+    //
+    Gltf_Accessor *accessor = gltf->accessors;
+    for(int i = 0; i < c.accessor_count; ++i) {
+        c.sparse_count += accessor->sparse_count > 0;
+        c.float_count  += gltf_accessor_bounds_len(accessor) * 2;
+        accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+    }
+    Gltf_Animation *animation = gltf->animations;
+    for(int i = 0; i < c.animation_count; ++i) {
+        c.channel_count           += animation->channel_count;
+        c.animation_sampler_count += animation->sampler_count;
+        animation = (Gltf_Animation*)((u8*)animation + animation->stride);
+    }
+    Gltf_Buffer *buffer = gltf->buffers;
+    for(int i = 0; i < c.buffer_count; ++i) {
+        c.string_size += buffer->uri ? strlen(buffer->uri) + 1 : 0;
+        buffer = (Gltf_Buffer*)((u8*)buffer + buffer->stride);
+    }
+    Gltf_Image *image = gltf->images;
+    for(int i = 0; i < c.image_count; ++i) {
+        c.string_size += image->uri ? strlen(image->uri) + 1 : 0;
+        image = (Gltf_Image*)((u8*)image + image->stride);
+    }
+    Gltf_Mesh *mesh = gltf->meshes;
+    Gltf_Mesh_Primitive *primitive;
+    Gltf_Morph_Target *target;
+    for(int i = 0; i < c.mesh_count; ++i) {
+        c.primitive_count += mesh->primitive_count;
+        c.float_count     += mesh->weight_count;
+
+        primitive = mesh->primitives;
+        for(int j = 0; j < mesh->primitive_count; ++j) {
+            c.attribute_count += primitive->extra_attribute_count;
+            c.target_count    += primitive->target_count;
+
+            target = primitive->targets;
+            for(int k = 0; k < primitive->target_count; ++k) {
+                c.attribute_count += target->attribute_count;
+                target = (Gltf_Morph_Target*)((u8*)target + target->stride);
+            }
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    }
+    Gltf_Node *node = gltf->nodes;
+    for(int i = 0; i < c.node_count; ++i) {
+        c.int_count   += node->child_count;
+        c.float_count += node->weight_count;
+        node = (Gltf_Node*)((u8*)node + node->stride);
+    }
+    Gltf_Scene *scene = gltf->scenes;
+    for(int i = 0; i < c.scene_count; ++i) {
+        c.int_count += scene->node_count;
+        scene = (Gltf_Scene*)((u8*)scene + scene->stride);
+    }
+    Gltf_Skin *skin = gltf->skins;
+    for(int i = 0; i < c.skin_count; ++i) {
+        c.int_count += skin->joint_count;
+        skin = (Gltf_Skin*)((u8*)skin + skin->stride);
+    }
+
+    c.size   = gltf_compact_layout(&c, NULL);
+    c.memory = memory_allocate_heap(c.size, 8);
+    gltf_compact_layout(&c, (u8*)c.memory);
+
+    //
+    // Copy out
+    //
+    int sparse_count = 0;
+    int int_count    = 0;
+    int float_count  = 0;
+    int string_size  = 0;
+    int len;
+
+    accessor = gltf->accessors;
+    for(int i = 0; i < c.accessor_count; ++i) {
+        c.accessors.format[i]      = accessor->format;
+        c.accessors.buffer_view[i] = accessor->buffer_view;
+        c.accessors.byte_stride[i] = accessor->byte_stride;
+        c.accessors.normalized[i]  = accessor->normalized;
+        c.accessors.count[i]       = accessor->count;
+        c.accessors.byte_offset[i] = accessor->byte_offset;
+
+        if (accessor->sparse_count > 0) {
+            c.sparse[sparse_count] = {
+                .count                  = accessor->sparse_count,
+                .indices_buffer_view    = accessor->indices_buffer_view,
+                .values_buffer_view     = accessor->values_buffer_view,
+                .indices_component_type = accessor->indices_component_type,
+                .indices_byte_offset    = accessor->indices_byte_offset,
+                .values_byte_offset     = accessor->values_byte_offset,
+            };
+            c.accessors.sparse[i] = sparse_count;
+            sparse_count++;
+        } else {
+            c.accessors.sparse[i] = -1;
+        }
+
+        len = gltf_accessor_bounds_len(accessor);
+        c.accessors.bounds[i] = {float_count, len};
+        if (len) {
+            memcpy(c.floats + float_count,       accessor->max, sizeof(float) * len);
+            memcpy(c.floats + float_count + len, accessor->min, sizeof(float) * len);
+        }
+        float_count += len * 2;
+
+        accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+    }
+
+    int channel_count = 0;
+    int sampler_count = 0;
+    animation = gltf->animations;
+    for(int i = 0; i < c.animation_count; ++i) {
+        c.animations.channels[i] = {channel_count, animation->channel_count};
+        c.animations.samplers[i] = {sampler_count, animation->sampler_count};
+        memcpy(c.channels + channel_count, animation->channels,
+               sizeof(Gltf_Animation_Channel) * animation->channel_count);
+        memcpy(c.animation_samplers + sampler_count, animation->samplers,
+               sizeof(Gltf_Animation_Sampler) * animation->sampler_count);
+        channel_count += animation->channel_count;
+        sampler_count += animation->sampler_count;
+        animation = (Gltf_Animation*)((u8*)animation + animation->stride);
+    }
+
+    buffer = gltf->buffers;
+    for(int i = 0; i < c.buffer_count; ++i) {
+        c.buffers.byte_length[i] = buffer->byte_length;
+        c.buffers.uri[i]         = gltf_compact_push_string(&c, buffer->uri, &string_size);
+        buffer = (Gltf_Buffer*)((u8*)buffer + buffer->stride);
+    }
+
+    Gltf_Buffer_View *buffer_view = gltf->buffer_views;
+    for(int i = 0; i < c.buffer_view_count; ++i) {
+        c.buffer_views.buffer[i]      = buffer_view->buffer;
+        c.buffer_views.byte_stride[i] = buffer_view->byte_stride;
+        c.buffer_views.byte_offset[i] = buffer_view->byte_offset;
+        c.buffer_views.byte_length[i] = buffer_view->byte_length;
+        buffer_view = (Gltf_Buffer_View*)((u8*)buffer_view + buffer_view->stride);
+    }
+
+    image = gltf->images;
+    for(int i = 0; i < c.image_count; ++i) {
+        c.images.jpeg[i]        = image->jpeg;
+        c.images.buffer_view[i] = image->buffer_view;
+        c.images.uri[i]         = gltf_compact_push_string(&c, image->uri, &string_size);
+        image = (Gltf_Image*)((u8*)image + image->stride);
+    }
+
+    int primitive_count = 0;
+    int attribute_count = 0;
+    int target_count    = 0;
+    mesh = gltf->meshes;
+    for(int i = 0; i < c.mesh_count; ++i) {
+        c.meshes.primitives[i] = {primitive_count, mesh->primitive_count};
+        c.meshes.weights[i]    = {float_count,     mesh->weight_count};
+        memcpy(c.floats + float_count, mesh->weights, sizeof(float) * mesh->weight_count);
+        float_count += mesh->weight_count;
+
+        primitive = mesh->primitives;
+        for(int j = 0; j < mesh->primitive_count; ++j) {
+            c.primitives.indices[primitive_count]     = primitive->indices;
+            c.primitives.material[primitive_count]    = primitive->material;
+            c.primitives.topology[primitive_count]    = primitive->topology;
+            c.primitives.position[primitive_count]    = primitive->position;
+            c.primitives.normal[primitive_count]      = primitive->normal;
+            c.primitives.tangent[primitive_count]     = primitive->tangent;
+            c.primitives.tex_coord_0[primitive_count] = primitive->tex_coord_0;
+
+            c.primitives.extra_attributes[primitive_count] = {attribute_count, primitive->extra_attribute_count};
+            memcpy(c.attributes + attribute_count, primitive->extra_attributes,
+                   sizeof(Gltf_Mesh_Attribute) * primitive->extra_attribute_count);
+            attribute_count += primitive->extra_attribute_count;
+
+            c.primitives.targets[primitive_count] = {target_count, primitive->target_count};
+            target = primitive->targets;
+            for(int k = 0; k < primitive->target_count; ++k) {
+                c.targets[target_count] = {attribute_count, target->attribute_count};
+                memcpy(c.attributes + attribute_count, target->attributes,
+                       sizeof(Gltf_Mesh_Attribute) * target->attribute_count);
+                attribute_count += target->attribute_count;
+                target_count++;
+                target = (Gltf_Morph_Target*)((u8*)target + target->stride);
+            }
+
+            primitive_count++;
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    }
+
+    node = gltf->nodes;
+    for(int i = 0; i < c.node_count; ++i) {
+        c.nodes.camera[i] = node->camera;
+        c.nodes.skin[i]   = node->skin;
+        c.nodes.mesh[i]   = node->mesh;
+        memcpy(&c.nodes.transform[i], &node->matrix, sizeof(Mat4));
+
+        c.nodes.children[i] = {int_count, node->child_count};
+        memcpy(c.ints + int_count, node->children, sizeof(int) * node->child_count);
+        int_count += node->child_count;
+
+        c.nodes.weights[i] = {float_count, node->weight_count};
+        memcpy(c.floats + float_count, node->weights, sizeof(float) * node->weight_count);
+        float_count += node->weight_count;
+
+        node = (Gltf_Node*)((u8*)node + node->stride);
+    }
+
+    scene = gltf->scenes;
+    for(int i = 0; i < c.scene_count; ++i) {
+        c.scenes[i] = {int_count, scene->node_count};
+        memcpy(c.ints + int_count, scene->nodes, sizeof(int) * scene->node_count);
+        int_count += scene->node_count;
+        scene = (Gltf_Scene*)((u8*)scene + scene->stride);
+    }
+
+    skin = gltf->skins;
+    for(int i = 0; i < c.skin_count; ++i) {
+        c.skins.inverse_bind_matrices[i] = skin->inverse_bind_matrices;
+        c.skins.skeleton[i]              = skin->skeleton;
+        c.skins.joints[i]                = {int_count, skin->joint_count};
+        memcpy(c.ints + int_count, skin->joints, sizeof(int) * skin->joint_count);
+        int_count += skin->joint_count;
+        skin = (Gltf_Skin*)((u8*)skin + skin->stride);
+    }
+
+    for(int i = 0; i < c.camera_count; ++i)
+        c.cameras[i] = *gltf_camera_by_index(gltf, i);
+    for(int i = 0; i < c.material_count; ++i)
+        c.materials[i] = *gltf_material_by_index(gltf, i);
+    for(int i = 0; i < c.sampler_count; ++i)
+        c.samplers[i] = *gltf_sampler_by_index(gltf, i);
+    for(int i = 0; i < c.texture_count; ++i)
+        c.textures[i] = *gltf_texture_by_index(gltf, i);
+
+    return c;
+}
+
+void gltf_free_compact(Gltf_Compact *compact) {
+    memory_free_heap(compact->memory);
+    *compact = {};
+}
+
+// `Baking
+//
+// Blob layout: header, then for each section (accessors, animations, ...) its count/offset array and its
+// records. The records are copied exactly as the parser packed them: nested data (accessor->max,
+// mesh->primitives, buffer->uri etc.) is allocated inside its owner's stride, so a section is one run of
+// bytes. Pointers inside the records are written as offsets from the start of the blob (0 is NULL, as the
+// header sits there), and loading only has to add the address of the mapping back to them.
+//
+static constexpr u32 GLTF_BAKE_MAGIC         = 0x4b424c47; // 'GLBK'
+static constexpr int GLTF_BAKE_SECTION_COUNT = 13;
+
+struct Gltf_Bake_Section {
+    u64 counts;  // offset of the count/offset array (count at [0], so Gltf.X_count = counts + 1)
+    u64 records; // offset of the packed records
+    u64 size;    // byte size of the packed records
+};
+struct Gltf_Bake_Header {
+    u32 magic;
+    u32 version;
+    u64 source_hash;
+    u64 size;
+    int scene;
+    int pad;
+    Gltf_Bake_Section sections[GLTF_BAKE_SECTION_COUNT];
+};
+
+enum Gltf_Bake_Section_Type {
+    GLTF_BAKE_SECTION_ACCESSORS,
+    GLTF_BAKE_SECTION_ANIMATIONS,
+    GLTF_BAKE_SECTION_BUFFERS,
+    GLTF_BAKE_SECTION_BUFFER_VIEWS,
+    GLTF_BAKE_SECTION_CAMERAS,
+    GLTF_BAKE_SECTION_IMAGES,
+    GLTF_BAKE_SECTION_MATERIALS,
+    GLTF_BAKE_SECTION_MESHES,
+    GLTF_BAKE_SECTION_NODES,
+    GLTF_BAKE_SECTION_SAMPLERS,
+    GLTF_BAKE_SECTION_SCENES,
+    GLTF_BAKE_SECTION_SKINS,
+    GLTF_BAKE_SECTION_TEXTURES,
+};
+
+// Not every record has its stride as its first member
+static constexpr u64 GLTF_BAKE_STRIDE_OFFSETS[GLTF_BAKE_SECTION_COUNT] = {
+    offsetof(Gltf_Accessor,    stride),
+    offsetof(Gltf_Animation,   stride),
+    offsetof(Gltf_Buffer,      stride),
+    offsetof(Gltf_Buffer_View, stride),
+    offsetof(Gltf_Camera,      stride),
+    offsetof(Gltf_Image,       stride),
+    offsetof(Gltf_Material,    stride),
+    offsetof(Gltf_Mesh,        stride),
+    offsetof(Gltf_Node,        stride),
+    offsetof(Gltf_Sampler,     stride),
+    offsetof(Gltf_Scene,       stride),
+    offsetof(Gltf_Skin,        stride),
+    offsetof(Gltf_Texture,     stride),
+};
+
+static void gltf_bake_get_sections(Gltf *gltf, int ***counts, void ***records) {
+    counts[GLTF_BAKE_SECTION_ACCESSORS]    = &gltf->accessor_count;
+    counts[GLTF_BAKE_SECTION_ANIMATIONS]   = &gltf->animation_count;
+    counts[GLTF_BAKE_SECTION_BUFFERS]      = &gltf->buffer_count;
+    counts[GLTF_BAKE_SECTION_BUFFER_VIEWS] = &gltf->buffer_view_count;
+    counts[GLTF_BAKE_SECTION_CAMERAS]      = &gltf->camera_count;
+    counts[GLTF_BAKE_SECTION_IMAGES]       = &gltf->image_count;
+    counts[GLTF_BAKE_SECTION_MATERIALS]    = &gltf->material_count;
+    counts[GLTF_BAKE_SECTION_MESHES]       = &gltf->mesh_count;
+    counts[GLTF_BAKE_SECTION_NODES]        = &gltf->node_count;
+    counts[GLTF_BAKE_SECTION_SAMPLERS]     = &gltf->sampler_count;
+    counts[GLTF_BAKE_SECTION_SCENES]       = &gltf->scene_count;
+    counts[GLTF_BAKE_SECTION_SKINS]        = &gltf->skin_count;
+    counts[GLTF_BAKE_SECTION_TEXTURES]     = &gltf->texture_count;
+
+    records[GLTF_BAKE_SECTION_ACCESSORS]    = (void**)&gltf->accessors;
+    records[GLTF_BAKE_SECTION_ANIMATIONS]   = (void**)&gltf->animations;
+    records[GLTF_BAKE_SECTION_BUFFERS]      = (void**)&gltf->buffers;
+    records[GLTF_BAKE_SECTION_BUFFER_VIEWS] = (void**)&gltf->buffer_views;
+    records[GLTF_BAKE_SECTION_CAMERAS]      = (void**)&gltf->cameras;
+    records[GLTF_BAKE_SECTION_IMAGES]       = (void**)&gltf->images;
+    records[GLTF_BAKE_SECTION_MATERIALS]    = (void**)&gltf->materials;
+    records[GLTF_BAKE_SECTION_MESHES]       = (void**)&gltf->meshes;
+    records[GLTF_BAKE_SECTION_NODES]        = (void**)&gltf->nodes;
+    records[GLTF_BAKE_SECTION_SAMPLERS]     = (void**)&gltf->samplers;
+    records[GLTF_BAKE_SECTION_SCENES]       = (void**)&gltf->scenes;
+    records[GLTF_BAKE_SECTION_SKINS]        = (void**)&gltf->skins;
+    records[GLTF_BAKE_SECTION_TEXTURES]     = (void**)&gltf->textures;
+}
+
+//
+// Add 'delta' to a non-null pointer field, and return where the data it points to currently lives
+// (the new value + 'bias'), so that nested records can be walked.
+//     Writing: delta = section offset in blob - section address in temp, bias = blob address
+//     Loading: delta = blob address, bias = 0
+//
+static inline void* gltf_bake_relocate(void *field, u64 delta, u64 bias) {
+    u64 ptr;
+    memcpy(&ptr, field, sizeof(ptr));
+    if (!ptr)
+        return NULL;
+    ptr += delta;
+    memcpy(field, &ptr, sizeof(ptr));
+    return (void*)(ptr + bias);
+}
+
+static void gltf_bake_relocate_section(int section, void *records, int count, u64 delta, u64 bias) {
+    switch(section) {
+    case GLTF_BAKE_SECTION_ACCESSORS:
+    {
+        Gltf_Accessor *accessor = (Gltf_Accessor*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&accessor->max, delta, bias);
+            gltf_bake_relocate(&accessor->min, delta, bias);
+            accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_ANIMATIONS:
+    {
+        Gltf_Animation *animation = (Gltf_Animation*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&animation->channels, delta, bias);
+            gltf_bake_relocate(&animation->samplers, delta, bias);
+            animation = (Gltf_Animation*)((u8*)animation + animation->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_BUFFERS:
+    {
+        Gltf_Buffer *buffer = (Gltf_Buffer*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&buffer->uri, delta, bias);
+            buffer = (Gltf_Buffer*)((u8*)buffer + buffer->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_IMAGES:
+    {
+        Gltf_Image *image = (Gltf_Image*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&image->uri, delta, bias);
+            image = (Gltf_Image*)((u8*)image + image->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_MESHES:
+    {
+        Gltf_Mesh *mesh = (Gltf_Mesh*)records;
+        Gltf_Mesh_Primitive *primitive;
+        Gltf_Morph_Target *target;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&mesh->weights, delta, bias);
+
+            primitive = (Gltf_Mesh_Primitive*)gltf_bake_relocate(&mesh->primitives, delta, bias);
+            for(int j = 0; j < mesh->primitive_count; ++j) {
+                gltf_bake_relocate(&primitive->extra_attributes, delta, bias);
+
+                target = (Gltf_Morph_Target*)gltf_bake_relocate(&primitive->targets, delta, bias);
+                for(int k = 0; k < primitive->target_count; ++k) {
+                    gltf_bake_relocate(&target->attributes, delta, bias);
+                    target = (Gltf_Morph_Target*)((u8*)target + target->stride);
+                }
+                primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+            }
+            mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_NODES:
+    {
+        Gltf_Node *node = (Gltf_Node*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&node->children, delta, bias);
+            gltf_bake_relocate(&node->weights,  delta, bias);
+            node = (Gltf_Node*)((u8*)node + node->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_SCENES:
+    {
+        Gltf_Scene *scene = (Gltf_Scene*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&scene->nodes, delta, bias);
+            scene = (Gltf_Scene*)((u8*)scene + scene->stride);
+        }
+        break;
+    }
+    case GLTF_BAKE_SECTION_SKINS:
+    {
+        Gltf_Skin *skin = (Gltf_Skin*)records;
+        for(int i = 0; i < count; ++i) {
+            gltf_bake_relocate(&skin->joints, delta, bias);
+            skin = (Gltf_Skin*)((u8*)skin + skin->stride);
+        }
+        break;
+    }
+    default:
+        break; // no pointers
+    }
+}
+
+bool gltf_write_baked(Gltf *gltf, u64 source_hash, const char *bake_file_name) {
+    int  **counts[GLTF_BAKE_SECTION_COUNT];
+    void **records[GLTF_BAKE_SECTION_COUNT];
+    gltf_bake_get_sections(gltf, counts, records);
+
+    Gltf_Bake_Header header = {};
+    header.magic       = GLTF_BAKE_MAGIC;
+    header.version     = GLTF_BAKE_VERSION;
+    header.source_hash = source_hash;
+    header.scene       = gltf->scene;
+
+    u64 size = align(sizeof(Gltf_Bake_Header), 8);
+    int count;
+    int last_stride;
+    for(int i = 0; i < GLTF_BAKE_SECTION_COUNT; ++i) {
+        count = (*counts[i])[-1];
+        header.sections[i].counts = size;
+        size += align(sizeof(int) * (count + 1), 8);
+
+        if (count) {
+            memcpy(&last_stride, (u8*)*records[i] + (*counts[i])[count - 1] + GLTF_BAKE_STRIDE_OFFSETS[i], sizeof(int));
+            header.sections[i].size = (*counts[i])[count - 1] + last_stride;
+        }
+        header.sections[i].records = size;
+        size += align(header.sections[i].size, 8);
+    }
+    header.size = size;
+
+    u8 *blob = memory_allocate_heap(size, 8);
+    memset(blob, 0, size);
+    memcpy(blob, &header, sizeof(header));
+
+    u8 *section_records;
+    for(int i = 0; i < GLTF_BAKE_SECTION_COUNT; ++i) {
+        count = (*counts[i])[-1];
+        memcpy(blob + header.sections[i].counts, *counts[i] - 1, sizeof(int) * (count + 1));
+
+        section_records = blob + header.sections[i].records;
+        memcpy(section_records, *records[i], header.sections[i].size);
+        gltf_bake_relocate_section(i, section_records, count,
+                header.sections[i].records - (u64)*records[i], (u64)blob);
+    }
+
+    FILE *file = fopen(bake_file_name, "wb");
+    if (!file) {
+        memory_free_heap(blob);
+        return false;
+    }
+    u64 written = fwrite(blob, 1, size, file);
+    fclose(file);
+    memory_free_heap(blob);
+
+    return written == size;
+}
+
+bool gltf_map_baked(const char *bake_file_name, u64 source_hash, Gltf_Baked *baked) {
+    u64 size;
+    u8 *blob = file_map_private(bake_file_name, &size);
+    if (!blob)
+        return false;
+
+    Gltf_Bake_Header *header = (Gltf_Bake_Header*)blob;
+    if (size < sizeof(Gltf_Bake_Header)     ||
+        header->magic       != GLTF_BAKE_MAGIC   ||
+        header->version     != GLTF_BAKE_VERSION ||
+        header->source_hash != source_hash       ||
+        header->size        != size)
+    {
+        file_unmap(blob, size);
+        return false;
+    }
+
+    *baked = {};
+    baked->map  = blob;
+    baked->size = size;
+    baked->gltf.scene = header->scene;
+
+    int  **counts[GLTF_BAKE_SECTION_COUNT];
+    void **records[GLTF_BAKE_SECTION_COUNT];
+    gltf_bake_get_sections(&baked->gltf, counts, records);
+
+    for(int i = 0; i < GLTF_BAKE_SECTION_COUNT; ++i) {
+        *counts[i]  = (int*)(blob + header->sections[i].counts) + 1;
+        *records[i] = blob + header->sections[i].records;
+        gltf_bake_relocate_section(i, *records[i], (*counts[i])[-1], (u64)blob, 0);
+    }
+    return true;
+}
+
+Gltf_Baked gltf_load_or_bake(const char *gltf_file_name, const char *bake_file_name) {
+    u64 mark = get_mark_temp();
+    u64 size;
+    const u8 *source = file_read_bin_temp(gltf_file_name, &size);
+    u64 source_hash = wyhash(source, size, 0, _wyp);
+    reset_to_mark_temp(mark);
+
+    Gltf_Baked ret = {};
+    if (gltf_map_baked(bake_file_name, source_hash, &ret))
+        return ret;
+
+    ret.gltf = parse_gltf(gltf_file_name);
+    if (!gltf_write_baked(&ret.gltf, source_hash, bake_file_name))
+        println("Failed to write baked gltf %c", bake_file_name);
+
+    return ret;
+}
+void gltf_unload_baked(Gltf_Baked *baked) {
+    if (baked->map)
+        file_unmap(baked->map, baked->size);
+    *baked = {};
+}
+
 #if TEST
 static void test_accessors(Gltf_Accessor *accessor);
 static void test_animations(Gltf_Animation *animation);
@@ -1970,6 +3521,11 @@ static void test_samplers(Gltf_Sampler *samplers);
 static void test_scenes(Gltf_Scene *scenes);
 static void test_skins(Gltf_Skin *skins);
 static void test_textures(Gltf_Texture *textures);
+static void test_key_dispatch();
+static void test_baked();
+static void test_compact(Gltf *gltf);
+static void test_streamed(Gltf *gltf);
+static void test_sparse();
 
 void test_gltf() {
     Gltf gltf = parse_gltf("test_gltf.gltf");
@@ -2000,6 +3556,11 @@ void test_gltf() {
     ASSERT(gltf.skin_count[-1] == 4, "Incorrect Skin Count");
     test_textures(gltf.textures);
     ASSERT(gltf.texture_count[-1] == 4, "Incorrect Texture Count");
+    test_key_dispatch();
+    test_baked();
+    test_compact(&gltf);
+    test_streamed(&gltf);
+    test_sparse();
 
     BEGIN_TEST_MODULE("Gltf_Indexing", true, false);
 
@@ -2599,6 +4160,332 @@ void test_textures(Gltf_Texture *textures) {
 
     END_TEST_MODULE();
 }
+static void test_baked() {
+    BEGIN_TEST_MODULE("Gltf_Baked", true, false);
+
+    const char *bake_file_name = "test_gltf.gltf.bake";
+    remove(bake_file_name);
+
+    // first load has nothing to map, so it parses and writes the bake; the second maps it
+    Gltf_Baked parsed = gltf_load_or_bake("test_gltf.gltf", bake_file_name);
+    Gltf_Baked mapped = gltf_load_or_bake("test_gltf.gltf", bake_file_name);
+    TEST_EQ("parsed.map", parsed.map == NULL, true, false);
+    TEST_EQ("mapped.map", mapped.map != NULL, true, false);
+
+    // a different source hash must not map
+    Gltf_Baked stale;
+    TEST_EQ("stale hash", gltf_map_baked(bake_file_name, 0, &stale), false, false);
+
+    Gltf *gltf = &mapped.gltf;
+    TEST_EQ("scene",             gltf->scene,             parsed.gltf.scene, false);
+    TEST_EQ("accessor_count",    gltf->accessor_count[-1],    3, false);
+    TEST_EQ("animation_count",   gltf->animation_count[-1],   4, false);
+    TEST_EQ("buffer_count",      gltf->buffer_count[-1],      5, false);
+    TEST_EQ("buffer_view_count", gltf->buffer_view_count[-1], 4, false);
+    TEST_EQ("mesh_count",        gltf->mesh_count[-1],        2, false);
+    TEST_EQ("node_count",        gltf->node_count[-1],        7, false);
+    TEST_EQ("skin_count",        gltf->skin_count[-1],        4, false);
+    TEST_EQ("texture_count",     gltf->texture_count[-1],     4, false);
+
+    Gltf_Accessor *accessor = gltf_accessor_by_index(gltf, 0);
+    TEST_EQ("accessor[0].max[0]", accessor->max[0], 4212, false);
+    accessor = gltf_accessor_by_index(gltf, 2);
+    TEST_EQ("accessor[2].values_byte_offset", accessor->values_byte_offset, (u64)9999, false);
+
+    TEST_STREQ("buffers[0].uri", gltf_buffer_by_index(gltf, 0)->uri, "duck1.bin", false);
+
+    Gltf_Animation *animation = gltf_animation_by_index(gltf, 3);
+    TEST_EQ("animation[3].channels[1].target_node", animation->channels[1].target_node, 36, false);
+    TEST_EQ("animation[3].samplers[0].input",       animation->samplers[0].input,      999, false);
+
+    Gltf_Mesh *mesh = gltf_mesh_by_index(gltf, 0);
+    TEST_FEQ("meshes[0].weights[1]", mesh->weights[1], 0.5, false);
+    Gltf_Mesh_Primitive *primitive = (Gltf_Mesh_Primitive*)((u8*)mesh->primitives + mesh->primitives->stride);
+    TEST_EQ("meshes[0].primitives[1].indices", primitive->indices, 31, false);
+    Gltf_Morph_Target *target = (Gltf_Morph_Target*)((u8*)primitive->targets + primitive->targets->stride);
+    TEST_EQ("meshes[0].primitives[1].targets[1].attributes[2].accessor_index",
+            target->attributes[2].accessor_index, 44, false);
+
+    Gltf_Node *node = gltf_node_by_index(gltf, 0);
+    TEST_FEQ("nodes[0].weights[3]", node->weights[3], 0.8, false);
+
+    Gltf_Skin *skin = gltf_skin_by_index(gltf, 3);
+    TEST_EQ("skins[3].joints[1]", skin->joints[1], 8, false);
+
+    gltf_unload_baked(&mapped);
+    remove(bake_file_name);
+
+    END_TEST_MODULE();
+}
+static void test_compact(Gltf *gltf) {
+    BEGIN_TEST_MODULE("Gltf_Compact", true, false);
+
+    Gltf_Compact c = gltf_compact(gltf);
+    TEST_EQ("accessor_count",  c.accessor_count,  3, false);
+    TEST_EQ("mesh_count",      c.mesh_count,      2, false);
+    TEST_EQ("node_count",      c.node_count,      7, false);
+    TEST_EQ("primitive_count", c.primitive_count,
+            gltf_mesh_by_index(gltf, 0)->primitive_count + gltf_mesh_by_index(gltf, 1)->primitive_count, false);
+
+    TEST_EQ("accessors.format[0]",      c.accessors.format[0],      GLTF_ACCESSOR_FORMAT_SCALAR_U16, false);
+    TEST_EQ("accessors.byte_offset[0]", c.accessors.byte_offset[0], (u64)100, false);
+    TEST_EQ("accessors.count[1]",       c.accessors.count[1],       2399, false);
+    TEST_EQ("accessors.sparse[0]",      c.accessors.sparse[0],      -1, false);
+
+    Gltf_Range bounds = c.accessors.bounds[1];
+    TEST_EQ ("accessors.bounds[1].count", bounds.count, 3, false);
+    TEST_FEQ("accessors[1].max[2]", c.floats[bounds.offset + 2],                0.539252,  false);
+    TEST_FEQ("accessors[1].min[0]", c.floats[bounds.offset + bounds.count + 0], -0.692985, false);
+
+    Gltf_Compact_Sparse *sparse = &c.sparse[c.accessors.sparse[2]];
+    TEST_EQ("accessors[2].sparse.count",              sparse->count,              10, false);
+    TEST_EQ("accessors[2].sparse.values_byte_offset", sparse->values_byte_offset, (u64)9999, false);
+
+    TEST_STREQ("buffers[0].uri", c.strings + c.buffers.uri[0].offset, "duck1.bin", false);
+
+    Gltf_Range channels = c.animations.channels[3];
+    TEST_EQ("animations[3].channels[1].target_node", c.channels[channels.offset + 1].target_node, 36, false);
+    Gltf_Range samplers = c.animations.samplers[3];
+    TEST_EQ("animations[3].samplers[0].input", c.animation_samplers[samplers.offset].input, 999, false);
+
+    TEST_FEQ("meshes[0].weights[1]", c.floats[c.meshes.weights[0].offset + 1], 0.5, false);
+
+    // meshes[0].primitives[1]
+    int primitive = c.meshes.primitives[0].offset + 1;
+    TEST_EQ("meshes[0].primitives[1].indices", c.primitives.indices[primitive], 31, false);
+    Gltf_Range target = c.targets[c.primitives.targets[primitive].offset + 1];
+    TEST_EQ("meshes[0].primitives[1].targets[1].attributes[2].accessor_index",
+            c.attributes[target.offset + 2].accessor_index, 44, false);
+
+    TEST_FEQ("nodes[0].weights[3]", c.floats[c.nodes.weights[0].offset + 3], 0.8, false);
+    TEST_EQ ("skins[3].joints[1]",  c.ints[c.skins.joints[3].offset + 1],    8,   false);
+    TEST_EQ ("scenes[1].nodes[0]",  c.ints[c.scenes[1].offset],              5,   false);
+
+    // Every section should agree with the strided records element for element
+    bool same = true;
+    for(int i = 0; i < c.node_count; ++i) {
+        Gltf_Node *node = gltf_node_by_index(gltf, i);
+        same &= c.nodes.mesh[i] == node->mesh;
+        same &= c.nodes.children[i].count == node->child_count;
+        same &= memcmp(&c.nodes.transform[i], &node->matrix, sizeof(Mat4)) == 0;
+        for(int j = 0; j < node->child_count; ++j)
+            same &= c.ints[c.nodes.children[i].offset + j] == node->children[j];
+    }
+    TEST_EQ("nodes match", same, true, false);
+
+    same = true;
+    for(int i = 0; i < c.buffer_view_count; ++i) {
+        Gltf_Buffer_View *buffer_view = gltf_buffer_view_by_index(gltf, i);
+        same &= c.buffer_views.buffer[i]      == buffer_view->buffer;
+        same &= c.buffer_views.byte_offset[i] == buffer_view->byte_offset;
+        same &= c.buffer_views.byte_length[i] == buffer_view->byte_length;
+    }
+    TEST_EQ("buffer views match", same, true, false);
+
+    same = true;
+    for(int i = 0; i < c.material_count; ++i)
+        same &= memcmp(&c.materials[i], gltf_material_by_index(gltf, i), sizeof(Gltf_Material)) == 0;
+    TEST_EQ("materials match", same, true, false);
+
+    gltf_free_compact(&c);
+
+    END_TEST_MODULE();
+}
+static void test_streamed(Gltf *gltf) {
+    BEGIN_TEST_MODULE("Gltf_Streamed", true, false);
+
+    // Offset arrays match only if every record was parsed to the same size and packed the same way
+    int **counts[] = {
+        &gltf->accessor_count, &gltf->animation_count, &gltf->buffer_count, &gltf->buffer_view_count,
+        &gltf->camera_count,   &gltf->image_count,     &gltf->material_count, &gltf->mesh_count,
+        &gltf->node_count,     &gltf->sampler_count,   &gltf->scene_count,  &gltf->skin_count,
+        &gltf->texture_count,
+    };
+
+    // 64 bytes is smaller than most elements in the file, so the window has to grow; 4096 holds
+    // several elements, so sections are split into batches across refills.
+    u64 window_sizes[] = {64, 4096, 1 << 20};
+    Linear_Allocator arena = create_linear_allocator(1 << 20);
+
+    for(int w = 0; w < 3; ++w) {
+        linear_allocator_zero(&arena);
+        Gltf streamed = parse_gltf_streamed("test_gltf.gltf", &arena, window_sizes[w]);
+
+        int **streamed_counts[] = {
+            &streamed.accessor_count, &streamed.animation_count, &streamed.buffer_count,
+            &streamed.buffer_view_count, &streamed.camera_count, &streamed.image_count,
+            &streamed.material_count, &streamed.mesh_count, &streamed.node_count,
+            &streamed.sampler_count, &streamed.scene_count, &streamed.skin_count, &streamed.texture_count,
+        };
+        bool same = true;
+        for(int i = 0; i < 13; ++i) {
+            int count = (*counts[i])[-1];
+            same &= (*streamed_counts[i])[-1] == count;
+            same &= memcmp(*streamed_counts[i], *counts[i], sizeof(int) * count) == 0;
+        }
+        TEST_EQ("section offsets", same, true, false);
+        TEST_EQ("scene", streamed.scene, gltf->scene, false);
+
+        Gltf_Accessor *accessor = gltf_accessor_by_index(&streamed, 1);
+        TEST_FEQ("accessor[1].min[1]", accessor->min[1], 0.0992937, false);
+        accessor = gltf_accessor_by_index(&streamed, 2);
+        TEST_EQ("accessor[2].values_byte_offset", accessor->values_byte_offset, (u64)9999, false);
+
+        TEST_STREQ("buffers[0].uri", gltf_buffer_by_index(&streamed, 0)->uri, "duck1.bin", false);
+
+        Gltf_Animation *animation = gltf_animation_by_index(&streamed, 3);
+        TEST_EQ("animation[3].channels[1].target_node", animation->channels[1].target_node, 36, false);
+
+        Gltf_Mesh *mesh = gltf_mesh_by_index(&streamed, 0);
+        Gltf_Mesh_Primitive *primitive = (Gltf_Mesh_Primitive*)((u8*)mesh->primitives + mesh->primitives->stride);
+        TEST_EQ("meshes[0].primitives[1].indices", primitive->indices, 31, false);
+
+        Gltf_Material *material = gltf_material_by_index(&streamed, 1);
+        TEST_FEQ("materials[1].occlusion_strength", material->occlusion_strength,
+                 gltf_material_by_index(gltf, 1)->occlusion_strength, false);
+
+        TEST_EQ("skins[3].joints[1]", gltf_skin_by_index(&streamed, 3)->joints[1], 8, false);
+        TEST_EQ("textures[3].source_image", gltf_texture_by_index(&streamed, 3)->source_image,
+                gltf_texture_by_index(gltf, 3)->source_image, false);
+    }
+
+    destroy_linear_allocator(&arena);
+
+    END_TEST_MODULE();
+}
+static void test_sparse() {
+    BEGIN_TEST_MODULE("Gltf_Sparse", true, false);
+
+    // buffer: [0, 192) vec3 base, [192, 212) u16 indices, [212, 332) vec3 values,
+    //         [332, 524) vec2 base at stride 12, [524, 533) u8 indices
+    const char *json =
+        "{\"accessors\": ["
+        "{\"bufferView\": 0, \"componentType\": 5126, \"count\": 16, \"type\": \"VEC3\", \"sparse\": "
+        "{\"count\": 10, \"indices\": {\"bufferView\": 1, \"componentType\": 5123}, \"values\": {\"bufferView\": 2}}},"
+        "{\"componentType\": 5126, \"count\": 16, \"type\": \"VEC3\", \"sparse\": "
+        "{\"count\": 10, \"indices\": {\"bufferView\": 1, \"componentType\": 5123}, \"values\": {\"bufferView\": 2}}},"
+        "{\"bufferView\": 3, \"componentType\": 5126, \"count\": 16, \"type\": \"VEC2\", \"sparse\": "
+        "{\"count\": 3, \"indices\": {\"bufferView\": 1, \"byteOffset\": 2, \"componentType\": 5123}, "
+        "\"values\": {\"bufferView\": 2, \"byteOffset\": 8}}},"
+        "{\"bufferView\": 0, \"componentType\": 5126, \"count\": 16, \"type\": \"VEC3\", \"sparse\": "
+        "{\"count\": 9, \"indices\": {\"bufferView\": 4, \"componentType\": 5121}, \"values\": {\"bufferView\": 2}}}"
+        "], \"bufferViews\": ["
+        "{\"buffer\": 0, \"byteOffset\": 0, \"byteLength\": 192},"
+        "{\"buffer\": 0, \"byteOffset\": 192, \"byteLength\": 20},"
+        "{\"buffer\": 0, \"byteOffset\": 212, \"byteLength\": 120},"
+        "{\"buffer\": 0, \"byteOffset\": 332, \"byteLength\": 192, \"byteStride\": 12},"
+        "{\"buffer\": 0, \"byteOffset\": 524, \"byteLength\": 9}"
+        "]}";
+
+    const char *file_name = "test_sparse.gltf";
+    FILE *file = fopen(file_name, "wb");
+    fwrite(json, 1, strlen(json), file);
+    fclose(file);
+    Gltf gltf = parse_gltf(file_name);
+    remove(file_name);
+
+    u8 buffer[536];
+    float *base = (float*)buffer;
+    u16 *indices16 = (u16*)(buffer + 192);
+    float *values = (float*)(buffer + 212);
+    float *strided = (float*)(buffer + 332);
+    u8 *indices8 = buffer + 524;
+
+    u16 sparse_indices[] = {15, 0, 3, 4, 7, 8, 9, 10, 12, 14};
+    for(int i = 0; i < 48; ++i)
+        base[i] = i;
+    for(int i = 0; i < 10; ++i) {
+        indices16[i] = sparse_indices[i];
+        if (i < 9)
+            indices8[i] = (u8)sparse_indices[i];
+    }
+    for(int i = 0; i < 30; ++i)
+        values[i] = 100 + i;
+    for(int i = 0; i < 48; ++i)
+        strided[i] = 200 + i;
+
+    // expected results are built the slow way: base first, then every sparse element overwrites its slot
+    float expected[48];
+    float resolved[48];
+
+    Gltf_Accessor *accessor = gltf_accessor_by_index(&gltf, 0);
+    TEST_EQ("accessor[0].byte_stride", accessor->byte_stride, 12, false);
+    memcpy(expected, base, sizeof(expected));
+    for(int i = 0; i < 10; ++i)
+        memcpy(expected + sparse_indices[i] * 3, values + i * 3, 12);
+    gltf_resolve_sparse_accessor(&gltf, accessor, 12, buffer, (u8*)resolved);
+    TEST_EQ("vec3 over view, u16 indices", memcmp(resolved, expected, sizeof(expected)), 0, false);
+
+    accessor = gltf_accessor_by_index(&gltf, 1);
+    TEST_EQ("accessor[1].buffer_view", accessor->buffer_view, -1, false);
+    memset(expected, 0, sizeof(expected));
+    for(int i = 0; i < 10; ++i)
+        memcpy(expected + sparse_indices[i] * 3, values + i * 3, 12);
+    gltf_resolve_sparse_accessor(&gltf, accessor, 12, buffer, (u8*)resolved);
+    TEST_EQ("vec3 without view", memcmp(resolved, expected, sizeof(expected)), 0, false);
+
+    accessor = gltf_accessor_by_index(&gltf, 2);
+    TEST_EQ("accessor[2].byte_stride", accessor->byte_stride, 12, false);
+    for(int i = 0; i < 16; ++i)
+        memcpy(expected + i * 2, strided + i * 3, 8);
+    for(int i = 0; i < 3; ++i)
+        memcpy(expected + sparse_indices[i + 1] * 2, values + 2 + i * 2, 8);
+    gltf_resolve_sparse_accessor(&gltf, accessor, 8, buffer, (u8*)resolved);
+    TEST_EQ("vec2 over strided view", memcmp(resolved, expected, 16 * 8), 0, false);
+
+    accessor = gltf_accessor_by_index(&gltf, 3);
+    memcpy(expected, base, sizeof(expected));
+    for(int i = 0; i < 9; ++i)
+        memcpy(expected + sparse_indices[i] * 3, values + i * 3, 12);
+    gltf_resolve_sparse_accessor(&gltf, accessor, 12, buffer, (u8*)resolved);
+    TEST_EQ("vec3 over view, u8 indices", memcmp(resolved, expected, sizeof(expected)), 0, false);
+
+    END_TEST_MODULE();
+}
+static void test_key_dispatch() {
+    BEGIN_TEST_MODULE("Gltf_Key_Dispatch", true, false);
+
+    // keys are read 32 bytes at a time, so pad the test strings like the file is padded
+    char buf[64];
+    const char *keys[] = {
+        "accessors\": [",
+        "scene\": 0",
+        "scenes\": [",
+        "scenex\": 0",
+        "bufferView\": 1",
+        "bufferViews\": [",
+        "extensionsUsed\": [",
+        "\": 0",
+    };
+    int expected[] = {GLTF_KEY_ACCESSORS, GLTF_KEY_SCENE, GLTF_KEY_SCENES, -1, -1, GLTF_KEY_BUFFER_VIEWS, -1, -1};
+    for(int i = 0; i < 8; ++i) {
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf, keys[i], strlen(keys[i]));
+        TEST_EQ("top level keys", gltf_match_key(buf, &GLTF_KEYS), expected[i], false);
+    }
+
+    // the long keys take the 32 byte compare
+    memset(buf, ' ', sizeof(buf));
+    memcpy(buf, "metallicRoughnessTexture\"", 25);
+    TEST_EQ("metallicRoughnessTexture", gltf_match_key(buf, &GLTF_MATERIAL_PBR_KEYS),
+            GLTF_MATERIAL_PBR_KEY_METALLIC_ROUGHNESS_TEXTURE, false);
+    memcpy(buf, "metallicRoughnessTextura\"", 25);
+    TEST_EQ("metallicRoughnessTextura", gltf_match_key(buf, &GLTF_MATERIAL_PBR_KEYS), -1, false);
+
+    memset(buf, ' ', sizeof(buf));
+    memcpy(buf, "inverseBindMatrices\"", 20);
+    TEST_EQ("inverseBindMatrices", gltf_match_key(buf, &GLTF_SKIN_KEYS), GLTF_SKIN_KEY_INVERSE_BIND_MATRICES, false);
+
+    // every key in a table finds itself
+    for(int i = 0; i < 9; ++i) {
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf, GLTF_NODE_KEYS.keys[i], GLTF_NODE_KEYS.lens[i]);
+        buf[GLTF_NODE_KEYS.lens[i]] = '"';
+        TEST_EQ("node keys", gltf_match_key(buf, &GLTF_NODE_KEYS), i, false);
+    }
+
+    END_TEST_MODULE();
+}
 #endif
 
 // This file is gltf file parser. It reads a gltf file and turns the information into usable C++.
@@ -219,24 +219,24 @@ struct Gltf_Material {
     float base_color_factor[4] = {1, 1, 1, 1};
     float metallic_factor      = 1;
     float roughness_factor     = 1;
-    int base_color_texture_index;
+    int base_color_texture_index = -1; // -1 if absent
     int base_color_tex_coord;
-    int metallic_roughness_texture_index;
+    int metallic_roughness_texture_index = -1;
     int metallic_roughness_tex_coord;
 
     // normal_texture
     float normal_scale = 1;
-    int normal_texture_index;
+    int normal_texture_index = -1;
     int normal_tex_coord;
 
     // occlusion_texture
     float occlusion_strength = 1;
-    int occlusion_texture_index;
+    int occlusion_texture_index = -1;
     int occlusion_tex_coord;
 
     // emissive_texture
     float emissive_factor[3] = {0, 0, 0};
-    int emissive_texture_index;
+    int emissive_texture_index = -1;
     int emissive_tex_coord;
 
     // alpha
@@ -403,6 +403,16 @@ struct Gltf {
 };
 Gltf parse_gltf(const char *file_name);
 
+// Write the resolved elements of a sparse accessor to 'dst', tightly packed ('element_size' apart): the base
+// data from its buffer view (zeros if it has none) with the sparse values scattered over it. 'buffer' is the
+// contents of the accessor's buffer. Works straight into the destination, nothing is staged in temp.
+void gltf_resolve_sparse_accessor(Gltf *gltf, Gltf_Accessor *accessor, int element_size, const u8 *buffer, u8 *dst);
+
+// Parse without ever holding the whole json: it is read through a 'window_size' window (which only grows
+// if a single top level element is bigger than it), and the records are written to 'arena' instead of the
+// temp allocator. For scene descriptions that do not fit in temp alongside their own text.
+Gltf parse_gltf_streamed(const char *file_name, Linear_Allocator *arena, u64 window_size);
+
 Gltf_Accessor* gltf_accessor_by_index(Gltf *gltf, int i);
 Gltf_Animation* gltf_animation_by_index(Gltf *gltf, int i);
 Gltf_Buffer* gltf_buffer_by_index(Gltf *gltf, int i);
@@ -431,6 +441,163 @@ int gltf_scene_get_count(Gltf *gltf);
 int gltf_skin_get_count(Gltf *gltf);
 int gltf_texture_get_count(Gltf *gltf);
 
+//
+// Compacted gltf: built once from a parsed Gltf. The hot fixed size fields of accessors, buffer views,
+// meshes, primitives, nodes, scenes and skins are laid out as parallel arrays indexed directly by element
+// index. Variable length data (children, weights, attributes etc.) is pulled out into the pools at the
+// bottom, and addressed by a Gltf_Range. Cold fixed size records (materials, samplers...) are just packed
+// densely. The whole thing is one heap allocation, so it outlives the temp allocator the parse used.
+//
+struct Gltf_Range {
+    int offset;
+    int count;
+};
+
+struct Gltf_Compact_Sparse {
+    int count;
+    int indices_buffer_view;
+    int values_buffer_view;
+    Gltf_Accessor_Type indices_component_type;
+    u64 indices_byte_offset;
+    u64 values_byte_offset;
+};
+struct Gltf_Compact_Accessors {
+    Gltf_Accessor_Format *format;
+    int *buffer_view;
+    int *byte_stride;
+    int *normalized;
+    int *count;
+    int *sparse;        // index into Gltf_Compact.sparse, -1 if the accessor is not sparse
+    u64 *byte_offset;
+    Gltf_Range *bounds; // into Gltf_Compact.floats: max at 'offset', min at 'offset + count'
+};
+struct Gltf_Compact_Buffer_Views {
+    int *buffer;
+    int *byte_stride;
+    u64 *byte_offset;
+    u64 *byte_length;
+};
+struct Gltf_Compact_Meshes {
+    Gltf_Range *primitives; // into Gltf_Compact.primitives
+    Gltf_Range *weights;    // into Gltf_Compact.floats
+};
+// Every mesh's primitives, end to end
+struct Gltf_Compact_Primitives {
+    int *indices;
+    int *material;
+    int *topology;
+    int *position;
+    int *normal;
+    int *tangent;
+    int *tex_coord_0;
+    Gltf_Range *extra_attributes; // into Gltf_Compact.attributes
+    Gltf_Range *targets;          // into Gltf_Compact.targets
+};
+struct Gltf_Compact_Nodes {
+    int *camera;
+    int *skin;
+    int *mesh;
+    Gltf_Range *children; // into Gltf_Compact.ints
+    Gltf_Range *weights;  // into Gltf_Compact.floats
+    Mat4 *transform;      // the bytes of Gltf_Node's trs/matrix union, read it the same way
+};
+struct Gltf_Compact_Skins {
+    int *inverse_bind_matrices;
+    int *skeleton;
+    Gltf_Range *joints; // into Gltf_Compact.ints
+};
+struct Gltf_Compact_Animations {
+    Gltf_Range *channels; // into Gltf_Compact.channels
+    Gltf_Range *samplers; // into Gltf_Compact.animation_samplers
+};
+struct Gltf_Compact_Images {
+    int *jpeg;
+    int *buffer_view;
+    Gltf_Range *uri; // into Gltf_Compact.strings, null terminated
+};
+struct Gltf_Compact_Buffers {
+    u64 *byte_length;
+    Gltf_Range *uri; // into Gltf_Compact.strings, null terminated
+};
+
+struct Gltf_Compact {
+    int scene;
+
+    int accessor_count;
+    int animation_count;
+    int buffer_count;
+    int buffer_view_count;
+    int camera_count;
+    int image_count;
+    int material_count;
+    int mesh_count;
+    int node_count;
+    int sampler_count;
+    int scene_count;
+    int skin_count;
+    int texture_count;
+
+    Gltf_Compact_Accessors    accessors;
+    Gltf_Compact_Animations   animations;
+    Gltf_Compact_Buffers      buffers;
+    Gltf_Compact_Buffer_Views buffer_views;
+    Gltf_Compact_Images       images;
+    Gltf_Compact_Meshes       meshes;
+    Gltf_Compact_Primitives   primitives;
+    Gltf_Compact_Nodes        nodes;
+    Gltf_Compact_Skins        skins;
+    Gltf_Range               *scenes; // into ints
+
+    // Fixed size and cold, so just packed (their stride fields are meaningless here)
+    Gltf_Camera   *cameras;
+    Gltf_Material *materials;
+    Gltf_Sampler  *samplers;
+    Gltf_Texture  *textures;
+
+    // Pools
+    int primitive_count;
+    int sparse_count;
+    int int_count;
+    int float_count;
+    int attribute_count;
+    int target_count;
+    int channel_count;
+    int animation_sampler_count;
+    int string_size;
+
+    Gltf_Compact_Sparse    *sparse;
+    int                    *ints;
+    float                  *floats;
+    Gltf_Mesh_Attribute    *attributes;         // primitive extra attributes and morph target attributes
+    Gltf_Range             *targets;            // morph targets, into attributes
+    Gltf_Animation_Channel *channels;
+    Gltf_Animation_Sampler *animation_samplers;
+    char                   *strings;
+
+    u64 size;
+    void *memory;
+};
+Gltf_Compact gltf_compact(Gltf *gltf);
+void gltf_free_compact(Gltf_Compact *compact);
+
+//
+// Baked gltf: the parsed Gltf written out as one relocatable blob, keyed on a hash of the source json.
+// A current bake is mapped and pointer fixed rather than parsed. 'map' is NULL if the json had to be
+// parsed, in which case the Gltf lives in the temp allocator like any other parse.
+//
+static constexpr u32 GLTF_BAKE_VERSION = 2;
+
+struct Gltf_Baked {
+    Gltf gltf;
+    u64 size;
+    void *map;
+};
+Gltf_Baked gltf_load_or_bake(const char *gltf_file_name, const char *bake_file_name);
+void gltf_unload_baked(Gltf_Baked *baked);
+
+bool gltf_write_baked(Gltf *gltf, u64 source_hash, const char *bake_file_name);
+bool gltf_map_baked(const char *bake_file_name, u64 source_hash, Gltf_Baked *baked);
+
 #if TEST
     void test_gltf();
 #endif
@@ -0,0 +1,289 @@
+//
+// glTF parse benchmark. Generates synthetic scene descriptions at a few scales, then times parse_gltf,
+// parse_gltf_streamed and the big section parsers on their own. CPU only: no window, no gpu.
+//
+//     GltfBench [max_count]    (max_count defaults to 1000000; scales above it are skipped)
+//
+// Every parser change should be measured against this before and after.
+//
+#include "basic.h"
+#include "gltf.hpp"
+#include "file.hpp"
+
+#include <chrono>
+
+// The section parsers are private to gltf.cpp (parse_gltf is the only intended caller), but timing them in
+// isolation is half the point of this file.
+Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor_count);
+Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *buffer_view_count);
+Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count);
+Gltf_Node* gltf_parse_nodes(const char *data, u64 *offset, int *node_count);
+
+static constexpr int GLTF_BENCH_RUNS          = 5;
+static constexpr int GLTF_BENCH_SCALE_COUNT   = 3;
+static constexpr int GLTF_BENCH_SCALES[]      = {1000, 100000, 1000000};
+static constexpr int GLTF_BENCH_PRIMITIVES    = 4;       // per mesh
+static constexpr u64 GLTF_BENCH_STREAM_WINDOW = 1 << 20;
+
+enum Gltf_Bench_Section {
+    GLTF_BENCH_SECTION_ACCESSORS,
+    GLTF_BENCH_SECTION_BUFFER_VIEWS,
+    GLTF_BENCH_SECTION_MESHES,
+    GLTF_BENCH_SECTION_NODES,
+    GLTF_BENCH_SECTION_COUNT,
+};
+static const char *GLTF_BENCH_SECTION_NAMES[GLTF_BENCH_SECTION_COUNT] = {
+    "accessors", "bufferViews", "meshes", "nodes",
+};
+
+struct Gltf_Bench_File {
+    char name[64];
+    int count;
+    u64 size;
+    u64 section_begin[GLTF_BENCH_SECTION_COUNT]; // just inside the key's opening quote, as parse_gltf calls
+    u64 section_end[GLTF_BENCH_SECTION_COUNT];
+};
+
+static inline u64 gltf_bench_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void gltf_bench_begin_section(FILE *file, Gltf_Bench_File *bench, int section, const char *key) {
+    fprintf(file, "    \"");
+    bench->section_begin[section] = ftell(file);
+    fprintf(file, "%s\": [\n", key);
+}
+static inline void gltf_bench_end_section(FILE *file, Gltf_Bench_File *bench, int section) {
+    fprintf(file, "    ],\n");
+    bench->section_end[section] = ftell(file);
+}
+
+//
+// 'count' accessors, nodes and primitives. Accessors alternate between vec3 float attributes (with max/min)
+// and u16 indices, every 16th is sparse; nodes alternate matrix and trs, with children and weights sprinkled
+// in; every 32nd primitive has morph targets.
+//
+static bool gltf_bench_generate(Gltf_Bench_File *bench, int count) {
+    snprintf(bench->name, sizeof(bench->name), "gltf_bench_%i.gltf", count);
+    bench->count = count;
+
+    FILE *file = fopen(bench->name, "wb");
+    if (!file) {
+        println("Failed to open %c for writing", bench->name);
+        return false;
+    }
+
+    int buffer_view_count = count / 4 + 1;
+    int mesh_count        = count / GLTF_BENCH_PRIMITIVES;
+
+    fprintf(file, "{\n");
+    fprintf(file, "    \"asset\": { \"version\": \"2.0\" },\n");
+    fprintf(file, "    \"scene\": 0,\n");
+
+    fprintf(file, "    \"scenes\": [ { \"nodes\": [ 0");
+    for(int i = 1; i < count && i < 64; ++i)
+        fprintf(file, ", %i", i);
+    fprintf(file, " ] } ],\n");
+
+    fprintf(file, "    \"buffers\": [ { \"byteLength\": %llu, \"uri\": \"gltf_bench.bin\" } ],\n",
+            (unsigned long long)buffer_view_count * 4096);
+
+    fprintf(file, "    \"materials\": [ { \"pbrMetallicRoughness\": { \"baseColorFactor\": [ 1.0, 0.5, 0.5, 1.0 ], "
+                  "\"metallicFactor\": 0.2 }, \"doubleSided\": true } ],\n");
+
+    gltf_bench_begin_section(file, bench, GLTF_BENCH_SECTION_BUFFER_VIEWS, "bufferViews");
+    for(int i = 0; i < buffer_view_count; ++i) {
+        fprintf(file, "        { \"buffer\": 0, \"byteOffset\": %i, \"byteLength\": 4096, \"byteStride\": 12, "
+                      "\"target\": 34962 }%s\n", i * 4096, i + 1 < buffer_view_count ? "," : "");
+    }
+    gltf_bench_end_section(file, bench, GLTF_BENCH_SECTION_BUFFER_VIEWS);
+
+    gltf_bench_begin_section(file, bench, GLTF_BENCH_SECTION_ACCESSORS, "accessors");
+    for(int i = 0; i < count; ++i) {
+        fprintf(file, "        {\n");
+        fprintf(file, "            \"bufferView\": %i,\n", i % buffer_view_count);
+        fprintf(file, "            \"byteOffset\": %i,\n", (i % 64) * 12);
+        if (i & 1) {
+            fprintf(file, "            \"componentType\": 5123,\n");
+            fprintf(file, "            \"count\": %i,\n", 3 * (i % 1000 + 1));
+            fprintf(file, "            \"type\": \"SCALAR\"");
+        } else {
+            fprintf(file, "            \"componentType\": 5126,\n");
+            fprintf(file, "            \"count\": %i,\n", i % 1000 + 1);
+            fprintf(file, "            \"type\": \"VEC3\",\n");
+            fprintf(file, "            \"max\": [ %f, %f, %f ],\n", 1.0 + i % 7, 2.5, 0.125 * (i % 9));
+            fprintf(file, "            \"min\": [ %f, %f, %f ]", -1.0 - i % 5, -2.5, -0.125 * (i % 3));
+        }
+        if (i % 16 == 0) {
+            fprintf(file, ",\n            \"sparse\": { \"count\": 4, "
+                          "\"indices\": { \"bufferView\": %i, \"byteOffset\": 0, \"componentType\": 5123 }, "
+                          "\"values\": { \"bufferView\": %i, \"byteOffset\": 64 } }",
+                    (i + 1) % buffer_view_count, (i + 2) % buffer_view_count);
+        }
+        fprintf(file, "\n        }%s\n", i + 1 < count ? "," : "");
+    }
+    gltf_bench_end_section(file, bench, GLTF_BENCH_SECTION_ACCESSORS);
+
+    gltf_bench_begin_section(file, bench, GLTF_BENCH_SECTION_MESHES, "meshes");
+    int primitive = 0;
+    for(int i = 0; i < mesh_count; ++i) {
+        fprintf(file, "        { \"primitives\": [\n");
+        for(int j = 0; j < GLTF_BENCH_PRIMITIVES; ++j, ++primitive) {
+            fprintf(file, "            { \"attributes\": { \"POSITION\": %i, \"NORMAL\": %i, \"TEXCOORD_0\": %i }, "
+                          "\"indices\": %i, \"material\": 0, \"mode\": 4",
+                    primitive & ~1, (primitive + 2) % count & ~1, (primitive + 4) % count & ~1, primitive | 1);
+            if (primitive % 32 == 0) {
+                fprintf(file, ", \"targets\": [ { \"POSITION\": %i, \"NORMAL\": %i } ]",
+                        (primitive + 6) % count & ~1, (primitive + 8) % count & ~1);
+            }
+            fprintf(file, " }%s\n", j + 1 < GLTF_BENCH_PRIMITIVES ? "," : "");
+        }
+        fprintf(file, "        ]%s }%s\n", i % 8 == 0 ? ", \"weights\": [ 0.25, 0.75 ]" : "",
+                i + 1 < mesh_count ? "," : "");
+    }
+    gltf_bench_end_section(file, bench, GLTF_BENCH_SECTION_MESHES);
+
+    gltf_bench_begin_section(file, bench, GLTF_BENCH_SECTION_NODES, "nodes");
+    for(int i = 0; i < count; ++i) {
+        fprintf(file, "        { \"mesh\": %i", mesh_count ? i % mesh_count : 0);
+        if (i & 1) {
+            fprintf(file, ", \"translation\": [ %f, 0.0, -%f ], \"rotation\": [ 0.0, 0.707107, 0.0, 0.707107 ], "
+                          "\"scale\": [ 1.0, 2.0, 1.0 ]", 0.5 * (i % 100), 0.25 * (i % 40));
+        } else {
+            fprintf(file, ", \"matrix\": [ 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, "
+                          "%f, %f, %f, 1.0 ]", 1.0 * (i % 10), 2.0 * (i % 5), -0.5 * (i % 20));
+        }
+        if (i % 8 == 0 && i + 3 < count)
+            fprintf(file, ", \"children\": [ %i, %i, %i ]", i + 1, i + 2, i + 3);
+        if (i % 16 == 0)
+            fprintf(file, ", \"weights\": [ 0.1, 0.2, 0.3, 0.4 ]");
+        fprintf(file, " }%s\n", i + 1 < count ? "," : "");
+    }
+    // last section: no trailing comma
+    fprintf(file, "    ]\n");
+    bench->section_end[GLTF_BENCH_SECTION_NODES] = ftell(file);
+
+    fprintf(file, "}\n");
+    bench->size = ftell(file);
+    fclose(file);
+    return true;
+}
+
+static void gltf_bench_report(const char *name, int items, u64 bytes, u64 us, u64 memory) {
+    if (!us)
+        us = 1; // sub microsecond, call it one
+    println("    %c: %u items, %u bytes, %u us, %u MB/s, %u items/s, %u KB",
+            name, (u64)items, bytes, us, bytes / us, (u64)items * 1000000 / us, memory / 1024);
+}
+
+static void* gltf_bench_parse_section(int section, const char *data, int *count) {
+    u64 offset = 0;
+    switch(section) {
+    case GLTF_BENCH_SECTION_ACCESSORS:
+        return gltf_parse_accessors(data, &offset, count);
+    case GLTF_BENCH_SECTION_BUFFER_VIEWS:
+        return gltf_parse_buffer_views(data, &offset, count);
+    case GLTF_BENCH_SECTION_MESHES:
+        return gltf_parse_meshes(data, &offset, count);
+    case GLTF_BENCH_SECTION_NODES:
+        return gltf_parse_nodes(data, &offset, count);
+    default:
+        return NULL;
+    }
+}
+
+static void gltf_bench_run(Gltf_Bench_File *bench) {
+    println("%c (%u bytes):", bench->name, bench->size);
+
+    u64 begin;
+    u64 us;
+    u64 best;
+    u64 peak;
+    int items = 0;
+
+    //
+    // Whole file: read + parse + offset tables. Temp is linear, so its high water mark is where it ends up.
+    //
+    best = Max_u64;
+    for(int run = 0; run < GLTF_BENCH_RUNS; ++run) {
+        reset_temp();
+        begin = gltf_bench_now_us();
+        Gltf gltf = parse_gltf(bench->name);
+        us = gltf_bench_now_us() - begin;
+
+        best  = us < best ? us : best;
+        peak  = get_mark_temp();
+        items = gltf_accessor_get_count(&gltf) + gltf_node_get_count(&gltf) + gltf_mesh_get_count(&gltf);
+    }
+    gltf_bench_report("parse_gltf", items, bench->size, best, peak);
+
+    // Streamed: only the window is held, records go to the arena
+    Linear_Allocator arena = create_linear_allocator(get_instance_temp()->capacity / 2);
+    best = Max_u64;
+    for(int run = 0; run < GLTF_BENCH_RUNS; ++run) {
+        reset_temp();
+        arena.used = 0;
+        begin = gltf_bench_now_us();
+        Gltf gltf = parse_gltf_streamed(bench->name, &arena, GLTF_BENCH_STREAM_WINDOW);
+        us = gltf_bench_now_us() - begin;
+
+        best  = us < best ? us : best;
+        peak  = arena.used + GLTF_BENCH_STREAM_WINDOW;
+        items = gltf_accessor_get_count(&gltf) + gltf_node_get_count(&gltf) + gltf_mesh_get_count(&gltf);
+    }
+    gltf_bench_report("parse_gltf_streamed", items, bench->size, best, peak);
+    destroy_linear_allocator(&arena);
+
+    //
+    // Sections on their own, against text already in memory
+    //
+    reset_temp();
+    u64 size;
+    const char *data = (const char*)file_read_char_temp_padded(bench->name, &size, 16);
+    u64 mark = get_mark_temp();
+
+    for(int section = 0; section < GLTF_BENCH_SECTION_COUNT; ++section) {
+        best = Max_u64;
+        for(int run = 0; run < GLTF_BENCH_RUNS; ++run) {
+            reset_to_mark_temp(mark);
+            begin = gltf_bench_now_us();
+            gltf_bench_parse_section(section, data + bench->section_begin[section], &items);
+            us = gltf_bench_now_us() - begin;
+
+            best = us < best ? us : best;
+            peak = get_mark_temp() - mark;
+        }
+        gltf_bench_report(GLTF_BENCH_SECTION_NAMES[section], items,
+                          bench->section_end[section] - bench->section_begin[section], best, peak);
+    }
+    reset_temp();
+}
+
+int main(int argc, const char **argv) {
+    int max_count = argc > 1 ? atoi(argv[1]) : GLTF_BENCH_SCALES[GLTF_BENCH_SCALE_COUNT - 1];
+
+    Gltf_Bench_File benches[GLTF_BENCH_SCALE_COUNT];
+    int bench_count = 0;
+    u64 largest = 0;
+    for(int i = 0; i < GLTF_BENCH_SCALE_COUNT && GLTF_BENCH_SCALES[i] <= max_count; ++i) {
+        println("Generating %u...", (u64)GLTF_BENCH_SCALES[i]);
+        if (!gltf_bench_generate(&benches[bench_count], GLTF_BENCH_SCALES[i]))
+            break;
+        largest = benches[bench_count].size > largest ? benches[bench_count].size : largest;
+        bench_count++;
+    }
+
+    // The parsed records are a fraction of the size of their json, so twice the json covers file + records.
+    // The heap holds the streaming window and arena.
+    init_heap_allocator(align(largest * 2, 1 << 20) + (64 << 20));
+    init_temp_allocator(align(largest * 2, 1 << 20) + (64 << 20));
+
+    for(int i = 0; i < bench_count; ++i) {
+        gltf_bench_run(&benches[i]);
+        remove(benches[i].name);
+    }
+
+    kill_allocators();
+    return 0;
+}
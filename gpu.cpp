@@ -28,7 +28,8 @@ void init_gpu()
             (sizeof(Gpu)                  * 1) +
             (sizeof(VkQueue)              * 3) +
             (sizeof(u32)                  * 3) +
-            (sizeof(Gpu_Buf_Allocator) * 4), 8);
+            (sizeof(Gpu_Buf_Allocator) * 4) +
+            (sizeof(Gpu_Tex_Allocator) * 1), 8);
 
     Gpu *gpu = get_gpu_instance();
 
@@ -39,6 +40,7 @@ void init_gpu()
     gpu->vertex_device_allocator  = (Gpu_Buf_Allocator*)(gpu->index_device_allocator  + 1);
     gpu->index_host_allocator  = (Gpu_Buf_Allocator*)(gpu->vertex_device_allocator + 1);
     gpu->vertex_host_allocator = (Gpu_Buf_Allocator*)(gpu->index_host_allocator + 1);
+    gpu->texture_allocator     = (Gpu_Tex_Allocator*)(gpu->vertex_host_allocator + 1);
 
     Create_Vk_Instance_Info create_instance_info = {};
     gpu->vk_instance = create_vk_instance(&create_instance_info);
@@ -60,6 +62,14 @@ void kill_gpu(Gpu *gpu) {
     vkDestroyImage(device, gpu->memory_resources.depth_attachments[0], ALLOCATION_CALLBACKS);
     vkFreeMemory(device, gpu->memory_resources.depth_mems[0], ALLOCATION_CALLBACKS);
 
+    // Blocks chained on as the arenas grew
+    gpu_destroy_buf_allocator_blocks(device, gpu->index_device_allocator);
+    gpu_destroy_buf_allocator_blocks(device, gpu->vertex_device_allocator);
+    if ((gpu->memory_resources.flags & GPU_MEM_UMA_BIT) == 0) {
+        gpu_destroy_buf_allocator_blocks(device, gpu->index_host_allocator);
+        gpu_destroy_buf_allocator_blocks(device, gpu->vertex_host_allocator);
+    }
+
     vkDestroyBuffer(device, gpu->memory_resources.index_bufs_device [0], ALLOCATION_CALLBACKS);
     vkDestroyBuffer(device, gpu->memory_resources.vertex_bufs_device[0], ALLOCATION_CALLBACKS);
     vkFreeMemory(device, gpu->memory_resources.index_vertex_mems_device[0], ALLOCATION_CALLBACKS);
@@ -70,6 +80,13 @@ void kill_gpu(Gpu *gpu) {
         vkFreeMemory(device, gpu->memory_resources.index_vertex_mems_host[0], ALLOCATION_CALLBACKS);
     }
 
+    for(u32 i = 0; i < gpu->texture_allocator->img_cnt; ++i)
+        vkDestroyImage(device, gpu->texture_allocator->imgs[i], ALLOCATION_CALLBACKS);
+    gpu_destroy_tex_allocator(gpu->texture_allocator);
+    vkDestroyBuffer(device, gpu->memory_resources.texture_stages[0], ALLOCATION_CALLBACKS);
+    vkFreeMemory(device, gpu->memory_resources.texture_mems_stage[0], ALLOCATION_CALLBACKS);
+    vkFreeMemory(device, gpu->memory_resources.texture_mems_device[0], ALLOCATION_CALLBACKS);
+
     vkDestroyDevice(gpu->vk_device, ALLOCATION_CALLBACKS);
 #if DEBUG
     vkDestroyDebugUtilsMessengerEXT(gpu->vk_instance, *get_vk_debug_messenger_instance(), ALLOCATION_CALLBACKS);
@@ -154,11 +171,13 @@ VkInstance create_vk_instance(Create_Vk_Instance_Info *info) {
 // `Device ///////////
 VkDevice create_vk_device(Gpu *gpu) { // returns logical device, silently fills in gpu.physical_device
 
+    // VK_EXT_memory_budget is only enabled if supported, see below
     uint32_t ext_count = 3;
     const char *ext_names[] = {
         "VK_KHR_swapchain",
         "VK_EXT_descriptor_buffer",
         "VK_EXT_memory_priority",
+        "VK_EXT_memory_budget",
     };
 
     VkPhysicalDeviceFeatures vk1_features = {
@@ -167,6 +186,7 @@ VkDevice create_vk_device(Gpu *gpu) { // returns logical device, silently fills
     VkPhysicalDeviceVulkan12Features vk12_features = {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
         .descriptorIndexing = VK_TRUE,
+        .timelineSemaphore = VK_TRUE,
         .bufferDeviceAddress = VK_TRUE,
     };
     VkPhysicalDeviceVulkan13Features vk13_features = {
@@ -226,6 +246,10 @@ VkDevice create_vk_device(Gpu *gpu) { // returns logical device, silently fills
             std::cerr << "Device Index " << i << " does not support Memory Priority\n";
             incompatible = true;
         }
+        if (vk12_features.timelineSemaphore == VK_FALSE) {
+            std::cerr << "Device Index " << i << " does not support Timeline Semaphores\n";
+            incompatible = true;
+        }
 
         if (incompatible)
             continue;
@@ -291,6 +315,14 @@ VkDevice create_vk_device(Gpu *gpu) { // returns logical device, silently fills
         transfer_queue_index = graphics_queue_index;
     }
 
+    // Block compressed textures are optional: enable whichever the device has, textures fall back to rgba8
+    VkPhysicalDeviceFeatures selected_features;
+    vkGetPhysicalDeviceFeatures(physical_devices[physical_device_index], &selected_features);
+    features_full_unfilled.features.textureCompressionBC       = selected_features.textureCompressionBC;
+    features_full_unfilled.features.textureCompressionASTC_LDR = selected_features.textureCompressionASTC_LDR;
+    gpu->info.texture_compression_bc   = selected_features.textureCompressionBC;
+    gpu->info.texture_compression_astc = selected_features.textureCompressionASTC_LDR;
+
     // @Todo query and store the important information for the device in a GpuInfo struct
     // Do this later when the info is actually required
     VkPhysicalDeviceProperties props;
@@ -323,6 +355,21 @@ VkDevice create_vk_device(Gpu *gpu) { // returns logical device, silently fills
 
     VkDeviceQueueCreateInfo queue_infos[] = { graphics_queue_create_info, transfer_queue_create_info };
 
+    // Memory budget is only used to size the memory arenas, which fall back to the heap sizes without it
+    u32 device_ext_count;
+    vkEnumerateDeviceExtensionProperties(physical_devices[physical_device_index], NULL, &device_ext_count, NULL);
+    VkExtensionProperties *device_exts =
+        (VkExtensionProperties*)memory_allocate_temp(sizeof(VkExtensionProperties) * device_ext_count, 8);
+    vkEnumerateDeviceExtensionProperties(physical_devices[physical_device_index], NULL, &device_ext_count, device_exts);
+
+    gpu->info.memory_budget = false;
+    for(u32 i = 0; i < device_ext_count; ++i)
+        if (strcmp(device_exts[i].extensionName, ext_names[3]) == 0) {
+            gpu->info.memory_budget = true;
+            ext_count++;
+            break;
+        }
+
     VkDeviceCreateInfo device_create_info      = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
     device_create_info.pNext                   = &features_full_unfilled;
     device_create_info.queueCreateInfoCount    = queue_info_count;
@@ -374,18 +421,32 @@ VkSubmitInfo2 gpu_device_buffer_upload_non_uma_discrete_transfer(Gpu_Buffer_Copy
 // @Todo Unimplemented allocator / memory resource setups:
 //     - Color Attachment
 //     - Uniform
-//     - Texture
 //     - Storage Image
 //     - Storage Buffer
 //     - Recreate depth and color attachments on swapchain recreation (window resize)
 // Complete Setups:
 //     - Vertex / Index
 //     - Depth Attachment
+//     - Texture
+static u64 gpu_get_arena_size(u64 heap_budget, u64 divisor)
+{
+    u64 size = heap_budget / divisor;
+    if (size < GPU_ALLOCATOR_MIN_SIZE)
+        return GPU_ALLOCATOR_MIN_SIZE;
+    if (size > GPU_ALLOCATOR_MAX_SIZE)
+        return GPU_ALLOCATOR_MAX_SIZE;
+    return size;
+}
+
 void gpu_init_memory_resources(Gpu *gpu)
 {
     gpu->memory_resources.flags = 0x0;
-    VkPhysicalDeviceMemoryProperties props;
-    vkGetPhysicalDeviceMemoryProperties(gpu->vk_physical_device, &props);
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+    VkPhysicalDeviceMemoryProperties2 props2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2};
+    if (gpu->info.memory_budget)
+        props2.pNext = &budget;
+    vkGetPhysicalDeviceMemoryProperties2(gpu->vk_physical_device, &props2);
+    VkPhysicalDeviceMemoryProperties props = props2.memoryProperties;
     // This does not work. For instance, on my laptop there are two heaps, despite uma. One of them
     // is just listed as zero size.
     //bool uma = props.memoryHeapCount == 1;
@@ -440,6 +501,18 @@ void gpu_init_memory_resources(Gpu *gpu)
                 attachment_index = i;
         }
 
+    gpu->memory_resources.device_memory_type = attachment_index;
+    gpu->memory_resources.host_memory_type   = uniform_index;
+
+    // The host staging arenas are the same size as the device ones, so that device blocks can mirror them
+    u32 arena_heap   = props.memoryTypes[attachment_index].heapIndex;
+    u64 arena_budget = gpu->info.memory_budget ? budget.heapBudget[arena_heap] : props.memoryHeaps[arena_heap].size;
+    u64 index_arena_size   = gpu_get_arena_size(arena_budget, GPU_INDEX_ALLOCATOR_BUDGET_DIVISOR);
+    u64 vertex_arena_size  = gpu_get_arena_size(arena_budget, GPU_VERTEX_ALLOCATOR_BUDGET_DIVISOR);
+    gpu->memory_resources.index_arena_size   = index_arena_size;
+    gpu->memory_resources.vertex_arena_size  = vertex_arena_size;
+    gpu->memory_resources.texture_arena_size = gpu_get_arena_size(arena_budget, GPU_TEXTURE_ALLOCATOR_BUDGET_DIVISOR);
+
                                  /* Attachments Begin */
 
     // @Unused Color allocation currently unimplemented.
@@ -519,11 +592,11 @@ void gpu_init_memory_resources(Gpu *gpu)
         gpu->device_buffer_upload_fn = &gpu_device_buffer_upload_uma;
         gpu->memory_resources.flags |= GPU_MEM_UMA_BIT;
 
-        buffer_info.size = GPU_INDEX_ALLOCATOR_SIZE;
+        buffer_info.size = index_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &index_device_buffer);
 
-        buffer_info.size = GPU_VERTEX_ALLOCATOR_SIZE;
+        buffer_info.size = vertex_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &vertex_device_buffer);
 
@@ -553,15 +626,22 @@ void gpu_init_memory_resources(Gpu *gpu)
             gpu_get_buf_allocator(
                 index_device_buffer,
                 mapped_ptr,
-                GPU_INDEX_ALLOCATOR_SIZE,
-                32);
+                index_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
 
         *gpu->vertex_device_allocator =
             gpu_get_buf_allocator(
                 vertex_device_buffer,
                 (u8*)mapped_ptr + index_vertex_mem_req[0].size,
-                GPU_VERTEX_ALLOCATOR_SIZE,
-                32);
+                vertex_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
+
+        gpu_buf_allocator_enable_growth(gpu->index_device_allocator,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            attachment_index, true, index_vertex_priority_device);
+        gpu_buf_allocator_enable_growth(gpu->vertex_device_allocator,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            attachment_index, true, index_vertex_priority_device);
 
         gpu->index_host_allocator  = gpu->index_device_allocator;
         gpu->vertex_host_allocator = gpu->vertex_device_allocator;
@@ -576,19 +656,19 @@ void gpu_init_memory_resources(Gpu *gpu)
         else
             gpu->device_buffer_upload_fn = &gpu_device_buffer_upload_non_uma_discrete_transfer;
 
-        buffer_info.size = GPU_INDEX_ALLOCATOR_SIZE;
+        buffer_info.size = index_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &index_device_buffer);
 
-        buffer_info.size = GPU_VERTEX_ALLOCATOR_SIZE;
+        buffer_info.size = vertex_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &vertex_device_buffer);
 
-        buffer_info.size  = GPU_INDEX_ALLOCATOR_SIZE;
+        buffer_info.size  = index_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &index_host_buffer);
 
-        buffer_info.size  = GPU_VERTEX_ALLOCATOR_SIZE;
+        buffer_info.size  = vertex_arena_size;
         buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &vertex_host_buffer);
 
@@ -636,39 +716,117 @@ void gpu_init_memory_resources(Gpu *gpu)
             gpu_get_buf_allocator(
                 index_device_buffer,
                 NULL,
-                GPU_INDEX_ALLOCATOR_SIZE,
-                32);
+                index_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
 
         *gpu->vertex_device_allocator =
             gpu_get_buf_allocator(
                 vertex_device_buffer,
                 NULL,
-                GPU_VERTEX_ALLOCATOR_SIZE,
-                32);
+                vertex_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
 
         *gpu->index_host_allocator =
             gpu_get_buf_allocator(
-                index_device_buffer,
+                index_host_buffer,
                 mapped_ptr,
-                GPU_INDEX_ALLOCATOR_SIZE,
-                32);
+                index_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
 
         *gpu->vertex_host_allocator =
             gpu_get_buf_allocator(
-                vertex_device_buffer,
+                vertex_host_buffer,
                 (u8*)mapped_ptr + index_vertex_mem_req[2].size,
-                GPU_VERTEX_ALLOCATOR_SIZE,
-                32);
+                vertex_arena_size,
+                GPU_BUF_ALLOCATOR_ALLOCATION_CAP);
+
+        gpu_buf_allocator_enable_growth(gpu->index_device_allocator,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            attachment_index, false, index_vertex_priority_device);
+        gpu_buf_allocator_enable_growth(gpu->vertex_device_allocator,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            attachment_index, false, index_vertex_priority_device);
+        gpu_buf_allocator_enable_growth(gpu->index_host_allocator,  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            uniform_index, true, index_vertex_priority_host);
+        gpu_buf_allocator_enable_growth(gpu->vertex_host_allocator, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            uniform_index, true, index_vertex_priority_host);
     }
                           /* Vertex Index End */
 
+                            /* Texture Begin */
+
+    // Images are bound in device memory, their mip chains staged in host memory of the same size (which is the
+    // same memory type under uma: optimal tiling needs the copy either way).
+    float texture_priority = 0.5;
+    VkBuffer texture_stage;
+    VkDeviceMemory texture_device_mem;
+    VkDeviceMemory texture_stage_mem;
+    VkMemoryRequirements texture_mem_req;
+    void *texture_mapped_ptr;
+
+    buffer_info.size  = gpu->memory_resources.texture_arena_size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &texture_stage);
+    vkGetBufferMemoryRequirements(device, texture_stage, &texture_mem_req);
+
+    priority.priority = 0.0;
+    allocation_info.pNext           = &priority;
+    allocation_info.allocationSize  = texture_mem_req.size;
+    allocation_info.memoryTypeIndex = uniform_index;
+    vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &texture_stage_mem);
+    vkBindBufferMemory(device, texture_stage, texture_stage_mem, 0);
+    vkMapMemory(device, texture_stage_mem, 0, VK_WHOLE_SIZE, 0x0, &texture_mapped_ptr);
+
+    // Every texture is bound in the one arena, so its memory type must suit them all: ask a representative image
+    // (sampled color images of the same tiling, usage and flags share their memory type bits, whatever the format)
+    image_info.format    = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.extent    = {.width = 256, .height = 256, .depth = 1};
+    image_info.mipLevels = 9;
+    image_info.usage     = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImage texture_probe;
+    check = vkCreateImage(device, &image_info, ALLOCATION_CALLBACKS, &texture_probe);
+    DEBUG_OBJ_CREATION(vkCreateImage, check);
+    vkGetImageMemoryRequirements(device, texture_probe, &texture_mem_req);
+    vkDestroyImage(device, texture_probe, ALLOCATION_CALLBACKS);
+
+    int texture_index = attachment_index;
+    if (!(texture_mem_req.memoryTypeBits & (1 << texture_index))) {
+        texture_index = -1;
+        for(uint i = 0; i < props.memoryTypeCount; ++i) {
+            if (!(texture_mem_req.memoryTypeBits & (1 << i)))
+                continue;
+            if (props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+                texture_index = i;
+                break;
+            }
+            if (texture_index == -1)
+                texture_index = i;
+        }
+        ASSERT(texture_index != -1, "No memory type for textures");
+    }
+
+    priority.priority = texture_priority;
+    allocation_info.allocationSize  = gpu->memory_resources.texture_arena_size;
+    allocation_info.memoryTypeIndex = texture_index;
+    vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &texture_device_mem);
+
+    *gpu->texture_allocator =
+        gpu_create_tex_allocator(
+            texture_device_mem,
+            texture_stage,
+            texture_mapped_ptr,
+            gpu->memory_resources.texture_arena_size,
+            GPU_TEX_ALLOCATOR_IMAGE_CAP);
+
+                             /* Texture End */
+
     gpu->memory_resources.index_vertex_mems_device[0] = index_vertex_device_mem;
     gpu->memory_resources.index_vertex_mems_host[0]   = index_vertex_host_mem;
     //gpu->memory_resources.uniform_mems             ;//= ;
     //gpu->memory_resources.color_mems               ;//= ;
     gpu->memory_resources.depth_mems[0]               = depth_mem;
-    //gpu->memory_resources.texture_mems_stage       ;//= ;
-    //gpu->memory_resources.texture_mems_device      ;//= ;
+    gpu->memory_resources.texture_mems_stage[0]       = texture_stage_mem;
+    gpu->memory_resources.texture_mems_device[0]      = texture_device_mem;
 
     gpu->memory_resources.index_bufs_device[0]        = index_device_buffer;
     gpu->memory_resources.vertex_bufs_device[0]       = vertex_device_buffer;
@@ -677,7 +835,7 @@ void gpu_init_memory_resources(Gpu *gpu)
     //gpu->memory_resources.uniform_bufs             ;//= ;
     //gpu->memory_resources.color_attachments        ;//= ;
     gpu->memory_resources.depth_attachments[0]        = depth;
-    //gpu->memory_resources.texture_stages           ;//= ;
+    gpu->memory_resources.texture_stages[0]           = texture_stage;
 
     u64 image_alignment;
 }
@@ -1689,7 +1847,8 @@ void create_vk_graphics_pipelines(VkDevice vk_device, VkPipelineCache cache, int
             .location = (u32)info->vertex_input_state->attribute_description_locations[i],
             .binding = (u32)info->vertex_input_state->attribute_description_bindings[i],
             .format = info->vertex_input_state->formats[i],
-            .offset = 0,
+            .offset = info->vertex_input_state->attribute_description_offsets ?
+                (u32)info->vertex_input_state->attribute_description_offsets[i] : 0,
         };
         vertex_attribute_descriptions[i] = create_vk_vertex_attribute_description(&attribute_info);
     }
@@ -2361,29 +2520,139 @@ gpu_get_buf_allocator(VkBuffer buffer, void *ptr, u64 size, u32 count)
     ret.buf = buffer;
     ret.ptr = ptr;
 
+    ret.block_count   = 1;
+    ret.block_caps[0] = ret.cap;
+    ret.block_bufs[0] = buffer;
+    ret.block_mems[0] = VK_NULL_HANDLE;
+    ret.block_ptrs[0] = ptr;
+    ret.grow_memory_type = -1;
+
     return ret;
 }
+void gpu_buf_allocator_enable_growth(Gpu_Buf_Allocator *allocator, VkBufferUsageFlags usage, u32 memory_type_index,
+                                     bool mapped, float priority)
+{
+    allocator->grow_usage       = usage;
+    allocator->grow_memory_type = memory_type_index;
+    allocator->grow_mapped      = mapped;
+    allocator->grow_priority    = priority;
+}
+void gpu_destroy_buf_allocator_blocks(VkDevice device, Gpu_Buf_Allocator *allocator)
+{
+    for(int i = 1; i < allocator->block_count; ++i) {
+        vkDestroyBuffer(device, allocator->block_bufs[i], ALLOCATION_CALLBACKS);
+        vkFreeMemory(device, allocator->block_mems[i], ALLOCATION_CALLBACKS);
+    }
+    allocator->block_count = 1;
+    gpu_reset_buf_allocator(device, allocator);
+}
+
+static bool gpu_buf_allocator_add_block(Gpu_Buf_Allocator *allocator, u64 size)
+{
+    if (allocator->grow_memory_type == -1 || allocator->block_count == GPU_BUF_ALLOCATOR_MAX_BLOCKS)
+        return false;
+
+    VkDevice device = get_gpu_instance()->vk_device;
+    int block = allocator->block_count;
+    size = align(size, allocator->alignment);
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_info.size        = size;
+    buffer_info.usage       = allocator->grow_usage;
+    auto check = vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &allocator->block_bufs[block]);
+    DEBUG_OBJ_CREATION(vkCreateBuffer, check);
+
+    VkMemoryRequirements mem_req;
+    vkGetBufferMemoryRequirements(device, allocator->block_bufs[block], &mem_req);
+    ASSERT(mem_req.memoryTypeBits & (1 << allocator->grow_memory_type), "Buffer cannot live in the growth memory type");
+
+    VkMemoryPriorityAllocateInfoEXT priority = {VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT};
+    priority.priority = allocator->grow_priority;
+
+    VkMemoryAllocateInfo allocation_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocation_info.pNext           = &priority;
+    allocation_info.allocationSize  = mem_req.size;
+    allocation_info.memoryTypeIndex = allocator->grow_memory_type;
+    check = vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &allocator->block_mems[block]);
+    if (check != VK_SUCCESS) {
+        vkDestroyBuffer(device, allocator->block_bufs[block], ALLOCATION_CALLBACKS);
+        return false;
+    }
+
+    VkBindBufferMemoryInfo buffer_bind = {VK_STRUCTURE_TYPE_BIND_BUFFER_MEMORY_INFO};
+    buffer_bind.buffer = allocator->block_bufs[block];
+    buffer_bind.memory = allocator->block_mems[block];
+    buffer_bind.memoryOffset = 0;
+    vkBindBufferMemory2(device, 1, &buffer_bind);
+
+    allocator->block_ptrs[block] = NULL;
+    if (allocator->grow_mapped)
+        vkMapMemory(device, allocator->block_mems[block], 0, VK_WHOLE_SIZE, 0x0, &allocator->block_ptrs[block]);
+
+    allocator->block_caps[block] = size;
+    allocator->block_used[block] = 0;
+    allocator->block_count++;
+    return true;
+}
+static void gpu_buf_allocator_set_block(Gpu_Buf_Allocator *allocator, int block)
+{
+    allocator->block_used[allocator->block] = allocator->used;
+    allocator->block = block;
+    allocator->buf   = allocator->block_bufs[block];
+    allocator->ptr   = allocator->block_ptrs[block];
+    allocator->cap   = allocator->block_caps[block];
+    allocator->used  = allocator->block_used[block];
+}
+
 void gpu_reset_buf_allocator(VkDevice device, Gpu_Buf_Allocator *allocator)
 {
     allocator->alloc_cnt = 0;
     allocator->used = 0;
+    for(int i = 0; i < allocator->block_count; ++i)
+        allocator->block_used[i] = 0;
+    gpu_buf_allocator_set_block(allocator, 0);
 }
 void* gpu_make_buf_allocation(Gpu_Buf_Allocator *allocator, u64 size, u64 *ret_offset)
 {
     allocator->used = align(allocator->used, allocator->alignment);
-    u64 offset = allocator->used;
+    size = align(size, allocator->alignment);
 
     allocator->alloc_cnt++;
     ASSERT(allocator->alloc_cnt <= allocator->alloc_cap, "Gpu Buf Overflow");
 
-    allocator->used += align(size, allocator->alignment);
-    ASSERT(allocator->used <= allocator->cap, "Gpu Buf Overflow");
+    // Chained blocks are never smaller than block 0, so an allocation which fits nowhere gets a block its size
+    while (allocator->used + size > allocator->cap) {
+        if (allocator->block + 1 == allocator->block_count) {
+            bool grown = gpu_buf_allocator_add_block(
+                             allocator, size > allocator->block_caps[0] ? size : allocator->block_caps[0]);
+            ASSERT(grown, "Gpu Buf Overflow");
+            if (!grown)
+                return NULL;
+        }
+        gpu_buf_allocator_set_block(allocator, allocator->block + 1);
+    }
+    u64 offset = allocator->used;
+    allocator->used += size;
 
     if (ret_offset)
         *ret_offset = offset;
 
     return (void*)((u8*)allocator->ptr + offset);
 }
+void gpu_buf_allocator_mirror_block(Gpu_Buf_Allocator *to, Gpu_Buf_Allocator *from, int block)
+{
+    bool grown;
+    while (to->block_count <= block) {
+        grown = gpu_buf_allocator_add_block(to, from->block_caps[to->block_count]);
+        ASSERT(grown, "Gpu Buf Overflow");
+        if (!grown)
+            return;
+    }
+    ASSERT(to->block_caps[block] >= from->block_caps[block], "Mirrored block is smaller than the original");
+    if (to->block != block)
+        gpu_buf_allocator_set_block(to, block);
+}
 VkCopyBufferInfo2 gpu_buf_allocator_setup_copy(
     Gpu_Buf_Allocator *to_allocator,
     Gpu_Buf_Allocator *from_allocator,
@@ -2406,6 +2675,365 @@ VkCopyBufferInfo2 gpu_buf_allocator_setup_copy(
     return ret;
 }
 
+// `Staging Uploader
+Gpu_Staging_Uploader gpu_create_staging_uploader(VkDevice device, u32 memory_type_index, u64 size,
+                                                 u64 bytes_per_frame, int frame_count, int upload_cap)
+{
+    ASSERT(frame_count > 0 && frame_count <= GPU_UPLOADER_MAX_FRAMES, "Too many frames in flight");
+    Gpu_Staging_Uploader ret = {};
+    ret.alignment       = get_gpu_instance()->info.properties.limits.optimalBufferCopyOffsetAlignment;
+    ret.size            = align(size, ret.alignment); // so that aligned chunks never straddle the end
+    ret.bytes_per_frame = bytes_per_frame;
+    ret.frame_count     = frame_count;
+    ret.upload_cap      = upload_cap;
+    ret.uploads         = (Gpu_Upload*)memory_allocate_heap(sizeof(Gpu_Upload) * upload_cap, 8);
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_info.size        = ret.size;
+    buffer_info.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    auto check = vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &ret.ring);
+    DEBUG_OBJ_CREATION(vkCreateBuffer, check);
+
+    VkMemoryRequirements mem_req;
+    vkGetBufferMemoryRequirements(device, ret.ring, &mem_req);
+    ASSERT(mem_req.memoryTypeBits & (1 << memory_type_index), "Staging ring cannot live in this memory type");
+
+    VkMemoryAllocateInfo allocation_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocation_info.allocationSize  = mem_req.size;
+    allocation_info.memoryTypeIndex = memory_type_index;
+    check = vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &ret.memory);
+    DEBUG_OBJ_CREATION(vkAllocateMemory, check);
+
+    vkBindBufferMemory(device, ret.ring, ret.memory, 0);
+    vkMapMemory(device, ret.memory, 0, VK_WHOLE_SIZE, 0x0, (void**)&ret.ptr);
+    return ret;
+}
+void gpu_destroy_staging_uploader(VkDevice device, Gpu_Staging_Uploader *uploader)
+{
+    vkDestroyBuffer(device, uploader->ring, ALLOCATION_CALLBACKS);
+    vkFreeMemory(device, uploader->memory, ALLOCATION_CALLBACKS);
+    memory_free_heap(uploader->uploads);
+    *uploader = {};
+}
+
+u64 gpu_enqueue_upload(Gpu_Staging_Uploader *uploader, VkBuffer dst, u64 dst_offset, const void *src, u64 size)
+{
+    if (size == 0)
+        return uploader->enqueued;
+    if (uploader->upload_count == uploader->upload_cap)
+        return 0;
+
+    Gpu_Upload *upload = &uploader->uploads[(uploader->upload_first + uploader->upload_count) % uploader->upload_cap];
+    upload->dst        = dst;
+    upload->dst_offset = dst_offset;
+    upload->size       = size;
+    upload->staged     = 0;
+    upload->src        = (const u8*)src;
+    uploader->upload_count++;
+
+    uploader->enqueued += size;
+    return uploader->enqueued;
+}
+
+void gpu_uploader_begin_frame(Gpu_Staging_Uploader *uploader, int frame)
+{
+    ASSERT(frame < uploader->frame_count, "Frame out of range");
+    // Frames complete in order, so everything staged up to the end of this one is done with
+    if (uploader->frame_heads[frame] > uploader->tail)
+        uploader->tail = uploader->frame_heads[frame];
+    if (uploader->frame_staged[frame] > uploader->completed)
+        uploader->completed = uploader->frame_staged[frame];
+    uploader->frame = frame;
+}
+
+// Stage and record the copies only; the caller decides on the barrier. The regions are left in temp, grouped by
+// destination.
+static u64 gpu_uploader_record_copies(Gpu_Staging_Uploader *uploader, VkCommandBuffer cmd, int *ret_region_count,
+                                      VkBufferCopy2 **ret_regions, VkBuffer **ret_dsts)
+{
+    // An upload is cut at most once by the end of the ring, else it ends the frame
+    VkBufferCopy2 *regions = (VkBufferCopy2*)memory_allocate_temp(sizeof(VkBufferCopy2) * (uploader->upload_count + 1), 8);
+    VkBuffer *region_dsts  = (VkBuffer*)memory_allocate_temp(sizeof(VkBuffer) * (uploader->upload_count + 1), 8);
+    int region_count = 0;
+
+    u64 budget = uploader->bytes_per_frame;
+    u64 recorded = 0;
+    u64 position, space, chunk;
+    Gpu_Upload *upload;
+    while(uploader->upload_count > 0 && budget > 0) {
+        upload = &uploader->uploads[uploader->upload_first];
+
+        position = uploader->head % uploader->size;
+        space    = uploader->size - position;
+        if (space > uploader->size - (uploader->head - uploader->tail))
+            space = uploader->size - (uploader->head - uploader->tail);
+        if (space == 0)
+            break; // ring full until a frame completes
+
+        chunk = upload->size - upload->staged;
+        if (chunk > budget)
+            chunk = budget;
+        if (chunk > space)
+            chunk = space;
+
+        memcpy(uploader->ptr + position, upload->src + upload->staged, chunk);
+        regions[region_count] = {VK_STRUCTURE_TYPE_BUFFER_COPY_2};
+        regions[region_count].srcOffset = position;
+        regions[region_count].dstOffset = upload->dst_offset + upload->staged;
+        regions[region_count].size      = chunk;
+        region_dsts[region_count] = upload->dst;
+        region_count++;
+
+        upload->staged += chunk;
+        uploader->staged += chunk;
+        uploader->head = align(uploader->head + chunk, uploader->alignment);
+        budget   -= chunk;
+        recorded += chunk;
+
+        if (upload->staged == upload->size) {
+            uploader->upload_first = (uploader->upload_first + 1) % uploader->upload_cap;
+            uploader->upload_count--;
+        }
+    }
+    // A frame which staged nothing keeps what it last held: rewriting it with the current head would free ring
+    // space still being read if the slot is retired again before it is next used
+    if (region_count > 0) {
+        uploader->frame_heads [uploader->frame] = uploader->head;
+        uploader->frame_staged[uploader->frame] = uploader->staged;
+    }
+    *ret_region_count = region_count;
+    *ret_regions      = regions;
+    *ret_dsts         = region_dsts;
+    if (region_count == 0)
+        return 0;
+
+    // One copy per destination: gather each destination's regions to the front of the ones not yet recorded
+    VkCopyBufferInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2};
+    copy_info.srcBuffer = uploader->ring;
+    VkBufferCopy2 tmp_region;
+    VkBuffer tmp_dst;
+    int start = 0;
+    int end;
+    while(start < region_count) {
+        end = start + 1;
+        for(int i = end; i < region_count; ++i) {
+            if (region_dsts[i] != region_dsts[start])
+                continue;
+            tmp_region = regions[end];
+            regions[end] = regions[i];
+            regions[i] = tmp_region;
+            tmp_dst = region_dsts[end];
+            region_dsts[end] = region_dsts[i];
+            region_dsts[i] = tmp_dst;
+            end++;
+        }
+        copy_info.dstBuffer   = region_dsts[start];
+        copy_info.regionCount = end - start;
+        copy_info.pRegions    = regions + start;
+        vkCmdCopyBuffer2(cmd, &copy_info);
+        start = end;
+    }
+    return recorded;
+}
+u64 gpu_uploader_record(Gpu_Staging_Uploader *uploader, VkCommandBuffer cmd)
+{
+    int region_count;
+    VkBufferCopy2 *regions;
+    VkBuffer *region_dsts;
+    u64 recorded = gpu_uploader_record_copies(uploader, cmd, &region_count, &regions, &region_dsts);
+    if (recorded == 0)
+        return 0;
+
+    VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.memoryBarrierCount = 1;
+    dependency.pMemoryBarriers    = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    return recorded;
+}
+
+// `Transfer Queue
+Gpu_Transfer_Queue gpu_create_transfer_queue(VkDevice device, u32 memory_type_index, u64 ring_size,
+                                             u64 bytes_per_submit, int submit_count, int upload_cap)
+{
+    ASSERT(submit_count > 0 && submit_count <= GPU_TRANSFER_MAX_SUBMITS, "Too many transfer submissions in flight");
+    Gpu *gpu = get_gpu_instance();
+    Gpu_Transfer_Queue ret = {};
+    ret.queue           = gpu->vk_queues[2];
+    ret.family          = gpu->vk_queue_indices[2];
+    ret.graphics_family = gpu->vk_queue_indices[0];
+    ret.submit_count    = submit_count;
+    ret.uploader        = gpu_create_staging_uploader(device, memory_type_index, ring_size, bytes_per_submit,
+                                                      submit_count, upload_cap);
+    ret.acquire_values  = (u64*)memory_allocate_heap(sizeof(u64) * GPU_TRANSFER_ACQUIRE_CAP, 8);
+    ret.acquires        = (VkBufferMemoryBarrier2*)memory_allocate_heap(
+                              sizeof(VkBufferMemoryBarrier2) * GPU_TRANSFER_ACQUIRE_CAP, 8);
+
+    VkSemaphoreTypeCreateInfo type_info = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue  = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    semaphore_info.pNext = &type_info;
+    auto check = vkCreateSemaphore(device, &semaphore_info, ALLOCATION_CALLBACKS, &ret.timeline);
+    DEBUG_OBJ_CREATION(vkCreateSemaphore, check);
+
+    // A pool per slot, so that a slot's command buffer is reset with its pool
+    for(int i = 0; i < submit_count; ++i) {
+        ret.command_allocators[i] = gpu_create_command_allocator(device, ret.family, true, 1);
+        ret.cmds[i] = *gpu_allocate_command_buffers(device, &ret.command_allocators[i], 1, false);
+    }
+    return ret;
+}
+void gpu_destroy_transfer_queue(VkDevice device, Gpu_Transfer_Queue *transfer)
+{
+    gpu_transfer_wait(device, transfer, transfer->value, Max_u64);
+    for(int i = 0; i < transfer->submit_count; ++i)
+        gpu_destroy_command_allocator(device, &transfer->command_allocators[i]);
+    vkDestroySemaphore(device, transfer->timeline, ALLOCATION_CALLBACKS);
+    gpu_destroy_staging_uploader(device, &transfer->uploader);
+    memory_free_heap(transfer->acquire_values);
+    memory_free_heap(transfer->acquires);
+    *transfer = {};
+}
+
+VkResult gpu_transfer_wait(VkDevice device, Gpu_Transfer_Queue *transfer, u64 value, u64 timeout)
+{
+    VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores    = &transfer->timeline;
+    wait_info.pValues        = &value;
+    return vkWaitSemaphores(device, &wait_info, timeout);
+}
+
+u64 gpu_transfer_submit(VkDevice device, Gpu_Transfer_Queue *transfer)
+{
+    if (transfer->uploader.upload_count == 0)
+        return 0;
+
+    int slot = transfer->submit;
+    if (transfer->submit_values[slot]) {
+        gpu_transfer_wait(device, transfer, transfer->submit_values[slot], Max_u64);
+        gpu_uploader_begin_frame(&transfer->uploader, slot);
+    } else {
+        transfer->uploader.frame = slot;
+    }
+    gpu_reset_command_allocator(device, &transfer->command_allocators[slot]);
+    transfer->command_allocators[slot].buffer_count = 1; // keep the buffer, the pool reset only resets it
+
+    VkCommandBuffer cmd = transfer->cmds[slot];
+    gpu_begin_primary_command_buffer(cmd, true);
+
+    int region_count;
+    VkBufferCopy2 *regions;
+    VkBuffer *region_dsts;
+    u64 recorded = gpu_uploader_record_copies(&transfer->uploader, cmd, &region_count, &regions, &region_dsts);
+    if (recorded == 0) {
+        // The ring is full of work still in flight: submit nothing, and move on so that the next call waits on
+        // the oldest slot in flight, which frees some of it
+        gpu_end_command_buffer(cmd);
+        transfer->submit = (slot + 1) % transfer->submit_count;
+        return 0;
+    }
+
+    u64 value = transfer->value + 1;
+    if (transfer->family != transfer->graphics_family) {
+        ASSERT(transfer->acquire_count + region_count <= GPU_TRANSFER_ACQUIRE_CAP,
+               "Too many released ranges waiting to be acquired");
+        VkBufferMemoryBarrier2 *releases = transfer->acquires + transfer->acquire_count;
+        for(int i = 0; i < region_count; ++i) {
+            releases[i] = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2};
+            releases[i].srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+            releases[i].srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            releases[i].srcQueueFamilyIndex = transfer->family;
+            releases[i].dstQueueFamilyIndex = transfer->graphics_family;
+            releases[i].buffer              = region_dsts[i];
+            releases[i].offset              = regions[i].dstOffset;
+            releases[i].size                = regions[i].size;
+            transfer->acquire_values[transfer->acquire_count + i] = value;
+        }
+        VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        dependency.bufferMemoryBarrierCount = region_count;
+        dependency.pBufferMemoryBarriers    = releases;
+        vkCmdPipelineBarrier2(cmd, &dependency);
+
+        // The stored copies become the acquires: same ranges, the graphics half of the stages
+        for(int i = 0; i < region_count; ++i) {
+            releases[i].srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+            releases[i].srcAccessMask = VK_ACCESS_2_NONE;
+            releases[i].dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+            releases[i].dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+        }
+        transfer->acquire_count += region_count;
+    }
+    gpu_end_command_buffer(cmd);
+
+    VkCommandBufferSubmitInfo cmd_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    cmd_info.commandBuffer = cmd;
+
+    VkSemaphoreSubmitInfo signal_info = {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    signal_info.semaphore = transfer->timeline;
+    signal_info.value     = value;
+    signal_info.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+
+    VkSubmitInfo2 submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submit_info.commandBufferInfoCount   = 1;
+    submit_info.pCommandBufferInfos      = &cmd_info;
+    submit_info.signalSemaphoreInfoCount = 1;
+    submit_info.pSignalSemaphoreInfos    = &signal_info;
+    vkQueueSubmit2(transfer->queue, 1, &submit_info, NULL);
+
+    transfer->value = value;
+    transfer->submit_values[slot] = value;
+    transfer->submit_staged[slot] = transfer->uploader.staged;
+    transfer->submit = (slot + 1) % transfer->submit_count;
+    return value;
+}
+
+u64 gpu_transfer_get_value(Gpu_Transfer_Queue *transfer, u64 ticket)
+{
+    // The earliest submission in flight to have staged the ticket's last byte. Slots are only reused once their
+    // value is reached, so a ticket staged by none of them was staged by one which is already done.
+    u64 value = 0;
+    u64 oldest = Max_u64;
+    for(int i = 0; i < transfer->submit_count; ++i) {
+        if (transfer->submit_values[i] == 0)
+            continue;
+        if (transfer->submit_values[i] < oldest)
+            oldest = transfer->submit_values[i];
+        if (transfer->submit_staged[i] >= ticket && (value == 0 || transfer->submit_values[i] < value))
+            value = transfer->submit_values[i];
+    }
+    if (value == 0 && ticket <= transfer->uploader.staged && oldest != Max_u64)
+        value = oldest;
+    return value;
+}
+
+void gpu_transfer_acquire(Gpu_Transfer_Queue *transfer, VkCommandBuffer cmd, u64 value)
+{
+    int count = 0;
+    while(count < transfer->acquire_count && transfer->acquire_values[count] <= value)
+        count++;
+    if (count == 0)
+        return;
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.bufferMemoryBarrierCount = count;
+    dependency.pBufferMemoryBarriers    = transfer->acquires;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    transfer->acquire_count -= count;
+    memmove(transfer->acquires, transfer->acquires + count, sizeof(VkBufferMemoryBarrier2) * transfer->acquire_count);
+    memmove(transfer->acquire_values, transfer->acquire_values + count, sizeof(u64) * transfer->acquire_count);
+}
+
 // `Gpu Tex Allocator
 Gpu_Tex_Allocator gpu_create_tex_allocator(VkDeviceMemory img_mem, VkBuffer stage, void *mapped_ptr, u64 byte_cap, u32 img_cap)
 {
@@ -2416,25 +3044,103 @@ Gpu_Tex_Allocator gpu_create_tex_allocator(VkDeviceMemory img_mem, VkBuffer stag
     alloc.mem = img_mem;
     alloc.ptr = mapped_ptr;
 
-    // @Todo add row pitch alignment, not just the host buffer alignment offset
+    // Chains are tightly packed, so only their starts need aligning: levels of the supported formats are whole
+    // texel blocks, which is all a copy's buffer offset needs.
     alloc.alignment = get_gpu_instance()->info.properties.limits.optimalBufferCopyOffsetAlignment;
+    if (alloc.alignment < 16)
+        alloc.alignment = 16; // BC block size
 
     alloc.imgs = (VkImage*)memory_allocate_heap(sizeof(VkImage) * img_cap, 8);
     alloc.offsets = (u64*)memory_allocate_heap(sizeof(u64) * img_cap, 8);
+    alloc.infos = (Gpu_Tex_Info*)memory_allocate_heap(sizeof(Gpu_Tex_Info) * img_cap, 8);
 
     return alloc;
 }
 void gpu_destroy_tex_allocator(Gpu_Tex_Allocator *alloc)
 {
     memory_free_heap(alloc->imgs);
+    memory_free_heap(alloc->offsets);
+    memory_free_heap(alloc->infos);
+}
+// Texel block dimensions and bytes per block, 0 if the format is not one the texture paths know
+static u32 gpu_get_format_block(VkFormat format, u32 *block_width, u32 *block_height)
+{
+    *block_width  = 4;
+    *block_height = 4;
+    switch(format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        *block_width  = 1;
+        *block_height = 1;
+        return 4;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+        return 8;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        break;
+    }
+    // ASTC LDR formats come in UNORM, SRGB pairs from 4x4 to 12x12; every block is 16 bytes
+    static const u8 astc_blocks[14][2] = {
+        {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10},
+        {12, 10}, {12, 12},
+    };
+    if (format < VK_FORMAT_ASTC_4x4_UNORM_BLOCK || format > VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+        return 0;
+    int astc = (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) >> 1;
+    *block_width  = astc_blocks[astc][0];
+    *block_height = astc_blocks[astc][1];
+    return 16;
+}
+u64 gpu_get_tex_level_size(VkFormat format, u32 width, u32 height)
+{
+    u32 block_width, block_height;
+    u32 block_size = gpu_get_format_block(format, &block_width, &block_height);
+    ASSERT(block_size, "Unsupported texture format");
+    return (u64)((width + block_width - 1) / block_width) * ((height + block_height - 1) / block_height) * block_size;
+}
+bool gpu_tex_format_is_supported(VkFormat format)
+{
+    u32 block_width, block_height;
+    if (!gpu_get_format_block(format, &block_width, &block_height))
+        return false;
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(get_gpu_instance()->vk_physical_device, format, &props);
+    return props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+}
+u64 gpu_get_tex_size(Gpu_Tex_Info *info)
+{
+    u64 size = 0;
+    u32 width  = info->width;
+    u32 height = info->height;
+    for(u32 i = 0; i < info->mip_levels; ++i) {
+        size  += gpu_get_tex_level_size(info->format, width, height);
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    return size;
 }
-void* gpu_make_tex_allocation(VkDevice device, Gpu_Tex_Allocator *alloc, u32 width, u32 height, VkImage *image)
+void* gpu_make_tex_allocation(VkDevice device, Gpu_Tex_Allocator *alloc, Gpu_Tex_Info *tex_info, u64 size, VkImage *image)
 {
     VkImageCreateInfo info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
     info.imageType     = VK_IMAGE_TYPE_2D;
-    info.format        = VK_FORMAT_R8G8B8A8_SRGB;
-    info.extent        = {.width = width, .height = height, .depth = 1};
-    info.mipLevels     = 1; // @Todo mip mapping
+    info.format        = tex_info->format;
+    info.extent        = {.width = tex_info->width, .height = tex_info->height, .depth = 1};
+    info.mipLevels     = tex_info->mip_levels;
     info.arrayLayers   = 1;
     info.samples       = VK_SAMPLE_COUNT_1_BIT; // @Todo multisampling
     info.tiling        = VK_IMAGE_TILING_OPTIMAL;
@@ -2448,8 +3154,9 @@ void* gpu_make_tex_allocation(VkDevice device, Gpu_Tex_Allocator *alloc, u32 wid
     alloc->buf_used = align(alloc->buf_used, alloc->alignment);
     void *ptr = (u8*)alloc->ptr + alloc->buf_used;
     alloc->offsets[alloc->img_cnt] = alloc->buf_used;
+    alloc->infos[alloc->img_cnt] = *tex_info;
 
-    alloc->buf_used += width * height;
+    alloc->buf_used += size;
     alloc->imgs[alloc->img_cnt] = *image;
     alloc->img_cnt++;
     // @Todo Handle failure better here, or not? Not because it should never happen
@@ -2466,6 +3173,75 @@ void* gpu_make_tex_allocation(VkDevice device, Gpu_Tex_Allocator *alloc, u32 wid
 
     return ptr;
 }
+void gpu_cmd_tex_allocator_upload(VkCommandBuffer cmd, Gpu_Tex_Allocator *alloc, u32 first, u32 count)
+{
+    u32 region_count = 0;
+    for(u32 i = first; i < first + count; ++i)
+        region_count += alloc->infos[i].mip_levels;
+
+    VkImageMemoryBarrier2 *barriers =
+        (VkImageMemoryBarrier2*)memory_allocate_temp(sizeof(VkImageMemoryBarrier2) * count, 8);
+    VkBufferImageCopy2 *regions =
+        (VkBufferImageCopy2*)memory_allocate_temp(sizeof(VkBufferImageCopy2) * region_count, 8);
+
+    for(u32 i = 0; i < count; ++i) {
+        barriers[i] = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        barriers[i].srcStageMask        = VK_PIPELINE_STAGE_2_NONE;
+        barriers[i].srcAccessMask       = VK_ACCESS_2_NONE;
+        barriers[i].dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+        barriers[i].dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barriers[i].oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[i].newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].image               = alloc->imgs[first + i];
+        barriers[i].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, alloc->infos[first + i].mip_levels, 0, 1};
+    }
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = count;
+    dependency.pImageMemoryBarriers    = barriers;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    VkCopyBufferToImageInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2};
+    copy_info.srcBuffer      = alloc->stage;
+    copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+    Gpu_Tex_Info *info;
+    u64 offset;
+    u32 width, height;
+    VkBufferImageCopy2 *image_regions = regions;
+    for(u32 i = first; i < first + count; ++i) {
+        info   = &alloc->infos[i];
+        offset = alloc->offsets[i];
+        width  = info->width;
+        height = info->height;
+        for(u32 level = 0; level < info->mip_levels; ++level) {
+            image_regions[level] = {VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2};
+            image_regions[level].bufferOffset     = offset;
+            image_regions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            image_regions[level].imageExtent      = {width, height, 1};
+
+            offset += gpu_get_tex_level_size(info->format, width, height);
+            width   = width  > 1 ? width  >> 1 : 1;
+            height  = height > 1 ? height >> 1 : 1;
+        }
+        copy_info.dstImage    = alloc->imgs[i];
+        copy_info.regionCount = info->mip_levels;
+        copy_info.pRegions    = image_regions;
+        vkCmdCopyBufferToImage2(cmd, &copy_info);
+        image_regions += info->mip_levels;
+    }
+
+    for(u32 i = 0; i < count; ++i) {
+        barriers[i].srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+        barriers[i].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barriers[i].dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        barriers[i].dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barriers[i].oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[i].newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
 void gpu_reset_tex_allocator(Gpu_Tex_Allocator *alloc)
 {
     alloc->img_cnt  = 0;
@@ -2473,6 +3249,531 @@ void gpu_reset_tex_allocator(Gpu_Tex_Allocator *alloc)
     alloc->mem_used = 0;
 }
 
+// `Virtual Textures
+Gpu_Virtual_Texture gpu_create_virtual_texture(
+    VkDevice device, Virtual_Texture *vt, VkFormat format, u32 device_memory_type_index,
+    u32 host_memory_type_index, u32 feedback_count, int tiles_per_frame, int frame_count)
+{
+    ASSERT(tiles_per_frame <= GPU_VT_MAX_TILES_PER_FRAME, "Too many tiles per frame");
+    ASSERT(frame_count > 0 && frame_count <= GPU_UPLOADER_MAX_FRAMES, "Too many frames in flight");
+    VkPhysicalDeviceLimits *limits = &get_gpu_instance()->info.properties.limits;
+
+    Gpu_Virtual_Texture ret = {};
+    ret.format          = format;
+    ret.tile_size       = gpu_get_tex_level_size(format, VT_TILE_SLOT_SIZE, VT_TILE_SLOT_SIZE);
+    ret.page_table_size = sizeof(u32) * vt->page_count;
+    ret.feedback_count  = feedback_count;
+    ret.tiles_per_frame = tiles_per_frame;
+    ret.frame_count     = frame_count;
+
+    // Tiles at copy alignment (tile sizes are multiples of 16), feedback at storage buffer alignment
+    u64 alignment       = limits->optimalBufferCopyOffsetAlignment > limits->minStorageBufferOffsetAlignment ?
+                          limits->optimalBufferCopyOffsetAlignment : limits->minStorageBufferOffsetAlignment;
+    ret.feedback_offset = align(ret.tile_size * tiles_per_frame + ret.page_table_size, alignment);
+    ret.frame_size      = align(ret.feedback_offset + sizeof(u32) * feedback_count, alignment);
+
+    VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    image_info.imageType     = VK_IMAGE_TYPE_2D;
+    image_info.format        = format;
+    image_info.extent        = {vt->pool_width * VT_TILE_SLOT_SIZE, vt->pool_height * VT_TILE_SLOT_SIZE, 1};
+    image_info.mipLevels     = 1;
+    image_info.arrayLayers   = 1;
+    image_info.samples       = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    auto check = vkCreateImage(device, &image_info, ALLOCATION_CALLBACKS, &ret.pool);
+    DEBUG_OBJ_CREATION(vkCreateImage, check);
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_info.size        = ret.page_table_size;
+    buffer_info.usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    check = vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &ret.page_table);
+    DEBUG_OBJ_CREATION(vkCreateBuffer, check);
+
+    buffer_info.size  = ret.frame_size * frame_count;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    check = vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &ret.stage);
+    DEBUG_OBJ_CREATION(vkCreateBuffer, check);
+
+    // The page table follows the pool on a page of its own (bufferImageGranularity)
+    VkMemoryRequirements image_req, table_req, stage_req;
+    vkGetImageMemoryRequirements(device, ret.pool, &image_req);
+    vkGetBufferMemoryRequirements(device, ret.page_table, &table_req);
+    vkGetBufferMemoryRequirements(device, ret.stage, &stage_req);
+    ASSERT(image_req.memoryTypeBits & table_req.memoryTypeBits & (1 << device_memory_type_index),
+           "Tile pool cannot live in this memory type");
+    ASSERT(stage_req.memoryTypeBits & (1 << host_memory_type_index), "Tile staging cannot live in this memory type");
+
+    u64 table_alignment = table_req.alignment > limits->bufferImageGranularity ?
+                          table_req.alignment : limits->bufferImageGranularity;
+    u64 table_offset    = align(image_req.size, table_alignment);
+
+    VkMemoryAllocateInfo allocation_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocation_info.allocationSize  = table_offset + table_req.size;
+    allocation_info.memoryTypeIndex = device_memory_type_index;
+    check = vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &ret.device_memory);
+    DEBUG_OBJ_CREATION(vkAllocateMemory, check);
+    vkBindImageMemory(device, ret.pool, ret.device_memory, 0);
+    vkBindBufferMemory(device, ret.page_table, ret.device_memory, table_offset);
+
+    allocation_info.allocationSize  = stage_req.size;
+    allocation_info.memoryTypeIndex = host_memory_type_index;
+    check = vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &ret.host_memory);
+    DEBUG_OBJ_CREATION(vkAllocateMemory, check);
+    vkBindBufferMemory(device, ret.stage, ret.host_memory, 0);
+    vkMapMemory(device, ret.host_memory, 0, VK_WHOLE_SIZE, 0x0, (void**)&ret.ptr);
+
+    // Frames which have not run yet read back as no feedback
+    for(int i = 0; i < frame_count; ++i)
+        memset(ret.ptr + i * ret.frame_size + ret.feedback_offset, 0xff, sizeof(u32) * feedback_count);
+
+    VkImageViewCreateInfo view_info = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    view_info.image            = ret.pool;
+    view_info.viewType         = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format           = format;
+    view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    check = vkCreateImageView(device, &view_info, ALLOCATION_CALLBACKS, &ret.pool_view);
+    DEBUG_OBJ_CREATION(vkCreateImageView, check);
+    return ret;
+}
+void gpu_destroy_virtual_texture(VkDevice device, Gpu_Virtual_Texture *gvt)
+{
+    vkDestroyImageView(device, gvt->pool_view, ALLOCATION_CALLBACKS);
+    vkDestroyImage(device, gvt->pool, ALLOCATION_CALLBACKS);
+    vkDestroyBuffer(device, gvt->page_table, ALLOCATION_CALLBACKS);
+    vkDestroyBuffer(device, gvt->stage, ALLOCATION_CALLBACKS);
+    vkFreeMemory(device, gvt->device_memory, ALLOCATION_CALLBACKS);
+    vkFreeMemory(device, gvt->host_memory, ALLOCATION_CALLBACKS);
+    *gvt = {};
+}
+
+const u32* gpu_vt_begin_frame(Gpu_Virtual_Texture *gvt, int frame)
+{
+    ASSERT(frame < gvt->frame_count, "Frame out of range");
+    gvt->frame        = frame;
+    gvt->staged_count = 0;
+    return (const u32*)(gvt->ptr + frame * gvt->frame_size + gvt->feedback_offset);
+}
+
+void* gpu_vt_stage_tile(Gpu_Virtual_Texture *gvt, u32 slot)
+{
+    if (gvt->staged_count == gvt->tiles_per_frame)
+        return NULL;
+    gvt->staged_slots[gvt->staged_count] = slot;
+    return gvt->ptr + gvt->frame * gvt->frame_size + gvt->staged_count++ * gvt->tile_size;
+}
+
+void gpu_cmd_vt_upload(VkCommandBuffer cmd, Gpu_Virtual_Texture *gvt, Virtual_Texture *vt)
+{
+    u64 frame_offset = gvt->frame * gvt->frame_size;
+    bool table_dirty = vt->dirty_end > vt->dirty_first;
+    bool pool_dirty  = gvt->staged_count > 0 || !gvt->pool_written;
+
+    // The last frames' reads of the pool and page table, and of the feedback by the cpu (its fence was waited on),
+    // must be done before they are overwritten
+    VkImageMemoryBarrier2 image_barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+    image_barrier.srcStageMask        = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    image_barrier.srcAccessMask       = VK_ACCESS_2_NONE;
+    image_barrier.dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+    image_barrier.dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    image_barrier.oldLayout           = gvt->pool_written ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL :
+                                                            VK_IMAGE_LAYOUT_UNDEFINED;
+    image_barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.image               = gvt->pool;
+    image_barrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    VkMemoryBarrier2 memory_barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    memory_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    memory_barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    memory_barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    memory_barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.memoryBarrierCount      = 1;
+    dependency.pMemoryBarriers         = &memory_barrier;
+    dependency.imageMemoryBarrierCount = pool_dirty ? 1 : 0;
+    dependency.pImageMemoryBarriers    = &image_barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    if (gvt->staged_count) {
+        VkBufferImageCopy2 regions[GPU_VT_MAX_TILES_PER_FRAME];
+        u32 slot_x, slot_y;
+        for(int i = 0; i < gvt->staged_count; ++i) {
+            vt_get_slot_coords(vt, gvt->staged_slots[i], &slot_x, &slot_y);
+            regions[i] = {VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2};
+            regions[i].bufferOffset     = frame_offset + i * gvt->tile_size;
+            regions[i].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            regions[i].imageOffset      = {(s32)(slot_x * VT_TILE_SLOT_SIZE), (s32)(slot_y * VT_TILE_SLOT_SIZE), 0};
+            regions[i].imageExtent      = {VT_TILE_SLOT_SIZE, VT_TILE_SLOT_SIZE, 1};
+        }
+        VkCopyBufferToImageInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2};
+        copy_info.srcBuffer      = gvt->stage;
+        copy_info.dstImage       = gvt->pool;
+        copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copy_info.regionCount    = gvt->staged_count;
+        copy_info.pRegions       = regions;
+        vkCmdCopyBufferToImage2(cmd, &copy_info);
+    }
+
+    if (table_dirty) {
+        u64 offset = sizeof(u32) * vt->dirty_first;
+        u64 size   = sizeof(u32) * (vt->dirty_end - vt->dirty_first);
+        u64 stage_offset = frame_offset + gvt->tile_size * gvt->tiles_per_frame;
+        memcpy(gvt->ptr + stage_offset, vt->page_table + vt->dirty_first, size);
+
+        VkBufferCopy2 region = {VK_STRUCTURE_TYPE_BUFFER_COPY_2};
+        region.srcOffset = stage_offset;
+        region.dstOffset = offset;
+        region.size      = size;
+        VkCopyBufferInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2};
+        copy_info.srcBuffer   = gvt->stage;
+        copy_info.dstBuffer   = gvt->page_table;
+        copy_info.regionCount = 1;
+        copy_info.pRegions    = &region;
+        vkCmdCopyBuffer2(cmd, &copy_info);
+        vt_clear_dirty(vt);
+    }
+
+    vkCmdFillBuffer(cmd, gvt->stage, frame_offset + gvt->feedback_offset, sizeof(u32) * gvt->feedback_count,
+                    VT_NULL_FEEDBACK);
+
+    image_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+    image_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    image_barrier.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    image_barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    image_barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    memory_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    memory_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    memory_barrier.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    memory_barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    gvt->pool_written = true;
+}
+
+void gpu_cmd_vt_feedback_barrier(VkCommandBuffer cmd)
+{
+    VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_HOST_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.memoryBarrierCount = 1;
+    dependency.pMemoryBarriers    = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+// `Gpu Memory Allocator
+Gpu_Memory_Allocator gpu_create_memory_allocator(
+    u32 memory_type_index, bool host_visible, u64 block_size, u64 granularity, int block_allocation_cap,
+    VkBufferUsageFlags block_buffer_usage)
+{
+    Gpu_Memory_Allocator ret = {};
+    ret.memory_type_index    = memory_type_index;
+    ret.host_visible         = host_visible;
+    ret.block_size           = block_size;
+    ret.granularity          = granularity;
+    ret.block_allocation_cap = block_allocation_cap;
+    ret.block_buffer_usage   = block_buffer_usage;
+    return ret;
+}
+
+static void gpu_release_memory_block(VkDevice device, Gpu_Memory_Allocator *alloc, int block)
+{
+    if (alloc->blocks[block].memory == VK_NULL_HANDLE)
+        return;
+    if (alloc->blocks[block].buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, alloc->blocks[block].buffer, ALLOCATION_CALLBACKS);
+    // Freeing mapped memory unmaps it
+    vkFreeMemory(device, alloc->blocks[block].memory, ALLOCATION_CALLBACKS);
+    destroy_suballocator(&alloc->blocks[block].suballocator);
+    alloc->blocks[block] = {};
+}
+void gpu_destroy_memory_allocator(VkDevice device, Gpu_Memory_Allocator *alloc)
+{
+    for(int i = 0; i < alloc->block_count; ++i)
+        gpu_release_memory_block(device, alloc, i);
+    alloc->block_count = 0;
+}
+
+// Released blocks' slots are reused first, so that the indices of live blocks never change. Returns the block
+// index, -1 on failure.
+static int gpu_add_memory_block(VkDevice device, Gpu_Memory_Allocator *alloc, u64 size)
+{
+    int block = alloc->block_count;
+    for(int i = 0; i < alloc->block_count; ++i)
+        if (alloc->blocks[i].memory == VK_NULL_HANDLE) {
+            block = i;
+            break;
+        }
+    if (block == GPU_MEMORY_ALLOCATOR_MAX_BLOCKS)
+        return -1;
+
+    Gpu_Memory_Block *ret = &alloc->blocks[block];
+    *ret = {};
+
+    VkMemoryAllocateInfo allocation_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocation_info.allocationSize  = size;
+    allocation_info.memoryTypeIndex = alloc->memory_type_index;
+
+    VkResult check;
+    if (alloc->block_buffer_usage) {
+        VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        buffer_info.size        = size;
+        buffer_info.usage       = alloc->block_buffer_usage;
+        check = vkCreateBuffer(device, &buffer_info, ALLOCATION_CALLBACKS, &ret->buffer);
+        DEBUG_OBJ_CREATION(vkCreateBuffer, check);
+
+        VkMemoryRequirements mem_req;
+        vkGetBufferMemoryRequirements(device, ret->buffer, &mem_req);
+        ASSERT(mem_req.memoryTypeBits & (1 << alloc->memory_type_index),
+               "Block buffer cannot live in this allocator's memory type");
+        allocation_info.allocationSize = mem_req.size;
+    }
+
+    check = vkAllocateMemory(device, &allocation_info, ALLOCATION_CALLBACKS, &ret->memory);
+    if (check != VK_SUCCESS) {
+        if (ret->buffer != VK_NULL_HANDLE)
+            vkDestroyBuffer(device, ret->buffer, ALLOCATION_CALLBACKS);
+        *ret = {};
+        return -1;
+    }
+    if (ret->buffer != VK_NULL_HANDLE)
+        vkBindBufferMemory(device, ret->buffer, ret->memory, 0);
+
+    if (alloc->host_visible)
+        vkMapMemory(device, ret->memory, 0, VK_WHOLE_SIZE, 0x0, &ret->ptr);
+    ret->suballocator = create_suballocator(size, alloc->granularity, alloc->block_allocation_cap);
+    if (block == alloc->block_count)
+        alloc->block_count++;
+    return block;
+}
+
+bool gpu_allocate_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkMemoryRequirements *requirements,
+                         Suballocation_Kind kind, Gpu_Memory_Allocation *ret)
+{
+    ASSERT(requirements->memoryTypeBits & (1 << alloc->memory_type_index),
+           "Resource cannot live in this allocator's memory type");
+
+    Suballocation suballocation;
+    int block = -1;
+    for(int i = 0; i < alloc->block_count; ++i) {
+        if (alloc->blocks[i].memory == VK_NULL_HANDLE)
+            continue;
+        if (suballocator_allocate(&alloc->blocks[i].suballocator, requirements->size, requirements->alignment,
+                                  kind, &suballocation))
+        {
+            block = i;
+            break;
+        }
+    }
+    if (block == -1) {
+        // Oversized requests get a block of their own, rounded to the granularity so the whole page is theirs
+        u64 size = requirements->size + requirements->alignment + alloc->granularity;
+        size = size > alloc->block_size ? align(size, alloc->granularity) : alloc->block_size;
+        block = gpu_add_memory_block(device, alloc, size);
+        if (block == -1)
+            return false;
+
+        if (!suballocator_allocate(&alloc->blocks[block].suballocator, requirements->size, requirements->alignment,
+                                   kind, &suballocation))
+            return false;
+    }
+
+    ret->memory = alloc->blocks[block].memory;
+    ret->offset = suballocation.offset;
+    ret->size   = suballocation.size;
+    ret->ptr    = alloc->blocks[block].ptr ? (u8*)alloc->blocks[block].ptr + suballocation.offset : NULL;
+    ret->block  = block;
+    ret->handle = suballocation.block;
+    return true;
+}
+void gpu_free_memory(Gpu_Memory_Allocator *alloc, Gpu_Memory_Allocation *allocation)
+{
+    // @Todo Give empty blocks (beyond the first) back to the driver
+    suballocator_free(&alloc->blocks[allocation->block].suballocator, allocation->handle);
+    *allocation = {};
+}
+
+bool gpu_allocate_buffer_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkBuffer buffer,
+                                Gpu_Memory_Allocation *ret)
+{
+    VkMemoryRequirements req;
+    vkGetBufferMemoryRequirements(device, buffer, &req);
+    if (!gpu_allocate_memory(device, alloc, &req, SUBALLOCATION_KIND_LINEAR, ret))
+        return false;
+    vkBindBufferMemory(device, buffer, ret->memory, ret->offset);
+    return true;
+}
+bool gpu_allocate_image_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkImage image, VkImageTiling tiling,
+                               Gpu_Memory_Allocation *ret)
+{
+    VkMemoryRequirements req;
+    vkGetImageMemoryRequirements(device, image, &req);
+    Suballocation_Kind kind =
+        tiling == VK_IMAGE_TILING_OPTIMAL ? SUBALLOCATION_KIND_OPTIMAL : SUBALLOCATION_KIND_LINEAR;
+    if (!gpu_allocate_memory(device, alloc, &req, kind, ret))
+        return false;
+    vkBindImageMemory(device, image, ret->memory, ret->offset);
+    return true;
+}
+
+// `Defragmentation
+Gpu_Defragmenter gpu_create_defragmenter(Gpu_Memory_Allocator *allocator, u64 bytes_per_frame, u64 alignment,
+                                         int move_cap)
+{
+    ASSERT(allocator->block_buffer_usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT &&
+           allocator->block_buffer_usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+           "Defragmented blocks must be copied between");
+    Gpu_Defragmenter ret = {};
+    ret.allocator       = allocator;
+    ret.bytes_per_frame = bytes_per_frame;
+    ret.alignment       = alignment;
+    ret.source_block    = -1;
+    ret.move_cap        = move_cap;
+    ret.moves           = (Gpu_Defrag_Move*)memory_allocate_heap(sizeof(Gpu_Defrag_Move) * move_cap, 8);
+    return ret;
+}
+void gpu_destroy_defragmenter(Gpu_Defragmenter *defrag)
+{
+    memory_free_heap(defrag->moves);
+    *defrag = {};
+}
+
+// The sparsest block below GPU_DEFRAG_MAX_OCCUPANCY whose allocations fit in the free space of the others, -1 if
+// there is none
+static int gpu_defrag_pick_source(Gpu_Memory_Allocator *alloc)
+{
+    u64 free_total = 0;
+    for(int i = 0; i < alloc->block_count; ++i)
+        if (alloc->blocks[i].memory != VK_NULL_HANDLE)
+            free_total += alloc->blocks[i].suballocator.size - alloc->blocks[i].suballocator.used;
+
+    int ret = -1;
+    float occupancy;
+    float sparsest = GPU_DEFRAG_MAX_OCCUPANCY;
+    Suballocator *suballocator;
+    for(int i = 0; i < alloc->block_count; ++i) {
+        suballocator = &alloc->blocks[i].suballocator;
+        if (alloc->blocks[i].memory == VK_NULL_HANDLE || suballocator->allocation_count == 0)
+            continue;
+        occupancy = (float)suballocator->used / suballocator->size;
+        if (occupancy < sparsest && suballocator->used <= free_total - (suballocator->size - suballocator->used)) {
+            sparsest = occupancy;
+            ret = i;
+        }
+    }
+    return ret;
+}
+
+int gpu_defrag_record(Gpu_Defragmenter *defrag, VkCommandBuffer cmd)
+{
+    if (defrag->move_count > 0)
+        return 0;
+
+    Gpu_Memory_Allocator *alloc = defrag->allocator;
+    if (defrag->source_block == -1) {
+        defrag->source_block = gpu_defrag_pick_source(alloc);
+        defrag->cursor = 0;
+        if (defrag->source_block == -1)
+            return 0;
+    }
+
+    // Released blocks are skipped as destinations
+    Suballocator *allocs[GPU_MEMORY_ALLOCATOR_MAX_BLOCKS];
+    for(int i = 0; i < alloc->block_count; ++i)
+        allocs[i] = alloc->blocks[i].memory == VK_NULL_HANDLE ? NULL : &alloc->blocks[i].suballocator;
+    defrag->move_count = suballocator_plan_moves(alloc->block_count, allocs, defrag->source_block, &defrag->cursor,
+                                                 defrag->bytes_per_frame, defrag->alignment, defrag->move_cap,
+                                                 defrag->moves);
+    if (defrag->move_count == 0) {
+        // Nothing left in the block fits elsewhere
+        defrag->source_block = -1;
+        return 0;
+    }
+
+    // One copy per destination block. Moves are few, so the regions are just gathered per block.
+    Gpu_Defrag_Move *move;
+    VkBufferCopy2 *regions = (VkBufferCopy2*)memory_allocate_temp(sizeof(VkBufferCopy2) * defrag->move_count, 8);
+    VkCopyBufferInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2};
+    copy_info.srcBuffer = alloc->blocks[defrag->source_block].buffer;
+    copy_info.pRegions  = regions;
+    for(int i = 0; i < alloc->block_count; ++i) {
+        copy_info.regionCount = 0;
+        for(int j = 0; j < defrag->move_count; ++j) {
+            move = &defrag->moves[j];
+            if (move->dst_block != i)
+                continue;
+            regions[copy_info.regionCount] = {VK_STRUCTURE_TYPE_BUFFER_COPY_2};
+            regions[copy_info.regionCount].srcOffset = move->src_offset;
+            regions[copy_info.regionCount].dstOffset = move->dst_offset;
+            regions[copy_info.regionCount].size      = move->size;
+            copy_info.regionCount++;
+        }
+        if (copy_info.regionCount == 0)
+            continue;
+        copy_info.dstBuffer = alloc->blocks[i].buffer;
+        vkCmdCopyBuffer2(cmd, &copy_info);
+    }
+
+    VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.memoryBarrierCount = 1;
+    dependency.pMemoryBarriers    = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    return defrag->move_count;
+}
+
+Gpu_Defrag_Move* gpu_defrag_complete(VkDevice device, Gpu_Defragmenter *defrag, int *move_count)
+{
+    *move_count = defrag->move_count;
+    if (defrag->move_count == 0)
+        return defrag->moves;
+
+    Gpu_Memory_Allocator *alloc = defrag->allocator;
+    Suballocator *source = &alloc->blocks[defrag->source_block].suballocator;
+    for(int i = 0; i < defrag->move_count; ++i)
+        suballocator_free(source, defrag->moves[i].src_handle);
+    defrag->move_count = 0;
+
+    // Done with the block once everything has been tried; it only goes back to the driver if it emptied
+    Suballocation next;
+    if (!suballocator_find_allocation(source, defrag->cursor, &next)) {
+        if (source->allocation_count == 0)
+            gpu_release_memory_block(device, alloc, defrag->source_block);
+        defrag->source_block = -1;
+    }
+    return defrag->moves;
+}
+
+bool gpu_apply_defrag_move(Gpu_Memory_Allocator *alloc, Gpu_Memory_Allocation *allocation, int move_count,
+                           Gpu_Defrag_Move *moves)
+{
+    if (!suballocator_apply_move(&allocation->block, &allocation->offset, &allocation->handle, move_count, moves))
+        return false;
+    Gpu_Memory_Block *block = &alloc->blocks[allocation->block];
+    allocation->memory = block->memory;
+    allocation->ptr    = block->ptr ? (u8*)block->ptr + allocation->offset : NULL;
+    return true;
+}
+
 // `Attachments
 VkImageView gpu_create_depth_attachment_view(VkDevice vk_device, VkImage vk_image)
 {
@@ -12,6 +12,8 @@
 
 #include "basic.h"
 #include "glfw.hpp"
+#include "suballocator.hpp"
+#include "virtual_texture.hpp"
 
 struct Gpu_Tex_Allocator;
 struct Gpu_Buf_Allocator;
@@ -39,9 +41,15 @@ struct Gpu_Bind_Index_Vertex_Buffers_Info {
 };
 typedef void (*Pfn_Bind_Index_Vertex_Buffers)(Gpu_Bind_Index_Vertex_Buffers_Info*);
 
-static constexpr u64 GPU_VERTEX_ALLOCATOR_SIZE = 1024 * 1024;
-static constexpr u64 GPU_INDEX_ALLOCATOR_SIZE  = 1024 * 1024;
-static constexpr u64 GPU_TEXTURE_ALLOCATOR_SIZE = 1024 * 1024;
+// Arenas are sized as a fraction of their heap's budget at startup (VK_EXT_memory_budget, else the heap size),
+// clamped to [GPU_ALLOCATOR_MIN_SIZE, GPU_ALLOCATOR_MAX_SIZE]. That is only a first guess: arenas chain on more
+// blocks when they fill up, see Gpu_Buf_Allocator.
+static constexpr u64 GPU_ALLOCATOR_MIN_SIZE              = 1024 * 1024;
+static constexpr u64 GPU_ALLOCATOR_MAX_SIZE              = 256 * 1024 * 1024;
+static constexpr u64 GPU_VERTEX_ALLOCATOR_BUDGET_DIVISOR  = 16;
+static constexpr u64 GPU_INDEX_ALLOCATOR_BUDGET_DIVISOR   = 64;
+static constexpr u64 GPU_TEXTURE_ALLOCATOR_BUDGET_DIVISOR = 8;
+static constexpr u32 GPU_BUF_ALLOCATOR_ALLOCATION_CAP    = 4096;
 
 // @Todo Storage equivalents
 static constexpr u32 GPU_MAX_ALLOCATOR_COUNT_INDEX   = 1;
@@ -75,9 +83,21 @@ struct Gpu_Memory_Resources {
     VkImage        color_attachments                    [GPU_MAX_ATTACHMENT_COUNT_COLOR ];
     VkImage        depth_attachments                    [GPU_MAX_ATTACHMENT_COUNT_DEPTH ];
     VkBuffer       texture_stages                       [GPU_MAX_ALLOCATOR_COUNT_TEXTURE];
+
+    // For resources made after init: device local, and host visible and coherent (the same type under uma)
+    u32 device_memory_type;
+    u32 host_memory_type;
+
+    // Block sizes chosen from the budgets
+    u64 index_arena_size;
+    u64 vertex_arena_size;
+    u64 texture_arena_size;
 };
 struct GpuInfo {
     VkPhysicalDeviceProperties properties;
+    bool memory_budget; // VK_EXT_memory_budget is enabled
+    bool texture_compression_bc;
+    bool texture_compression_astc; // LDR
 };
 struct Gpu {
     GpuInfo info;
@@ -100,7 +120,7 @@ struct Gpu {
 
     Gpu_Buf_Allocator *uniform_allocator;
 
-    Gpu_Tex_Allocator *texture_allocator;
+    Gpu_Tex_Allocator *texture_allocator; // texture_arena_size of images and as much staging
 };
 Gpu* get_gpu_instance();
 
@@ -133,21 +153,50 @@ void destroy_vk_queue(Gpu *gpu);
 void gpu_init_memory_resources(Gpu *gpu);
 
 // Buffer Allocator
+//
+// Linear allocation through a chain of buffers. Block 0 is the buffer the allocator is made with (and does not
+// own). Once growth is enabled, an allocation which does not fit in the current block moves on to the next one,
+// chaining a new VkBuffer and VkDeviceMemory on if there is none; otherwise it asserts. Offsets are relative to
+// the block the allocation landed in: 'block' after gpu_make_buf_allocation().
+static constexpr int GPU_BUF_ALLOCATOR_MAX_BLOCKS = 8;
+
 struct Gpu_Buf_Allocator {
     u32 alloc_cnt;
     u32 alloc_cap;
 
     u64  alignment;
-    u64  used;
-    u64  cap;
+    u64  used; // of the current block
+    u64  cap;  // of the current block
 
-    VkBuffer buf;
+    VkBuffer buf; // current block
     void *ptr;
+
+    int block;
+    int block_count;
+    u64            block_caps[GPU_BUF_ALLOCATOR_MAX_BLOCKS];
+    u64            block_used[GPU_BUF_ALLOCATOR_MAX_BLOCKS]; // as of leaving the block; 'used' for the current one
+    VkBuffer       block_bufs[GPU_BUF_ALLOCATOR_MAX_BLOCKS];
+    VkDeviceMemory block_mems[GPU_BUF_ALLOCATOR_MAX_BLOCKS]; // VK_NULL_HANDLE for block 0
+    void          *block_ptrs[GPU_BUF_ALLOCATOR_MAX_BLOCKS];
+
+    int grow_memory_type; // -1 unless growth is enabled
+    bool grow_mapped;
+    float grow_priority;
+    VkBufferUsageFlags grow_usage;
 };
 Gpu_Buf_Allocator gpu_get_buf_allocator(VkBuffer buffer, void *ptr, u64 size, u32 count);
+// Chained blocks get 'usage' and 'memory_type_index', and are at least as large as block 0
+void gpu_buf_allocator_enable_growth(Gpu_Buf_Allocator *allocator, VkBufferUsageFlags usage, u32 memory_type_index,
+                                     bool mapped, float priority);
+// Destroy the chained blocks (block 0 belongs to the caller)
+void gpu_destroy_buf_allocator_blocks(VkDevice device, Gpu_Buf_Allocator *allocator);
+// Back to the start of block 0; chained blocks are kept for reuse
 void gpu_reset_buf_allocator(VkDevice device, Gpu_Buf_Allocator *allocator);
 // Reserve space in allocator; Return pointer to beginning of new allocation
 void* gpu_make_buf_allocation(Gpu_Buf_Allocator *allocator, u64 size, u64 *offset);
+// Make 'block' current in 'to', chaining on blocks as large as 'from's up to it, so that allocations can be made
+// at the same offsets as in 'from' (device allocators mirroring their host staging allocators)
+void gpu_buf_allocator_mirror_block(Gpu_Buf_Allocator *to, Gpu_Buf_Allocator *from, int block);
 // Get copy information using allocators
 VkCopyBufferInfo2 gpu_buf_allocator_setup_copy(
     Gpu_Buf_Allocator *to_allocator,
@@ -158,6 +207,72 @@ inline static VkSubmitInfo2 gpu_cmd_begin_buf_transfer_graphics(Gpu_Buffer_Copy_
     return get_gpu_instance()->device_buffer_upload_fn(info);
 }
 
+// Staging Uploader
+//
+// A persistent, mapped ring buffer that uploads are streamed through. Uploads of any size are queued; each frame
+// at most 'bytes_per_frame' of them are copied into the ring (split wherever the ring or the budget runs out) and
+// recorded as one vkCmdCopyBuffer2 per destination buffer. The ring space a frame used is given back when that
+// frame in flight is known to be complete, so only the ring, never a whole upload, needs host memory.
+static constexpr int GPU_UPLOADER_MAX_FRAMES = 3;
+
+struct Gpu_Upload {
+    VkBuffer dst;
+    u64 dst_offset;
+    u64 size;
+    u64 staged; // bytes already copied into the ring
+    const u8 *src; // must stay valid until the upload is complete
+};
+struct Gpu_Staging_Uploader {
+    VkBuffer ring;
+    VkDeviceMemory memory;
+    u8 *ptr;
+    u64 size;
+    u64 alignment; // of the staged chunks in the ring
+    u64 bytes_per_frame;
+
+    // Byte counts since creation: the ring holds [tail, head), and uploads are complete up to 'completed'
+    u64 head;
+    u64 tail;
+    u64 enqueued;
+    u64 staged;
+    u64 completed;
+
+    int frame_count;
+    int frame; // the frame in flight being recorded
+    u64 frame_heads[GPU_UPLOADER_MAX_FRAMES];
+    u64 frame_staged[GPU_UPLOADER_MAX_FRAMES];
+
+    int upload_cap;
+    int upload_count;
+    int upload_first;
+    Gpu_Upload *uploads; // Heap allocated, a FIFO
+};
+// 'memory_type_index' must be host visible and coherent
+Gpu_Staging_Uploader gpu_create_staging_uploader(VkDevice device, u32 memory_type_index, u64 size,
+                                                 u64 bytes_per_frame, int frame_count, int upload_cap);
+void gpu_destroy_staging_uploader(VkDevice device, Gpu_Staging_Uploader *uploader);
+// Queue an upload. Returns a ticket for gpu_upload_is_complete(), or 0 if the queue is full.
+u64 gpu_enqueue_upload(Gpu_Staging_Uploader *uploader, VkBuffer dst, u64 dst_offset, const void *src, u64 size);
+// Call at the start of a frame, once the fence of the frame that last used slot 'frame' has been waited on: the
+// ring space staged in that frame is free again.
+void gpu_uploader_begin_frame(Gpu_Staging_Uploader *uploader, int frame);
+// Stage this frame's share of the queue and record its copies, with a barrier making them visible to vertex
+// input, into 'cmd'. Returns the bytes recorded.
+u64 gpu_uploader_record(Gpu_Staging_Uploader *uploader, VkCommandBuffer cmd);
+inline static bool gpu_upload_is_complete(Gpu_Staging_Uploader *uploader, u64 ticket) {
+    return uploader->completed >= ticket;
+}
+
+// Images are bound one after another in 'mem'; their mip chains are staged tightly packed (level 0 first) at
+// 'offsets' in 'stage', and copied over with gpu_cmd_tex_allocator_upload().
+static constexpr u32 GPU_TEX_ALLOCATOR_IMAGE_CAP = 256;
+
+struct Gpu_Tex_Info {
+    u32 width;
+    u32 height;
+    u32 mip_levels;
+    VkFormat format; // R8G8B8A8 (UNORM or SRGB), BCn or ASTC LDR
+};
 struct Gpu_Tex_Allocator {
     u32 img_cap;
     u32 img_cnt;
@@ -170,16 +285,165 @@ struct Gpu_Tex_Allocator {
     VkBuffer stage;
     u64 *offsets;
     VkImage *imgs;
+    Gpu_Tex_Info *infos;
     VkDeviceMemory mem;
     void *ptr;
 };
-// Setup allocator; Memory allocate .imgs pointer
+// Setup allocator; Memory allocate .imgs, .offsets and .infos
 Gpu_Tex_Allocator gpu_create_tex_allocator(VkDeviceMemory img_mem, VkBuffer stage, void *mapped_ptr, u64 byte_cap, u32 img_cap);
-// Free .imgs pointer
+// Free .imgs, .offsets and .infos
 void gpu_destroy_tex_allocator(Gpu_Tex_Allocator *alloc);
-void* gpu_make_tex_allocation(Gpu_Tex_Allocator *alloc, u64 width, u64 height, VkImage *image);
+// Create and bind an image, and reserve 'size' bytes of staging for its mip chain (see gpu_get_tex_size()).
+// Returns where to write the chain.
+void* gpu_make_tex_allocation(VkDevice device, Gpu_Tex_Allocator *alloc, Gpu_Tex_Info *info, u64 size, VkImage *image);
 void gpu_reset_tex_allocator(Gpu_Tex_Allocator *alloc);
 
+// Bytes of one mip level of 'format', and of a whole chain
+u64 gpu_get_tex_level_size(VkFormat format, u32 width, u32 height);
+u64 gpu_get_tex_size(Gpu_Tex_Info *info);
+// One of the formats above (R8G8B8A8, BCn or ASTC LDR), and sampled by the device with optimal tiling; block
+// compressed formats also need their feature, see GpuInfo. Others (R8, float, ASTC HDR...) cannot be sized.
+bool gpu_tex_format_is_supported(VkFormat format);
+
+// Record the copies of images [first, first + count) from staging, every mip level, with the layout transitions
+// to shader read only at the fragment shader. Graphics queue only.
+void gpu_cmd_tex_allocator_upload(VkCommandBuffer cmd, Gpu_Tex_Allocator *alloc, u32 first, u32 count);
+
+// Virtual textures: the gpu half of a Virtual_Texture. The tile pool is one image of pool_width x pool_height
+// slots, the page table a storage buffer mirroring the cpu's, and each frame in flight has a feedback buffer (which
+// the fragment shader fills with vt_make_feedback() values, see shaders/virtual_texture.glsl) and a staging region
+// of 'tiles_per_frame' tiles plus the page table. The tile copies, the page table's dirty range and the clear of
+// the frame's feedback are recorded by gpu_cmd_vt_upload().
+static constexpr int GPU_VT_MAX_TILES_PER_FRAME = 64;
+
+struct Gpu_Virtual_Texture {
+    VkImage pool;
+    VkImageView pool_view;
+    VkBuffer page_table;
+    VkDeviceMemory device_memory; // the pool, then the page table
+
+    VkBuffer stage; // per frame: the tiles, the page table, then the feedback
+    VkDeviceMemory host_memory;
+    u8 *ptr;
+
+    VkFormat format;
+    u64 tile_size;
+    u64 page_table_size;
+    u64 feedback_offset; // in a frame's region
+    u64 frame_size;
+    u32 feedback_count;
+    int tiles_per_frame;
+    int frame_count;
+    int frame;
+    bool pool_written; // the pool has left VK_IMAGE_LAYOUT_UNDEFINED
+
+    int staged_count;
+    u32 staged_slots[GPU_VT_MAX_TILES_PER_FRAME];
+};
+// 'format' must match the tile file (R8G8B8A8 or BC7, UNORM or SRGB). 'host_memory_type_index' must be host
+// visible and coherent; feedback is read through it, so prefer a cached type.
+Gpu_Virtual_Texture gpu_create_virtual_texture(
+    VkDevice device, Virtual_Texture *vt, VkFormat format, u32 device_memory_type_index,
+    u32 host_memory_type_index, u32 feedback_count, int tiles_per_frame, int frame_count);
+void gpu_destroy_virtual_texture(VkDevice device, Gpu_Virtual_Texture *gvt);
+// Call at the start of a frame, once the fence of the frame that last used slot 'frame' has been waited on.
+// Returns the feedback that frame wrote ('feedback_count' values).
+const u32* gpu_vt_begin_frame(Gpu_Virtual_Texture *gvt, int frame);
+// Where to write the tile for 'slot', or NULL if this frame's tiles are all staged
+void* gpu_vt_stage_tile(Gpu_Virtual_Texture *gvt, u32 slot);
+// The range of the stage buffer the fragment shader writes the current frame's feedback to
+inline static VkDescriptorBufferInfo gpu_vt_get_feedback_info(Gpu_Virtual_Texture *gvt) {
+    return {gvt->stage, gvt->frame * gvt->frame_size + gvt->feedback_offset, gvt->feedback_count * sizeof(u32)};
+}
+// Record the copies of the staged tiles and of the page table's dirty range (then clear it), and the clear of the
+// frame's feedback, with barriers to the fragment shader. Graphics queue only, before the frame's draws.
+void gpu_cmd_vt_upload(VkCommandBuffer cmd, Gpu_Virtual_Texture *gvt, Virtual_Texture *vt);
+// Record after the frame's draws: the feedback is read on the host once the frame's fence is signalled
+void gpu_cmd_vt_feedback_barrier(VkCommandBuffer cmd);
+
+// Device memory allocator: VkDeviceMemory blocks of one memory type, each carved up by a Suballocator, so that
+// resources can be freed one at a time. Blocks are allocated as they are needed; a request larger than the block
+// size gets a block of its own. With 'block_buffer_usage', every block also gets a VkBuffer covering all of it, and
+// allocations can be used as ranges of that buffer (gpu_allocate_memory()) rather than having buffers of their own.
+static constexpr int GPU_MEMORY_ALLOCATOR_MAX_BLOCKS = 16;
+
+struct Gpu_Memory_Block {
+    VkDeviceMemory memory; // VK_NULL_HANDLE if the block was released, see Gpu_Defragmenter
+    VkBuffer buffer; // VK_NULL_HANDLE without block buffers
+    void *ptr; // NULL unless host visible
+    Suballocator suballocator;
+};
+struct Gpu_Memory_Allocator {
+    u32 memory_type_index;
+    bool host_visible;
+    u64 block_size;
+    u64 granularity; // bufferImageGranularity
+    int block_allocation_cap;
+    VkBufferUsageFlags block_buffer_usage;
+
+    int block_count;
+    Gpu_Memory_Block blocks[GPU_MEMORY_ALLOCATOR_MAX_BLOCKS];
+};
+struct Gpu_Memory_Allocation {
+    VkDeviceMemory memory;
+    u64 offset;
+    u64 size;
+    void *ptr; // NULL unless host visible
+    int block;
+    u32 handle;
+};
+Gpu_Memory_Allocator gpu_create_memory_allocator(
+    u32 memory_type_index, bool host_visible, u64 block_size, u64 granularity, int block_allocation_cap,
+    VkBufferUsageFlags block_buffer_usage = 0x0);
+// Free every block
+void gpu_destroy_memory_allocator(VkDevice device, Gpu_Memory_Allocator *alloc);
+// Returns false if no block has room and no new block could be allocated
+bool gpu_allocate_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkMemoryRequirements *requirements,
+                         Suballocation_Kind kind, Gpu_Memory_Allocation *ret);
+void gpu_free_memory(Gpu_Memory_Allocator *alloc, Gpu_Memory_Allocation *allocation);
+// Allocate and bind; buffers are always SUBALLOCATION_KIND_LINEAR
+bool gpu_allocate_buffer_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkBuffer buffer,
+                                Gpu_Memory_Allocation *ret);
+bool gpu_allocate_image_memory(VkDevice device, Gpu_Memory_Allocator *alloc, VkImage image, VkImageTiling tiling,
+                               Gpu_Memory_Allocation *ret);
+
+// Incremental defragmentation of an allocator with block buffers, for vertex and index data which is streamed in
+// and out. The sparsest block is emptied a byte budget at a time: each frame, some of its allocations are moved
+// into the other blocks with vkCmdCopyBuffer2, and once those copies are known to be complete the users of the
+// moved ranges are repointed (gpu_apply_defrag_move()) and the old ranges freed. An emptied block is given back
+// to the driver. Allocations must not be freed while they are being moved.
+// The renderer's index and vertex data is allocated like this with Renderer_Gpu_Allocator_Group::device_memory,
+// see renderer_apply_defrag_moves().
+static constexpr float GPU_DEFRAG_MAX_OCCUPANCY = 0.5f; // fuller blocks are not worth emptying
+
+typedef Suballocation_Move Gpu_Defrag_Move; // blocks are Gpu_Memory_Allocator::blocks indices
+struct Gpu_Defragmenter {
+    Gpu_Memory_Allocator *allocator;
+    u64 bytes_per_frame;
+    u64 alignment; // moved ranges are placed at this alignment
+
+    int source_block; // -1 between blocks
+    u64 cursor; // the source block's allocations before this offset have been moved (or could not be)
+
+    int move_cap;
+    int move_count; // recorded, waiting for gpu_defrag_complete()
+    Gpu_Defrag_Move *moves; // Heap allocated, in source offset order
+};
+Gpu_Defragmenter gpu_create_defragmenter(Gpu_Memory_Allocator *allocator, u64 bytes_per_frame, u64 alignment,
+                                         int move_cap);
+void gpu_destroy_defragmenter(Gpu_Defragmenter *defrag);
+// Record this frame's copies (and a barrier making them visible to vertex input) into 'cmd'. Returns the move
+// count, zero if there is nothing worth moving or the last moves have not been completed.
+int gpu_defrag_record(Gpu_Defragmenter *defrag, VkCommandBuffer cmd);
+// Call once the commands of the last gpu_defrag_record() have executed, and apply the returned moves (see
+// gpu_apply_defrag_move()) before recording anything else that uses the moved ranges. The moves stay valid
+// until the next record.
+Gpu_Defrag_Move* gpu_defrag_complete(VkDevice device, Gpu_Defragmenter *defrag, int *move_count);
+// Point an allocation of the defragmented allocator at where it was moved to (block, offset, handle, memory and
+// ptr), so that it is freed from there. Returns false if it was not moved.
+bool gpu_apply_defrag_move(Gpu_Memory_Allocator *alloc, Gpu_Memory_Allocation *allocation, int move_count,
+                           Gpu_Defrag_Move *moves);
+
 // Surface and Swapchain
 struct Window {
     VkSwapchainKHR vk_swapchain;
@@ -335,6 +599,77 @@ VkSemaphore* gpu_get_binary_semaphores(Gpu_Binary_Semaphore_Pool *pool, u32 coun
 void gpu_reset_binary_semaphore_pool(Gpu_Binary_Semaphore_Pool *pool);
 void gpu_cut_tail_binary_semaphores(Gpu_Binary_Semaphore_Pool *pool, u32 size);
 
+// Transfer Queue
+//
+// A staging uploader driven from the transfer queue. Every submission signals the next value of a timeline
+// semaphore, so an upload is done once the semaphore reaches the value of the submission which staged its last
+// byte: the cpu can poll or wait for exactly that value, and a graphics submission can wait on it at vertex input
+// instead of on all of the streaming work. Submission slots (and so ring space) are reused once their value is
+// reached, without fences.
+//
+// With a dedicated transfer family the destination buffers are exclusive to the graphics family: each copied range
+// is released by the transfer queue and must be acquired, with gpu_transfer_acquire(), by a graphics command buffer
+// which waits on the value (the ranges are written whole, so they are never acquired by the transfer side first).
+static constexpr int GPU_TRANSFER_MAX_SUBMITS = 4;
+static constexpr int GPU_TRANSFER_ACQUIRE_CAP = 1024;
+
+struct Gpu_Transfer_Queue {
+    VkQueue queue;
+    u32 family;
+    u32 graphics_family;
+    VkSemaphore timeline;
+    u64 value; // last value submitted
+
+    int submit_count;
+    int submit; // next slot
+    u64 submit_values[GPU_TRANSFER_MAX_SUBMITS]; // 0 if the slot is unused
+    u64 submit_staged[GPU_TRANSFER_MAX_SUBMITS]; // uploader byte count staged by the slot's submission
+    Gpu_Command_Allocator command_allocators[GPU_TRANSFER_MAX_SUBMITS];
+    VkCommandBuffer cmds[GPU_TRANSFER_MAX_SUBMITS];
+
+    Gpu_Staging_Uploader uploader;
+
+    // Released ranges waiting for the graphics family, in submission order
+    int acquire_count;
+    u64 *acquire_values;                // Heap allocated
+    VkBufferMemoryBarrier2 *acquires;   // Heap allocated
+};
+// 'bytes_per_submit' is the uploader's per frame budget, see Gpu_Staging_Uploader
+Gpu_Transfer_Queue gpu_create_transfer_queue(VkDevice device, u32 memory_type_index, u64 ring_size,
+                                             u64 bytes_per_submit, int submit_count, int upload_cap);
+void gpu_destroy_transfer_queue(VkDevice device, Gpu_Transfer_Queue *transfer);
+
+// Returns a ticket for gpu_transfer_get_value(), or 0 if the queue is full
+inline static u64 gpu_transfer_enqueue(Gpu_Transfer_Queue *transfer, VkBuffer dst, u64 dst_offset, const void *src,
+                                       u64 size) {
+    return gpu_enqueue_upload(&transfer->uploader, dst, dst_offset, src, size);
+}
+// Stage and submit the next share of the queued uploads. Returns the value the submission signals, or 0 if nothing
+// was queued. Waits only if the slot being reused is still in flight.
+u64 gpu_transfer_submit(VkDevice device, Gpu_Transfer_Queue *transfer);
+
+// The value at which the upload with 'ticket' is complete, or 0 if it is not fully submitted yet
+u64 gpu_transfer_get_value(Gpu_Transfer_Queue *transfer, u64 ticket);
+
+inline static bool gpu_transfer_is_complete(VkDevice device, Gpu_Transfer_Queue *transfer, u64 value) {
+    u64 counter;
+    vkGetSemaphoreCounterValue(device, transfer->timeline, &counter);
+    return counter >= value;
+}
+VkResult gpu_transfer_wait(VkDevice device, Gpu_Transfer_Queue *transfer, u64 value, u64 timeout);
+
+// For a graphics submission's wait infos
+inline static VkSemaphoreSubmitInfo gpu_transfer_get_wait_info(Gpu_Transfer_Queue *transfer, u64 value) {
+    VkSemaphoreSubmitInfo ret = {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    ret.semaphore = transfer->timeline;
+    ret.value     = value;
+    ret.stageMask = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+    return ret;
+}
+// Record the acquires of every range released by submissions up to 'value' into a graphics 'cmd' whose submission
+// waits on at least 'value'. Does nothing if there is no dedicated transfer family.
+void gpu_transfer_acquire(Gpu_Transfer_Queue *transfer, VkCommandBuffer cmd, u64 value);
+
 // Descriptors - static, pool allocated
 VkDescriptorPool create_vk_descriptor_pool(VkDevice vk_device, int max_set_count, int counts[11]);
 VkResult reset_vk_descriptor_pool(VkDevice vk_device, VkDescriptorPool pool);
@@ -519,6 +854,7 @@ struct Gpu_Vertex_Input_State {
     // attribute description info
     int *attribute_description_locations;
     int *attribute_description_bindings;
+    int *attribute_description_offsets; // NULL if every attribute starts its binding
     VkFormat *formats;
 };
 
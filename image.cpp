@@ -2,13 +2,48 @@
 #include "image.hpp"
 #include "allocator.hpp"
 
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// Decode workers point this at a scratch arena of their own, as the global heap is not thread safe. Scratch
+// allocations carry their size in front (stb needs it to realloc), and are freed all at once between images.
+static thread_local Linear_Allocator *s_decode_scratch = NULL;
+static thread_local bool s_decode_scratch_exhausted = false;
+static constexpr u64 IMAGE_SCRATCH_HEADER = 16;
+
+static inline void* image_scratch_allocate(u64 size) {
+    Linear_Allocator *scratch = s_decode_scratch;
+    u64 used = align(scratch->used, IMAGE_SCRATCH_HEADER);
+    if (used + IMAGE_SCRATCH_HEADER + size > scratch->capacity) {
+        s_decode_scratch_exhausted = true;
+        return NULL; // stb reports out of memory, the job fails and is retried with a larger arena
+    }
+    scratch->used = used + IMAGE_SCRATCH_HEADER + size;
+    memcpy(scratch->memory + used, &size, sizeof(size));
+    return scratch->memory + used + IMAGE_SCRATCH_HEADER;
+}
+
 static inline void* stbi_malloc_wrapper_heap(u64 size) {
+    if (s_decode_scratch)
+        return image_scratch_allocate(size);
     return memory_allocate_heap(size, 8);
 }
 static inline void* stbi_realloc_wrapper_heap(void *p, u64 newsz) {
+    if (s_decode_scratch) {
+        void *ret = image_scratch_allocate(newsz);
+        if (p && ret) {
+            u64 size;
+            memcpy(&size, (u8*)p - IMAGE_SCRATCH_HEADER, sizeof(size));
+            memcpy(ret, p, size < newsz ? size : newsz);
+        }
+        return ret;
+    }
     return memory_reallocate_heap((u8*)p, newsz);
 }
 static inline void stbi_free_wrapper_heap(void *p) {
+    if (s_decode_scratch)
+        return;
     return memory_free_heap(p);
 }
 
@@ -22,3 +57,815 @@ static inline void stbi_free_wrapper_heap(void *p) {
 const u8* load_image(const char *filename, int *width, int *height) {
     return (const u8*)stbi_load(filename, width, height, NULL, 0);
 }
+
+#include <math.h>
+#include <immintrin.h>
+
+#if TEST
+#include "test.hpp"
+#endif
+
+u8* image_load_rgba8(const char *filename, int *width, int *height) {
+    int channels;
+    return (u8*)stbi_load(filename, width, height, &channels, 4);
+}
+u8* image_load_rgba8_from_memory(const u8 *data, u64 size, int *width, int *height) {
+    int channels;
+    return (u8*)stbi_load_from_memory(data, (int)size, width, height, &channels, 4);
+}
+void image_free(const u8 *pixels) {
+    stbi_image_free((void*)pixels);
+}
+bool image_get_info(const char *filename, int *width, int *height) {
+    int channels;
+    return stbi_info(filename, width, height, &channels) != 0;
+}
+
+int image_get_mip_count(int width, int height) {
+    int count = 1;
+    while(width > 1 || height > 1) {
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+        count++;
+    }
+    return count;
+}
+u64 image_get_mip_chain_size_rgba8(int width, int height, int mip_count) {
+    u64 size = 0;
+    for(int i = 0; i < mip_count; ++i) {
+        size += (u64)width * height * 4;
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    return size;
+}
+
+// `Mips
+
+// sRGB <-> linear tables: decode per byte, encode from 12 bit linear, which is finer than the sRGB steps
+// everywhere but the very darkest values
+static float s_srgb_to_linear[256];
+static u8 s_linear_to_srgb[4096];
+static bool s_srgb_tables_ready = false;
+
+static void image_init_srgb_tables() {
+    if (s_srgb_tables_ready)
+        return;
+    float c;
+    for(int i = 0; i < 256; ++i) {
+        c = i / 255.0f;
+        s_srgb_to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for(int i = 0; i < 4096; ++i) {
+        c = i / 4095.0f;
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1 / 2.4f) - 0.055f;
+        s_linear_to_srgb[i] = (u8)(c * 255.0f + 0.5f);
+    }
+    s_srgb_tables_ready = true;
+}
+
+void image_downsample_rgba8(u8 *dst, const u8 *src, int width, int height, bool srgb) {
+    int dst_width  = width  > 1 ? width  >> 1 : 1;
+    int dst_height = height > 1 ? height >> 1 : 1;
+    u64 src_pitch  = (u64)width * 4;
+    if (srgb)
+        image_init_srgb_tables();
+
+    const u8 *row0;
+    const u8 *row1;
+    u8 *out;
+    int x0, x1;
+    float sum;
+    for(int y = 0; y < dst_height; ++y) {
+        row0 = src + (u64)(y * 2) * src_pitch;
+        row1 = y * 2 + 1 < height ? row0 + src_pitch : row0;
+        out  = dst + (u64)y * dst_width * 4;
+
+        int x = 0;
+        if (!srgb && width > 1) {
+            // Eight source texels per row to four: gather even texels to the low half and odd to the high, then
+            // sum the four of each output in 16 bits
+            __m256i even_odd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+            __m256i round = _mm256_set1_epi16(2);
+            __m256i a, b, sum16;
+            for(; x + 4 <= dst_width; x += 4) {
+                a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((__m256i*)(row0 + x * 8)), even_odd);
+                b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((__m256i*)(row1 + x * 8)), even_odd);
+                sum16 = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)),
+                                         _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)));
+                sum16 = _mm256_add_epi16(sum16, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)));
+                sum16 = _mm256_add_epi16(sum16, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)));
+                sum16 = _mm256_srli_epi16(_mm256_add_epi16(sum16, round), 2);
+                sum16 = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum16, sum16), 0b1000);
+                _mm_storeu_si128((__m128i*)(out + x * 4), _mm256_castsi256_si128(sum16));
+            }
+        }
+        for(; x < dst_width; ++x) {
+            x0 = x * 2 * 4;
+            x1 = x * 2 + 1 < width ? x0 + 4 : x0;
+            if (srgb) {
+                for(int c = 0; c < 3; ++c) {
+                    sum = s_srgb_to_linear[row0[x0 + c]] + s_srgb_to_linear[row0[x1 + c]] +
+                          s_srgb_to_linear[row1[x0 + c]] + s_srgb_to_linear[row1[x1 + c]];
+                    out[x * 4 + c] = s_linear_to_srgb[(int)(sum * (4095.0f / 4) + 0.5f)];
+                }
+                out[x * 4 + 3] = (u8)((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) >> 2);
+            } else {
+                for(int c = 0; c < 4; ++c)
+                    out[x * 4 + c] = (u8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void image_generate_mips_rgba8(u8 *dst, const u8 *src, int width, int height, int mip_count, bool srgb) {
+    memcpy(dst, src, (u64)width * height * 4);
+    const u8 *level = dst;
+    u8 *next;
+    for(int i = 1; i < mip_count; ++i) {
+        next = (u8*)level + (u64)width * height * 4;
+        image_downsample_rgba8(next, level, width, height, srgb);
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+        level  = next;
+    }
+}
+
+// `Block Compression
+
+u64 image_get_bc_size(int width, int height) {
+    return (u64)((width + 3) / 4) * ((height + 3) / 4) * 16;
+}
+u64 image_get_mip_chain_size_bc(int width, int height, int mip_count) {
+    u64 size = 0;
+    for(int i = 0; i < mip_count; ++i) {
+        size += image_get_bc_size(width, height);
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    return size;
+}
+
+// 4x4 texels from (bx * 4, by * 4), clamped to the image
+static void image_load_block(u8 *block, const u8 *src, int width, int height, int bx, int by) {
+    int x, y;
+    for(int j = 0; j < 4; ++j) {
+        y = by * 4 + j < height ? by * 4 + j : height - 1;
+        for(int i = 0; i < 4; ++i) {
+            x = bx * 4 + i < width ? bx * 4 + i : width - 1;
+            memcpy(block + (j * 4 + i) * 4, src + ((u64)y * width + x) * 4, 4);
+        }
+    }
+}
+
+// Blocks are little endian bit streams
+static inline void image_put_bits(u64 *bits, int *pos, u64 value, int count) {
+    int word = *pos >> 6;
+    int shift = *pos & 63;
+    bits[word] |= value << shift;
+    if (shift + count > 64)
+        bits[word + 1] |= value >> (64 - shift);
+    *pos += count;
+}
+
+static const int s_bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static inline int image_bc7_interpolate(int e0, int e1, int weight) {
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+// Quantize an endpoint to 7 bits per channel plus a shared p bit, choosing the p bit closer overall
+static void image_bc7_quantize_endpoint(const int *endpoint, int *q, int *p) {
+    int best_error = Max_s32;
+    int tmp[4];
+    int error, v;
+    for(int bit = 0; bit < 2; ++bit) {
+        error = 0;
+        for(int c = 0; c < 4; ++c) {
+            v = (endpoint[c] - bit + 1) >> 1;
+            v = v < 0 ? 0 : v > 127 ? 127 : v;
+            tmp[c] = v;
+            v = ((v << 1) | bit) - endpoint[c];
+            error += v * v;
+        }
+        if (error < best_error) {
+            best_error = error;
+            *p = bit;
+            memcpy(q, tmp, sizeof(tmp));
+        }
+    }
+}
+
+static void image_encode_bc7_block(u8 *dst, const u8 *block) {
+    int lo[4] = {255, 255, 255, 255};
+    int hi[4] = {0, 0, 0, 0};
+    for(int i = 0; i < 16; ++i)
+        for(int c = 0; c < 4; ++c) {
+            if (block[i * 4 + c] < lo[c]) lo[c] = block[i * 4 + c];
+            if (block[i * 4 + c] > hi[c]) hi[c] = block[i * 4 + c];
+        }
+
+    // The box diagonal only follows the texels if every channel rises with the widest one: flip those which fall
+    int widest = 0;
+    for(int c = 1; c < 4; ++c)
+        if (hi[c] - lo[c] > hi[widest] - lo[widest])
+            widest = c;
+    int mean[4] = {};
+    for(int i = 0; i < 16; ++i)
+        for(int c = 0; c < 4; ++c)
+            mean[c] += block[i * 4 + c];
+    int e0[4], e1[4];
+    int covariance, tmp;
+    for(int c = 0; c < 4; ++c) {
+        covariance = 0;
+        for(int i = 0; i < 16; ++i)
+            covariance += (block[i * 4 + c] * 16 - mean[c]) * (block[i * 4 + widest] * 16 - mean[widest]);
+        e0[c] = lo[c];
+        e1[c] = hi[c];
+        if (covariance < 0) {
+            tmp = e0[c]; e0[c] = e1[c]; e1[c] = tmp;
+        }
+    }
+
+    int q0[4], q1[4], p0, p1;
+    image_bc7_quantize_endpoint(e0, q0, &p0);
+    image_bc7_quantize_endpoint(e1, q1, &p1);
+    for(int c = 0; c < 4; ++c) {
+        e0[c] = (q0[c] << 1) | p0;
+        e1[c] = (q1[c] << 1) | p1;
+    }
+
+    int indices[16];
+    int best_error, error, d;
+    for(int i = 0; i < 16; ++i) {
+        best_error = Max_s32;
+        for(int w = 0; w < 16; ++w) {
+            error = 0;
+            for(int c = 0; c < 4; ++c) {
+                d = image_bc7_interpolate(e0[c], e1[c], s_bc7_weights4[w]) - block[i * 4 + c];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                indices[i] = w;
+            }
+        }
+    }
+    // The first index is stored without its top bit: swap the endpoints to make it zero
+    if (indices[0] & 8) {
+        for(int c = 0; c < 4; ++c) {
+            tmp = q0[c]; q0[c] = q1[c]; q1[c] = tmp;
+        }
+        tmp = p0; p0 = p1; p1 = tmp;
+        for(int i = 0; i < 16; ++i)
+            indices[i] = 15 - indices[i];
+    }
+
+    u64 bits[2] = {};
+    int pos = 0;
+    image_put_bits(bits, &pos, 1 << 6, 7); // mode 6
+    for(int c = 0; c < 4; ++c) {
+        image_put_bits(bits, &pos, q0[c], 7);
+        image_put_bits(bits, &pos, q1[c], 7);
+    }
+    image_put_bits(bits, &pos, p0, 1);
+    image_put_bits(bits, &pos, p1, 1);
+    image_put_bits(bits, &pos, indices[0], 3);
+    for(int i = 1; i < 16; ++i)
+        image_put_bits(bits, &pos, indices[i], 4);
+    memcpy(dst, bits, 16);
+}
+
+void image_encode_bc7(u8 *dst, const u8 *src, int width, int height) {
+    u8 block[64];
+    int blocks_x = (width  + 3) / 4;
+    int blocks_y = (height + 3) / 4;
+    for(int by = 0; by < blocks_y; ++by)
+        for(int bx = 0; bx < blocks_x; ++bx) {
+            image_load_block(block, src, width, height, bx, by);
+            image_encode_bc7_block(dst + ((u64)by * blocks_x + bx) * 16, block);
+        }
+}
+
+// BC4 palette: with e0 > e1 six values between the endpoints, else four and then 0 and 255
+static void image_bc4_palette(int *palette, int e0, int e1) {
+    palette[0] = e0;
+    palette[1] = e1;
+    if (e0 > e1) {
+        for(int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+    } else {
+        for(int i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// One channel of a block ('channel' of 4 interleaved) to 8 bytes
+static void image_encode_bc4_block(u8 *dst, const u8 *block, int channel) {
+    int lo = 255;
+    int hi = 0;
+    for(int i = 0; i < 16; ++i) {
+        if (block[i * 4 + channel] < lo) lo = block[i * 4 + channel];
+        if (block[i * 4 + channel] > hi) hi = block[i * 4 + channel];
+    }
+    int palette[8];
+    image_bc4_palette(palette, hi, lo);
+
+    u64 bits = (u64)hi | ((u64)lo << 8);
+    int best, best_error, error;
+    for(int i = 0; i < 16; ++i) {
+        best = 0;
+        best_error = Max_s32;
+        for(int j = 0; j < 8; ++j) {
+            error = palette[j] - block[i * 4 + channel];
+            error = error < 0 ? -error : error;
+            if (error < best_error) {
+                best_error = error;
+                best = j;
+            }
+        }
+        bits |= (u64)best << (16 + i * 3);
+    }
+    memcpy(dst, &bits, 8);
+}
+
+void image_encode_bc5(u8 *dst, const u8 *src, int width, int height) {
+    u8 block[64];
+    int blocks_x = (width  + 3) / 4;
+    int blocks_y = (height + 3) / 4;
+    u8 *out;
+    for(int by = 0; by < blocks_y; ++by)
+        for(int bx = 0; bx < blocks_x; ++bx) {
+            image_load_block(block, src, width, height, bx, by);
+            out = dst + ((u64)by * blocks_x + bx) * 16;
+            image_encode_bc4_block(out,     block, 0);
+            image_encode_bc4_block(out + 8, block, 1);
+        }
+}
+
+// `Decode Jobs
+
+static void image_run_decode_job(Image_Decode_Job *job) {
+    auto start = std::chrono::steady_clock::now();
+
+    int width, height, channels;
+    u8 *pixels = stbi_load(job->path, &width, &height, &channels, 4);
+    if (!pixels || width != job->width || height != job->height) {
+        job->ok = false;
+        return;
+    }
+    auto decoded = std::chrono::steady_clock::now();
+
+    if (job->output == IMAGE_DECODE_OUTPUT_RGBA8) {
+        image_generate_mips_rgba8(job->dst, pixels, width, height, job->mip_count, job->srgb);
+    } else {
+        u8 *chain = (u8*)image_scratch_allocate(image_get_mip_chain_size_rgba8(width, height, job->mip_count));
+        if (!chain) {
+            job->ok = false;
+            return;
+        }
+        image_generate_mips_rgba8(chain, pixels, width, height, job->mip_count, job->srgb);
+        u8 *dst = job->dst;
+        for(int i = 0; i < job->mip_count; ++i) {
+            if (job->output == IMAGE_DECODE_OUTPUT_BC5)
+                image_encode_bc5(dst, chain, width, height);
+            else
+                image_encode_bc7(dst, chain, width, height);
+            dst   += image_get_bc_size(width, height);
+            chain += (u64)width * height * 4;
+            width  = width  > 1 ? width  >> 1 : 1;
+            height = height > 1 ? height >> 1 : 1;
+        }
+    }
+    auto done = std::chrono::steady_clock::now();
+
+    job->ok = true;
+    job->decode_us  = (u32)std::chrono::duration_cast<std::chrono::microseconds>(decoded - start).count();
+    job->process_us = (u32)std::chrono::duration_cast<std::chrono::microseconds>(done - decoded).count();
+}
+
+static void image_decode_worker(Image_Decode_Job *jobs, int job_count, std::atomic<int> *next,
+                                Linear_Allocator *scratch) {
+    s_decode_scratch = scratch;
+    int job;
+    while((job = next->fetch_add(1)) < job_count) {
+        scratch->used = 0;
+        s_decode_scratch_exhausted = false;
+        image_run_decode_job(&jobs[job]);
+        jobs[job].out_of_scratch = !jobs[job].ok && s_decode_scratch_exhausted;
+    }
+    s_decode_scratch = NULL;
+}
+
+u64 image_get_decode_scratch_size(int width, int height) {
+    // The decoded image, the filter input of the compressed outputs (about 4/3 of it), and the decoder's own
+    // buffers, which for png are the inflated scanlines and for jpeg the component planes
+    u64 pixels = (u64)width * height * 4;
+    return pixels * 4 + IMAGE_DECODE_SCRATCH_SLACK;
+}
+
+void image_decode_jobs(Image_Decode_Job *jobs, int job_count, int thread_count) {
+    if (job_count == 0)
+        return;
+    if (thread_count <= 0)
+        thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count > IMAGE_DECODE_MAX_THREADS)
+        thread_count = IMAGE_DECODE_MAX_THREADS;
+    if (thread_count > job_count)
+        thread_count = job_count;
+    if (thread_count < 1)
+        thread_count = 1;
+
+    // Workers cannot touch the global allocators: everything they use is made here
+    image_init_srgb_tables();
+    u64 scratch_size = 0;
+    u64 size;
+    for(int i = 0; i < job_count; ++i) {
+        size = image_get_decode_scratch_size(jobs[i].width, jobs[i].height);
+        scratch_size = size > scratch_size ? size : scratch_size;
+        jobs[i].ok = false;
+        jobs[i].decode_us = 0;
+        jobs[i].process_us = 0;
+        jobs[i].out_of_scratch = false;
+        jobs[i].retry_count = 0;
+    }
+    Linear_Allocator scratches[IMAGE_DECODE_MAX_THREADS];
+    for(int i = 0; i < thread_count; ++i)
+        scratches[i] = create_linear_allocator(scratch_size);
+
+    std::atomic<int> next(0);
+    std::thread threads[IMAGE_DECODE_MAX_THREADS];
+    for(int i = 1; i < thread_count; ++i)
+        threads[i] = std::thread(image_decode_worker, jobs, job_count, &next, &scratches[i]);
+    image_decode_worker(jobs, job_count, &next, &scratches[0]); // the calling thread works too
+    for(int i = 1; i < thread_count; ++i)
+        threads[i].join();
+
+    for(int i = 0; i < thread_count; ++i)
+        destroy_linear_allocator(&scratches[i]);
+
+    // The estimate can fall short (stb's scratch is never freed, so png inflate buffers pile up): retry those jobs
+    // on this thread, doubling the arena each time
+    std::atomic<int> retry;
+    for(int i = 0; i < job_count; ++i) {
+        size = scratch_size;
+        for(int attempt = 0; jobs[i].out_of_scratch && attempt < IMAGE_DECODE_SCRATCH_RETRIES; ++attempt) {
+            size *= 2;
+            scratches[0] = create_linear_allocator(size);
+            retry = 0;
+            image_decode_worker(jobs + i, 1, &retry, &scratches[0]);
+            destroy_linear_allocator(&scratches[0]);
+            jobs[i].retry_count++;
+        }
+    }
+}
+
+// `KTX2
+
+static const u8 s_ktx2_identifier[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+static constexpr u64 IMAGE_KTX2_HEADER_SIZE = 80; // header and index, then the level index
+
+static inline u32 image_read_u32(const u8 *data) {
+    u32 ret;
+    memcpy(&ret, data, 4);
+    return ret;
+}
+static inline u64 image_read_u64(const u8 *data) {
+    u64 ret;
+    memcpy(&ret, data, 8);
+    return ret;
+}
+
+Image_Ktx2_Result image_parse_ktx2(const u8 *data, u64 size, Image_Ktx2 *ret) {
+    if (size < IMAGE_KTX2_HEADER_SIZE || memcmp(data, s_ktx2_identifier, sizeof(s_ktx2_identifier)) != 0)
+        return IMAGE_KTX2_NOT_KTX2;
+
+    u32 vk_format        = image_read_u32(data + 12);
+    u32 width            = image_read_u32(data + 20);
+    u32 height           = image_read_u32(data + 24);
+    u32 depth            = image_read_u32(data + 28);
+    u32 layer_count      = image_read_u32(data + 32);
+    u32 face_count       = image_read_u32(data + 36);
+    u32 level_count      = image_read_u32(data + 40);
+    u32 supercompression = image_read_u32(data + 44);
+
+    if (depth > 1 || layer_count > 1 || face_count != 1 || height == 0 || level_count > IMAGE_KTX2_MAX_LEVELS)
+        return IMAGE_KTX2_UNSUPPORTED;
+    if (vk_format == 0) // VK_FORMAT_UNDEFINED
+        return IMAGE_KTX2_NEEDS_TRANSCODE;
+    if (supercompression != 0)
+        return IMAGE_KTX2_SUPERCOMPRESSED;
+
+    // Zero levels asks the loader to generate mips: there is still one stored
+    if (level_count == 0)
+        level_count = 1;
+    if (size < IMAGE_KTX2_HEADER_SIZE + level_count * 24)
+        return IMAGE_KTX2_TRUNCATED;
+
+    ret->vk_format   = vk_format;
+    ret->width       = width;
+    ret->height      = height;
+    ret->level_count = level_count;
+    const u8 *level_index = data + IMAGE_KTX2_HEADER_SIZE;
+    for(u32 i = 0; i < level_count; ++i) {
+        ret->levels[i].offset = image_read_u64(level_index + i * 24);
+        ret->levels[i].size   = image_read_u64(level_index + i * 24 + 8);
+        if (ret->levels[i].offset > size || ret->levels[i].size > size - ret->levels[i].offset)
+            return IMAGE_KTX2_TRUNCATED;
+    }
+    return IMAGE_KTX2_OK;
+}
+
+#if TEST
+static void test_image_mips();
+static void test_image_bc7();
+static void test_image_bc5();
+static void test_image_ktx2();
+static void test_image_decode_jobs();
+
+void test_image() {
+    test_image_mips();
+    test_image_bc7();
+    test_image_bc5();
+    test_image_ktx2();
+    test_image_decode_jobs();
+}
+
+static void test_image_mips() {
+    BEGIN_TEST_MODULE("Image_Mips", true, false);
+
+    TEST_EQ("mip count square", image_get_mip_count(256, 256), 9, false);
+    TEST_EQ("mip count odd", image_get_mip_count(5, 3), 3, false);
+    TEST_EQ("chain size", image_get_mip_chain_size_rgba8(4, 2, 3), (4 * 2 + 2 * 1 + 1 * 1) * 4, false);
+
+    // Wide enough for the simd path plus a remainder, both filters against a scalar reference
+    int width = 22;
+    int height = 6;
+    u8 *src = (u8*)memory_allocate_heap((u64)width * height * 4, 16);
+    u8 *dst = (u8*)memory_allocate_heap((u64)(width / 2) * (height / 2) * 4, 16);
+    for(int i = 0; i < width * height * 4; ++i)
+        src[i] = (u8)((i * 37 + (i >> 3) * 11) & 0xff);
+
+    image_downsample_rgba8(dst, src, width, height, false);
+    int mismatches = 0;
+    int expect;
+    for(int y = 0; y < height / 2; ++y)
+        for(int x = 0; x < width / 2; ++x)
+            for(int c = 0; c < 4; ++c) {
+                expect = (src[((y * 2) * width + x * 2) * 4 + c] + src[((y * 2) * width + x * 2 + 1) * 4 + c] +
+                          src[((y * 2 + 1) * width + x * 2) * 4 + c] +
+                          src[((y * 2 + 1) * width + x * 2 + 1) * 4 + c] + 2) >> 2;
+                mismatches += dst[(y * (width / 2) + x) * 4 + c] != expect;
+            }
+    TEST_EQ("box filter", mismatches, 0, false);
+
+    // A flat sRGB image stays flat, a black and white checker averages to linear grey (188 in sRGB), not to 128
+    for(int i = 0; i < width * height; ++i) {
+        src[i * 4 + 0] = 200; src[i * 4 + 1] = 100; src[i * 4 + 2] = 0; src[i * 4 + 3] = 255;
+    }
+    image_downsample_rgba8(dst, src, width, height, true);
+    TEST_EQ("srgb flat r", dst[0], 200, false);
+    TEST_EQ("srgb flat g", dst[1], 100, false);
+    TEST_EQ("srgb flat a", dst[3], 255, false);
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x)
+            memset(src + (y * width + x) * 4, (x + y) & 1 ? 255 : 0, 4);
+    image_downsample_rgba8(dst, src, width, height, true);
+    TEST_EQ("srgb checker", dst[0], 188, false);
+    TEST_EQ("srgb checker alpha linear", dst[3], 128, false);
+
+    // 1xN reduces along one axis only, to 1x1
+    u8 column[3 * 4] = {0, 0, 0, 0, 100, 100, 100, 100, 40, 40, 40, 40};
+    u8 chain[3 * 4 + 4];
+    image_generate_mips_rgba8(chain, column, 1, 3, 2, false);
+    TEST_EQ("column level 0 copied", chain[8], 40, false);
+    TEST_EQ("column level 1", chain[12], 50, false);
+
+    memory_free_heap(src);
+    memory_free_heap(dst);
+    END_TEST_MODULE();
+}
+
+static int test_image_get_bits(const u8 *block, int *pos, int count) {
+    int value = 0;
+    for(int i = 0; i < count; ++i, ++*pos)
+        value |= ((block[*pos >> 3] >> (*pos & 7)) & 1) << i;
+    return value;
+}
+// Mode 6 decode, per the spec
+static void test_image_decode_bc7(u8 *texels, const u8 *block) {
+    int pos = 0;
+    int mode = test_image_get_bits(block, &pos, 7);
+    if (mode != 1 << 6) {
+        memset(texels, 0, 64);
+        return;
+    }
+    int e[2][4];
+    for(int c = 0; c < 4; ++c) {
+        e[0][c] = test_image_get_bits(block, &pos, 7);
+        e[1][c] = test_image_get_bits(block, &pos, 7);
+    }
+    int p0 = test_image_get_bits(block, &pos, 1);
+    int p1 = test_image_get_bits(block, &pos, 1);
+    for(int c = 0; c < 4; ++c) {
+        e[0][c] = (e[0][c] << 1) | p0;
+        e[1][c] = (e[1][c] << 1) | p1;
+    }
+    int index;
+    for(int i = 0; i < 16; ++i) {
+        index = test_image_get_bits(block, &pos, i == 0 ? 3 : 4);
+        for(int c = 0; c < 4; ++c)
+            texels[i * 4 + c] = (u8)image_bc7_interpolate(e[0][c], e[1][c], s_bc7_weights4[index]);
+    }
+}
+
+static void test_image_bc7() {
+    BEGIN_TEST_MODULE("Image_BC7", true, false);
+
+    TEST_EQ("bc size", image_get_bc_size(5, 4), 32, false);
+    TEST_EQ("bc chain size", image_get_mip_chain_size_bc(8, 8, 4), 16 * 4 + 16 + 16 + 16, false);
+
+    // A gradient whose blue and alpha fall as red rises (the flipped channel case), across a partial block
+    int width = 6;
+    int height = 4;
+    u8 src[6 * 4 * 4];
+    int t;
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x) {
+            t = x * 36 + y * 9;
+            src[(y * width + x) * 4 + 0] = (u8)t;
+            src[(y * width + x) * 4 + 1] = 90;
+            src[(y * width + x) * 4 + 2] = (u8)(230 - t);
+            src[(y * width + x) * 4 + 3] = (u8)(255 - t / 4);
+        }
+    u8 blocks[32];
+    image_encode_bc7(blocks, src, width, height);
+
+    u8 texels[64];
+    int max_error = 0;
+    int error;
+    for(int b = 0; b < 2; ++b) {
+        test_image_decode_bc7(texels, blocks + b * 16);
+        for(int y = 0; y < 4; ++y)
+            for(int x = 0; x < 4 && b * 4 + x < width; ++x)
+                for(int c = 0; c < 4; ++c) {
+                    error = texels[(y * 4 + x) * 4 + c] - src[(y * width + b * 4 + x) * 4 + c];
+                    error = error < 0 ? -error : error;
+                    max_error = error > max_error ? error : max_error;
+                }
+    }
+    TEST_LT("bc7 gradient error", max_error, 8, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_image_bc5() {
+    BEGIN_TEST_MODULE("Image_BC5", true, false);
+
+    u8 src[4 * 4 * 4];
+    for(int i = 0; i < 16; ++i) {
+        src[i * 4 + 0] = (u8)(i * 17);
+        src[i * 4 + 1] = 128;
+        src[i * 4 + 2] = 255;
+        src[i * 4 + 3] = 255;
+    }
+    u8 block[16];
+    image_encode_bc5(block, src, 4, 4);
+
+    int palette[8];
+    int max_error = 0;
+    int error;
+    u64 bits;
+    for(int channel = 0; channel < 2; ++channel) {
+        memcpy(&bits, block + channel * 8, 8);
+        image_bc4_palette(palette, bits & 0xff, (bits >> 8) & 0xff);
+        for(int i = 0; i < 16; ++i) {
+            error = palette[(bits >> (16 + i * 3)) & 7] - src[i * 4 + channel];
+            error = error < 0 ? -error : error;
+            max_error = error > max_error ? error : max_error;
+        }
+    }
+    TEST_LT("bc5 ramp error", max_error, 20, false);
+    TEST_EQ("bc5 flat green", block[8], 128, false);
+
+    END_TEST_MODULE();
+}
+static void test_image_put_u32(u8 *data, u32 value) {
+    memcpy(data, &value, 4);
+}
+static void test_image_put_u64(u8 *data, u64 value) {
+    memcpy(data, &value, 8);
+}
+
+static void test_image_ktx2() {
+    BEGIN_TEST_MODULE("Image_KTX2", true, false);
+
+    // 8x8 BC7 (VK_FORMAT_BC7_UNORM_BLOCK = 145) with four levels, stored smallest first as the spec orders them
+    u8 file[80 + 4 * 24 + 64 + 16 * 3];
+    memset(file, 0, sizeof(file));
+    memcpy(file, s_ktx2_identifier, sizeof(s_ktx2_identifier));
+    test_image_put_u32(file + 12, 145);
+    test_image_put_u32(file + 16, 1);
+    test_image_put_u32(file + 20, 8);
+    test_image_put_u32(file + 24, 8);
+    test_image_put_u32(file + 36, 1);
+    test_image_put_u32(file + 40, 4);
+    u64 level_sizes[4] = {64, 16, 16, 16};
+    u64 offset = sizeof(file);
+    for(int i = 0; i < 4; ++i) {
+        offset -= level_sizes[i];
+        test_image_put_u64(file + 80 + i * 24,      offset);
+        test_image_put_u64(file + 80 + i * 24 + 8,  level_sizes[i]);
+        test_image_put_u64(file + 80 + i * 24 + 16, level_sizes[i]);
+    }
+
+    Image_Ktx2 ktx2;
+    TEST_EQ("parse", image_parse_ktx2(file, sizeof(file), &ktx2), IMAGE_KTX2_OK, false);
+    TEST_EQ("format", ktx2.vk_format, 145, false);
+    TEST_EQ("width", ktx2.width, 8, false);
+    TEST_EQ("levels", ktx2.level_count, 4, false);
+    TEST_EQ("level 0 last in file", ktx2.levels[0].offset, sizeof(file) - 64, false);
+    TEST_EQ("level 3 first in file", ktx2.levels[3].offset, 80 + 4 * 24, false);
+    TEST_EQ("level 0 size", ktx2.levels[0].size, 64, false);
+
+    TEST_EQ("truncated", image_parse_ktx2(file, sizeof(file) - 1, &ktx2), IMAGE_KTX2_TRUNCATED, false);
+
+    test_image_put_u32(file + 44, 2); // zstd
+    TEST_EQ("supercompressed", image_parse_ktx2(file, sizeof(file), &ktx2), IMAGE_KTX2_SUPERCOMPRESSED, false);
+    test_image_put_u32(file + 12, 0);
+    test_image_put_u32(file + 44, 1); // BasisLZ
+    TEST_EQ("basis", image_parse_ktx2(file, sizeof(file), &ktx2), IMAGE_KTX2_NEEDS_TRANSCODE, false);
+    test_image_put_u32(file + 36, 6);
+    TEST_EQ("cubemap", image_parse_ktx2(file, sizeof(file), &ktx2), IMAGE_KTX2_UNSUPPORTED, false);
+    file[1] = 'k';
+    TEST_EQ("identifier", image_parse_ktx2(file, sizeof(file), &ktx2), IMAGE_KTX2_NOT_KTX2, false);
+
+    END_TEST_MODULE();
+}
+// Binary ppm, which stb_image reads, so that the test needs no encoder
+static void test_image_write_ppm(const char *path, const u8 *rgb, int width, int height) {
+    FILE *f = fopen(path, "wb");
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    fwrite(rgb, 1, width * height * 3, f);
+    fclose(f);
+}
+
+static void test_image_decode_jobs() {
+    BEGIN_TEST_MODULE("Image_Decode_Jobs", true, false);
+
+    const int width = 6;
+    const int height = 4;
+    u8 rgb[2][width * height * 3];
+    for(int i = 0; i < width * height * 3; ++i) {
+        rgb[0][i] = (u8)(i * 7);
+        rgb[1][i] = (u8)(255 - i * 3);
+    }
+    const char *paths[] = {"image_test_decode_0.ppm", "image_test_decode_1.ppm", "image_test_decode_missing.ppm"};
+    test_image_write_ppm(paths[0], rgb[0], width, height);
+    test_image_write_ppm(paths[1], rgb[1], width, height);
+
+    int info_width, info_height;
+    TEST_EQ("info", image_get_info(paths[0], &info_width, &info_height), true, false);
+    TEST_EQ("info width", info_width, width, false);
+    TEST_EQ("info missing", image_get_info(paths[2], &info_width, &info_height), false, false);
+
+    int mip_count = image_get_mip_count(width, height);
+    u64 rgba8_size = image_get_mip_chain_size_rgba8(width, height, mip_count);
+    u8 *dst = (u8*)memory_allocate_heap(rgba8_size * 3, 16);
+
+    Image_Decode_Job jobs[3] = {};
+    for(int i = 0; i < 3; ++i) {
+        jobs[i].path      = paths[i];
+        jobs[i].dst       = dst + rgba8_size * i;
+        jobs[i].width     = width;
+        jobs[i].height    = height;
+        jobs[i].mip_count = mip_count;
+        jobs[i].output    = IMAGE_DECODE_OUTPUT_RGBA8;
+    }
+    jobs[1].output = IMAGE_DECODE_OUTPUT_BC7;
+    image_decode_jobs(jobs, 3, 2);
+
+    TEST_EQ("job 0 ok", jobs[0].ok, true, false);
+    TEST_EQ("job 1 ok", jobs[1].ok, true, false);
+    TEST_EQ("missing file fails", jobs[2].ok, false, false);
+    TEST_EQ("no retries", jobs[0].retry_count + jobs[1].retry_count + jobs[2].retry_count, 0, false);
+
+    int mismatches = 0;
+    for(int i = 0; i < width * height; ++i) {
+        mismatches += memcmp(dst + i * 4, rgb[0] + i * 3, 3) != 0;
+        mismatches += dst[i * 4 + 3] != 255;
+    }
+    TEST_EQ("rgba8 level 0", mismatches, 0, false);
+    u8 *level1 = dst + width * height * 4;
+    int expect = (rgb[0][0] + rgb[0][3] + rgb[0][width * 3] + rgb[0][width * 3 + 3] + 2) >> 2;
+    TEST_EQ("rgba8 level 1", level1[0], expect, false);
+    TEST_EQ("bc7 mode 6", jobs[1].dst[0] & 0x7f, 1 << 6, false);
+
+    memory_free_heap(dst);
+    remove(paths[0]);
+    remove(paths[1]);
+    END_TEST_MODULE();
+}
+#endif // TEST
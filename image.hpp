@@ -1,6 +1,104 @@
 #ifndef SOL_IMAGE_HPP_INCLUDE_GUARD_
 #define SOL_IMAGE_HPP_INCLUDE_GUARD_
 
+#include "basic.h"
+
 const u8* load_image(const char *filename, int *width, int *height);
 
+//
+// Texture preparation on the cpu: decode (stb_image) to rgba8, build the mip chain, and optionally block compress
+// it. Mip chains are tightly packed, level 0 first, each level max(1, previous / 2) in both dimensions.
+//
+
+// Always four channels. Returns NULL if the file could not be decoded; free with image_free().
+u8* image_load_rgba8(const char *filename, int *width, int *height);
+u8* image_load_rgba8_from_memory(const u8 *data, u64 size, int *width, int *height);
+void image_free(const u8 *pixels);
+
+int image_get_mip_count(int width, int height);
+u64 image_get_mip_chain_size_rgba8(int width, int height, int mip_count);
+
+// 2x2 box filter into a (max(1, width / 2), max(1, height / 2)) image; the last row or column of odd dimensions is
+// dropped. sRGB images are filtered in linear space (and so take the scalar path), alpha always is linear.
+void image_downsample_rgba8(u8 *dst, const u8 *src, int width, int height, bool srgb);
+// Copy level 0 to 'dst' and filter each level from the last
+void image_generate_mips_rgba8(u8 *dst, const u8 *src, int width, int height, int mip_count, bool srgb);
+
+// Block compression, 16 bytes per 4x4 block (a quarter of rgba8); partial blocks at the edges repeat the last
+// row or column.
+u64 image_get_bc_size(int width, int height);
+u64 image_get_mip_chain_size_bc(int width, int height, int mip_count);
+// BC7, mode 6 only: rgba endpoints along the block's bounding box (flipped per channel to follow the dominant
+// one) and a 4 bit index per texel. Fast rather than best quality.
+void image_encode_bc7(u8 *dst, const u8 *src, int width, int height);
+// BC5 from the red and green channels, for tangent space normal maps: shaders reconstruct z
+void image_encode_bc5(u8 *dst, const u8 *src, int width, int height);
+
+// Decode jobs: decode many files in parallel, each straight into the destination the caller made for it (texture
+// staging, say) as the full mip chain of the chosen output. Workers allocate from scratch arenas of their own
+// (created before and freed after, on the calling thread), never from the global allocators.
+static constexpr int IMAGE_DECODE_MAX_THREADS = 16;
+static constexpr u64 IMAGE_DECODE_SCRATCH_SLACK = 4 * 1024 * 1024;
+static constexpr int IMAGE_DECODE_SCRATCH_RETRIES = 4; // each with twice the scratch of the last
+
+enum Image_Decode_Output {
+    IMAGE_DECODE_OUTPUT_RGBA8 = 0, // image_get_mip_chain_size_rgba8() bytes
+    IMAGE_DECODE_OUTPUT_BC7   = 1, // image_get_mip_chain_size_bc() bytes
+    IMAGE_DECODE_OUTPUT_BC5   = 2,
+};
+struct Image_Decode_Job {
+    const char *path;
+    u8 *dst;
+    int width; // from image_get_info(): the destination is sized before decoding
+    int height;
+    int mip_count;
+    Image_Decode_Output output;
+    bool srgb;
+
+    // Results
+    bool ok;
+    u32 decode_us;  // file read and decode
+    u32 process_us; // mips and compression
+    bool out_of_scratch; // the last attempt failed for want of scratch
+    int retry_count;     // attempts after the first, each with a larger arena
+};
+// Dimensions from the file header only. Returns false if stb_image cannot read the file.
+bool image_get_info(const char *filename, int *width, int *height);
+// Scratch each worker starts with for an image; jobs whose decoder needs more are retried (on the calling thread,
+// after the others) with larger arenas, and fail only if the last retry runs out too
+u64 image_get_decode_scratch_size(int width, int height);
+// Run every job on 'thread_count' threads (<= 0 for one per core), the calling thread included, and return once
+// all are done
+void image_decode_jobs(Image_Decode_Job *jobs, int job_count, int thread_count);
+
+// KTX2 containers of payloads the gpu samples directly (BCn, ASTC, ...), mips included. Only the header and level
+// index are read: level data stays where it is, to be copied straight into staging. Basis Universal payloads
+// (vkFormat undefined) and supercompressed ones are reported rather than transcoded.
+static constexpr int IMAGE_KTX2_MAX_LEVELS = 16;
+
+enum Image_Ktx2_Result {
+    IMAGE_KTX2_OK              = 0,
+    IMAGE_KTX2_NOT_KTX2        = 1,
+    IMAGE_KTX2_TRUNCATED       = 2, // a level or the index runs past the end
+    IMAGE_KTX2_UNSUPPORTED     = 3, // 3d, array, cubemap, or too many levels
+    IMAGE_KTX2_NEEDS_TRANSCODE = 4, // Basis Universal (ETC1S or UASTC)
+    IMAGE_KTX2_SUPERCOMPRESSED = 5, // zstd or zlib
+};
+struct Image_Ktx2_Level {
+    u64 offset; // from the start of the file
+    u64 size;
+};
+struct Image_Ktx2 {
+    u32 vk_format; // a VkFormat
+    u32 width;
+    u32 height;
+    u32 level_count;
+    Image_Ktx2_Level levels[IMAGE_KTX2_MAX_LEVELS]; // level 0 (the largest) first
+};
+Image_Ktx2_Result image_parse_ktx2(const u8 *data, u64 size, Image_Ktx2 *ret);
+
+#if TEST
+void test_image();
+#endif
+
 #endif // include guard
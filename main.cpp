@@ -9,6 +9,11 @@
 #include "gltf.hpp"
 #include "simd.hpp"
 #include "renderer.hpp"
+#include "vertex.hpp"
+#include "mesh.hpp"
+#include "suballocator.hpp"
+#include "virtual_texture.hpp"
+#include "tex_streamer.hpp"
 #include "vulkan/vulkan_core.h"
 
 #if TEST
@@ -19,6 +24,11 @@ void run_tests(); // defined below main
 // @Todo Find a good memory footprint
 // Some completely arbitrary sizes for now. This should be managed as the other memory resources are.
 static constexpr u64 DRAW_INFO_ALLOCATOR_SIZE  = 10000;
+static constexpr int RESIDENCY_TABLE_CAPACITY  = 256;
+static constexpr u64 VERTEX_MEMORY_BLOCK_SIZE  = 16 * 1024 * 1024;
+static constexpr int VERTEX_MEMORY_ALLOCATION_CAP = 1024; // per block
+static constexpr u64 DEFRAG_BYTES_PER_FRAME    = 1024 * 1024;
+static constexpr int DEFRAG_MOVE_CAP           = 64;
 
 int main() {
     init_allocators();
@@ -43,27 +53,60 @@ int main() {
 
 
     /* Begin Code That Actually Does Stuff */
-    Gltf model = parse_gltf("models/cube-static/Cube.gltf");
-
-    Gpu_Buf_Allocator *device_index_allocator  = gpu->index_device_allocator;
-    Gpu_Buf_Allocator *device_vertex_allocator = gpu->vertex_device_allocator;
-
     Gpu_Buf_Allocator *host_index_allocator  = gpu->index_host_allocator;
     Gpu_Buf_Allocator *host_vertex_allocator = gpu->vertex_host_allocator;
 
     Linear_Allocator draw_info_allocator = create_linear_allocator(DRAW_INFO_ALLOCATOR_SIZE);
 
+    // Index and vertex data lives in allocations of its own, staged through the host allocators, so that it can be
+    // freed per model and defragmented
+    Gpu_Memory_Allocator vertex_memory =
+        renderer_create_vertex_memory(VERTEX_MEMORY_BLOCK_SIZE, VERTEX_MEMORY_ALLOCATION_CAP);
+    Gpu_Defragmenter defrag =
+        gpu_create_defragmenter(&vertex_memory, DEFRAG_BYTES_PER_FRAME, 16, DEFRAG_MOVE_CAP);
+
     Renderer_Gpu_Allocator_Group gpu_allocator_group = {
         .draw_info_allocator = &draw_info_allocator,
         .index_allocator     = host_index_allocator,
         .vertex_allocator    = host_vertex_allocator,
+        .tex_allocator       = gpu->texture_allocator,
+        .device_memory       = &vertex_memory,
     };
-    Renderer_Vertex_Attribute_Resources resource_list =
-        renderer_setup_vertex_attribute_resources_static_model(&model, &gpu_allocator_group);
-    Renderer_Draws model_draw_infos =
-        renderer_download_model_data(&model, &resource_list, "models/cube-static/");
 
-    Gpu_Vertex_Input_State pl_stage_1 = resource_list.vertex_state_infos[0][0];
+    // Buffer views with the same content are uploaded once, however many models use them
+    Renderer_Residency_Table residency = renderer_create_residency_table(RESIDENCY_TABLE_CAPACITY);
+
+    // Gltf files only have their json parsed if the bake is missing or stale
+    Renderer_Scene_Model_Info scene_model_infos[] = {
+        {"models/cube-static/Cube.gltf", "models/cube-static/Cube.gltf.bake", "models/cube-static/"},
+    };
+    Renderer_Scene scene =
+        renderer_load_scene(1, scene_model_infos, &gpu_allocator_group, NULL, NULL,
+                            RENDERER_VERTEX_LAYOUT_SEPARATE, 0x0, &residency);
+    Renderer_Draws model_draw_infos = scene.draws[0];
+
+    // Cache stats are in thousandths, as println has no floats
+    Renderer_Optimize_Stats *optimize_stats = &model_draw_infos.optimize_stats;
+    if (optimize_stats->primitive_count) {
+        println("Optimized %u primitives, %u vertices -> %u:", (u64)optimize_stats->primitive_count,
+                (u64)optimize_stats->vertex_count, (u64)optimize_stats->optimized_vertex_count);
+        println("    ACMR (x1000): %u -> %u", (u64)(optimize_stats->cache_before.acmr * 1000),
+                (u64)(optimize_stats->cache_after.acmr * 1000));
+        println("    ATVR (x1000): %u -> %u", (u64)(optimize_stats->cache_before.atvr * 1000),
+                (u64)(optimize_stats->cache_after.atvr * 1000));
+    }
+
+    // Decoded and staged with their mips, uploaded with the vertex data below
+    Renderer_Texture_Resources model_textures =
+        renderer_setup_textures_static_model(&scene.models[0].gltf, &gpu_allocator_group,
+                                             scene_model_infos[0].dir_path);
+    u64 texture_decode_us = 0;
+    for(u32 i = 0; i < model_textures.texture_count; ++i)
+        texture_decode_us += model_textures.decode_us[i];
+    println("Decoded %u textures in %u us (summed over the job threads), %u retries",
+            (u64)model_textures.decode_job_count, texture_decode_us, (u64)model_textures.decode_retry_count);
+
+    Gpu_Vertex_Input_State pl_stage_1 = scene.vertex_state_infos[0][0][0];
 
     Gpu_Rasterization_State pl_stage_2 =
         renderer_define_rasterization_state(GPU_POLYGON_MODE_FILL_BIT, VK_CULL_MODE_NONE);
@@ -193,38 +236,24 @@ int main() {
     VkCommandBuffer *transfer_cmd =
         gpu_allocate_command_buffers(gpu->vk_device, &transfer_command_allocator, 1, false);
 
-    VkCopyBufferInfo2 buffer_copy_infos[] = {
-        gpu_buf_allocator_setup_copy(
-            device_index_allocator,
-            host_index_allocator,
-            resource_list.index_allocation_start,
-            resource_list.index_allocation_end),
-        gpu_buf_allocator_setup_copy(
-            device_vertex_allocator,
-            host_vertex_allocator,
-            resource_list.vertex_allocation_start,
-            resource_list.vertex_allocation_end),
-    };
-
     Gpu_Binary_Semaphore_Pool semaphore_pool =
         gpu_create_binary_semaphore_pool(gpu->vk_device, 4);
     VkSemaphore *transfer_semaphore = gpu_get_binary_semaphores(&semaphore_pool, 1);
 
-    VkBuffer buffers[] = {device_index_allocator->buf, device_vertex_allocator->buf};
-
     Gpu_Buffer_Copy_Info buffer_copy = {};
     buffer_copy.transfer_signal = *transfer_semaphore;
     buffer_copy.transfer_cmd = *transfer_cmd;
     buffer_copy.graphics_cmd = *graphics_cmd;
-    buffer_copy.buffer_count = 2;
-    buffer_copy.buffers = buffers;
-    buffer_copy.copy_infos = buffer_copy_infos;
+    buffer_copy.buffer_count = scene.copy_count;
+    buffer_copy.buffers = scene.copy_buffers;
+    buffer_copy.copy_infos = scene.copy_infos;
 
+    // Draw infos say which of the vertex memory's blocks to bind
     VkBuffer vertex_buffers[] = {
-        device_vertex_allocator->buf,
-        device_vertex_allocator->buf,
-        device_vertex_allocator->buf,
-        device_vertex_allocator->buf,
+        vertex_memory.blocks[model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_blocks[0]].buffer,
+        vertex_memory.blocks[model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_blocks[1]].buffer,
+        vertex_memory.blocks[model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_blocks[2]].buffer,
+        vertex_memory.blocks[model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_blocks[3]].buffer,
     };
     u64 vertex_buffer_offsets[] = {
         model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_offsets[0],
@@ -241,6 +270,9 @@ int main() {
     };
     
     VkSubmitInfo2 graphics_submit_info = gpu_cmd_begin_buf_transfer_graphics(&buffer_copy);
+        if (model_textures.allocation_count)
+            gpu_cmd_tex_allocator_upload(*graphics_cmd, gpu->texture_allocator, model_textures.allocation_first,
+                                         model_textures.allocation_count);
         vkCmdSetViewportWithCount(*graphics_cmd, 1, &viewport);
         vkCmdSetScissorWithCount(*graphics_cmd, 1, renderpass_begin_info.render_area);
 
@@ -250,20 +282,32 @@ int main() {
 
             vkCmdBindIndexBuffer(
                 *graphics_cmd,
-                device_index_allocator->buf,
+                vertex_memory.blocks[model_draw_infos.meshes[0].primitive_draw_infos[0].index_buffer_block].buffer,
                 model_draw_infos.meshes[0].primitive_draw_infos[0].index_buffer_offset,
-                VK_INDEX_TYPE_UINT16);
+                model_draw_infos.meshes[0].primitive_draw_infos[0].index_type);
             vkCmdBindVertexBuffers(
                 *graphics_cmd,
                 0,
-                4,
+                model_draw_infos.meshes[0].primitive_draw_infos[0].vertex_buffer_count,
                 vertex_buffers,
                 vertex_buffer_offsets);
-            vkCmdDrawIndexed(
-                *graphics_cmd,
-                model_draw_infos.meshes[0].primitive_draw_infos[0].draw_count,
-                1,
-                0, 0, 0);
+            if (model_draw_infos.meshes[0].primitive_draw_infos[0].index_split) {
+                Renderer_Index_Split *split = model_draw_infos.meshes[0].primitive_draw_infos[0].index_split;
+                for(int i = 0; i < split->range_count; ++i)
+                    vkCmdDrawIndexed(
+                        *graphics_cmd,
+                        split->ranges[i].index_count,
+                        1,
+                        split->ranges[i].first_index,
+                        (s32)split->ranges[i].vertex_offset,
+                        0);
+            } else {
+                vkCmdDrawIndexed(
+                    *graphics_cmd,
+                    model_draw_infos.meshes[0].primitive_draw_infos[0].draw_count,
+                    1,
+                    0, 0, 0);
+            }
 
         vkCmdEndRenderPass(*graphics_cmd);
 
@@ -291,10 +335,33 @@ int main() {
     vkQueuePresentKHR(gpu->vk_queues[1], &present_info);
 
     zero_temp();
+    int defrag_move_count;
+    Gpu_Defrag_Move *defrag_moves;
+    VkCommandBufferSubmitInfo defrag_cmd_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    defrag_cmd_info.commandBuffer = *graphics_cmd;
+    VkSubmitInfo2 defrag_submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    defrag_submit_info.commandBufferInfoCount = 1;
+    defrag_submit_info.pCommandBufferInfos    = &defrag_cmd_info;
     while(!glfwWindowShouldClose(glfw->window)) {
         // vkAcquireNextImageKHR(
         //     gpu->vk_device, window->vk_swapchain, 10e9, VK_NULL_HANDLE, *fence, &image_index);
         window_poll_and_get_input(glfw);
+
+        // Vertex memory is compacted a budget at a time, once the last step's copies (or the frame) are done
+        vkWaitForFences(gpu->vk_device, 1, fence, VK_TRUE, 10e9);
+        defrag_moves = gpu_defrag_complete(gpu->vk_device, &defrag, &defrag_move_count);
+        renderer_apply_defrag_moves(scene.model_count, scene.draws, &residency, &vertex_memory, defrag_move_count,
+                                    defrag_moves);
+
+        gpu_reset_command_allocator(gpu->vk_device, &graphics_command_allocator);
+        gpu_begin_primary_command_buffer(*graphics_cmd, true);
+        defrag_move_count = gpu_defrag_record(&defrag, *graphics_cmd);
+        gpu_end_command_buffer(*graphics_cmd);
+        if (defrag_move_count > 0) {
+            vkResetFences(gpu->vk_device, 1, fence);
+            vkQueueSubmit2(gpu->vk_queues[0], 1, &defrag_submit_info, *fence);
+        }
+        zero_temp();
     }
 
     /* ShutDown Code */
@@ -313,6 +380,10 @@ int main() {
     destroy_vk_pipeline_layout(gpu->vk_device, pl_layout);
     renderer_destroy_shader_stages(gpu->vk_device, 2, pl_shader_stages);
 
+    renderer_unload_scene(&scene); // before the draw info allocator, which holds the models
+    gpu_destroy_defragmenter(&defrag);
+    gpu_destroy_memory_allocator(gpu->vk_device, &vertex_memory);
+    renderer_destroy_residency_table(&residency);
     destroy_linear_allocator(&draw_info_allocator);
     gpu_destroy_descriptor_allocator(gpu->vk_device, &descriptor_allocator);
     gpu_destroy_descriptor_set_layouts(gpu->vk_device, set_info_count, descriptor_set_layouts);
@@ -332,6 +403,12 @@ void run_tests() {
 
     test_spirv();
     test_gltf();
+    test_vertex();
+    test_mesh();
+    test_suballocator();
+    test_image();
+    test_virtual_texture();
+    test_tex_streamer();
 
     end_tests();
 }
@@ -0,0 +1,1315 @@
+#include "mesh.hpp"
+#include "simd.hpp"
+#include "array.hpp"
+#include "external/wyhash.h"
+
+#include <float.h> // FLT_MAX
+
+#if TEST
+#include "test.hpp"
+#include "gltf.hpp"
+#include "file.hpp"
+#endif
+
+static inline float mesh_sqrt(float x) {
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+}
+
+// Descending by key, ties broken by index so that runs of equal keys (there are plenty of zero cost collapses
+// on flat areas) do not degrade the sort (see sort_array())
+struct Mesh_Sort_Key {
+    float key;
+    int index;
+};
+static inline bool mesh_sort_before(Mesh_Sort_Key a, Mesh_Sort_Key b) {
+    return a.key > b.key || (a.key == b.key && a.index < b.index);
+}
+
+Mesh_Cache_Stats mesh_analyze_vertex_cache(const u32 *indices, int index_count, int vertex_count, int cache_size) {
+    u64 mark = get_mark_temp();
+
+    // A vertex is still in the FIFO if fewer than 'cache_size' vertices have been pushed since it was
+    u32 *pushed_at = (u32*)memory_allocate_temp(sizeof(u32) * vertex_count, 4);
+    memset(pushed_at, 0, sizeof(u32) * vertex_count);
+
+    u32 time = cache_size + 1;
+    int misses = 0;
+    for(int i = 0; i < index_count; ++i) {
+        if (time - pushed_at[indices[i]] > (u32)cache_size) {
+            pushed_at[indices[i]] = time;
+            time++;
+            misses++;
+        }
+    }
+
+    reset_to_mark_temp(mark);
+
+    Mesh_Cache_Stats ret;
+    ret.acmr = index_count  ? (float)misses / (index_count / 3) : 0;
+    ret.atvr = vertex_count ? (float)misses / vertex_count      : 0;
+    return ret;
+}
+
+static inline u64 mesh_hash_vertex(u32 vertex, int stream_count, const Vertex_Stream *streams) {
+    u64 hash = 0;
+    for(int s = 0; s < stream_count; ++s)
+        hash = wyhash(streams[s].src + (u64)vertex * streams[s].stride, streams[s].size, hash, _wyp);
+    return hash;
+}
+static inline bool mesh_vertex_equal(u32 a, u32 b, int stream_count, const Vertex_Stream *streams) {
+    for(int s = 0; s < stream_count; ++s)
+        if (memcmp(streams[s].src + (u64)a * streams[s].stride,
+                   streams[s].src + (u64)b * streams[s].stride, streams[s].size) != 0)
+            return false;
+    return true;
+}
+
+int mesh_generate_vertex_remap(u32 *remap, const u32 *indices, int index_count, int vertex_count,
+                               int stream_count, const Vertex_Stream *streams)
+{
+    u64 mark = get_mark_temp();
+
+    // Open addressing over vertex indices, at most half full
+    u32 table_size = 16;
+    while(table_size < (u32)vertex_count * 2)
+        table_size <<= 1;
+    u32 mask = table_size - 1;
+    u32 *table = (u32*)memory_allocate_temp(sizeof(u32) * table_size, 4);
+    memset(table, 0xff, sizeof(u32) * table_size);
+    memset(remap, 0xff, sizeof(u32) * vertex_count);
+
+    int unique = 0;
+    u32 vertex;
+    u32 slot;
+    for(int i = 0; i < index_count; ++i) {
+        vertex = indices[i];
+        if (remap[vertex] != Max_u32)
+            continue;
+
+        slot = (u32)mesh_hash_vertex(vertex, stream_count, streams) & mask;
+        while(table[slot] != Max_u32 && !mesh_vertex_equal(table[slot], vertex, stream_count, streams))
+            slot = (slot + 1) & mask;
+
+        if (table[slot] == Max_u32) {
+            table[slot] = vertex;
+            remap[vertex] = unique;
+            unique++;
+        } else {
+            remap[vertex] = remap[table[slot]];
+        }
+    }
+
+    reset_to_mark_temp(mark);
+    return unique;
+}
+
+void mesh_remap_indices(u32 *dst, const u32 *indices, int index_count, const u32 *remap) {
+    for(int i = 0; i < index_count; ++i)
+        dst[i] = remap[indices[i]];
+}
+
+void mesh_remap_vertices(u8 *dst, const u8 *src, int src_stride, int size, int vertex_count, const u32 *remap) {
+    for(int i = 0; i < vertex_count; ++i)
+        if (remap[i] != Max_u32)
+            memcpy(dst + (u64)remap[i] * size, src + (u64)i * src_stride, size);
+}
+
+// `Forsyth
+//
+// Every vertex is scored by its position in a simulated LRU cache and by how many triangles still use it
+// (so that lone vertices are finished off); a triangle's score is the sum of its vertices'. The best scoring
+// triangle touching the cache is emitted next. When the cache has nothing left to offer, the next triangle
+// in input order is taken.
+static constexpr int   MESH_FORSYTH_CACHE_SIZE     = 32;
+static constexpr int   MESH_FORSYTH_MAX_VALENCE    = 32; // scores above this use the last table entry
+static constexpr float MESH_FORSYTH_LAST_TRI_SCORE = 0.75f;
+
+struct Mesh_Forsyth_Tables {
+    float cache[MESH_FORSYTH_CACHE_SIZE];
+    float valence[MESH_FORSYTH_MAX_VALENCE + 1];
+};
+static void mesh_forsyth_tables(Mesh_Forsyth_Tables *tables) {
+    for(int i = 0; i < MESH_FORSYTH_CACHE_SIZE; ++i) {
+        if (i < 3) {
+            tables->cache[i] = MESH_FORSYTH_LAST_TRI_SCORE;
+        } else {
+            // (1 - (i - 3) / (size - 3)) ^ 1.5
+            float s = 1.0f - (float)(i - 3) / (MESH_FORSYTH_CACHE_SIZE - 3);
+            tables->cache[i] = s * mesh_sqrt(s);
+        }
+    }
+    tables->valence[0] = 0;
+    for(int i = 1; i <= MESH_FORSYTH_MAX_VALENCE; ++i)
+        tables->valence[i] = 2.0f / mesh_sqrt((float)i); // 2 * valence ^ -0.5
+}
+static inline float mesh_forsyth_score(Mesh_Forsyth_Tables *tables, int cache_position, int live) {
+    if (live == 0)
+        return -1;
+    float score = cache_position >= 0 ? tables->cache[cache_position] : 0;
+    return score + tables->valence[live < MESH_FORSYTH_MAX_VALENCE ? live : MESH_FORSYTH_MAX_VALENCE];
+}
+
+void mesh_optimize_vertex_cache(u32 *dst, const u32 *indices, int index_count, int vertex_count) {
+    u64 mark = get_mark_temp();
+    int tri_count = index_count / 3;
+
+    Mesh_Forsyth_Tables tables;
+    mesh_forsyth_tables(&tables);
+
+    // Triangle adjacency: 'adjacency[offsets[v]..offsets[v] + live[v]]' are the unemitted triangles using v
+    int *live    = (int*)memory_allocate_temp(sizeof(int) * vertex_count, 4);
+    int *offsets = (int*)memory_allocate_temp(sizeof(int) * (vertex_count + 1), 4);
+    int *adjacency = (int*)memory_allocate_temp(sizeof(int) * index_count, 4);
+    memset(live, 0, sizeof(int) * vertex_count);
+    for(int i = 0; i < index_count; ++i)
+        live[indices[i]]++;
+    offsets[0] = 0;
+    for(int v = 0; v < vertex_count; ++v)
+        offsets[v + 1] = offsets[v] + live[v];
+    memset(live, 0, sizeof(int) * vertex_count);
+    for(int i = 0; i < index_count; ++i) {
+        adjacency[offsets[indices[i]] + live[indices[i]]] = i / 3;
+        live[indices[i]]++;
+    }
+
+    int   *cache_position = (int*)  memory_allocate_temp(sizeof(int)   * vertex_count, 4);
+    float *vertex_score   = (float*)memory_allocate_temp(sizeof(float) * vertex_count, 4);
+    float *tri_score      = (float*)memory_allocate_temp(sizeof(float) * tri_count, 4);
+    bool  *emitted        = (bool*) memory_allocate_temp(sizeof(bool)  * tri_count, 1);
+    for(int v = 0; v < vertex_count; ++v) {
+        cache_position[v] = -1;
+        vertex_score[v] = mesh_forsyth_score(&tables, -1, live[v]);
+    }
+    for(int t = 0; t < tri_count; ++t) {
+        tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+        emitted[t] = false;
+    }
+
+    // Three over, for the vertices pushed out by the triangle being emitted
+    u32 cache[MESH_FORSYTH_CACHE_SIZE + 3];
+    u32 next_cache[MESH_FORSYTH_CACHE_SIZE + 3];
+    int cache_count = 0;
+    int next_count;
+
+    int best = 0;
+    int cursor = 0;
+    float best_score;
+    u32 vertex;
+    for(int out = 0; out < tri_count; ++out) {
+        if (best < 0) {
+            while(emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        emitted[best] = true;
+        memcpy(dst + out * 3, indices + best * 3, sizeof(u32) * 3);
+
+        // The emitted triangle goes to the front, then everything that was in the cache before it
+        next_count = 0;
+        for(int k = 0; k < 3; ++k) {
+            vertex = indices[best * 3 + k];
+            next_cache[next_count] = vertex;
+            next_count++;
+
+            for(int a = offsets[vertex]; a < offsets[vertex] + live[vertex]; ++a) {
+                if (adjacency[a] == best) {
+                    adjacency[a] = adjacency[offsets[vertex] + live[vertex] - 1];
+                    break;
+                }
+            }
+            live[vertex]--;
+        }
+        for(int c = 0; c < cache_count; ++c) {
+            vertex = cache[c];
+            if (vertex != next_cache[0] && vertex != next_cache[1] && vertex != next_cache[2]) {
+                next_cache[next_count] = vertex;
+                next_count++;
+            }
+        }
+
+        // Rescore everything that moved (or fell out), then every triangle they are still part of
+        for(int c = 0; c < next_count; ++c) {
+            vertex = next_cache[c];
+            cache_position[vertex] = c < MESH_FORSYTH_CACHE_SIZE ? c : -1;
+            vertex_score[vertex] = mesh_forsyth_score(&tables, cache_position[vertex], live[vertex]);
+        }
+        best = -1;
+        best_score = -1;
+        for(int c = 0; c < next_count; ++c) {
+            vertex = next_cache[c];
+            for(int a = offsets[vertex]; a < offsets[vertex] + live[vertex]; ++a) {
+                int t = adjacency[a];
+                tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] +
+                               vertex_score[indices[t * 3 + 2]];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = next_count < MESH_FORSYTH_CACHE_SIZE ? next_count : MESH_FORSYTH_CACHE_SIZE;
+        memcpy(cache, next_cache, sizeof(u32) * cache_count);
+    }
+
+    reset_to_mark_temp(mark);
+}
+
+// `Overdraw
+//
+// The cache optimized order is cut into clusters wherever a triangle misses on all three vertices, as that
+// is where the cache starts over anyway. Clusters are then sorted by how much they face away from the
+// centre of the mesh: drawing those first tends to fill the depth buffer with occluders.
+void mesh_optimize_overdraw(u32 *dst, const u32 *indices, int index_count, const u8 *positions,
+                            int position_stride, int vertex_count, float threshold)
+{
+    u64 mark = get_mark_temp();
+    int tri_count = index_count / 3;
+
+    u32 *pushed_at = (u32*)memory_allocate_temp(sizeof(u32) * vertex_count, 4);
+    memset(pushed_at, 0, sizeof(u32) * vertex_count);
+    int *cluster_starts = (int*)memory_allocate_temp(sizeof(int) * (tri_count + 1), 4);
+    int cluster_count = 0;
+
+    u32 time = MESH_ANALYZE_CACHE_SIZE + 1;
+    int misses;
+    for(int t = 0; t < tri_count; ++t) {
+        misses = 0;
+        for(int k = 0; k < 3; ++k) {
+            if (time - pushed_at[indices[t * 3 + k]] > (u32)MESH_ANALYZE_CACHE_SIZE) {
+                pushed_at[indices[t * 3 + k]] = time;
+                time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            cluster_starts[cluster_count] = t;
+            cluster_count++;
+        }
+    }
+    cluster_starts[cluster_count] = tri_count;
+
+    // Area weighted centroids (of the mesh and of each cluster) and summed face normals
+    float *cluster_data = (float*)memory_allocate_temp(sizeof(float) * 6 * cluster_count, 4);
+    float mesh_centroid[3] = {};
+    float mesh_area = 0;
+    const float *p[3];
+    float e0[3], e1[3], n[3];
+    float area;
+    for(int c = 0; c < cluster_count; ++c) {
+        float *centroid = cluster_data + c * 6;
+        float *normal   = cluster_data + c * 6 + 3;
+        float cluster_area = 0;
+        memset(cluster_data + c * 6, 0, sizeof(float) * 6);
+
+        for(int t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+            for(int k = 0; k < 3; ++k)
+                p[k] = (const float*)(positions + (u64)indices[t * 3 + k] * position_stride);
+            for(int j = 0; j < 3; ++j) {
+                e0[j] = p[1][j] - p[0][j];
+                e1[j] = p[2][j] - p[0][j];
+            }
+            n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+            n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+            n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+            area = mesh_sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for(int j = 0; j < 3; ++j) {
+                centroid[j] += (p[0][j] + p[1][j] + p[2][j]) * area;
+                normal[j]   += n[j];
+            }
+            cluster_area += area;
+        }
+        for(int j = 0; j < 3; ++j)
+            mesh_centroid[j] += centroid[j];
+        mesh_area += cluster_area;
+
+        for(int j = 0; j < 3; ++j)
+            centroid[j] = cluster_area > 0 ? centroid[j] / (cluster_area * 3) : 0;
+    }
+    for(int j = 0; j < 3; ++j)
+        mesh_centroid[j] = mesh_area > 0 ? mesh_centroid[j] / (mesh_area * 3) : 0;
+
+    Mesh_Sort_Key *keys = (Mesh_Sort_Key*)memory_allocate_temp(sizeof(Mesh_Sort_Key) * cluster_count, 4);
+    float len;
+    for(int c = 0; c < cluster_count; ++c) {
+        float *centroid = cluster_data + c * 6;
+        float *normal   = cluster_data + c * 6 + 3;
+        len = mesh_sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        keys[c].index = c;
+        keys[c].key = 0;
+        for(int j = 0; j < 3; ++j)
+            keys[c].key += (centroid[j] - mesh_centroid[j]) * (len > 0 ? normal[j] / len : 0);
+    }
+    sort_array(keys, 0, cluster_count - 1, mesh_sort_before);
+
+    int out = 0;
+    int count;
+    for(int c = 0; c < cluster_count; ++c) {
+        count = (cluster_starts[keys[c].index + 1] - cluster_starts[keys[c].index]) * 3;
+        memcpy(dst + out, indices + cluster_starts[keys[c].index] * 3, sizeof(u32) * count);
+        out += count;
+    }
+
+    reset_to_mark_temp(mark);
+
+    Mesh_Cache_Stats before = mesh_analyze_vertex_cache(indices, index_count, vertex_count);
+    Mesh_Cache_Stats after  = mesh_analyze_vertex_cache(dst, index_count, vertex_count);
+    if (after.acmr > before.acmr * threshold)
+        memcpy(dst, indices, sizeof(u32) * index_count);
+}
+
+int mesh_optimize_vertex_fetch_remap(u32 *remap, const u32 *indices, int index_count, int vertex_count) {
+    memset(remap, 0xff, sizeof(u32) * vertex_count);
+    int next = 0;
+    for(int i = 0; i < index_count; ++i) {
+        if (remap[indices[i]] == Max_u32) {
+            remap[indices[i]] = next;
+            next++;
+        }
+    }
+    return next;
+}
+
+int mesh_split_index_ranges(Mesh_Index_Range *ranges, const u32 *indices, int index_count, u32 max_vertices) {
+    int range_count = 0;
+    u32 first = 0;
+    u32 lo = Max_u32;
+    u32 hi = 0;
+    u32 tri_lo, tri_hi;
+    for(u32 t = 0; t < (u32)index_count / 3; ++t) {
+        tri_lo = indices[t * 3];
+        tri_hi = indices[t * 3];
+        for(int k = 1; k < 3; ++k) {
+            tri_lo = indices[t * 3 + k] < tri_lo ? indices[t * 3 + k] : tri_lo;
+            tri_hi = indices[t * 3 + k] > tri_hi ? indices[t * 3 + k] : tri_hi;
+        }
+        ASSERT(tri_hi - tri_lo < max_vertices, "Triangle spans more vertices than a range can hold");
+
+        // Close the range if this triangle would stretch it too far, and start the next one with it
+        if (t * 3 > first && (tri_hi > hi ? tri_hi : hi) - (tri_lo < lo ? tri_lo : lo) >= max_vertices) {
+            if (ranges)
+                ranges[range_count] = {first, t * 3 - first, lo};
+            range_count++;
+            first = t * 3;
+            lo = tri_lo;
+            hi = tri_hi;
+            continue;
+        }
+        lo = tri_lo < lo ? tri_lo : lo;
+        hi = tri_hi > hi ? tri_hi : hi;
+    }
+    if ((u32)index_count > first) {
+        if (ranges)
+            ranges[range_count] = {first, index_count - first, lo};
+        range_count++;
+    }
+    return range_count;
+}
+
+void mesh_narrow_indices_u16(u16 *dst, const u32 *indices, int count, u32 base) {
+    // Values are below 65536 once rebased, so the saturating pack never saturates; it does interleave the
+    // two 128 bit lanes though, which the permute undoes.
+    __m256i b = _mm256_set1_epi32(base);
+    __m256i a;
+    int i = 0;
+    for(; i + 16 <= count; i += 16) {
+        a = _mm256_packus_epi32(
+                _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(indices + i)),     b),
+                _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(indices + i + 8)), b));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(a, 0b11011000));
+    }
+    for(; i < count; ++i)
+        dst[i] = (u16)(indices[i] - base);
+}
+
+// `Meshlets
+
+int mesh_build_meshlets_bound(int index_count, int max_vertices, int max_triangles) {
+    // Every meshlet but the last is closed by a triangle which needed room it did not have, so it holds at least
+    // max_triangles triangles or max_vertices - 2 vertices
+    int tri_count = index_count / 3;
+    int by_triangles = (tri_count + max_triangles - 1) / max_triangles;
+    int by_vertices  = (index_count + (max_vertices - 2) - 1) / (max_vertices - 2);
+    return (by_triangles > by_vertices ? by_triangles : by_vertices) + 1;
+}
+
+int mesh_build_meshlets(Mesh_Meshlet *meshlets, u32 *vertices, u8 *triangles, const u32 *indices, int index_count,
+                        int vertex_count, int max_vertices, int max_triangles)
+{
+    ASSERT(max_vertices <= 256, "Meshlet triangles index vertices with u8");
+    u64 mark = get_mark_temp();
+
+    // The meshlet local index of each vertex, 0xff if it is not in the current meshlet
+    u8 *local = (u8*)memory_allocate_temp(vertex_count, 1);
+    memset(local, 0xff, vertex_count);
+
+    int meshlet_count = 0;
+    Mesh_Meshlet current = {};
+    int new_vertices;
+    u32 vertex;
+    for(int t = 0; t < index_count / 3; ++t) {
+        new_vertices = 0;
+        for(int k = 0; k < 3; ++k)
+            new_vertices += local[indices[t * 3 + k]] == 0xff;
+
+        if (current.vertex_count + new_vertices > (u32)max_vertices || current.triangle_count == (u32)max_triangles) {
+            for(u32 i = 0; i < current.vertex_count; ++i)
+                local[vertices[current.vertex_offset + i]] = 0xff;
+            meshlets[meshlet_count] = current;
+            meshlet_count++;
+
+            current.vertex_offset  += current.vertex_count;
+            current.triangle_offset += current.triangle_count * 3;
+            current.vertex_count   = 0;
+            current.triangle_count = 0;
+        }
+
+        for(int k = 0; k < 3; ++k) {
+            vertex = indices[t * 3 + k];
+            if (local[vertex] == 0xff) {
+                local[vertex] = current.vertex_count;
+                vertices[current.vertex_offset + current.vertex_count] = vertex;
+                current.vertex_count++;
+            }
+            triangles[current.triangle_offset + current.triangle_count * 3 + k] = local[vertex];
+        }
+        current.triangle_count++;
+    }
+    if (current.triangle_count) {
+        meshlets[meshlet_count] = current;
+        meshlet_count++;
+    }
+
+    reset_to_mark_temp(mark);
+    return meshlet_count;
+}
+
+static inline float mesh_distance_squared(const float *a, const float *b) {
+    return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]);
+}
+
+Mesh_Meshlet_Bounds mesh_compute_meshlet_bounds(const Mesh_Meshlet *meshlet, const u32 *vertices, const u8 *triangles,
+                                                const u8 *positions, int position_stride)
+{
+    Mesh_Meshlet_Bounds ret = {};
+    const u32 *meshlet_vertices = vertices + meshlet->vertex_offset;
+    const u8 *meshlet_triangles = triangles + meshlet->triangle_offset;
+    #define MESH_POSITION(i) ((const float*)(positions + (u64)meshlet_vertices[i] * position_stride))
+
+    // Ritter: start from two far apart vertices, then grow the sphere to take in any vertex still outside
+    const float *p = MESH_POSITION(0);
+    const float *a = p;
+    const float *b = p;
+    for(u32 i = 0; i < meshlet->vertex_count; ++i)
+        if (mesh_distance_squared(p, MESH_POSITION(i)) > mesh_distance_squared(p, a))
+            a = MESH_POSITION(i);
+    for(u32 i = 0; i < meshlet->vertex_count; ++i)
+        if (mesh_distance_squared(a, MESH_POSITION(i)) > mesh_distance_squared(a, b))
+            b = MESH_POSITION(i);
+
+    for(int j = 0; j < 3; ++j)
+        ret.center[j] = (a[j] + b[j]) * 0.5f;
+    ret.radius = mesh_sqrt(mesh_distance_squared(a, b)) * 0.5f;
+
+    float d, grow;
+    for(u32 i = 0; i < meshlet->vertex_count; ++i) {
+        p = MESH_POSITION(i);
+        d = mesh_sqrt(mesh_distance_squared(p, ret.center));
+        if (d > ret.radius) {
+            grow = (d - ret.radius) * 0.5f;
+            for(int j = 0; j < 3; ++j)
+                ret.center[j] += (p[j] - ret.center[j]) * (grow / d);
+            ret.radius += grow;
+        }
+    }
+
+    // The cone axis is the mean of the unit face normals; the cutoff comes from the least aligned of them
+    float normals[MESH_MESHLET_MAX_TRIANGLES * 3];
+    ASSERT(meshlet->triangle_count <= MESH_MESHLET_MAX_TRIANGLES, "Meshlet too large for its bounds");
+    const float *v[3];
+    float e0[3], e1[3], len;
+    int normal_count = 0;
+    for(u32 t = 0; t < meshlet->triangle_count; ++t) {
+        for(int k = 0; k < 3; ++k)
+            v[k] = MESH_POSITION(meshlet_triangles[t * 3 + k]);
+        for(int j = 0; j < 3; ++j) {
+            e0[j] = v[1][j] - v[0][j];
+            e1[j] = v[2][j] - v[0][j];
+        }
+        float *n = normals + normal_count * 3;
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+        len = mesh_sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len == 0) // degenerate triangles have no say
+            continue;
+        for(int j = 0; j < 3; ++j) {
+            n[j] /= len;
+            ret.cone_axis[j] += n[j];
+        }
+        normal_count++;
+    }
+    #undef MESH_POSITION
+
+    len = mesh_sqrt(ret.cone_axis[0] * ret.cone_axis[0] + ret.cone_axis[1] * ret.cone_axis[1] +
+                    ret.cone_axis[2] * ret.cone_axis[2]);
+    ret.cone_cutoff = 1;
+    if (len == 0)
+        return ret;
+    for(int j = 0; j < 3; ++j)
+        ret.cone_axis[j] /= len;
+
+    float min_dot = 1;
+    for(int i = 0; i < normal_count; ++i) {
+        d = normals[i * 3] * ret.cone_axis[0] + normals[i * 3 + 1] * ret.cone_axis[1] +
+            normals[i * 3 + 2] * ret.cone_axis[2];
+        min_dot = d < min_dot ? d : min_dot;
+    }
+    // Some normal is at least 90 degrees off the axis: from somewhere, something is front facing
+    if (min_dot <= 0)
+        return ret;
+    ret.cone_cutoff = mesh_sqrt(1 - min_dot * min_dot);
+    return ret;
+}
+
+bool mesh_cull_meshlet_cone(const Mesh_Meshlet_Bounds *bounds, const float *camera_position) {
+    // Conservative for the whole sphere, not just its centre (Zeux, "Meshlet culling")
+    float view[3];
+    for(int j = 0; j < 3; ++j)
+        view[j] = bounds->center[j] - camera_position[j];
+    float dist = mesh_sqrt(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+    float d = view[0] * bounds->cone_axis[0] + view[1] * bounds->cone_axis[1] + view[2] * bounds->cone_axis[2];
+    return d >= bounds->cone_cutoff * dist + bounds->radius;
+}
+
+bool mesh_cull_sphere(const float *center, float radius, int plane_count, const float *planes) {
+    for(int i = 0; i < plane_count; ++i) {
+        const float *plane = planes + i * 4;
+        if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+            return true;
+    }
+    return false;
+}
+
+// `Simplify
+
+// Symmetric 4x4 error matrix of a set of planes, plus the weight (area) it was built from
+struct Mesh_Quadric {
+    float a2, b2, c2, d2;
+    float ab, ac, ad, bc, bd, cd;
+    float w;
+};
+static inline void mesh_quadric_add(Mesh_Quadric *q, const Mesh_Quadric *r) {
+    q->a2 += r->a2; q->b2 += r->b2; q->c2 += r->c2; q->d2 += r->d2;
+    q->ab += r->ab; q->ac += r->ac; q->ad += r->ad; q->bc += r->bc; q->bd += r->bd; q->cd += r->cd;
+    q->w  += r->w;
+}
+// Mean squared distance of 'p' from the planes
+static inline float mesh_quadric_error(const Mesh_Quadric *q, const float *p) {
+    float x = p[0], y = p[1], z = p[2];
+    float e = q->a2 * x * x + q->b2 * y * y + q->c2 * z * z + q->d2 +
+              2 * (q->ab * x * y + q->ac * x * z + q->bc * y * z + q->ad * x + q->bd * y + q->cd * z);
+    e = e > 0 ? e : 0; // rounding
+    return q->w > 0 ? e / q->w : 0;
+}
+// Unnormalized normal (length twice the area)
+static inline void mesh_triangle_normal(float *n, const float *p0, const float *p1, const float *p2) {
+    float e0[3], e1[3];
+    for(int j = 0; j < 3; ++j) {
+        e0[j] = p1[j] - p0[j];
+        e1[j] = p2[j] - p0[j];
+    }
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+float mesh_get_extent(const u8 *positions, int position_stride, int vertex_count) {
+    float lo[3] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    const float *p;
+    for(int i = 0; i < vertex_count; ++i) {
+        p = (const float*)(positions + (u64)i * position_stride);
+        for(int j = 0; j < 3; ++j) {
+            lo[j] = p[j] < lo[j] ? p[j] : lo[j];
+            hi[j] = p[j] > hi[j] ? p[j] : hi[j];
+        }
+    }
+    float extent = 0;
+    for(int j = 0; j < 3; ++j)
+        extent = hi[j] - lo[j] > extent ? hi[j] - lo[j] : extent;
+    return extent;
+}
+
+static inline u64 mesh_edge_key(u32 a, u32 b) {
+    return ((u64)a << 32) | b;
+}
+
+int mesh_simplify(u32 *dst, const u32 *indices, int index_count, const u8 *positions, int position_stride,
+                  int vertex_count, int target_index_count, float target_error, float *result_error)
+{
+    u64 mark = get_mark_temp();
+    if (dst != indices)
+        memcpy(dst, indices, sizeof(u32) * index_count);
+
+    // Work in units of the extent, so that errors come out relative
+    float extent = mesh_get_extent(positions, position_stride, vertex_count);
+    float inv_extent = extent > 0 ? 1 / extent : 0;
+    float *p = (float*)memory_allocate_temp(sizeof(float) * 3 * vertex_count, 4);
+    for(int i = 0; i < vertex_count; ++i)
+        for(int j = 0; j < 3; ++j)
+            p[i * 3 + j] = ((const float*)(positions + (u64)i * position_stride))[j] * inv_extent;
+
+    // An edge with no twin running the other way is open (a border, or a seam where the vertices are split)
+    u32 table_size = 16;
+    while(table_size < (u32)index_count * 2)
+        table_size <<= 1;
+    u32 mask = table_size - 1;
+    u64 *edges = (u64*)memory_allocate_temp(sizeof(u64) * table_size, 8);
+    memset(edges, 0xff, sizeof(u64) * table_size);
+
+    u8 *locked = (u8*)memory_allocate_temp(vertex_count, 1);
+    memset(locked, 0, vertex_count);
+
+    u64 key;
+    u32 slot;
+    for(int pass = 0; pass < 2; ++pass) {
+        for(int i = 0; i < index_count; ++i) {
+            u32 a = dst[i];
+            u32 b = dst[i % 3 == 2 ? i - 2 : i + 1];
+            key = pass == 0 ? mesh_edge_key(a, b) : mesh_edge_key(b, a);
+            slot = (u32)wyhash64(key, 0) & mask;
+            while(edges[slot] != Max_u64 && edges[slot] != key)
+                slot = (slot + 1) & mask;
+            if (pass == 0) {
+                edges[slot] = key;
+            } else if (edges[slot] == Max_u64) {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+
+    Mesh_Quadric *quadrics = (Mesh_Quadric*)memory_allocate_temp(sizeof(Mesh_Quadric) * vertex_count, 4);
+    memset(quadrics, 0, sizeof(Mesh_Quadric) * vertex_count);
+    float n[3], area, d;
+    Mesh_Quadric plane;
+    for(int t = 0; t < index_count / 3; ++t) {
+        const float *p0 = p + dst[t * 3] * 3;
+        mesh_triangle_normal(n, p0, p + dst[t * 3 + 1] * 3, p + dst[t * 3 + 2] * 3);
+        area = mesh_sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (area == 0)
+            continue;
+        for(int j = 0; j < 3; ++j)
+            n[j] /= area;
+        d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+        plane = {
+            n[0] * n[0] * area, n[1] * n[1] * area, n[2] * n[2] * area, d * d * area,
+            n[0] * n[1] * area, n[0] * n[2] * area, n[0] * d * area,
+            n[1] * n[2] * area, n[1] * d * area,    n[2] * d * area,
+            area,
+        };
+        for(int k = 0; k < 3; ++k)
+            mesh_quadric_add(&quadrics[dst[t * 3 + k]], &plane);
+    }
+
+    int   *offsets     = (int*)  memory_allocate_temp(sizeof(int)   * (vertex_count + 1), 4);
+    int   *adjacency   = (int*)  memory_allocate_temp(sizeof(int)   * index_count, 4);
+    int   *fill        = (int*)  memory_allocate_temp(sizeof(int)   * vertex_count, 4);
+    u32   *best_target = (u32*)  memory_allocate_temp(sizeof(u32)   * vertex_count, 4);
+    float *best_cost   = (float*)memory_allocate_temp(sizeof(float) * vertex_count, 4);
+    u32   *remap       = (u32*)  memory_allocate_temp(sizeof(u32)   * vertex_count, 4);
+    u8    *touched     = (u8*)   memory_allocate_temp(vertex_count, 1);
+    Mesh_Sort_Key *keys = (Mesh_Sort_Key*)memory_allocate_temp(sizeof(Mesh_Sort_Key) * vertex_count, 4);
+    for(int v = 0; v < vertex_count; ++v)
+        remap[v] = v;
+
+    float max_error_sq = target_error * target_error;
+    float result_sq = 0;
+    int count = index_count;
+    int candidate_count;
+    int removed;
+    int collapses;
+    u32 a, b, tri[3];
+    Mesh_Quadric merged;
+    float cost, before[3], after[3];
+    while(count > target_index_count) {
+        // Triangles around each vertex, for the flip check
+        memset(fill, 0, sizeof(int) * vertex_count);
+        for(int i = 0; i < count; ++i)
+            fill[dst[i]]++;
+        offsets[0] = 0;
+        for(int v = 0; v < vertex_count; ++v) {
+            offsets[v + 1] = offsets[v] + fill[v];
+            fill[v] = 0;
+        }
+        for(int i = 0; i < count; ++i) {
+            adjacency[offsets[dst[i]] + fill[dst[i]]] = i / 3;
+            fill[dst[i]]++;
+        }
+
+        // Cheapest collapse out of every vertex which can move
+        for(int v = 0; v < vertex_count; ++v) {
+            best_target[v] = Max_u32;
+            best_cost[v] = FLT_MAX;
+        }
+        for(int i = 0; i < count; ++i) {
+            for(int dir = 0; dir < 2; ++dir) {
+                a = dst[i];
+                b = dst[i % 3 == 2 ? i - 2 : i + 1];
+                if (dir) {
+                    a = b;
+                    b = dst[i];
+                }
+                if (locked[a])
+                    continue;
+                merged = quadrics[a];
+                mesh_quadric_add(&merged, &quadrics[b]);
+                cost = mesh_quadric_error(&merged, p + b * 3);
+                if (cost < best_cost[a]) {
+                    best_cost[a] = cost;
+                    best_target[a] = b;
+                }
+            }
+        }
+        candidate_count = 0;
+        for(int v = 0; v < vertex_count; ++v) {
+            if (best_target[v] != Max_u32 && best_cost[v] <= max_error_sq) {
+                keys[candidate_count] = {-best_cost[v], v};
+                candidate_count++;
+            }
+        }
+        if (candidate_count == 0)
+            break;
+        sort_array(keys, 0, candidate_count - 1, mesh_sort_before);
+
+        // Take collapses in order of cost, leaving alone anything around a vertex which has already moved
+        // this pass (its neighbourhood no longer looks like it did when the flip check would run)
+        memset(touched, 0, vertex_count);
+        removed = 0;
+        collapses = 0;
+        for(int c = 0; c < candidate_count && count - removed > target_index_count; ++c) {
+            a = keys[c].index;
+            b = best_target[a];
+            if (touched[a] || touched[b])
+                continue;
+
+            bool flips = false;
+            int shared = 0;
+            for(int j = offsets[a]; j < offsets[a + 1]; ++j) {
+                memcpy(tri, dst + adjacency[j] * 3, sizeof(tri));
+                if (tri[0] == b || tri[1] == b || tri[2] == b) {
+                    shared++;
+                    continue;
+                }
+                mesh_triangle_normal(before, p + tri[0] * 3, p + tri[1] * 3, p + tri[2] * 3);
+                for(int k = 0; k < 3; ++k)
+                    tri[k] = tri[k] == a ? b : tri[k];
+                mesh_triangle_normal(after, p + tri[0] * 3, p + tri[1] * 3, p + tri[2] * 3);
+                flips |= before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0;
+            }
+            if (flips)
+                continue;
+
+            remap[a] = b;
+            mesh_quadric_add(&quadrics[b], &quadrics[a]);
+            for(int j = offsets[a]; j < offsets[a + 1]; ++j)
+                for(int k = 0; k < 3; ++k)
+                    touched[dst[adjacency[j] * 3 + k]] = 1;
+
+            removed += shared * 3;
+            collapses++;
+            result_sq = best_cost[a] > result_sq ? best_cost[a] : result_sq;
+        }
+        if (collapses == 0)
+            break;
+
+        // Apply the pass and drop what became degenerate
+        int out = 0;
+        for(int t = 0; t < count / 3; ++t) {
+            for(int k = 0; k < 3; ++k)
+                tri[k] = remap[dst[t * 3 + k]];
+            if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+                continue;
+            memcpy(dst + out, tri, sizeof(tri));
+            out += 3;
+        }
+        count = out;
+    }
+
+    reset_to_mark_temp(mark);
+    *result_error = mesh_sqrt(result_sq);
+    return count;
+}
+
+int mesh_select_lod(const float *errors, int lod_count, float distance, float projection_scale, float max_pixel_error) {
+    if (distance <= 0)
+        return 0;
+    int lod = 0;
+    for(int i = 1; i < lod_count; ++i)
+        if (errors[i] * projection_scale / distance <= max_pixel_error)
+            lod = i;
+    return lod;
+}
+
+#if TEST
+static void test_cache_stats();
+static void test_remap();
+static void test_vertex_cache();
+static void test_overdraw();
+static void test_index_ranges();
+static void test_meshlets();
+static void test_simplify();
+
+void test_mesh() {
+    test_cache_stats();
+    test_remap();
+    test_vertex_cache();
+    test_overdraw();
+    test_index_ranges();
+    test_meshlets();
+    test_simplify();
+}
+
+// (n + 1) * (n + 1) vertices, two triangles per quad, in row order or shuffled
+static void test_mesh_grid(u32 *indices, int n, bool shuffle) {
+    int i = 0;
+    for(int y = 0; y < n; ++y) {
+        for(int x = 0; x < n; ++x) {
+            u32 v = y * (n + 1) + x;
+            u32 quad[6] = {v, v + n + 1, v + 1, v + 1, v + n + 1, v + n + 2};
+            memcpy(indices + i, quad, sizeof(quad));
+            i += 6;
+        }
+    }
+    if (!shuffle)
+        return;
+    u32 seed = 12345;
+    u32 tmp[3];
+    for(int t = n * n * 2 - 1; t > 0; --t) {
+        seed = seed * 1664525 + 1013904223;
+        int r = (seed >> 8) % (t + 1);
+        memcpy(tmp, indices + t * 3, sizeof(tmp));
+        memcpy(indices + t * 3, indices + r * 3, sizeof(tmp));
+        memcpy(indices + r * 3, tmp, sizeof(tmp));
+    }
+}
+// Order independent summary of a triangle list (triangles are kept whole, so their winding is hashed too)
+static u64 test_mesh_triangle_sum(const u32 *indices, int index_count) {
+    u64 sum = 0;
+    for(int t = 0; t < index_count / 3; ++t) {
+        u64 tri = ((u64)indices[t * 3] << 42) | ((u64)indices[t * 3 + 1] << 21) | indices[t * 3 + 2];
+        sum += wyhash64(tri, 0x9e3779b97f4a7c15);
+    }
+    return sum;
+}
+
+static void test_cache_stats() {
+    BEGIN_TEST_MODULE("Mesh_Cache_Stats", true, false);
+
+    u32 tri[3] = {0, 1, 2};
+    Mesh_Cache_Stats stats = mesh_analyze_vertex_cache(tri, 3, 3);
+    TEST_FEQ("one triangle acmr", stats.acmr, 3.0f, false);
+    TEST_FEQ("one triangle atvr", stats.atvr, 1.0f, false);
+
+    // a strip of quads shares two vertices per triangle after the first
+    u32 strip[12] = {0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5};
+    stats = mesh_analyze_vertex_cache(strip, 12, 6);
+    TEST_FEQ("strip acmr", stats.acmr, 1.5f, false);
+    TEST_FEQ("strip atvr", stats.atvr, 1.0f, false);
+
+    // with a cache of 3 the fan's hub is pushed out once, by vertex 3
+    u32 fan[12] = {0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5};
+    stats = mesh_analyze_vertex_cache(fan, 12, 6, 3);
+    TEST_FEQ("fan acmr, cache 3", stats.acmr, 1.75f, false);
+
+    // A real primitive, through the steps the renderer takes: the cube is exported with a vertex per index, so
+    // every triangle misses until the vertices are deduplicated on their attributes (32 of the 36 are distinct,
+    // export noise keeps some corners apart)
+    u64 mark = get_mark_temp();
+    Gltf cube = parse_gltf("models/cube-static/Cube.gltf");
+    u64 size;
+    const u8 *buffer = file_read_bin_temp("models/cube-static/Cube.bin", &size);
+    Gltf_Mesh_Primitive *primitive = cube.meshes->primitives;
+
+    Gltf_Accessor *accessor = gltf_accessor_by_index(&cube, primitive->indices);
+    Gltf_Buffer_View *view = gltf_buffer_view_by_index(&cube, accessor->buffer_view);
+    const u8 *src = buffer + view->byte_offset + accessor->byte_offset;
+    int index_count = accessor->count;
+    u32 *indices = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    for(int i = 0; i < index_count; ++i)
+        indices[i] = *(const u16*)(src + (u64)i * accessor->byte_stride);
+
+    int attributes[3] = {primitive->position, primitive->normal, primitive->tex_coord_0};
+    Vertex_Stream streams[3];
+    for(int k = 0; k < 3; ++k) {
+        accessor = gltf_accessor_by_index(&cube, attributes[k]);
+        view = gltf_buffer_view_by_index(&cube, accessor->buffer_view);
+        streams[k] = {buffer + view->byte_offset + accessor->byte_offset, accessor->byte_stride,
+                      accessor->byte_stride, 0};
+    }
+    int vertex_count = accessor->count;
+
+    Mesh_Cache_Stats before = mesh_analyze_vertex_cache(indices, index_count, vertex_count);
+    TEST_FEQ("cube acmr before", before.acmr, 3.0f, false);
+    TEST_FEQ("cube atvr before", before.atvr, 1.0f, false);
+
+    u32 *remap = (u32*)memory_allocate_temp(sizeof(u32) * vertex_count, 4);
+    u32 *optimized = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    vertex_count = mesh_generate_vertex_remap(remap, indices, index_count, vertex_count, 3, streams);
+    TEST_EQ("cube welded", vertex_count, 32, false);
+    mesh_remap_indices(indices, indices, index_count, remap);
+    mesh_optimize_vertex_cache(optimized, indices, index_count, vertex_count);
+
+    Mesh_Cache_Stats after = mesh_analyze_vertex_cache(optimized, index_count, vertex_count);
+    TEST_LT("cube acmr after", after.acmr, before.acmr, false);
+    TEST_FEQ("cube atvr after", after.atvr, 1.0f, false);
+    reset_to_mark_temp(mark);
+
+    END_TEST_MODULE();
+}
+
+static void test_remap() {
+    BEGIN_TEST_MODULE("Mesh_Remap", true, false);
+
+    // 4 x 4 grid with every triangle given its own three vertices
+    const int n = 4;
+    const int index_count = n * n * 6;
+    u32 grid[index_count];
+    test_mesh_grid(grid, n, false);
+
+    float positions[index_count * 3];
+    float uvs[index_count * 2];
+    u32 indices[index_count];
+    for(int i = 0; i < index_count; ++i) {
+        positions[i * 3 + 0] = (float)(grid[i] % (n + 1));
+        positions[i * 3 + 1] = (float)(grid[i] / (n + 1));
+        positions[i * 3 + 2] = 0;
+        uvs[i * 2 + 0] = positions[i * 3] / n;
+        uvs[i * 2 + 1] = positions[i * 3 + 1] / n;
+        indices[i] = i;
+    }
+    Vertex_Stream streams[] = {
+        {(const u8*)positions, 12, 12, 0},
+        {(const u8*)uvs,        8,  8, 0},
+    };
+
+    u32 remap[index_count];
+    int unique = mesh_generate_vertex_remap(remap, indices, index_count, index_count, 2, streams);
+    TEST_EQ("unique vertices", unique, (n + 1) * (n + 1), false);
+
+    mesh_remap_indices(indices, indices, index_count, remap);
+    float remapped[(n + 1) * (n + 1) * 3];
+    mesh_remap_vertices((u8*)remapped, (const u8*)positions, 12, 12, index_count, remap);
+    bool same = true;
+    for(int i = 0; i < index_count; ++i)
+        same &= memcmp(remapped + indices[i] * 3, positions + i * 3, 12) == 0;
+    TEST_EQ("remapped positions", same, true, false);
+
+    // the same position with a different uv is a different vertex
+    uvs[2 * 2 + 1] = 7; // index 2 is grid vertex 1, which four triangles share
+    for(int i = 0; i < index_count; ++i)
+        indices[i] = i;
+    unique = mesh_generate_vertex_remap(remap, indices, index_count, index_count, 2, streams);
+    TEST_EQ("split vertex", unique, (n + 1) * (n + 1) + 1, false);
+
+    // 'grid' only references the first (n + 1) * (n + 1) vertices
+    mesh_generate_vertex_remap(remap, grid, index_count, index_count, 2, streams);
+    TEST_EQ("unused vertices", remap[index_count - 1], Max_u32, false);
+
+    u32 fetch[index_count];
+    int used = mesh_optimize_vertex_fetch_remap(fetch, grid, index_count, index_count);
+    TEST_EQ("used vertices", used, (n + 1) * (n + 1), false);
+    mesh_remap_indices(indices, grid, index_count, fetch);
+    u32 expected = 0;
+    bool in_order = true;
+    for(int i = 0; i < index_count; ++i) {
+        if (indices[i] == expected)
+            expected++;
+        in_order &= indices[i] < expected;
+    }
+    TEST_EQ("first use order", in_order, true, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_vertex_cache() {
+    BEGIN_TEST_MODULE("Mesh_Vertex_Cache", true, false);
+
+    const int n = 32;
+    const int vertex_count = (n + 1) * (n + 1);
+    const int index_count = n * n * 6;
+    u32 *shuffled  = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u32 *optimized = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    test_mesh_grid(shuffled, n, true);
+
+    mesh_optimize_vertex_cache(optimized, shuffled, index_count, vertex_count);
+    TEST_EQ("same triangles", test_mesh_triangle_sum(optimized, index_count),
+            test_mesh_triangle_sum(shuffled, index_count), false);
+
+    Mesh_Cache_Stats before = mesh_analyze_vertex_cache(shuffled,  index_count, vertex_count);
+    Mesh_Cache_Stats after  = mesh_analyze_vertex_cache(optimized, index_count, vertex_count);
+    TEST_LT("acmr improves", after.acmr, before.acmr, false);
+    TEST_LT("acmr near a strip", after.acmr, 0.8f, false);
+    TEST_LT("atvr", after.atvr, 1.6f, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_overdraw() {
+    BEGIN_TEST_MODULE("Mesh_Overdraw", true, false);
+
+    // two grids, one in front (z = 1, facing +z) and one behind (z = -1, facing -z): outward facing
+    // clusters are the ones pointing away from the centre, so either order keeps each grid's clusters whole
+    const int n = 16;
+    const int grid_vertices = (n + 1) * (n + 1);
+    const int grid_indices  = n * n * 6;
+    u32 *indices   = (u32*)memory_allocate_temp(sizeof(u32) * grid_indices * 2, 4);
+    u32 *cached    = (u32*)memory_allocate_temp(sizeof(u32) * grid_indices * 2, 4);
+    u32 *optimized = (u32*)memory_allocate_temp(sizeof(u32) * grid_indices * 2, 4);
+    float *positions = (float*)memory_allocate_temp(sizeof(float) * grid_vertices * 2 * 3, 4);
+
+    test_mesh_grid(indices, n, true);
+    test_mesh_grid(indices + grid_indices, n, true);
+    for(int i = 0; i < grid_indices; ++i) {
+        // flip the back grid's winding so that it faces away from the front one
+        u32 v = indices[grid_indices + i] + grid_vertices;
+        indices[grid_indices + i] = v;
+    }
+    for(int t = 0; t < grid_indices / 3; ++t) {
+        u32 tmp = indices[grid_indices + t * 3 + 1];
+        indices[grid_indices + t * 3 + 1] = indices[grid_indices + t * 3 + 2];
+        indices[grid_indices + t * 3 + 2] = tmp;
+    }
+    for(int v = 0; v < grid_vertices * 2; ++v) {
+        positions[v * 3 + 0] = (float)((v % grid_vertices) % (n + 1));
+        positions[v * 3 + 1] = (float)((v % grid_vertices) / (n + 1));
+        positions[v * 3 + 2] = v < grid_vertices ? 1.0f : -1.0f;
+    }
+
+    mesh_optimize_vertex_cache(cached, indices, grid_indices * 2, grid_vertices * 2);
+    mesh_optimize_overdraw(optimized, cached, grid_indices * 2, (const u8*)positions, 12, grid_vertices * 2, 1.05f);
+    TEST_EQ("same triangles", test_mesh_triangle_sum(optimized, grid_indices * 2),
+            test_mesh_triangle_sum(indices, grid_indices * 2), false);
+
+    Mesh_Cache_Stats before = mesh_analyze_vertex_cache(cached,    grid_indices * 2, grid_vertices * 2);
+    Mesh_Cache_Stats after  = mesh_analyze_vertex_cache(optimized, grid_indices * 2, grid_vertices * 2);
+    TEST_LT("acmr within threshold", after.acmr, before.acmr * 1.05f + 0.0001f, false);
+
+    // a threshold below one can never be met, so the input order is kept
+    mesh_optimize_overdraw(optimized, cached, grid_indices * 2, (const u8*)positions, 12, grid_vertices * 2, 0.5f);
+    TEST_EQ("kept order", memcmp(optimized, cached, sizeof(u32) * grid_indices * 2), 0, false);
+
+    END_TEST_MODULE();
+}
+static void test_index_ranges() {
+    BEGIN_TEST_MODULE("Mesh_Index_Ranges", true, false);
+
+    // a 300 x 300 grid has over 65536 vertices, and its rows (once in order) only reach back one row
+    const int n = 300;
+    const int index_count = n * n * 6;
+    u32 *indices = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u16 *narrow  = (u16*)memory_allocate_temp(sizeof(u16) * index_count, 2);
+    test_mesh_grid(indices, n, false);
+
+    int range_count = mesh_split_index_ranges(NULL, indices, index_count, 65536);
+    Mesh_Index_Range *ranges = (Mesh_Index_Range*)memory_allocate_temp(sizeof(Mesh_Index_Range) * range_count, 4);
+    TEST_EQ("range count", mesh_split_index_ranges(ranges, indices, index_count, 65536), range_count, false);
+    TEST_EQ("more than one range", range_count > 1, true, false);
+
+    bool fits = true;
+    u32 covered = 0;
+    for(int r = 0; r < range_count; ++r) {
+        fits &= ranges[r].first_index == covered;
+        covered += ranges[r].index_count;
+        mesh_narrow_indices_u16(narrow + ranges[r].first_index, indices + ranges[r].first_index,
+                                ranges[r].index_count, ranges[r].vertex_offset);
+        for(u32 i = ranges[r].first_index; i < ranges[r].first_index + ranges[r].index_count; ++i)
+            fits &= (u32)narrow[i] + ranges[r].vertex_offset == indices[i];
+    }
+    TEST_EQ("ranges cover the list", covered, (u32)index_count, false);
+    TEST_EQ("narrowed indices", fits, true, false);
+
+    // a small list is one range from zero
+    u32 tri[6] = {0, 1, 2, 2, 1, 3};
+    TEST_EQ("one range", mesh_split_index_ranges(ranges, tri, 6, 65536), 1, false);
+    TEST_EQ("one range offset", ranges[0].vertex_offset, 0u, false);
+    TEST_EQ("one range count", ranges[0].index_count, 6u, false);
+
+    // odd lengths go through the scalar tail
+    u32 odd[19];
+    u16 odd_narrow[19];
+    for(int i = 0; i < 19; ++i)
+        odd[i] = 70000 + i * 3;
+    mesh_narrow_indices_u16(odd_narrow, odd, 19, 70000);
+    bool same = true;
+    for(int i = 0; i < 19; ++i)
+        same &= odd_narrow[i] == i * 3;
+    TEST_EQ("narrow tail", same, true, false);
+
+    END_TEST_MODULE();
+}
+static void test_meshlets() {
+    BEGIN_TEST_MODULE("Mesh_Meshlets", true, false);
+
+    // A flat grid in z = 0, its triangles wound to face +z, in cache order
+    const int n = 32;
+    const int vertex_count = (n + 1) * (n + 1);
+    const int index_count = n * n * 6;
+    u32 *grid    = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u32 *indices = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    float *positions = (float*)memory_allocate_temp(sizeof(float) * 3 * vertex_count, 4);
+    test_mesh_grid(grid, n, true);
+    mesh_optimize_vertex_cache(indices, grid, index_count, vertex_count);
+    for(int v = 0; v < vertex_count; ++v) {
+        positions[v * 3 + 0] = (float)(v % (n + 1));
+        positions[v * 3 + 1] = -(float)(v / (n + 1)); // rows go down, so the grid's winding faces +z
+        positions[v * 3 + 2] = 0;
+    }
+
+    int bound = mesh_build_meshlets_bound(index_count, MESH_MESHLET_MAX_VERTICES, MESH_MESHLET_MAX_TRIANGLES);
+    Mesh_Meshlet *meshlets = (Mesh_Meshlet*)memory_allocate_temp(sizeof(Mesh_Meshlet) * bound, 4);
+    u32 *vertices = (u32*)memory_allocate_temp(sizeof(u32) * bound * MESH_MESHLET_MAX_VERTICES, 4);
+    u8 *triangles = (u8*)memory_allocate_temp(bound * MESH_MESHLET_MAX_TRIANGLES * 3, 1);
+    int meshlet_count = mesh_build_meshlets(meshlets, vertices, triangles, indices, index_count, vertex_count);
+    TEST_LT("within bound", meshlet_count, bound + 1, false);
+
+    // Limits respected, and every triangle comes back out in order
+    bool limits = true;
+    bool same = true;
+    u32 t = 0;
+    for(int m = 0; m < meshlet_count; ++m) {
+        limits &= meshlets[m].vertex_count   <= MESH_MESHLET_MAX_VERTICES;
+        limits &= meshlets[m].triangle_count <= MESH_MESHLET_MAX_TRIANGLES;
+        for(u32 i = 0; i < meshlets[m].triangle_count * 3; ++i) {
+            same &= vertices[meshlets[m].vertex_offset + triangles[meshlets[m].triangle_offset + i]] == indices[t];
+            t++;
+        }
+    }
+    TEST_EQ("meshlet limits", limits, true, false);
+    TEST_EQ("meshlet triangles", same, true, false);
+    TEST_EQ("meshlet triangle count", t, (u32)index_count, false);
+
+    // Every vertex is inside its sphere; the cone of a flat patch points straight out of it
+    bool inside = true;
+    bool facing = true;
+    Mesh_Meshlet_Bounds bounds;
+    for(int m = 0; m < meshlet_count; ++m) {
+        bounds = mesh_compute_meshlet_bounds(&meshlets[m], vertices, triangles, (const u8*)positions, 12);
+        for(u32 i = 0; i < meshlets[m].vertex_count; ++i)
+            inside &= mesh_sqrt(mesh_distance_squared(positions + vertices[meshlets[m].vertex_offset + i] * 3,
+                                bounds.center)) <= bounds.radius * 1.0001f;
+        facing &= bounds.cone_axis[2] > 0.9999f && bounds.cone_cutoff < 0.0001f;
+    }
+    TEST_EQ("sphere contains vertices", inside, true, false);
+    TEST_EQ("flat cone", facing, true, false);
+
+    // From behind the grid every meshlet is backfacing, from in front none are
+    bounds = mesh_compute_meshlet_bounds(&meshlets[0], vertices, triangles, (const u8*)positions, 12);
+    float behind[3]   = {bounds.center[0], bounds.center[1], -100};
+    float in_front[3] = {bounds.center[0], bounds.center[1],  100};
+    TEST_EQ("cone culled behind", mesh_cull_meshlet_cone(&bounds, behind), true, false);
+    TEST_EQ("cone kept in front", mesh_cull_meshlet_cone(&bounds, in_front), false, false);
+
+    // A patch bent at a right angle (faces along +z and +y) has a 45 degree cone
+    float bent_positions[] = {0, 0, 0,  1, 0, 0,  0, 1, 0,  0, 0, 1};
+    u32 bent_vertices[] = {0, 1, 2, 3};
+    u8 bent_triangles[] = {0, 1, 2,  0, 3, 1};
+    Mesh_Meshlet bent = {0, 0, 4, 2};
+    bounds = mesh_compute_meshlet_bounds(&bent, bent_vertices, bent_triangles, (const u8*)bent_positions, 12);
+    TEST_FEQ("bent cone cutoff", bounds.cone_cutoff, mesh_sqrt(0.5f), false);
+    float front_corner[3] = { 10,  10,  10};
+    float back_corner[3]  = {-10, -10, -10};
+    float side[3] = {0, 10, -10}; // sees the +y face
+    TEST_EQ("bent cone kept in front", mesh_cull_meshlet_cone(&bounds, front_corner), false, false);
+    TEST_EQ("bent cone culled behind", mesh_cull_meshlet_cone(&bounds, back_corner), true, false);
+    TEST_EQ("bent cone kept at side", mesh_cull_meshlet_cone(&bounds, side), false, false);
+
+    // Planes facing in on the unit cube
+    float planes[] = {
+         1, 0, 0, 1,  -1, 0, 0, 1,
+         0, 1, 0, 1,   0,-1, 0, 1,
+         0, 0, 1, 1,   0, 0,-1, 1,
+    };
+    float in[3] = {0, 0, 0};
+    float touching[3] = {1.5f, 0, 0};
+    float out[3] = {3, 0, 0};
+    TEST_EQ("sphere inside", mesh_cull_sphere(in, 1, 6, planes), false, false);
+    TEST_EQ("sphere touching", mesh_cull_sphere(touching, 1, 6, planes), false, false);
+    TEST_EQ("sphere outside", mesh_cull_sphere(out, 1, 6, planes), true, false);
+
+    END_TEST_MODULE();
+}
+static void test_simplify() {
+    BEGIN_TEST_MODULE("Mesh_Simplify", true, false);
+
+    // A flat grid can lose everything but its (locked) border without any error
+    const int n = 16;
+    const int vertex_count = (n + 1) * (n + 1);
+    const int index_count = n * n * 6;
+    u32 indices[index_count];
+    u32 simplified[index_count];
+    float positions[vertex_count * 3];
+    test_mesh_grid(indices, n, false);
+    for(int v = 0; v < vertex_count; ++v) {
+        positions[v * 3 + 0] = (float)(v % (n + 1));
+        positions[v * 3 + 1] = -(float)(v / (n + 1));
+        positions[v * 3 + 2] = 0;
+    }
+    TEST_FEQ("extent", mesh_get_extent((const u8*)positions, 12, vertex_count), (float)n, false);
+
+    float error;
+    int count = mesh_simplify(simplified, indices, index_count, (const u8*)positions, 12, vertex_count, 0, 0.01f, &error);
+    TEST_LT("flat grid collapses", count, index_count / 4, false);
+    TEST_LT("flat grid error", error, 0.0001f, false);
+
+    // Nothing flipped, and the border (every vertex on it) is still there
+    bool facing = true;
+    float normal[3];
+    for(int t = 0; t < count / 3; ++t) {
+        mesh_triangle_normal(normal, positions + simplified[t * 3] * 3, positions + simplified[t * 3 + 1] * 3,
+                             positions + simplified[t * 3 + 2] * 3);
+        facing &= normal[2] > 0;
+    }
+    TEST_EQ("no flips", facing, true, false);
+    bool border[vertex_count] = {};
+    for(int i = 0; i < count; ++i)
+        border[simplified[i]] = true;
+    bool kept = true;
+    for(int i = 0; i <= n; ++i)
+        kept &= border[i] && border[n * (n + 1) + i] && border[i * (n + 1)] && border[i * (n + 1) + n];
+    TEST_EQ("border kept", kept, true, false);
+
+    // A curved grid: a tight error bound stops early, a loose one reaches the target and stays within it
+    for(int v = 0; v < vertex_count; ++v) {
+        float x = positions[v * 3] - n / 2;
+        float y = positions[v * 3 + 1] + n / 2;
+        positions[v * 3 + 2] = (x * x + y * y) * 0.05f;
+    }
+    int tight = mesh_simplify(simplified, indices, index_count, (const u8*)positions, 12, vertex_count,
+                              index_count / 4, 0.00001f, &error);
+    TEST_LT("tight error", error, 0.00001f + 0.0000001f, false);
+    int loose = mesh_simplify(simplified, indices, index_count, (const u8*)positions, 12, vertex_count,
+                              index_count / 4, 0.1f, &error);
+    TEST_LT("loose reduces more", loose, tight, false);
+    TEST_LT("loose reaches target", loose, index_count / 4 + 1, false);
+    TEST_LT("loose error", error, 0.1f, false);
+
+    // 'dst' may be the input
+    memcpy(simplified, indices, sizeof(indices));
+    TEST_EQ("in place", mesh_simplify(simplified, simplified, index_count, (const u8*)positions, 12, vertex_count,
+                                      index_count / 4, 0.1f, &error), loose, false);
+
+    // Level errors 0, 0.01, 0.05 and 0.2 units at 1000 pixels per unit
+    float errors[] = {0, 0.01f, 0.05f, 0.2f};
+    TEST_EQ("lod near",    mesh_select_lod(errors, 4,    1, 1000, 1), 0, false);
+    TEST_EQ("lod middle",  mesh_select_lod(errors, 4,   20, 1000, 1), 1, false);
+    TEST_EQ("lod far",     mesh_select_lod(errors, 4, 1000, 1000, 1), 3, false);
+    TEST_EQ("lod at zero", mesh_select_lod(errors, 4,    0, 1000, 1), 0, false);
+
+    END_TEST_MODULE();
+}
+#endif
@@ -0,0 +1,129 @@
+#ifndef SOL_MESH_HPP_INCLUDE_GUARD_
+#define SOL_MESH_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "vertex.hpp"
+
+//
+// CPU side mesh optimization. Everything works on triangle lists of u32 indices; vertex data is described by
+// Vertex_Streams ('offset' unused) so that it can be read straight out of a gltf buffer or an encoded copy.
+// Scratch memory comes from temp and is released before returning.
+//
+// The usual order is: remap (dedup) -> vertex cache -> overdraw -> fetch remap.
+//
+
+// Post transform cache statistics for a simulated FIFO cache of 'cache_size' vertices
+struct Mesh_Cache_Stats {
+    float acmr; // transformed vertices per triangle: 3 is the worst, 0.5 the best a regular grid can do
+    float atvr; // transformed vertices per vertex: 1 is the best
+};
+static constexpr int MESH_ANALYZE_CACHE_SIZE = 16;
+
+Mesh_Cache_Stats mesh_analyze_vertex_cache(const u32 *indices, int index_count, int vertex_count,
+                                           int cache_size = MESH_ANALYZE_CACHE_SIZE);
+
+// Find vertices whose attributes are bytewise identical. 'remap' gets the new index of every vertex, ~0 for
+// vertices that no triangle uses; new indices are given in order of first use. Returns the new vertex count.
+int mesh_generate_vertex_remap(u32 *remap, const u32 *indices, int index_count, int vertex_count,
+                               int stream_count, const Vertex_Stream *streams);
+
+// Apply a remap to indices ('dst' may be 'indices') and to one vertex stream ('dst' is tightly packed, 'size'
+// bytes per vertex, and must not be 'src')
+void mesh_remap_indices(u32 *dst, const u32 *indices, int index_count, const u32 *remap);
+void mesh_remap_vertices(u8 *dst, const u8 *src, int src_stride, int size, int vertex_count, const u32 *remap);
+
+// Reorder triangles for the post transform cache (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+// 'dst' must not be 'indices'.
+void mesh_optimize_vertex_cache(u32 *dst, const u32 *indices, int index_count, int vertex_count);
+
+// Reorder clusters of cache optimized triangles so that outward facing ones are drawn first, unless that
+// would take the ACMR above 'threshold' times its current value (1.05 is a good start). 'positions' are
+// float vec3. 'dst' must not be 'indices'.
+void mesh_optimize_overdraw(u32 *dst, const u32 *indices, int index_count, const u8 *positions,
+                            int position_stride, int vertex_count, float threshold);
+
+// Order vertices by first use so that fetches walk memory forwards. Fills 'remap' like
+// mesh_generate_vertex_remap() and returns the number of used vertices.
+int mesh_optimize_vertex_fetch_remap(u32 *remap, const u32 *indices, int index_count, int vertex_count);
+
+// A run of a triangle list which can be drawn with 16 bit indices: 'index_count' indices from 'first_index',
+// each stored relative to 'vertex_offset' (vkCmdDrawIndexed's vertexOffset)
+struct Mesh_Index_Range {
+    u32 first_index;
+    u32 index_count;
+    u32 vertex_offset;
+};
+
+// Cut a triangle list into runs whose indices all lie in [smallest, smallest + max_vertices). Runs end where the
+// next triangle would not fit, so the count depends on how local the indices are (see fetch remap above).
+// Pass NULL 'ranges' to only count them. Returns the range count.
+int mesh_split_index_ranges(Mesh_Index_Range *ranges, const u32 *indices, int index_count, u32 max_vertices);
+
+// Narrow u32 indices to u16 relative to 'base'; every index must be in [base, base + 65536)
+void mesh_narrow_indices_u16(u16 *dst, const u32 *indices, int count, u32 base);
+
+// Meshlets: small clusters of a triangle list for finer grained culling. Each meshlet lists the primitive's
+// vertices it uses ('vertex_count' u32 from 'vertex_offset' in the vertex array) and its triangles as u8 indices
+// into that list ('triangle_count' * 3 u8 from 'triangle_offset' in the triangle array).
+static constexpr int MESH_MESHLET_MAX_VERTICES  = 64;
+static constexpr int MESH_MESHLET_MAX_TRIANGLES = 124;
+
+struct Mesh_Meshlet {
+    u32 vertex_offset;
+    u32 triangle_offset;
+    u32 vertex_count;
+    u32 triangle_count;
+};
+// Bounding sphere and normal cone. The cone is as wide as the spread of the meshlet's face normals; a cutoff
+// of 1 means the normals are too spread out for the meshlet to ever be entirely backfacing.
+struct Mesh_Meshlet_Bounds {
+    float center[3];
+    float radius;
+    float cone_axis[3];
+    float cone_cutoff; // sin of the spread, see mesh_cull_meshlet_cone()
+};
+
+// Upper bound on the meshlet count, for sizing: meshlets <= this, vertices <= this * max_vertices and
+// triangle bytes <= this * max_triangles * 3.
+int mesh_build_meshlets_bound(int index_count, int max_vertices, int max_triangles);
+
+// Greedily walk the triangles in order (so a cache optimized list gives compact meshlets), starting a new
+// meshlet whenever the next triangle would not fit. Returns the meshlet count; 'vertices' and 'triangles'
+// are filled up to the last meshlet's offsets plus its counts.
+int mesh_build_meshlets(Mesh_Meshlet *meshlets, u32 *vertices, u8 *triangles, const u32 *indices, int index_count,
+                        int vertex_count, int max_vertices = MESH_MESHLET_MAX_VERTICES,
+                        int max_triangles = MESH_MESHLET_MAX_TRIANGLES);
+
+// 'positions' are float vec3
+Mesh_Meshlet_Bounds mesh_compute_meshlet_bounds(const Mesh_Meshlet *meshlet, const u32 *vertices, const u8 *triangles,
+                                                const u8 *positions, int position_stride);
+
+// True if every triangle of the meshlet faces away from 'camera_position' (counter clockwise front faces)
+bool mesh_cull_meshlet_cone(const Mesh_Meshlet_Bounds *bounds, const float *camera_position);
+
+// True if the sphere is entirely behind any of the planes. Planes are (nx, ny, nz, d) with the inside where
+// 'dot(n, p) + d >= 0'.
+bool mesh_cull_sphere(const float *center, float radius, int plane_count, const float *planes);
+
+// Largest dimension of the bounding box of float vec3 'positions'; simplification errors are relative to this
+float mesh_get_extent(const u8 *positions, int position_stride, int vertex_count);
+
+// Collapse edges in order of quadric error (Garland and Heckbert) until the list is down to 'target_index_count'
+// or the next collapse would move the surface further than 'target_error' (relative to mesh_get_extent()).
+// Collapses are onto an endpoint, so the result indexes the same vertices. Vertices on open edges, which
+// includes attribute seams, are never moved. '*result_error' gets the largest error (relative) of any collapse
+// made. Returns the new index count. 'dst' may be 'indices'.
+int mesh_simplify(u32 *dst, const u32 *indices, int index_count, const u8 *positions, int position_stride,
+                  int vertex_count, int target_index_count, float target_error, float *result_error);
+
+// Pick the coarsest level whose object space error, projected at 'distance', is at most 'max_pixel_error'.
+// 'errors' are per level and increasing (level 0 is the full mesh, error 0). 'projection_scale' is pixels per
+// unit at distance one: viewport height / (2 * tan(vertical fov / 2)). Scaled objects divide 'distance' by
+// their scale.
+int mesh_select_lod(const float *errors, int lod_count, float distance, float projection_scale, float max_pixel_error);
+
+#if TEST
+void test_mesh();
+#endif
+
+#endif // include guard
@@ -1,6 +1,10 @@
 #include "renderer.hpp"
 #include "gpu.hpp"
 #include "file.hpp"
+#include "image.hpp"
+#include "array.hpp"
+#include "external/wyhash.h"
+#include <math.h>
 
 int renderer_get_byte_stride(Gltf_Accessor_Format);
 
@@ -43,6 +47,534 @@ enum Buffer_Type {
     BT_UNIFORM = 3,
     BT_IMAGE   = 4,
 };
+// Levels of detail stop at this error (relative to the primitive's extent), or when a level would not fit in
+// the index allocation, which is sized for this many times the full primitive (ideally the levels halve,
+// summing to just under two).
+static constexpr float RENDERER_LOD_MAX_ERROR      = 0.05f;
+static constexpr int   RENDERER_LOD_INDEX_CAPACITY = 2;
+
+// Attributes: 0 indices, 1 position, 2 normal, 3 tangent, 4 tex_coord_0
+static Renderer_Vertex_Encoding renderer_choose_vertex_encoding(int attribute, Gltf_Accessor *accessor, bool quantize) {
+    if (attribute == 0)
+        return RENDERER_VERTEX_ENCODING_NONE;
+
+    // Accessor formats are the UINT vulkan formats, so normalized data would not be read as normalized
+    if (accessor->normalized) {
+        switch(accessor->format) {
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U8:
+        case GLTF_ACCESSOR_FORMAT_VEC2_U8:
+        case GLTF_ACCESSOR_FORMAT_VEC3_U8:
+        case GLTF_ACCESSOR_FORMAT_VEC4_U8:
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U16:
+        case GLTF_ACCESSOR_FORMAT_VEC2_U16:
+        case GLTF_ACCESSOR_FORMAT_VEC3_U16:
+        case GLTF_ACCESSOR_FORMAT_VEC4_U16:
+            return RENDERER_VERTEX_ENCODING_UNORM_FLOAT32;
+        default:
+            break;
+        }
+    }
+    if (!quantize)
+        return RENDERER_VERTEX_ENCODING_NONE;
+
+    if (attribute == 1 && accessor->format == GLTF_ACCESSOR_FORMAT_VEC3_FLOAT32)
+        return RENDERER_VERTEX_ENCODING_SNORM16;
+    if (attribute == 2 && accessor->format == GLTF_ACCESSOR_FORMAT_VEC3_FLOAT32)
+        return RENDERER_VERTEX_ENCODING_OCTAHEDRAL;
+    if (attribute == 3 && accessor->format == GLTF_ACCESSOR_FORMAT_VEC4_FLOAT32)
+        return RENDERER_VERTEX_ENCODING_FLOAT16;
+    if (attribute == 4 && accessor->format == GLTF_ACCESSOR_FORMAT_VEC2_FLOAT32)
+        return RENDERER_VERTEX_ENCODING_FLOAT16;
+
+    return RENDERER_VERTEX_ENCODING_NONE;
+}
+// u8 indices cannot be bound without an extension, so they are always widened. u32 indices are narrowed when
+// the primitive's vertices are in reach of u16, or once it is split into ranges that are.
+static Renderer_Vertex_Encoding renderer_choose_index_encoding(Gltf_Accessor *indices, int vertex_count, bool split) {
+    if (indices->format == GLTF_ACCESSOR_FORMAT_SCALAR_U8)
+        return RENDERER_VERTEX_ENCODING_INDEX_U16;
+    if (indices->format == GLTF_ACCESSOR_FORMAT_SCALAR_U32 && (vertex_count <= 65536 || split))
+        return RENDERER_VERTEX_ENCODING_INDEX_U16;
+    return RENDERER_VERTEX_ENCODING_NONE;
+}
+static int renderer_get_component_count(Gltf_Accessor_Format format) {
+    switch(format) {
+    case GLTF_ACCESSOR_FORMAT_SCALAR_U8:
+    case GLTF_ACCESSOR_FORMAT_SCALAR_U16:
+    case GLTF_ACCESSOR_FORMAT_SCALAR_FLOAT32:
+        return 1;
+    case GLTF_ACCESSOR_FORMAT_VEC2_U8:
+    case GLTF_ACCESSOR_FORMAT_VEC2_U16:
+    case GLTF_ACCESSOR_FORMAT_VEC2_FLOAT32:
+        return 2;
+    case GLTF_ACCESSOR_FORMAT_VEC3_U8:
+    case GLTF_ACCESSOR_FORMAT_VEC3_U16:
+    case GLTF_ACCESSOR_FORMAT_VEC3_FLOAT32:
+        return 3;
+    case GLTF_ACCESSOR_FORMAT_VEC4_U8:
+    case GLTF_ACCESSOR_FORMAT_VEC4_U16:
+    case GLTF_ACCESSOR_FORMAT_VEC4_FLOAT32:
+        return 4;
+    default:
+        ASSERT(false, "Unsupported vertex encoding format");
+        return 0;
+    }
+}
+// Format and (tightly packed) element size of an accessor once it is encoded
+static VkFormat renderer_get_encoded_format(Renderer_Vertex_Encoding encoding, Gltf_Accessor_Format format, int *size) {
+    int components;
+    switch(encoding) {
+    case RENDERER_VERTEX_ENCODING_UNORM_FLOAT32:
+    {
+        components = renderer_get_component_count(format);
+        VkFormat float_formats[] = {
+            VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT,
+        };
+        *size = components * 4;
+        return float_formats[components - 1];
+    }
+    case RENDERER_VERTEX_ENCODING_FLOAT16:
+        components = renderer_get_component_count(format);
+        *size = components * 2;
+        return components == 2 ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+    case RENDERER_VERTEX_ENCODING_OCTAHEDRAL:
+        *size = 4;
+        return VK_FORMAT_R16G16_SNORM;
+    case RENDERER_VERTEX_ENCODING_SNORM16:
+        *size = 8;
+        return VK_FORMAT_R16G16B16A16_SNORM;
+    case RENDERER_VERTEX_ENCODING_INDEX_U16:
+        *size = 2;
+        return VK_FORMAT_R16_UINT;
+    default:
+        *size = renderer_get_byte_stride(format);
+        return (VkFormat)format;
+    }
+}
+
+// Write 'accessor->count' encoded elements to 'dst', read from 'src' every 'src_stride' bytes
+static void renderer_encode_accessor(Gltf_Accessor *accessor, Renderer_Vertex_Encoding encoding,
+                                     const u8 *src, int src_stride, void *dst, Vertex_Dequantize *dequantize)
+{
+    int components;
+    switch(encoding) {
+    case RENDERER_VERTEX_ENCODING_UNORM_FLOAT32:
+        components = renderer_get_component_count(accessor->format);
+        if (renderer_get_byte_stride(accessor->format) == components)
+            vertex_unorm8_to_f32((float*)dst, src, src_stride, accessor->count, components);
+        else
+            vertex_unorm16_to_f32((float*)dst, src, src_stride, accessor->count, components);
+        break;
+    case RENDERER_VERTEX_ENCODING_FLOAT16:
+        components = renderer_get_component_count(accessor->format);
+        vertex_f32_to_f16((u16*)dst, src, src_stride, accessor->count, components);
+        break;
+    case RENDERER_VERTEX_ENCODING_OCTAHEDRAL:
+        vertex_encode_octahedral_snorm16((u32*)dst, src, src_stride, accessor->count);
+        break;
+    case RENDERER_VERTEX_ENCODING_SNORM16:
+        *dequantize = vertex_quantize_positions_snorm16((s16*)dst, src, src_stride, accessor->count,
+                                                        accessor->min, accessor->max);
+        break;
+    case RENDERER_VERTEX_ENCODING_INDEX_U16:
+        // Index buffer views cannot be strided
+        ASSERT(src_stride == renderer_get_byte_stride(accessor->format), "Strided indices");
+        if (accessor->format == GLTF_ACCESSOR_FORMAT_SCALAR_U8) {
+            for(int i = 0; i < accessor->count; ++i)
+                ((u16*)dst)[i] = src[i];
+        } else {
+            mesh_narrow_indices_u16((u16*)dst, (const u32*)src, accessor->count, 0);
+        }
+        break;
+    default:
+        ASSERT(false, "Not an encoding");
+        break;
+    }
+}
+
+// Mesh optimization works on u32 indices whatever the accessor's component type
+static void renderer_read_indices(u32 *dst, const u8 *src, int src_stride, int count, Gltf_Accessor_Format format) {
+    for(int i = 0; i < count; ++i) {
+        switch(format) {
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U8:
+            dst[i] = src[(u64)i * src_stride];
+            break;
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U16:
+            dst[i] = *(const u16*)(src + (u64)i * src_stride);
+            break;
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U32:
+            dst[i] = *(const u32*)(src + (u64)i * src_stride);
+            break;
+        default:
+            ASSERT(false, "Invalid index format");
+            break;
+        }
+    }
+}
+static void renderer_write_indices(void *dst, const u32 *src, int count, Gltf_Accessor_Format format) {
+    for(int i = 0; i < count; ++i) {
+        switch(format) {
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U16:
+            ((u16*)dst)[i] = (u16)src[i];
+            break;
+        case GLTF_ACCESSOR_FORMAT_SCALAR_U32:
+            ((u32*)dst)[i] = src[i];
+            break;
+        default:
+            ASSERT(false, "Invalid index format");
+            break;
+        }
+    }
+}
+
+// `Residency
+Renderer_Residency_Table renderer_create_residency_table(int capacity) {
+    ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0, "Residency table capacity must be a power of two");
+    Renderer_Residency_Table ret;
+    ret.capacity = capacity;
+    ret.count    = 0;
+    ret.entries  = (Renderer_Residency_Entry*)memory_allocate_heap(sizeof(Renderer_Residency_Entry) * capacity, 8);
+    memset(ret.entries, 0, sizeof(Renderer_Residency_Entry) * capacity);
+    return ret;
+}
+void renderer_destroy_residency_table(Renderer_Residency_Table *table) {
+    memory_free_heap(table->entries);
+    *table = {};
+}
+
+// Linear probing. Released entries keep their slot, so that probes walk past them, until an insert reuses it.
+Renderer_Residency_Entry* renderer_find_resident(Renderer_Residency_Table *table, u64 key) {
+    u32 mask = table->capacity - 1;
+    Renderer_Residency_Entry *entry;
+    for(u32 i = key & mask; ; i = (i + 1) & mask) {
+        entry = &table->entries[i];
+        if (entry->size == 0)
+            return NULL;
+        if (entry->ref_count > 0 && entry->key == key)
+            return entry;
+    }
+}
+
+static Renderer_Residency_Entry* renderer_get_resident_slot(Renderer_Residency_Table *table, u64 key) {
+    u32 mask = table->capacity - 1;
+    for(u32 i = key & mask; ; i = (i + 1) & mask)
+        if (table->entries[i].size == 0 || table->entries[i].ref_count == 0)
+            return &table->entries[i];
+}
+
+// Takes the first reference. The key must not be resident already.
+static void renderer_insert_resident(Renderer_Residency_Table *table, u64 key, u64 size, u64 offset, int block,
+                                     u32 destination, u32 handle)
+{
+    // Grow at half full (released slots count), so that probes stay short and always reach an empty slot
+    Renderer_Residency_Entry *entry;
+    if ((table->count + 1) * 2 > table->capacity) {
+        Renderer_Residency_Table old = *table;
+        *table = renderer_create_residency_table(old.capacity * 2);
+        for(int i = 0; i < old.capacity; ++i) {
+            if (old.entries[i].ref_count == 0)
+                continue;
+            entry = renderer_get_resident_slot(table, old.entries[i].key);
+            *entry = old.entries[i];
+            table->count++;
+        }
+        memory_free_heap(old.entries);
+    }
+
+    entry = renderer_get_resident_slot(table, key);
+    if (entry->size == 0)
+        table->count++;
+    *entry = {key, size, offset, block, 1, destination, handle};
+}
+
+int renderer_release_resident(Renderer_Residency_Table *table, Renderer_Draws *draws,
+                              Gpu_Memory_Allocator *device_memory)
+{
+    int ret = 0;
+    Renderer_Residency_Entry *entry;
+    Gpu_Memory_Allocation allocation;
+    for(int i = 0; i < draws->resident_count; ++i) {
+        entry = renderer_find_resident(table, draws->resident_keys[i]);
+        ASSERT(entry, "Released a copy which is not resident");
+        if (!entry)
+            continue;
+        entry->ref_count--;
+        if (entry->ref_count > 0)
+            continue;
+        ret++;
+        if (device_memory) {
+            allocation = {};
+            allocation.block  = entry->block;
+            allocation.handle = entry->handle;
+            gpu_free_memory(device_memory, &allocation);
+        }
+    }
+    draws->resident_count = 0;
+    return ret;
+}
+
+// `Device memory
+Gpu_Memory_Allocator renderer_create_vertex_memory(u64 block_size, int block_allocation_cap) {
+    Gpu *gpu = get_gpu_instance();
+    return gpu_create_memory_allocator(
+        gpu->memory_resources.device_memory_type, gpu->memory_resources.flags & GPU_MEM_UMA_BIT, block_size,
+        gpu->info.properties.limits.bufferImageGranularity, block_allocation_cap,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+}
+
+void renderer_apply_defrag_moves(int draw_count, Renderer_Draws *draws, Renderer_Residency_Table *residency,
+                                 Gpu_Memory_Allocator *device_memory, int move_count, Gpu_Defrag_Move *moves)
+{
+    if (move_count == 0)
+        return;
+
+    Renderer_Draw_Info_Static *draw_info;
+    for(int i = 0; i < draw_count; ++i) {
+        for(int j = 0; j < draws[i].allocation_count; ++j)
+            gpu_apply_defrag_move(device_memory, &draws[i].allocations[j], move_count, moves);
+
+        for(int j = 0; j < draws[i].mesh_count; ++j)
+            for(int k = 0; k < draws[i].meshes[j].primitive_count; ++k) {
+                draw_info = &draws[i].meshes[j].primitive_draw_infos[k];
+                suballocator_apply_move(&draw_info->index_buffer_block, &draw_info->index_buffer_offset, NULL,
+                                        move_count, moves);
+                for(int l = 0; l < draw_info->vertex_buffer_count; ++l)
+                    suballocator_apply_move(&draw_info->vertex_buffer_blocks[l],
+                                            &draw_info->vertex_buffer_offsets[l], NULL, move_count, moves);
+                // Without a position stream this patches an unused offset, which does no harm
+                suballocator_apply_move(&draw_info->position_buffer_block, &draw_info->position_buffer_offset,
+                                        NULL, move_count, moves);
+            }
+    }
+
+    if (!residency)
+        return;
+    Renderer_Residency_Entry *entry;
+    for(int i = 0; i < residency->capacity; ++i) {
+        entry = &residency->entries[i];
+        if (entry->ref_count > 0)
+            suballocator_apply_move(&entry->block, &entry->offset, &entry->handle, move_count, moves);
+    }
+}
+
+// `Buffer views
+enum Renderer_View_Destination {
+    RENDERER_VIEW_DESTINATION_NONE   = 0,
+    RENDERER_VIEW_DESTINATION_INDEX  = 1,
+    RENDERER_VIEW_DESTINATION_VERTEX = 2,
+};
+// A draw offset which is relative to a view until the view is allocated
+struct Renderer_View_Fixup {
+    u64 *draw_offset;
+    int *draw_block;
+    int view;
+};
+// Neighbouring views (in the gltf buffer, going to the same allocator) closer than this share one copy; the
+// gap between them is copied along with them.
+static constexpr u64 RENDERER_VIEW_COALESCE_GAP = 256;
+// Device memory allocations start aligned like the view copies, so that views keep their alignment
+static constexpr u64 RENDERER_DEVICE_ALIGNMENT = 16;
+
+// Reserve index or vertex data and return where to write it. Without device memory, that is the host allocator,
+// at the block and offset the draws use. With it, the draws use an allocation of its own there, which is either
+// written in place (host visible) or staged in the host allocator and copied across (see Renderer_Device_Copy).
+// With 'resident_handle', the allocation belongs to a residency entry rather than the model.
+static void* renderer_allocate_vertex_data(Renderer_Gpu_Allocator_Group *allocators,
+                                           Renderer_Vertex_Attribute_Resources *list, u32 destination, u64 size,
+                                           u64 *offset, int *block, u32 *resident_handle = NULL)
+{
+    Gpu_Buf_Allocator *allocator = destination == RENDERER_VIEW_DESTINATION_INDEX ?
+                                       allocators->index_allocator : allocators->vertex_allocator;
+    void *ret;
+    if (!allocators->device_memory) {
+        ret = gpu_make_buf_allocation(allocator, size, offset);
+        *block = allocator->block;
+        return ret;
+    }
+
+    Gpu_Memory_Allocator *memory = allocators->device_memory;
+    VkMemoryRequirements requirements = {size, RENDERER_DEVICE_ALIGNMENT, 1u << memory->memory_type_index};
+    Gpu_Memory_Allocation allocation;
+    bool allocated = gpu_allocate_memory(get_gpu_instance()->vk_device, memory, &requirements,
+                                         SUBALLOCATION_KIND_LINEAR, &allocation);
+    ASSERT(allocated, "Out of device memory for index and vertex data");
+    *offset = allocation.offset;
+    *block  = allocation.block;
+    if (resident_handle) {
+        *resident_handle = allocation.handle;
+    } else {
+        list->device_allocations[list->device_allocation_count] = allocation;
+        list->device_allocation_count++;
+    }
+    if (allocation.ptr)
+        return allocation.ptr;
+
+    Renderer_Device_Copy *copy = &list->device_copies[list->device_copy_count];
+    list->device_copy_count++;
+    copy->destination   = destination;
+    copy->device_block  = allocation.block;
+    copy->device_offset = allocation.offset;
+    copy->size          = size;
+    ret = gpu_make_buf_allocation(allocator, size, &copy->host_offset);
+    copy->host_block = allocator->block;
+    return ret;
+}
+
+struct Renderer_View_Key {
+    u64 key; // destination in the top byte, buffer offset below
+    int view;
+};
+// Views mostly come in buffer order, which sort_array()'s middle pivot copes with
+static bool renderer_view_key_before(Renderer_View_Key a, Renderer_View_Key b) {
+    return a.key < b.key;
+}
+
+// Allocate every marked view, coalescing neighbours into one copy. Fills 'allocation_offsets' and
+// 'allocation_blocks' for every marked view and 'copies' with one entry per copy, returning their count. With a residency table, copies whose content
+// is resident reuse that allocation (and get NULL data), the rest are added to the table; either way the model
+// takes a reference, listed in 'resident_keys'.
+static int renderer_allocate_buffer_views(Gltf *model, Renderer_Gpu_Allocator_Group *allocators,
+                                          Renderer_Vertex_Attribute_Resources *list,
+                                          const u8 *destinations, u64 *allocation_offsets, int *allocation_blocks,
+                                          Renderer_Buffer_View *copies, Renderer_Residency_Table *residency,
+                                          const u8 *gltf_buffer, int *resident_count, u64 **resident_keys)
+{
+    u64 mark = get_mark_temp();
+    int buffer_view_count = gltf_buffer_view_get_count(model);
+
+    Renderer_View_Key *keys = (Renderer_View_Key*)memory_allocate_temp(sizeof(Renderer_View_Key) * buffer_view_count, 8);
+    int key_count = 0;
+    for(int i = 0; i < buffer_view_count; ++i) {
+        if (destinations[i] == RENDERER_VIEW_DESTINATION_NONE)
+            continue;
+        keys[key_count] = {((u64)destinations[i] << 56) | gltf_buffer_view_by_index(model, i)->byte_offset, i};
+        key_count++;
+    }
+    sort_array(keys, 0, key_count - 1, renderer_view_key_before);
+
+    // Copies start 16 byte aligned, so that views keep their alignment within the allocation
+    int *view_copies = (int*)memory_allocate_temp(sizeof(int) * buffer_view_count, 4);
+    u8  *copy_destinations = (u8*)memory_allocate_temp(key_count, 1);
+    int copy_count = 0;
+    Gltf_Buffer_View *view;
+    Renderer_Buffer_View *copy = NULL;
+    u64 start, end;
+    for(int i = 0; i < key_count; ++i) {
+        view  = gltf_buffer_view_by_index(model, keys[i].view);
+        start = view->byte_offset & ~(u64)15;
+        end   = view->byte_offset + view->byte_length;
+
+        if (copy && copy_destinations[copy_count - 1] == destinations[keys[i].view] &&
+            start <= copy->byte_offset + copy->byte_length + RENDERER_VIEW_COALESCE_GAP)
+        {
+            if (end > copy->byte_offset + copy->byte_length)
+                copy->byte_length = end - copy->byte_offset;
+        } else {
+            copy = &copies[copy_count];
+            copy->byte_offset = start;
+            copy->byte_length = end - start;
+            copy_destinations[copy_count] = destinations[keys[i].view];
+            copy_count++;
+        }
+        view_copies[keys[i].view] = copy_count - 1;
+    }
+
+    u64 *copy_offsets = (u64*)memory_allocate_temp(sizeof(u64) * (copy_count + 1), 8);
+    int *copy_blocks  = (int*)memory_allocate_temp(sizeof(int) * (copy_count + 1), 4);
+    *resident_count = 0;
+    *resident_keys  = NULL;
+    if (residency)
+        *resident_keys = (u64*)linear_allocator_allocate(allocators->draw_info_allocator, sizeof(u64) * copy_count, 8);
+
+    u64 key = 0;
+    u32 handle;
+    bool tracked;
+    Renderer_Residency_Entry *entry;
+    for(int i = 0; i < copy_count; ++i) {
+        entry = NULL;
+        if (residency) {
+            key = wyhash(gltf_buffer + copies[i].byte_offset, copies[i].byte_length, copy_destinations[i], _wyp);
+            entry = renderer_find_resident(residency, key);
+            if (entry && entry->size == copies[i].byte_length && entry->destination == copy_destinations[i]) {
+                (*resident_keys)[*resident_count] = key;
+                *resident_count += 1;
+                entry->ref_count++;
+                copies[i].data  = NULL;
+                copy_offsets[i] = entry->offset;
+                copy_blocks[i]  = entry->block;
+                continue;
+            }
+        }
+        // A hash that collides with a copy of another length or destination is uploaded unshared and untracked
+        tracked = residency && !entry;
+        handle  = 0;
+        copies[i].data = renderer_allocate_vertex_data(allocators, list, copy_destinations[i], copies[i].byte_length,
+                                                       &copy_offsets[i], &copy_blocks[i], tracked ? &handle : NULL);
+        if (tracked) {
+            renderer_insert_resident(residency, key, copies[i].byte_length, copy_offsets[i], copy_blocks[i],
+                                     copy_destinations[i], handle);
+            (*resident_keys)[*resident_count] = key;
+            *resident_count += 1;
+        }
+    }
+
+    for(int i = 0; i < key_count; ++i) {
+        view = gltf_buffer_view_by_index(model, keys[i].view);
+        copy = &copies[view_copies[keys[i].view]];
+        allocation_offsets[keys[i].view] = copy_offsets[view_copies[keys[i].view]] + view->byte_offset - copy->byte_offset;
+        allocation_blocks[keys[i].view]  = copy_blocks[view_copies[keys[i].view]];
+    }
+
+    reset_to_mark_temp(mark);
+    return copy_count;
+}
+
+// Widen [start, end) to cover every view the accessor reads from, sparse ones included
+static void renderer_widen_read_range(Gltf *model, Gltf_Accessor *accessor, u64 *start, u64 *end) {
+    int views[3] = {accessor->buffer_view, -1, -1};
+    if (accessor->sparse_count > 0) {
+        views[1] = accessor->indices_buffer_view;
+        views[2] = accessor->values_buffer_view;
+    }
+    Gltf_Buffer_View *view;
+    for(int i = 0; i < 3; ++i) {
+        if (views[i] < 0)
+            continue;
+        view = gltf_buffer_view_by_index(model, views[i]);
+        if (view->byte_offset < *start)
+            *start = view->byte_offset;
+        if (view->byte_offset + view->byte_length > *end)
+            *end = view->byte_offset + view->byte_length;
+    }
+}
+
+// The part of the gltf buffer the model's primitives read, starting aligned down like the view copies
+void renderer_get_read_range(Gltf *model, u64 *start, u64 *end) {
+    *start = Max_u64;
+    *end   = 0;
+
+    Gltf_Mesh *mesh = model->meshes;
+    Gltf_Mesh_Primitive *primitive;
+    int mesh_count = gltf_mesh_get_count(model);
+    for(int i = 0; i < mesh_count; ++i) {
+        primitive = mesh->primitives;
+        for(int j = 0; j < mesh->primitive_count; ++j) {
+            renderer_widen_read_range(model, gltf_accessor_by_index(model, primitive->indices),     start, end);
+            renderer_widen_read_range(model, gltf_accessor_by_index(model, primitive->position),    start, end);
+            renderer_widen_read_range(model, gltf_accessor_by_index(model, primitive->normal),      start, end);
+            renderer_widen_read_range(model, gltf_accessor_by_index(model, primitive->tangent),     start, end);
+            renderer_widen_read_range(model, gltf_accessor_by_index(model, primitive->tex_coord_0), start, end);
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    }
+
+    if (*start > *end)
+        *start = *end;
+    *start &= ~(u64)15;
+}
+
 // Unimplemented Resource Function todos
     // @Todo Animation buffer ranges filtered into uniform buffer allocators.
     // @Todo Images filtered into image allocators.
@@ -51,7 +583,9 @@ enum Buffer_Type {
     // @Todo add sampler and image resource list elements.
     // @Todo add inverse bind matrices resource list elements.
 Renderer_Vertex_Attribute_Resources
-renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu_Allocator_Group *allocators) 
+renderer_setup_vertex_attribute_resources_static_model(
+    Gltf *model, Renderer_Gpu_Allocator_Group *allocators, Renderer_Vertex_Layout layout, Renderer_Model_Flags flags,
+    Renderer_Residency_Table *residency, const u8 *gltf_buffer)
 {
     /* Method:
 
@@ -61,14 +595,24 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
           Also mark buffer view as having been queued for allocation.
     */
 
+    bool quantize_vertices = flags & RENDERER_MODEL_QUANTIZE_VERTICES_BIT;
+    bool optimize_meshes   = flags & RENDERER_MODEL_OPTIMIZE_MESHES_BIT;
+    bool split_indices     = flags & RENDERER_MODEL_SPLIT_INDICES_BIT;
+    bool build_meshlets    = flags & RENDERER_MODEL_BUILD_MESHLETS_BIT;
+    bool generate_lods     = flags & RENDERER_MODEL_GENERATE_LODS_BIT;
+
+    ASSERT(!optimize_meshes || layout != RENDERER_VERTEX_LAYOUT_SEPARATE,
+           "Mesh optimization rewrites vertices, so it needs an allocation per primitive");
+    ASSERT(!generate_lods || optimize_meshes, "Levels of detail are written with the optimized indices");
+    ASSERT(!residency || gltf_buffer, "Resident copies are found by their content");
+
     int accessor_count    = gltf_accessor_get_count(model);
     int buffer_view_count = gltf_buffer_view_get_count(model);
     int mesh_count        = gltf_mesh_get_count(model);
 
     Renderer_Vertex_Attribute_Resources ret = {};
-    ret.buffer_view_count = buffer_view_count;
     ret.buffer_views = (Renderer_Buffer_View*)memory_allocate_temp(
-                            sizeof(Renderer_Buffer_View) * buffer_view_count, 8);
+                            sizeof(Renderer_Buffer_View) * buffer_view_count, 8); // at most one copy per view
     
     // Put draw information into persistent allocation
     // @Todo Have a separate linear allocator for this data, allocated from the global
@@ -77,6 +621,7 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
     ret.meshes = 
         (Renderer_Mesh*)linear_allocator_allocate(
             allocators->draw_info_allocator, sizeof(Renderer_Mesh) * mesh_count, 8);
+    ret.draw_info_allocator = allocators->draw_info_allocator;
 
     ret.vertex_state_infos = 
         (Gpu_Vertex_Input_State**)memory_allocate_temp(sizeof(u8*) * mesh_count, 8);
@@ -91,16 +636,67 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
     Gltf_Mesh_Primitive *primitive;
 
     int buffer_indices[5];
+    int accessor_indices[5];
+    u64 *draw_offsets[5];
+    int *draw_blocks[5];
     Gltf_Accessor *accessors[5];
-    Gltf_Buffer_View *buffer_view;
 
-    ASSERT(buffer_view_count <= 64, "Buffer View Mask Too Small");
-    u64 buffer_view_mask      = 0x0; // @Note Assumes fewer than 64 buffer views;
-    u64 *allocation_offsets   = (u64*)memory_allocate_temp(sizeof(u64) * buffer_view_count, 8);
+    Renderer_Vertex_Encoding encoding;
+    Renderer_Vertex_Encoding index_encoding;
+    Renderer_Resolved_Accessor *resolved;
+    Gpu_Vertex_Input_State *vertex_state;
+    VkFormat encoded_format;
+    int encoded_size;
+
+    // At most one allocation per accessor; 'resolved_slots' maps an accessor to its entry in 'resolved_accessors'
+    ret.resolved_accessors = (Renderer_Resolved_Accessor*)memory_allocate_temp(
+                                  sizeof(Renderer_Resolved_Accessor) * accessor_count, 8);
+    int *resolved_slots    = (int*)memory_allocate_temp(sizeof(int) * accessor_count, 4);
+    u64 *resolved_offsets  = (u64*)memory_allocate_temp(sizeof(u64) * accessor_count, 8);
+    int *resolved_blocks   = (int*)memory_allocate_temp(sizeof(int) * accessor_count, 4);
+    memset(resolved_slots, 0xff, sizeof(int) * accessor_count);
+
+    int primitive_count = 0;
+    for(int i = 0; i < mesh_count; ++i)
+        primitive_count += gltf_mesh_by_index(model, i)->primitive_count;
+
+    // At most an allocation per resolved accessor, three per interleaved primitive and one per copy
+    int device_allocation_cap = 0;
+    if (allocators->device_memory) {
+        device_allocation_cap = accessor_count + primitive_count * 3 + buffer_view_count;
+        ret.device_allocations = (Gpu_Memory_Allocation*)memory_allocate_temp(
+                                     sizeof(Gpu_Memory_Allocation) * device_allocation_cap, 8);
+        ret.device_copies = (Renderer_Device_Copy*)memory_allocate_temp(
+                                sizeof(Renderer_Device_Copy) * device_allocation_cap, 8);
+    }
+
+    Renderer_Interleaved_Primitive *interleaved;
+    if (layout != RENDERER_VERTEX_LAYOUT_SEPARATE) {
+        ret.interleaved = (Renderer_Interleaved_Primitive*)memory_allocate_temp(
+                              sizeof(Renderer_Interleaved_Primitive) * primitive_count, 8);
+    }
+    if (layout == RENDERER_VERTEX_LAYOUT_INTERLEAVED_POSITION_STREAM)
+        ret.position_state_infos =
+            (Gpu_Vertex_Input_State**)memory_allocate_temp(sizeof(u8*) * mesh_count, 8);
+
+    // Views are only marked as they are found. They are allocated after the loop, in one pass sorted by
+    // destination, and the draw offsets pointing into them are fixed up after that.
+    u8 *view_destinations = (u8*)memory_allocate_temp(buffer_view_count, 1);
+    memset(view_destinations, RENDERER_VIEW_DESTINATION_NONE, buffer_view_count);
+    u64 *allocation_offsets = (u64*)memory_allocate_temp(sizeof(u64) * buffer_view_count, 8);
+    int *allocation_blocks  = (int*)memory_allocate_temp(sizeof(int) * buffer_view_count, 4);
+    Renderer_View_Fixup *view_fixups =
+        (Renderer_View_Fixup*)memory_allocate_temp(sizeof(Renderer_View_Fixup) * primitive_count * 5, 8);
+    int view_fixup_count = 0;
+    u8 destination;
 
     // To know which area of the buffer to synchronize
     gpu_make_buf_allocation(allocators->index_allocator,  0, &ret.index_allocation_start);
     gpu_make_buf_allocation(allocators->vertex_allocator, 0, &ret.vertex_allocation_start);
+    ret.index_allocation_start_block  = allocators->index_allocator->block;
+    ret.vertex_allocation_start_block = allocators->vertex_allocator->block;
+
+    renderer_get_read_range(model, &ret.buffer_read_start, &ret.buffer_read_end);
 
     for(int i = 0; i < mesh_count; ++i) {
         primitive = mesh->primitives;
@@ -109,9 +705,29 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
                 allocators->draw_info_allocator,
                 sizeof(Renderer_Draw_Info_Static) * mesh->primitive_count, 8); 
 
+        ret.meshes[i].primitive_count = mesh->primitive_count;
+        ret.meshes[i].primitive_meshlets = NULL;
+        if (build_meshlets) {
+            ret.meshes[i].primitive_meshlets = (Renderer_Meshlets*)linear_allocator_allocate(
+                    allocators->draw_info_allocator,
+                    sizeof(Renderer_Meshlets) * mesh->primitive_count, 8);
+            memset(ret.meshes[i].primitive_meshlets, 0, sizeof(Renderer_Meshlets) * mesh->primitive_count);
+        }
+        ret.meshes[i].primitive_lods = NULL;
+        if (generate_lods) {
+            ret.meshes[i].primitive_lods = (Renderer_Lods*)linear_allocator_allocate(
+                    allocators->draw_info_allocator,
+                    sizeof(Renderer_Lods) * mesh->primitive_count, 8);
+            memset(ret.meshes[i].primitive_lods, 0, sizeof(Renderer_Lods) * mesh->primitive_count);
+        }
+
         ret.vertex_state_infos[i] =
                 (Gpu_Vertex_Input_State*)memory_allocate_temp(
                     sizeof(Gpu_Vertex_Input_State) * mesh->primitive_count, 8);
+        if (ret.position_state_infos)
+            ret.position_state_infos[i] =
+                (Gpu_Vertex_Input_State*)memory_allocate_temp(
+                    sizeof(Gpu_Vertex_Input_State) * mesh->primitive_count, 8);
 
         for(int j = 0; j < mesh->primitive_count; ++j) {
 
@@ -122,7 +738,12 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
             accessors[4] = gltf_accessor_by_index(model, primitive->tex_coord_0);
 
             // Fill in draw info
+            ret.meshes[i].primitive_draw_infos[j].position_dequantize = NULL;
+            ret.meshes[i].primitive_draw_infos[j].vertex_buffer_count = 4;
+            ret.meshes[i].primitive_draw_infos[j].position_buffer_offset = 0;
+            ret.meshes[i].primitive_draw_infos[j].position_buffer_block  = 0;
             ret.meshes[i].primitive_draw_infos[j].draw_count          = accessors[0]->count;
+            ret.meshes[i].primitive_draw_infos[j].index_split         = NULL;
             ret.meshes[i].primitive_draw_infos[j].index_buffer_offset = accessors[0]->byte_offset;
 
             ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[0] = accessors[1]->byte_offset;
@@ -137,176 +758,1570 @@ renderer_setup_vertex_attribute_resources_static_model(Gltf *model, Renderer_Gpu
             buffer_indices[3] = accessors[3]->buffer_view;
             buffer_indices[4] = accessors[4]->buffer_view;
 
+            draw_offsets[0] = &ret.meshes[i].primitive_draw_infos[j].index_buffer_offset;
+            draw_offsets[1] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[0]; // position
+            draw_offsets[2] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[1]; // normal
+            draw_offsets[3] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[2]; // tangent
+            draw_offsets[4] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[3]; // tex_coord_0
+
+            draw_blocks[0] = &ret.meshes[i].primitive_draw_infos[j].index_buffer_block;
+            draw_blocks[1] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_blocks[0];
+            draw_blocks[2] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_blocks[1];
+            draw_blocks[3] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_blocks[2];
+            draw_blocks[4] = &ret.meshes[i].primitive_draw_infos[j].vertex_buffer_blocks[3];
+            for(int k = 0; k < 5; ++k)
+                *draw_blocks[k] = 0;
+
+            accessor_indices[0] = primitive->indices;
+            accessor_indices[1] = primitive->position;
+            accessor_indices[2] = primitive->normal;
+            accessor_indices[3] = primitive->tangent;
+            accessor_indices[4] = primitive->tex_coord_0;
+
             ret.vertex_state_infos[i][j] =
                 renderer_define_vertex_input_state_static_model(primitive, model);
 
-            // Check if buffer view has already been queued, if not, get its details and add to queue
-            if ((buffer_view_mask & (1 << buffer_indices[0])) == 0) {
-                buffer_view = gltf_buffer_view_by_index(model, buffer_indices[0]);
+            index_encoding = renderer_choose_index_encoding(accessors[0], accessors[1]->count, split_indices);
+            ret.meshes[i].primitive_draw_infos[j].index_type =
+                index_encoding == RENDERER_VERTEX_ENCODING_INDEX_U16 ||
+                accessors[0]->format == GLTF_ACCESSOR_FORMAT_SCALAR_U16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+            // Only the indices go through buffer views when the attributes are interleaved, and not even those
+            // when the primitive is optimized
+            int view_accessor_count = layout == RENDERER_VERTEX_LAYOUT_SEPARATE ? 5 : optimize_meshes ? 0 : 1;
+            for(int k = 0; k < view_accessor_count; ++k) {
+                destination = k == 0 ? RENDERER_VIEW_DESTINATION_INDEX : RENDERER_VIEW_DESTINATION_VERTEX;
+
+                // Sparse and encoded accessors are resolved into an allocation of their own at download
+                // time, so they are not pointed at their (shared) base buffer view.
+                encoding = k == 0 ? index_encoding : renderer_choose_vertex_encoding(k, accessors[k], quantize_vertices);
+                if (accessors[k]->sparse_count > 0 || encoding != RENDERER_VERTEX_ENCODING_NONE) {
+                    encoded_format = renderer_get_encoded_format(encoding, accessors[k]->format, &encoded_size);
+                    if (resolved_slots[accessor_indices[k]] == -1) {
+                        resolved_slots[accessor_indices[k]] = ret.resolved_accessor_count;
+                        resolved = &ret.resolved_accessors[ret.resolved_accessor_count];
+
+                        resolved->accessor   = accessor_indices[k];
+                        resolved->encoding   = encoding;
+                        resolved->dequantize = NULL;
+                        resolved->split      = NULL;
+                        resolved->data =
+                            renderer_allocate_vertex_data(
+                                allocators, &ret, destination,
+                                (u64)accessors[k]->count * encoded_size,
+                                &resolved_offsets[ret.resolved_accessor_count],
+                                &resolved_blocks[ret.resolved_accessor_count]);
+
+                        if (encoding == RENDERER_VERTEX_ENCODING_SNORM16)
+                            resolved->dequantize = (Vertex_Dequantize*)linear_allocator_allocate(
+                                allocators->draw_info_allocator, sizeof(Vertex_Dequantize), 8);
+                        // Only u32 accessors narrowed under RENDERER_MODEL_SPLIT_INDICES_BIT: u8 indices are
+                        // widened whatever the vertex count
+                        if (encoding == RENDERER_VERTEX_ENCODING_INDEX_U16 && split_indices &&
+                            accessors[0]->format == GLTF_ACCESSOR_FORMAT_SCALAR_U32 && accessors[1]->count > 65536)
+                            resolved->split = (Renderer_Index_Split*)linear_allocator_allocate(
+                                allocators->draw_info_allocator, sizeof(Renderer_Index_Split), 8);
+
+                        ret.resolved_accessor_count++;
+                    }
+                    resolved = &ret.resolved_accessors[resolved_slots[accessor_indices[k]]];
+                    *draw_offsets[k] = resolved_offsets[resolved_slots[accessor_indices[k]]];
+                    *draw_blocks[k]  = resolved_blocks[resolved_slots[accessor_indices[k]]];
+
+                    if (k == 0)
+                        ret.meshes[i].primitive_draw_infos[j].index_split = resolved->split;
+                    if (k == 1)
+                        ret.meshes[i].primitive_draw_infos[j].position_dequantize = resolved->dequantize;
+
+                    // Tightly packed now, whatever the view's stride was
+                    if (k > 0) {
+                        vertex_state = &ret.vertex_state_infos[i][j];
+                        vertex_state->formats[k - 1] = encoded_format;
+                        vertex_state->binding_description_strides[k - 1] = encoded_size;
+                    }
+                    continue;
+                }
+
+                // Mark the view as needed; the draw info is pointed at it once it is allocated
+                ASSERT(view_destinations[buffer_indices[k]] == RENDERER_VIEW_DESTINATION_NONE ||
+                       view_destinations[buffer_indices[k]] == destination,
+                       "Buffer view used for both index and vertex data");
+                view_destinations[buffer_indices[k]] = destination;
+
+                view_fixups[view_fixup_count] = {draw_offsets[k], draw_blocks[k], buffer_indices[k]};
+                view_fixup_count++;
+            }
 
-                ret.buffer_views[buffer_indices[0]].byte_length = buffer_view->byte_length;
-                ret.buffer_views[buffer_indices[0]].byte_offset = buffer_view->byte_offset;
+            if (layout != RENDERER_VERTEX_LAYOUT_SEPARATE) {
+                interleaved = &ret.interleaved[ret.interleaved_count];
+                ret.interleaved_count++;
+
+                vertex_state = &ret.vertex_state_infos[i][j];
+                vertex_state->input_binding_description_count = 1;
+
+                interleaved->count  = accessors[1]->count;
+                interleaved->stride = 0;
+                interleaved->dequantize = NULL;
+                interleaved->optimized_count = 0;
+                for(int k = 1; k < 5; ++k) {
+                    ASSERT(accessors[k]->count == interleaved->count, "Interleaved attributes differ in count");
+
+                    encoding = renderer_choose_vertex_encoding(k, accessors[k], quantize_vertices);
+                    encoded_format = renderer_get_encoded_format(encoding, accessors[k]->format, &encoded_size);
+
+                    interleaved->accessors[k - 1] = accessor_indices[k];
+                    interleaved->encodings[k - 1] = encoding;
+                    interleaved->offsets  [k - 1] = interleaved->stride;
+                    interleaved->stride += align(encoded_size, 4);
+
+                    vertex_state->formats[k - 1] = encoded_format;
+                    vertex_state->attribute_description_bindings[k - 1] = 0;
+                    vertex_state->attribute_description_offsets [k - 1] = interleaved->offsets[k - 1];
+                }
+                vertex_state->binding_description_strides[0] = interleaved->stride;
+
+                interleaved->data =
+                    renderer_allocate_vertex_data(
+                        allocators, &ret, RENDERER_VIEW_DESTINATION_VERTEX,
+                        (u64)interleaved->count * interleaved->stride,
+                        draw_offsets[1], draw_blocks[1]);
+                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_count = 1;
+
+                if (interleaved->encodings[0] == RENDERER_VERTEX_ENCODING_SNORM16) {
+                    interleaved->dequantize = (Vertex_Dequantize*)linear_allocator_allocate(
+                        allocators->draw_info_allocator, sizeof(Vertex_Dequantize), 8);
+                    ret.meshes[i].primitive_draw_infos[j].position_dequantize = interleaved->dequantize;
+                }
+
+                // Optimized indices are rewritten anyway, so they are narrowed as they are written (they are
+                // not split though: the reordering is free to scatter triangles across the whole vertex range)
+                interleaved->indices = accessor_indices[0];
+                interleaved->index_data = NULL;
+                interleaved->meshlets = build_meshlets ? &ret.meshes[i].primitive_meshlets[j] : NULL;
+                interleaved->lods     = generate_lods  ? &ret.meshes[i].primitive_lods[j]     : NULL;
+                if (optimize_meshes) {
+                    interleaved->index_format = interleaved->count > 65536 ?
+                        GLTF_ACCESSOR_FORMAT_SCALAR_U32 : GLTF_ACCESSOR_FORMAT_SCALAR_U16;
+                    interleaved->index_data =
+                        renderer_allocate_vertex_data(
+                            allocators, &ret, RENDERER_VIEW_DESTINATION_INDEX,
+                            (u64)accessors[0]->count * (generate_lods ? RENDERER_LOD_INDEX_CAPACITY : 1) *
+                                renderer_get_byte_stride(interleaved->index_format),
+                            draw_offsets[0], draw_blocks[0]);
+                    ret.meshes[i].primitive_draw_infos[j].index_type =
+                        interleaved->count > 65536 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+                }
+
+                interleaved->position_data = NULL;
+                if (layout == RENDERER_VERTEX_LAYOUT_INTERLEAVED_POSITION_STREAM) {
+                    encoded_format = renderer_get_encoded_format(interleaved->encodings[0], accessors[1]->format, &encoded_size);
+                    ret.position_state_infos[i][j] =
+                        renderer_define_vertex_input_state_position_stream(primitive, encoded_format, encoded_size);
+
+                    interleaved->position_data =
+                        renderer_allocate_vertex_data(
+                            allocators, &ret, RENDERER_VIEW_DESTINATION_VERTEX,
+                            (u64)interleaved->count * encoded_size,
+                            &ret.meshes[i].primitive_draw_infos[j].position_buffer_offset,
+                            &ret.meshes[i].primitive_draw_infos[j].position_buffer_block);
+                }
+            }
 
-                ret.buffer_views[buffer_indices[0]].data =
-                    gpu_make_buf_allocation(
-                        allocators->index_allocator, 
-                        ret.buffer_views[buffer_indices[0]].byte_length,
-                        &allocation_offsets[buffer_indices[0]]);
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    }
 
-                // Point draw infos at the queued allocation
-                ret.meshes[i].primitive_draw_infos[j].index_buffer_offset += allocation_offsets[buffer_indices[0]];
-            } else {
-                // Point draw infos at the queued allocation
-                ret.meshes[i].primitive_draw_infos[j].index_buffer_offset += allocation_offsets[buffer_indices[0]];
-            }
-            if ((buffer_view_mask & (1 << buffer_indices[1])) == 0) {
-                buffer_view = gltf_buffer_view_by_index(model, buffer_indices[1]);
+    ret.buffer_view_count =
+        renderer_allocate_buffer_views(model, allocators, &ret, view_destinations, allocation_offsets,
+                                       allocation_blocks, ret.buffer_views, residency, gltf_buffer,
+                                       &ret.resident_count, &ret.resident_keys);
+    for(int i = 0; i < view_fixup_count; ++i) {
+        *view_fixups[i].draw_offset += allocation_offsets[view_fixups[i].view];
+        *view_fixups[i].draw_block   = allocation_blocks[view_fixups[i].view];
+    }
 
-                ret.buffer_views[buffer_indices[1]].byte_length = buffer_view->byte_length;
-                ret.buffer_views[buffer_indices[1]].byte_offset = buffer_view->byte_offset;
+    // The model's allocations outlive setup, in Renderer_Draws
+    if (allocators->device_memory) {
+        ASSERT(ret.device_allocation_count <= device_allocation_cap, "Device allocation list overflow");
+        Gpu_Memory_Allocation *device_allocations = (Gpu_Memory_Allocation*)linear_allocator_allocate(
+            allocators->draw_info_allocator, sizeof(Gpu_Memory_Allocation) * ret.device_allocation_count, 8);
+        memcpy(device_allocations, ret.device_allocations,
+               sizeof(Gpu_Memory_Allocation) * ret.device_allocation_count);
+        ret.device_allocations = device_allocations;
+    }
 
-                ret.buffer_views[buffer_indices[1]].data =
-                    gpu_make_buf_allocation(
-                        allocators->vertex_allocator, 
-                        ret.buffer_views[buffer_indices[1]].byte_length,
-                        &allocation_offsets[buffer_indices[1]]);
+    ret.index_allocation_end        = allocators->index_allocator->used;
+    ret.vertex_allocation_end       = allocators->vertex_allocator->used;
+    ret.index_allocation_end_block  = allocators->index_allocator->block;
+    ret.vertex_allocation_end_block = allocators->vertex_allocator->block;
 
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[0] += allocation_offsets[buffer_indices[1]];
-            } else {
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[0] += allocation_offsets[buffer_indices[1]];
-            }
-            if ((buffer_view_mask & (1 << buffer_indices[2])) == 0) {
-                buffer_view = gltf_buffer_view_by_index(model, buffer_indices[2]);
+    return ret;
+}
+
+enum Renderer_Texture_Usage {
+    RENDERER_TEXTURE_USAGE_DATA   = 0, // linear: metallic roughness, occlusion, or unreferenced
+    RENDERER_TEXTURE_USAGE_COLOR  = 1, // sRGB
+    RENDERER_TEXTURE_USAGE_NORMAL = 2,
+};
+static void renderer_mark_texture_usage(Gltf *model, u8 *usages, int texture, Renderer_Texture_Usage usage) {
+    if (texture < 0)
+        return;
+    int image = gltf_texture_by_index(model, texture)->source_image;
+    if (image >= 0 && usages[image] == RENDERER_TEXTURE_USAGE_DATA)
+        usages[image] = usage;
+}
 
-                ret.buffer_views[buffer_indices[2]].byte_length = buffer_view->byte_length;
-                ret.buffer_views[buffer_indices[2]].byte_offset = buffer_view->byte_offset;
+// Map a KTX2 file whose levels can be copied as they are. On failure the file is unmapped again.
+static bool renderer_map_ktx2_texture(const char *path, u8 **file, u64 *size, Image_Ktx2 *ktx2, Gpu_Tex_Info *info)
+{
+    *file = file_map_private(path, size);
+    if (!*file) {
+        println("Failed to map image %c", path);
+        return false;
+    }
 
-                ret.buffer_views[buffer_indices[2]].data =
-                    gpu_make_buf_allocation(
-                        allocators->vertex_allocator, 
-                        ret.buffer_views[buffer_indices[2]].byte_length,
-                        &allocation_offsets[buffer_indices[2]]);
+    Image_Ktx2_Result result = image_parse_ktx2(*file, *size, ktx2);
+    if (result != IMAGE_KTX2_OK) {
+        // @Todo Basis Universal transcoding, zstd
+        println("Cannot load KTX2 image %c (result %u)", path, (u32)result);
+        file_unmap(*file, *size);
+        return false;
+    }
+    info->width      = ktx2->width;
+    info->height     = ktx2->height;
+    info->mip_levels = ktx2->level_count;
+    info->format     = (VkFormat)ktx2->vk_format;
+    if (!gpu_tex_format_is_supported(info->format)) {
+        // Only formats whose levels can be sized (R8G8B8A8, BCn, ASTC LDR) and which the device samples
+        println("Format of KTX2 image %c (%u) is not supported", path, ktx2->vk_format);
+        file_unmap(*file, *size);
+        return false;
+    }
 
-                // Point draw infos at the queued 'normal' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[1] += allocation_offsets[buffer_indices[2]];
-            } else {
-                // Point draw infos at the queued 'normal' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[1] += allocation_offsets[buffer_indices[2]];
-            }
-            if ((buffer_view_mask & (1 << buffer_indices[3])) == 0) {
-                buffer_view = gltf_buffer_view_by_index(model, buffer_indices[3]);
+    u32 width  = info->width;
+    u32 height = info->height;
+    for(u32 i = 0; i < info->mip_levels; ++i) {
+        if (ktx2->levels[i].size != gpu_get_tex_level_size(info->format, width, height)) {
+            println("Level %u of KTX2 image %c is the wrong size", i, path);
+            file_unmap(*file, *size);
+            return false;
+        }
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    return true;
+}
+
+// Copy a KTX2 file's levels straight from the mapped file into staging. The payload is used as stored, so usage
+// only matters in that the file should agree with it. Returns false (with nothing allocated) if the file cannot
+// be used as is.
+static bool renderer_stage_ktx2_texture(const char *path, Gpu_Tex_Allocator *tex_allocator, VkImage *image)
+{
+    u8 *file;
+    u64 size;
+    Image_Ktx2 ktx2;
+    Gpu_Tex_Info info;
+    if (!renderer_map_ktx2_texture(path, &file, &size, &ktx2, &info))
+        return false;
+
+    VkDevice device = get_gpu_instance()->vk_device;
+    u8 *staged = (u8*)gpu_make_tex_allocation(device, tex_allocator, &info, gpu_get_tex_size(&info), image);
+    for(u32 i = 0; i < info.mip_levels; ++i) {
+        memcpy(staged, file + ktx2.levels[i].offset, ktx2.levels[i].size);
+        staged += ktx2.levels[i].size;
+    }
+    file_unmap(file, size);
+    return true;
+}
+
+static bool renderer_is_ktx2_uri(const char *uri, int uri_len) {
+    return uri_len > 5 && memcmp(uri + uri_len - 5, ".ktx2", 5) == 0;
+}
+
+Renderer_Texture_Resources renderer_setup_textures_static_model(
+    Gltf *model, Renderer_Gpu_Allocator_Group *allocators, const char *model_dir_path, Renderer_Model_Flags flags)
+{
+    Gpu_Tex_Allocator *tex_allocator = allocators->tex_allocator;
+    int image_count = gltf_image_get_count(model);
+
+    Renderer_Texture_Resources ret = {};
+    ret.texture_count    = image_count;
+    ret.textures         = (VkImage*)linear_allocator_allocate(
+                               allocators->draw_info_allocator, sizeof(VkImage) * image_count, 8);
+    ret.offsets          = (u64*)linear_allocator_allocate(
+                               allocators->draw_info_allocator, sizeof(u64) * image_count, 8);
+    ret.decode_us        = (u32*)linear_allocator_allocate(
+                               allocators->draw_info_allocator, sizeof(u32) * image_count, 4);
+    ret.allocation_first = tex_allocator->img_cnt;
+
+    u64 mark = get_mark_temp();
+    u8 *usages = (u8*)memory_allocate_temp(image_count, 1);
+    memset(usages, RENDERER_TEXTURE_USAGE_DATA, image_count);
+
+    Gltf_Material *material;
+    int material_count = gltf_material_get_count(model);
+    for(int i = 0; i < material_count; ++i) {
+        material = gltf_material_by_index(model, i);
+        renderer_mark_texture_usage(model, usages, material->base_color_texture_index, RENDERER_TEXTURE_USAGE_COLOR);
+        renderer_mark_texture_usage(model, usages, material->emissive_texture_index,   RENDERER_TEXTURE_USAGE_COLOR);
+        renderer_mark_texture_usage(model, usages, material->normal_texture_index,     RENDERER_TEXTURE_USAGE_NORMAL);
+    }
+
+    // Images are made and their staging reserved here, from the file headers; the decodes then run in parallel
+    // straight into staging (see image_decode_jobs())
+    bool compress = (flags & RENDERER_MODEL_COMPRESS_TEXTURES_BIT) && get_gpu_instance()->info.texture_compression_bc;
+    VkDevice device = get_gpu_instance()->vk_device;
+    Image_Decode_Job *jobs = (Image_Decode_Job*)memory_allocate_temp(sizeof(Image_Decode_Job) * image_count, 8);
+    int *job_images = (int*)memory_allocate_temp(sizeof(int) * image_count, 4);
+    int job_count = 0;
+
+    Gltf_Image *image;
+    Image_Decode_Job *job;
+    Gpu_Tex_Info info;
+    char *path;
+    int dir_path_len = strlen(model_dir_path);
+    int uri_len, width, height;
+    bool srgb;
+    for(int i = 0; i < image_count; ++i) {
+        ret.textures[i]  = VK_NULL_HANDLE;
+        ret.offsets[i]   = 0;
+        ret.decode_us[i] = 0;
+
+        image = gltf_image_by_index(model, i);
+        if (!image->uri)
+            continue;
+        uri_len = strlen(image->uri);
+        path = (char*)memory_allocate_temp(dir_path_len + uri_len + 1, 1);
+        memcpy(path, model_dir_path, dir_path_len);
+        memcpy(path + dir_path_len, image->uri, uri_len + 1);
+
+        if (renderer_is_ktx2_uri(image->uri, uri_len)) {
+            if (renderer_stage_ktx2_texture(path, tex_allocator, &ret.textures[i]))
+                ret.offsets[i] = tex_allocator->offsets[tex_allocator->img_cnt - 1];
+            continue;
+        }
+
+        if (!image_get_info(path, &width, &height)) {
+            println("Failed to load image %c", path);
+            continue;
+        }
+
+        srgb = usages[i] == RENDERER_TEXTURE_USAGE_COLOR;
+        job = &jobs[job_count];
+        job->path      = path;
+        job->width     = width;
+        job->height    = height;
+        job->mip_count = image_get_mip_count(width, height);
+        job->srgb      = srgb;
+
+        info.width      = width;
+        info.height     = height;
+        info.mip_levels = job->mip_count;
+        if (!compress) {
+            info.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+            job->output = IMAGE_DECODE_OUTPUT_RGBA8;
+        } else if (usages[i] == RENDERER_TEXTURE_USAGE_NORMAL) {
+            info.format = VK_FORMAT_BC5_UNORM_BLOCK;
+            job->output = IMAGE_DECODE_OUTPUT_BC5;
+        } else {
+            info.format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            job->output = IMAGE_DECODE_OUTPUT_BC7;
+        }
+        job->dst = (u8*)gpu_make_tex_allocation(device, tex_allocator, &info, gpu_get_tex_size(&info), &ret.textures[i]);
+        ret.offsets[i] = tex_allocator->offsets[tex_allocator->img_cnt - 1];
+        job_images[job_count] = i;
+        job_count++;
+    }
+
+    image_decode_jobs(jobs, job_count, 0);
+    ret.decode_job_count = job_count;
+
+    // A failed decode leaves its image made but unwritten: it is still uploaded, just never handed out
+    for(int i = 0; i < job_count; ++i) {
+        ret.decode_retry_count += jobs[i].retry_count;
+        if (!jobs[i].ok) {
+            println("Failed to decode image %c", jobs[i].path);
+            ret.textures[job_images[i]] = VK_NULL_HANDLE;
+            continue;
+        }
+        ret.decode_us[job_images[i]] = jobs[i].decode_us + jobs[i].process_us;
+    }
+    reset_to_mark_temp(mark);
+
+    ret.allocation_count = tex_allocator->img_cnt - ret.allocation_first;
+    return ret;
+}
+
+bool renderer_create_virtual_texture(const char *tile_file_path, u32 pool_width, u32 pool_height,
+                                     u32 feedback_count, int tiles_per_frame, int frame_count,
+                                     Renderer_Virtual_Texture *ret)
+{
+    *ret = {};
+    ret->file = file_map_private(tile_file_path, &ret->file_size);
+    if (!ret->file) {
+        println("Failed to map tile file %c", tile_file_path);
+        return false;
+    }
+    if (!vt_parse_tile_file(ret->file, ret->file_size, &ret->tiles)) {
+        println("Invalid tile file %c", tile_file_path);
+        file_unmap(ret->file, ret->file_size);
+        return false;
+    }
+
+    Gpu *gpu = get_gpu_instance();
+    Vt_Tile_File_Header *header = &ret->tiles.header;
+    VkFormat format;
+    if (header->format == VT_TILE_FORMAT_BC7)
+        format = header->srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+    else
+        format = header->srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    if ((header->format == VT_TILE_FORMAT_BC7 && !gpu->info.texture_compression_bc) ||
+        !gpu_tex_format_is_supported(format))
+    {
+        println("Tile file %c: format cannot be sampled", tile_file_path);
+        file_unmap(ret->file, ret->file_size);
+        return false;
+    }
+
+    ret->vt  = create_virtual_texture(header->width, header->height, pool_width, pool_height,
+                                      RENDERER_VT_REQUEST_CAP);
+    ret->gpu = gpu_create_virtual_texture(gpu->vk_device, &ret->vt, format,
+                                          gpu->memory_resources.device_memory_type,
+                                          gpu->memory_resources.host_memory_type,
+                                          feedback_count, tiles_per_frame, frame_count);
+    return true;
+}
+void renderer_destroy_virtual_texture(Renderer_Virtual_Texture *rvt)
+{
+    gpu_destroy_virtual_texture(get_gpu_instance()->vk_device, &rvt->gpu);
+    destroy_virtual_texture(&rvt->vt);
+    file_unmap(rvt->file, rvt->file_size);
+    *rvt = {};
+}
 
-                ret.buffer_views[buffer_indices[3]].byte_length = buffer_view->byte_length;
-                ret.buffer_views[buffer_indices[3]].byte_offset = buffer_view->byte_offset;
+void renderer_update_virtual_texture(Renderer_Virtual_Texture *rvt, int frame, VkCommandBuffer cmd)
+{
+    Virtual_Texture *vt = &rvt->vt;
+    u64 tile_size = rvt->tiles.header.tile_size;
+    const u32 *feedback = gpu_vt_begin_frame(&rvt->gpu, frame);
+
+    // The pinned top page goes in with the first update
+    u32 page = vt->page_count - 1;
+    if (!rvt->gpu.pool_written)
+        memcpy(gpu_vt_stage_tile(&rvt->gpu, vt->pages[page].slot), vt_get_tile(&rvt->tiles, page), tile_size);
+
+    int request_count = vt_process_feedback(vt, feedback, rvt->gpu.feedback_count);
+    rvt->streamed = 0;
+
+    u32 slot;
+    for(int i = 0; i < request_count; ++i) {
+        if (rvt->gpu.staged_count == rvt->gpu.tiles_per_frame)
+            break;
+        page = vt->requests[i];
+        if (!vt_map_page(vt, page, &slot))
+            break;
+        memcpy(gpu_vt_stage_tile(&rvt->gpu, slot), vt_get_tile(&rvt->tiles, page), tile_size);
+        rvt->streamed++;
+    }
+    gpu_cmd_vt_upload(cmd, &rvt->gpu, vt);
+}
+
+// `Texture Streaming
+Renderer_Texture_Streamer renderer_create_texture_streamer(Gpu_Transfer_Queue *transfer, u64 budget, int texture_cap,
+                                                           int material_count, int frame_count)
+{
+    Gpu *gpu = get_gpu_instance();
+    u64 granularity = gpu->info.properties.limits.bufferImageGranularity;
+    u32 memory_type = gpu->memory_resources.device_memory_type;
+
+    Renderer_Texture_Streamer ret = {};
+    ret.streamer    = create_tex_streamer(budget, texture_cap, material_count);
+    ret.textures    = (Renderer_Streamed_Texture*)memory_allocate_heap(
+                          sizeof(Renderer_Streamed_Texture) * texture_cap, 8);
+    ret.transfer    = transfer;
+    ret.frame_count = frame_count;
+
+    // Blocks of an eighth of the budget leave room for the images being replaced and the retired ones
+    u64 block_size = align(budget / 8, granularity);
+    ret.image_memory   = gpu_create_memory_allocator(memory_type, false, block_size, granularity, texture_cap * 2);
+    ret.landing_memory = gpu_create_memory_allocator(
+        memory_type, false, block_size, granularity, texture_cap,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    return ret;
+}
+void renderer_destroy_texture_streamer(Renderer_Texture_Streamer *rs)
+{
+    VkDevice device = get_gpu_instance()->vk_device;
+    for(int i = 0; i < rs->retired_count; ++i) {
+        if (rs->retired[i].image)
+            vkDestroyImage(device, rs->retired[i].image, ALLOCATION_CALLBACKS);
+    }
+    for(int i = 0; i < rs->streamer.texture_count; ++i) {
+        if (rs->textures[i].image)
+            vkDestroyImage(device, rs->textures[i].image, ALLOCATION_CALLBACKS);
+        if (rs->textures[i].file)
+            file_unmap(rs->textures[i].file, rs->textures[i].file_size);
+    }
+    gpu_destroy_memory_allocator(device, &rs->image_memory);
+    gpu_destroy_memory_allocator(device, &rs->landing_memory);
+    memory_free_heap(rs->textures);
+    destroy_tex_streamer(&rs->streamer);
+    *rs = {};
+}
 
-                ret.buffer_views[buffer_indices[3]].data =
-                    gpu_make_buf_allocation(
-                        allocators->vertex_allocator, 
-                        ret.buffer_views [buffer_indices[3]].byte_length,
-                        &allocation_offsets[buffer_indices[3]]);
+int renderer_stream_texture(Renderer_Texture_Streamer *rs, const u8 *chain, Gpu_Tex_Info *info)
+{
+    if (rs->streamer.texture_count == rs->streamer.texture_cap || info->mip_levels > TEX_STREAMER_MAX_LEVELS)
+        return -1;
+
+    Renderer_Streamed_Texture *texture = &rs->textures[rs->streamer.texture_count];
+    *texture = {};
+    texture->format      = info->format;
+    texture->first_level = info->mip_levels;
+
+    u64 level_sizes[TEX_STREAMER_MAX_LEVELS];
+    u32 width  = info->width;
+    u32 height = info->height;
+    for(u32 i = 0; i < info->mip_levels; ++i) {
+        level_sizes[i]     = gpu_get_tex_level_size(info->format, width, height);
+        texture->levels[i] = chain;
+        chain  += level_sizes[i];
+        width   = width  > 1 ? width  >> 1 : 1;
+        height  = height > 1 ? height >> 1 : 1;
+    }
+    return tex_streamer_add_texture(&rs->streamer, info->width, info->height, info->mip_levels, level_sizes);
+}
+int renderer_stream_texture_ktx2(Renderer_Texture_Streamer *rs, const char *path)
+{
+    u8 *file;
+    u64 size;
+    Image_Ktx2 ktx2;
+    Gpu_Tex_Info info;
+    if (!renderer_map_ktx2_texture(path, &file, &size, &ktx2, &info))
+        return -1;
+
+    // KTX2 levels need not be contiguous, so point at them one by one
+    int index = renderer_stream_texture(rs, file, &info);
+    if (index == -1) {
+        file_unmap(file, size);
+        return -1;
+    }
+    Renderer_Streamed_Texture *texture = &rs->textures[index];
+    for(u32 i = 0; i < info.mip_levels; ++i)
+        texture->levels[i] = file + ktx2.levels[i].offset;
+    texture->file      = file;
+    texture->file_size = size;
+    return index;
+}
 
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[2] += allocation_offsets[buffer_indices[3]];
+void renderer_set_texture_stream_materials(Renderer_Texture_Streamer *rs, Gltf *model, const int *image_textures)
+{
+    Gltf_Material *material = model->materials;
+    int material_count = gltf_material_get_count(model);
+    ASSERT(material_count <= rs->streamer.material_count, "Too many materials for the streamer");
+    for(int i = 0; i < material_count; ++i) {
+        int slots[TEX_STREAMER_MATERIAL_SLOTS] = {
+            material->base_color_texture_index,
+            material->metallic_roughness_texture_index,
+            material->normal_texture_index,
+            material->occlusion_texture_index,
+            material->emissive_texture_index,
+        };
+        for(int j = 0; j < TEX_STREAMER_MATERIAL_SLOTS; ++j) {
+            int image = slots[j] < 0 ? -1 : gltf_texture_by_index(model, slots[j])->source_image;
+            tex_streamer_set_material(&rs->streamer, i, j, image < 0 ? -1 : image_textures[image]);
+        }
+        material = (Gltf_Material*)((u8*)material + material->stride);
+    }
+}
+
+int renderer_get_texture_stream_instances(Gltf *model, Mat4 *node_transforms, Tex_Stream_Instance *ret)
+{
+    int count = 0;
+    Gltf_Node *node = model->nodes;
+    int node_count = gltf_node_get_count(model);
+    for(int i = 0; i < node_count; ++i) {
+        if (node->mesh < 0) {
+            node = (Gltf_Node*)((u8*)node + node->stride);
+            continue;
+        }
+        Gltf_Mesh *mesh = gltf_mesh_by_index(model, node->mesh);
+        Gltf_Mesh_Primitive *primitive = mesh->primitives;
+        for(int j = 0; j < mesh->primitive_count; ++j) {
+            Gltf_Accessor *position = gltf_accessor_by_index(model, primitive->position);
+            if (primitive->material < 0 || !position->min || !position->max) {
+                primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+                continue;
+            }
+            if (ret) {
+                Tex_Stream_Instance *instance = &ret[count];
+                float *min = position->min;
+                float *max = position->max;
+                Vec3 extent = get_vec3(max[0] - min[0], max[1] - min[1], max[2] - min[2]);
+                instance->transform = node_transforms[i];
+                instance->center    = get_vec3((min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f,
+                                               (min[2] + max[2]) * 0.5f);
+                instance->radius    = 0.5f * sqrtf(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+                instance->material  = primitive->material;
+
+                // How many times the texture repeats across the primitive: the wider of its uv ranges
+                instance->uv_scale = 1;
+                if (primitive->tex_coord_0 >= 0) {
+                    Gltf_Accessor *tex_coord = gltf_accessor_by_index(model, primitive->tex_coord_0);
+                    if (tex_coord->min && tex_coord->max) {
+                        float u = tex_coord->max[0] - tex_coord->min[0];
+                        float v = tex_coord->max[1] - tex_coord->min[1];
+                        float scale = u > v ? u : v;
+                        if (scale > 0)
+                            instance->uv_scale = scale;
+                    }
+                }
+            }
+            count++;
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        node = (Gltf_Node*)((u8*)node + node->stride);
+    }
+    return count;
+}
+
+static void renderer_retire_texture_memory(Renderer_Texture_Streamer *rs, VkImage image,
+                                           Gpu_Memory_Allocation *memory)
+{
+    // Out of room: wait for the oldest frames rather than free memory they might still read
+    if (rs->retired_count == RENDERER_TEX_STREAM_RETIRE_CAP) {
+        VkDevice device = get_gpu_instance()->vk_device;
+        vkDeviceWaitIdle(device);
+        for(int i = 0; i < rs->retired_count; ++i) {
+            Renderer_Retired_Image *retired = &rs->retired[i];
+            if (retired->image) {
+                vkDestroyImage(device, retired->image, ALLOCATION_CALLBACKS);
+                gpu_free_memory(&rs->image_memory, &retired->memory);
             } else {
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[2] += allocation_offsets[buffer_indices[3]];
+                gpu_free_memory(&rs->landing_memory, &retired->memory);
             }
-            if ((buffer_view_mask & (1 << buffer_indices[4])) == 0) {
-                buffer_view = gltf_buffer_view_by_index(model, buffer_indices[4]);
+        }
+        rs->retired_count = 0;
+    }
+    Renderer_Retired_Image *retired = &rs->retired[rs->retired_count++];
+    retired->image  = image;
+    retired->memory = *memory;
+    retired->frame  = rs->frame;
+}
+
+// Record the copy of 'texture' into a new image holding levels [resident, level_count): levels the old image has
+// are copied across, the rest come from the landing buffer. The old image and the landing are retired. Returns
+// false, with nothing recorded, if there is no memory for the new image.
+static bool renderer_replace_streamed_image(Renderer_Texture_Streamer *rs, int index, int resident, bool landed,
+                                            VkCommandBuffer cmd)
+{
+    VkDevice device = get_gpu_instance()->vk_device;
+    Renderer_Streamed_Texture *texture = &rs->textures[index];
+    Tex_Stream_Texture *stream = &rs->streamer.textures[index];
+    int level_count  = stream->level_count;
+    int old_resident = texture->first_level;
+
+    VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    image_info.imageType     = VK_IMAGE_TYPE_2D;
+    image_info.format        = texture->format;
+    image_info.extent        = {stream->width  >> resident ? stream->width  >> resident : 1,
+                                stream->height >> resident ? stream->height >> resident : 1, 1};
+    image_info.mipLevels     = level_count - resident;
+    image_info.arrayLayers   = 1;
+    image_info.samples       = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                               VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image;
+    if (vkCreateImage(device, &image_info, ALLOCATION_CALLBACKS, &image) != VK_SUCCESS) {
+        println("Failed to create image for streamed texture %u", (u32)index);
+        return false;
+    }
+    Gpu_Memory_Allocation memory;
+    if (!gpu_allocate_image_memory(device, &rs->image_memory, image, VK_IMAGE_TILING_OPTIMAL, &memory)) {
+        println("Failed to allocate memory for streamed texture %u", (u32)index);
+        vkDestroyImage(device, image, ALLOCATION_CALLBACKS);
+        return false;
+    }
+
+    // The old image was last sampled by the fragment shader; the landing was acquired at vertex input
+    VkImageMemoryBarrier2 barriers[2];
+    barriers[0] = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+    barriers[0].srcStageMask        = VK_PIPELINE_STAGE_2_NONE;
+    barriers[0].srcAccessMask       = VK_ACCESS_2_NONE;
+    barriers[0].dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barriers[0].dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barriers[0].oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[0].newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image               = image;
+    barriers[0].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, image_info.mipLevels, 0, 1};
+
+    barriers[1] = barriers[0];
+    barriers[1].srcStageMask     = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barriers[1].dstAccessMask    = VK_ACCESS_2_TRANSFER_READ_BIT;
+    barriers[1].oldLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[1].newLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[1].image            = texture->image;
+    barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, (u32)(level_count - old_resident), 0, 1};
+
+    VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = texture->image ? 2 : 1;
+    dependency.pImageMemoryBarriers    = barriers;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    // Levels both images have
+    int first = resident > old_resident ? resident : old_resident;
+    if (texture->image && first < level_count) {
+        VkImageCopy2 regions[TEX_STREAMER_MAX_LEVELS];
+        for(int i = first; i < level_count; ++i) {
+            u32 width  = stream->width  >> i ? stream->width  >> i : 1;
+            u32 height = stream->height >> i ? stream->height >> i : 1;
+            VkImageCopy2 *region = &regions[i - first];
+            *region = {VK_STRUCTURE_TYPE_IMAGE_COPY_2};
+            region->srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (u32)(i - old_resident), 0, 1};
+            region->dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (u32)(i - resident), 0, 1};
+            region->extent         = {width, height, 1};
+        }
+        VkCopyImageInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2};
+        copy_info.srcImage       = texture->image;
+        copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        copy_info.dstImage       = image;
+        copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copy_info.regionCount    = level_count - first;
+        copy_info.pRegions       = regions;
+        vkCmdCopyImage2(cmd, &copy_info);
+    }
+
+    // Levels [resident, first) were loaded, tightly packed in the landing
+    if (landed) {
+        VkBufferImageCopy2 regions[TEX_STREAMER_MAX_LEVELS];
+        u64 offset = texture->landing.offset;
+        for(int i = resident; i < first; ++i) {
+            u32 width  = stream->width  >> i ? stream->width  >> i : 1;
+            u32 height = stream->height >> i ? stream->height >> i : 1;
+            VkBufferImageCopy2 *region = &regions[i - resident];
+            *region = {VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2};
+            region->bufferOffset     = offset;
+            region->imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (u32)(i - resident), 0, 1};
+            region->imageExtent      = {width, height, 1};
+            offset += stream->level_sizes[i];
+        }
+        VkCopyBufferToImageInfo2 copy_info = {VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2};
+        copy_info.srcBuffer      = rs->landing_memory.blocks[texture->landing.block].buffer;
+        copy_info.dstImage       = image;
+        copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copy_info.regionCount    = first - resident;
+        copy_info.pRegions       = regions;
+        vkCmdCopyBufferToImage2(cmd, &copy_info);
+
+        renderer_retire_texture_memory(rs, VK_NULL_HANDLE, &texture->landing);
+        texture->landing = {};
+    }
 
-                ret.buffer_views[buffer_indices[4]].byte_length = buffer_view->byte_length;
-                ret.buffer_views[buffer_indices[4]].byte_offset = buffer_view->byte_offset;
+    barriers[0].srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barriers[0].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barriers[0].dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    barriers[0].oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[0].newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    dependency.imageMemoryBarrierCount = 1;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    if (texture->image)
+        renderer_retire_texture_memory(rs, texture->image, &texture->memory);
+    texture->image       = image;
+    texture->memory      = memory;
+    texture->first_level = resident;
+    texture->replaced    = true;
+    return true;
+}
 
-                ret.buffer_views[buffer_indices[4]].data =
-                    gpu_make_buf_allocation(
-                        allocators->vertex_allocator, 
-                        ret.buffer_views [buffer_indices[4]].byte_length,
-                        &allocation_offsets[buffer_indices[4]]);
+// Stage a load's levels through the transfer queue into a landing buffer. Returns false, with nothing queued, if
+// there is no room.
+static bool renderer_begin_streamed_load(Renderer_Texture_Streamer *rs, Tex_Stream_Load *load)
+{
+    VkDevice device = get_gpu_instance()->vk_device;
+    Renderer_Streamed_Texture *texture = &rs->textures[load->texture];
+    Tex_Stream_Texture *stream = &rs->streamer.textures[load->texture];
+    int level_count = stream->resident - load->level;
+
+    // Every level or none: a landing freed under a queued upload would be written after it is reused
+    Gpu_Staging_Uploader *uploader = &rs->transfer->uploader;
+    if (uploader->upload_cap - uploader->upload_count < level_count)
+        return false;
+
+    VkMemoryRequirements requirements = {};
+    requirements.size           = load->size;
+    requirements.alignment      = 16; // BC block size, and a multiple of every texel size
+    requirements.memoryTypeBits = 1 << rs->landing_memory.memory_type_index;
+    if (!gpu_allocate_memory(device, &rs->landing_memory, &requirements, SUBALLOCATION_KIND_LINEAR,
+                             &texture->landing))
+        return false;
+
+    VkBuffer buffer = rs->landing_memory.blocks[texture->landing.block].buffer;
+    u64 offset = texture->landing.offset;
+    for(int i = load->level; i < stream->resident; ++i) {
+        texture->ticket = gpu_transfer_enqueue(rs->transfer, buffer, offset, texture->levels[i],
+                                               stream->level_sizes[i]);
+        offset += stream->level_sizes[i];
+    }
+    return true;
+}
 
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[3] += allocation_offsets[buffer_indices[4]];
+void renderer_update_texture_streamer(Renderer_Texture_Streamer *rs, Tex_Stream_View *view, int instance_count,
+                                      Tex_Stream_Instance *instances, VkCommandBuffer cmd)
+{
+    VkDevice device = get_gpu_instance()->vk_device;
+    Tex_Streamer *streamer = &rs->streamer;
+    rs->frame++;
+    rs->wait_value = 0;
+
+    // Nothing retired 'frame_count' updates ago is still in flight
+    int kept = 0;
+    for(int i = 0; i < rs->retired_count; ++i) {
+        Renderer_Retired_Image *retired = &rs->retired[i];
+        if (rs->frame - retired->frame <= (u32)rs->frame_count) {
+            rs->retired[kept++] = *retired;
+        } else if (retired->image) {
+            vkDestroyImage(device, retired->image, ALLOCATION_CALLBACKS);
+            gpu_free_memory(&rs->image_memory, &retired->memory);
+        } else {
+            gpu_free_memory(&rs->landing_memory, &retired->memory);
+        }
+    }
+    rs->retired_count = kept;
+
+    for(int i = 0; i < streamer->texture_count; ++i)
+        rs->textures[i].replaced = false;
+
+    // Completed loads: acquire their landings, then make them resident. Uploads complete in order, so every load
+    // whose value is reached by the last one found is complete too.
+    u64 value;
+    for(int i = 0; i < streamer->texture_count; ++i) {
+        if (streamer->textures[i].pending == -1)
+            continue;
+        value = gpu_transfer_get_value(rs->transfer, rs->textures[i].ticket);
+        if (value > rs->wait_value && gpu_transfer_is_complete(device, rs->transfer, value))
+            rs->wait_value = value;
+    }
+    if (rs->wait_value) {
+        gpu_transfer_acquire(rs->transfer, cmd, rs->wait_value);
+
+        // The acquires (or the semaphore wait without them) finish at vertex input
+        VkMemoryBarrier2 barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+        barrier.srcStageMask  = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+        barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        VkDependencyInfo dependency = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        dependency.memoryBarrierCount = 1;
+        dependency.pMemoryBarriers    = &barrier;
+        vkCmdPipelineBarrier2(cmd, &dependency);
+
+        for(int i = 0; i < streamer->texture_count; ++i) {
+            if (streamer->textures[i].pending == -1)
+                continue;
+            value = gpu_transfer_get_value(rs->transfer, rs->textures[i].ticket);
+            if (value == 0 || value > rs->wait_value)
+                continue;
+            if (renderer_replace_streamed_image(rs, i, streamer->textures[i].pending, true, cmd)) {
+                tex_streamer_complete_load(streamer, i);
             } else {
-                // Point draw infos at the queued 'position' vertex allocation
-                ret.meshes[i].primitive_draw_infos[j].vertex_buffer_offsets[3] += allocation_offsets[buffer_indices[4]];
+                renderer_retire_texture_memory(rs, VK_NULL_HANDLE, &rs->textures[i].landing);
+                tex_streamer_cancel_load(streamer, i);
             }
+        }
+    }
 
-            // Mark buffer as having been queued for allocation
-            buffer_view_mask |= 1 << buffer_indices[0];
-            buffer_view_mask |= 1 << buffer_indices[1];
-            buffer_view_mask |= 1 << buffer_indices[2];
-            buffer_view_mask |= 1 << buffer_indices[3];
-            buffer_view_mask |= 1 << buffer_indices[4];
+    tex_streamer_update(streamer, view, instance_count, instances);
 
-            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
-        }
-        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    // Evictions have already been applied to the residency: the image only needs shrinking (failing that, the
+    // larger image is kept)
+    for(int i = 0; i < streamer->eviction_count; ++i) {
+        if (rs->textures[streamer->evictions[i].texture].image)
+            renderer_replace_streamed_image(rs, streamer->evictions[i].texture, streamer->evictions[i].resident,
+                                            false, cmd);
     }
 
-    ret.index_allocation_end  = allocators->index_allocator->used - ret.index_allocation_start;
-    ret.vertex_allocation_end = allocators->vertex_allocator->used - ret.vertex_allocation_start;
+    for(int i = 0; i < streamer->load_count; ++i) {
+        if (!renderer_begin_streamed_load(rs, &streamer->loads[i]))
+            tex_streamer_cancel_load(streamer, streamer->loads[i].texture);
+    }
+}
+// Where an accessor's elements can be read from: the gltf buffer, or temp for sparse accessors
+static const u8* renderer_get_accessor_data(Gltf *model, Gltf_Accessor *accessor, const u8 *gltf_buffer, int *stride) {
+    if (accessor->sparse_count > 0) {
+        int element_size = renderer_get_byte_stride(accessor->format);
+        u8 *tmp = (u8*)memory_allocate_temp((u64)accessor->count * element_size, 16);
+        gltf_resolve_sparse_accessor(model, accessor, element_size, gltf_buffer, tmp);
+        *stride = element_size;
+        return tmp;
+    }
+    Gltf_Buffer_View *gltf_view = gltf_buffer_view_by_index(model, accessor->buffer_view);
+    *stride = accessor->byte_stride;
+    return gltf_buffer + gltf_view->byte_offset + accessor->byte_offset;
+}
 
-    return ret;
+// Build into temp at the worst case size, then copy out to the draw info allocator at the real one
+static void renderer_build_meshlets(Renderer_Meshlets *dst, const u32 *indices, int index_count, const u8 *positions,
+                                    int position_stride, int vertex_count, Linear_Allocator *draw_info_allocator)
+{
+    u64 mark = get_mark_temp();
+    int bound = mesh_build_meshlets_bound(index_count, MESH_MESHLET_MAX_VERTICES, MESH_MESHLET_MAX_TRIANGLES);
+    Mesh_Meshlet *meshlets = (Mesh_Meshlet*)memory_allocate_temp(sizeof(Mesh_Meshlet) * bound, 4);
+    u32 *vertices = (u32*)memory_allocate_temp(sizeof(u32) * bound * MESH_MESHLET_MAX_VERTICES, 4);
+    u8 *triangles = (u8*)memory_allocate_temp(bound * MESH_MESHLET_MAX_TRIANGLES * 3, 1);
+
+    int meshlet_count = mesh_build_meshlets(meshlets, vertices, triangles, indices, index_count, vertex_count);
+    if (meshlet_count == 0) {
+        // No indices, or every triangle was degenerate
+        *dst = {};
+        reset_to_mark_temp(mark);
+        return;
+    }
+    dst->meshlet_count = meshlet_count;
+    Mesh_Meshlet *last = &meshlets[dst->meshlet_count - 1];
+    u64 vertex_total   = last->vertex_offset + last->vertex_count;
+    u64 triangle_total = last->triangle_offset + last->triangle_count * 3;
+
+    dst->meshlets  = (Mesh_Meshlet*)linear_allocator_allocate(
+                         draw_info_allocator, sizeof(Mesh_Meshlet) * dst->meshlet_count, 8);
+    dst->bounds    = (Mesh_Meshlet_Bounds*)linear_allocator_allocate(
+                         draw_info_allocator, sizeof(Mesh_Meshlet_Bounds) * dst->meshlet_count, 8);
+    dst->vertices  = (u32*)linear_allocator_allocate(draw_info_allocator, sizeof(u32) * vertex_total, 8);
+    dst->triangles = (u8*)linear_allocator_allocate(draw_info_allocator, triangle_total, 8);
+    memcpy(dst->meshlets, meshlets, sizeof(Mesh_Meshlet) * dst->meshlet_count);
+    memcpy(dst->vertices, vertices, sizeof(u32) * vertex_total);
+    memcpy(dst->triangles, triangles, triangle_total);
+
+    for(int i = 0; i < dst->meshlet_count; ++i)
+        dst->bounds[i] = mesh_compute_meshlet_bounds(&dst->meshlets[i], dst->vertices, dst->triangles,
+                                                     positions, position_stride);
+    reset_to_mark_temp(mark);
 }
 
-Renderer_Texture_Resources renderer_setup_textures_static_model(Gltf *model, Renderer_Gpu_Allocator_Group *allocators)
+// Simplify level after level, each from the last, writing them behind level 0 in the primitive's index
+// allocation. A level only knows the error relative to its parent, so errors are summed down the chain.
+static void renderer_generate_lods(Renderer_Interleaved_Primitive *interleaved, const u32 *indices, int index_count,
+                                   const float *positions, int vertex_count)
 {
-    return {};
+    u64 mark = get_mark_temp();
+    Renderer_Lods *lods = interleaved->lods;
+    int element_size = renderer_get_byte_stride(interleaved->index_format);
+    u32 capacity = (u32)index_count * RENDERER_LOD_INDEX_CAPACITY;
+
+    lods->lod_count = 1;
+    lods->first_indices[0] = 0;
+    lods->index_counts[0]  = index_count;
+    lods->errors[0]        = 0;
+
+    float extent = mesh_get_extent((const u8*)positions, sizeof(float) * 3, vertex_count);
+    u32 *level     = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u32 *optimized = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    memcpy(level, indices, sizeof(u32) * index_count);
+
+    u32 first = index_count;
+    int level_count = index_count;
+    int next_count;
+    float error = 0;
+    float level_error;
+    while(lods->lod_count < RENDERER_MAX_LOD_COUNT) {
+        next_count = mesh_simplify(level, level, level_count, (const u8*)positions, sizeof(float) * 3, vertex_count,
+                                   level_count / 2, RENDERER_LOD_MAX_ERROR, &level_error);
+        if (next_count == 0 || next_count == level_count || first + next_count > capacity)
+            break;
+
+        mesh_optimize_vertex_cache(optimized, level, next_count, vertex_count);
+        renderer_write_indices((u8*)interleaved->index_data + (u64)first * element_size, optimized, next_count,
+                               interleaved->index_format);
+
+        error += level_error * extent;
+        lods->first_indices[lods->lod_count] = first;
+        lods->index_counts [lods->lod_count] = next_count;
+        lods->errors       [lods->lod_count] = error;
+        lods->lod_count++;
+
+        first += next_count;
+        level_count = next_count;
+        memcpy(level, optimized, sizeof(u32) * next_count);
+    }
+    reset_to_mark_temp(mark);
+}
+
+int renderer_select_lod(Renderer_Lods *lods, float distance, float projection_scale, float max_pixel_error) {
+    return mesh_select_lod(lods->errors, lods->lod_count, distance, projection_scale, max_pixel_error);
+}
+
+// Cut u32 indices into ranges that fit u16 and write each relative to its vertex offset
+static void renderer_split_indices(Renderer_Index_Split *split, Gltf_Accessor *accessor, const u8 *src, u16 *dst,
+                                   Linear_Allocator *draw_info_allocator)
+{
+    ASSERT(accessor->format == GLTF_ACCESSOR_FORMAT_SCALAR_U32, "Only u32 indices are split");
+    const u32 *indices = (const u32*)src;
+
+    split->range_count = mesh_split_index_ranges(NULL, indices, accessor->count, 65536);
+    split->ranges = (Mesh_Index_Range*)linear_allocator_allocate(
+                        draw_info_allocator, sizeof(Mesh_Index_Range) * split->range_count, 8);
+    mesh_split_index_ranges(split->ranges, indices, accessor->count, 65536);
+
+    for(int i = 0; i < split->range_count; ++i)
+        mesh_narrow_indices_u16(dst + split->ranges[i].first_index, indices + split->ranges[i].first_index,
+                                split->ranges[i].index_count, split->ranges[i].vertex_offset);
+}
+
+// Deduplicate, then reorder for the post transform cache, overdraw and fetch (see mesh.hpp). 'streams' are the
+// primitive's encoded attributes and are swapped for reordered, tightly packed copies in temp; 'positions'
+// are the float vec3 positions before encoding. The indices are written to the primitive's own allocation.
+// Returns the new vertex count.
+static int renderer_optimize_interleaved_primitive(Gltf *model, Renderer_Interleaved_Primitive *interleaved,
+                                                   const u8 *gltf_buffer, Vertex_Stream *streams,
+                                                   const u8 *positions, int position_stride,
+                                                   Linear_Allocator *draw_info_allocator)
+{
+    Gltf_Accessor *accessor = gltf_accessor_by_index(model, interleaved->indices);
+    int index_count = accessor->count;
+
+    int src_stride;
+    const u8 *src = renderer_get_accessor_data(model, accessor, gltf_buffer, &src_stride);
+
+    u32 *indices   = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u32 *optimized = (u32*)memory_allocate_temp(sizeof(u32) * index_count, 4);
+    u32 *remap     = (u32*)memory_allocate_temp(sizeof(u32) * interleaved->count, 4);
+    renderer_read_indices(indices, src, src_stride, index_count, accessor->format);
+
+    interleaved->cache_before = mesh_analyze_vertex_cache(indices, index_count, interleaved->count);
+
+    // Duplicates are found on the encoded attributes, as that is what the gpu will read
+    int vertex_count = mesh_generate_vertex_remap(remap, indices, index_count, interleaved->count, 4, streams);
+    mesh_remap_indices(indices, indices, index_count, remap);
+
+    float *remapped_positions = (float*)memory_allocate_temp(sizeof(float) * 3 * vertex_count, 4);
+    mesh_remap_vertices((u8*)remapped_positions, positions, position_stride, sizeof(float) * 3,
+                        interleaved->count, remap);
+
+    mesh_optimize_vertex_cache(optimized, indices, index_count, vertex_count);
+    mesh_optimize_overdraw(indices, optimized, index_count, (const u8*)remapped_positions, sizeof(float) * 3,
+                           vertex_count, 1.05f);
+
+    // Fold the fetch order into the dedup remap, so that the attributes are only moved once
+    u32 *fetch = (u32*)memory_allocate_temp(sizeof(u32) * vertex_count, 4);
+    mesh_optimize_vertex_fetch_remap(fetch, indices, index_count, vertex_count);
+    mesh_remap_indices(indices, indices, index_count, fetch);
+    for(int i = 0; i < interleaved->count; ++i)
+        if (remap[i] != Max_u32)
+            remap[i] = fetch[remap[i]];
+
+    u8 *tmp;
+    for(int k = 0; k < 4; ++k) {
+        tmp = (u8*)memory_allocate_temp((u64)vertex_count * streams[k].size, 16);
+        mesh_remap_vertices(tmp, streams[k].src, streams[k].stride, streams[k].size, interleaved->count, remap);
+        streams[k].src    = tmp;
+        streams[k].stride = streams[k].size;
+    }
+    renderer_write_indices(interleaved->index_data, indices, index_count, interleaved->index_format);
+
+    // Meshlets and levels of detail index the vertices as they are drawn, so the positions are moved once more
+    if (interleaved->meshlets || interleaved->lods)
+        mesh_remap_vertices((u8*)remapped_positions, positions, position_stride, sizeof(float) * 3,
+                            interleaved->count, remap);
+    if (interleaved->meshlets)
+        renderer_build_meshlets(interleaved->meshlets, indices, index_count, (const u8*)remapped_positions,
+                                sizeof(float) * 3, vertex_count, draw_info_allocator);
+    if (interleaved->lods)
+        renderer_generate_lods(interleaved, indices, index_count, remapped_positions, vertex_count);
+
+    interleaved->cache_after     = mesh_analyze_vertex_cache(indices, index_count, vertex_count);
+    interleaved->optimized_count = vertex_count;
+    return vertex_count;
+}
+// Primitives are summed as transformed vertex counts (the stats' numerators), which finish divides back out
+static void renderer_add_optimize_stats(Gltf *model, Renderer_Interleaved_Primitive *interleaved,
+                                        Renderer_Optimize_Stats *stats) {
+    int triangle_count = gltf_accessor_by_index(model, interleaved->indices)->count / 3;
+    stats->primitive_count        += 1;
+    stats->triangle_count         += triangle_count;
+    stats->vertex_count           += interleaved->count;
+    stats->optimized_vertex_count += interleaved->optimized_count;
+    stats->cache_before.acmr      += interleaved->cache_before.acmr * triangle_count;
+    stats->cache_after.acmr       += interleaved->cache_after.acmr * triangle_count;
+}
+static void renderer_finish_optimize_stats(Renderer_Optimize_Stats *stats) {
+    if (!stats->triangle_count)
+        return;
+    float before = stats->cache_before.acmr;
+    float after  = stats->cache_after.acmr;
+    stats->cache_before = {before / stats->triangle_count, before / stats->vertex_count};
+    stats->cache_after  = {after / stats->triangle_count, after / stats->optimized_vertex_count};
 }
 // @Todo @Speed @MemoryAccess. Idk if this function can benefit from rejigging data, because it
 // seems that the buffer views already exist is the correct grouping. As in I dont think that I can
 // order the data in some way that I can do fewer memcpys using larger contiguous blocks.
-Renderer_Draws renderer_download_model_data(
-    Gltf *model, Renderer_Vertex_Attribute_Resources *list, const char *model_dir_path) {
-    Renderer_Draws ret = {
-        .mesh_count = list->mesh_count,
-        .meshes = list->meshes,
-    };
-
+// 'path' gets 'dir_path' followed by the uri of the model's (only) buffer
+static void renderer_get_buffer_path(Gltf *model, const char *dir_path, char *path, int path_size) {
     // @Note this system assumes that the gltf file use one bin buffer file
     ASSERT(gltf_buffer_get_count(model) == 1, "Too many gltf buffers");
-    u64 buffer_len = model->buffers->byte_length;
 
+    int dir_path_len = strlen(dir_path);
+    int uri_len = strlen(model->buffers->uri);
+    ASSERT(dir_path_len + uri_len < path_size, "Buffer path too long");
+    memcpy(path, dir_path, dir_path_len);
+    memcpy(path + dir_path_len, model->buffers->uri, uri_len);
+    path[uri_len + dir_path_len] = '\0';
+}
+
+Renderer_Draws renderer_download_model_data(
+    Gltf *model, Renderer_Vertex_Attribute_Resources *list, const char *model_dir_path) {
     char model_path[127];
-    int dir_path_len = strlen(model_dir_path);
-    memcpy(model_path, model_dir_path, dir_path_len);
+    renderer_get_buffer_path(model, model_dir_path, model_path, sizeof(model_path));
 
-    int uri_len = strlen(model->buffers->uri);
-    memcpy(model_path + dir_path_len, model->buffers->uri, uri_len);
-    model_path[uri_len + dir_path_len] = '\0';
+    // Only the range the resources use is read; the buffer is addressed from the start of the file
+    u64 mark = get_mark_temp();
+    const u8 *range = file_read_bin_temp_range(model_path, list->buffer_read_start,
+                                               list->buffer_read_end - list->buffer_read_start);
+    Renderer_Draws ret = renderer_download_model_data_from_buffer(model, list, range - list->buffer_read_start);
+    reset_to_mark_temp(mark);
+    return ret;
+}
 
+Renderer_Draws renderer_download_model_data_from_buffer(
+    Gltf *model, Renderer_Vertex_Attribute_Resources *list, const u8 *gltf_buffer) {
+    Renderer_Draws ret = {
+        .mesh_count = list->mesh_count,
+        .meshes = list->meshes,
+        .resident_count = list->resident_count,
+        .resident_keys = list->resident_keys,
+        .allocation_count = list->device_allocation_count,
+        .allocations = list->device_allocations,
+    };
     u64 mark = get_mark_temp();
-    const u8 *gltf_buffer = file_read_bin_temp_large(model_path, buffer_len);
-    
+
     // Allocations already made in gpu linear allocators by 'setup_model_resources()'; the pointers 
     // ('list->data') being copied into point to the corresponding allocation for the buffer view.
     Renderer_Buffer_View *buffer_view;
     for(int i = 0; i < list->buffer_view_count; ++i) {
         buffer_view = &list->buffer_views[i];
+        if (!buffer_view->data) // resident, uploaded by another model
+            continue;
         memcpy(buffer_view->data, gltf_buffer + buffer_view->byte_offset, buffer_view->byte_length);
     }
 
+    // Resolved accessors are converted as they are copied, straight from the gltf buffer into the gpu
+    // allocation. Only an accessor which is both sparse and encoded is resolved through temp first.
+    Renderer_Resolved_Accessor *resolved;
+    Gltf_Accessor *accessor;
+    Gltf_Buffer_View *gltf_view;
+    const u8 *src;
+    int src_stride;
+    int element_size;
+    for(int i = 0; i < list->resolved_accessor_count; ++i) {
+        resolved = &list->resolved_accessors[i];
+        accessor = gltf_accessor_by_index(model, resolved->accessor);
+        element_size = renderer_get_byte_stride(accessor->format);
+
+        if (accessor->sparse_count > 0) {
+            if (resolved->encoding == RENDERER_VERTEX_ENCODING_NONE) {
+                gltf_resolve_sparse_accessor(model, accessor, element_size, gltf_buffer, (u8*)resolved->data);
+                continue;
+            }
+            u8 *tmp = (u8*)memory_allocate_temp((u64)accessor->count * element_size, 16);
+            gltf_resolve_sparse_accessor(model, accessor, element_size, gltf_buffer, tmp);
+            src = tmp;
+            src_stride = element_size;
+        } else {
+            gltf_view = gltf_buffer_view_by_index(model, accessor->buffer_view);
+            src = gltf_buffer + gltf_view->byte_offset + accessor->byte_offset;
+            src_stride = accessor->byte_stride;
+        }
+
+        ASSERT(resolved->encoding != RENDERER_VERTEX_ENCODING_NONE, "Only sparse accessors are resolved without an encoding");
+        if (resolved->split) {
+            renderer_split_indices(resolved->split, accessor, src, (u16*)resolved->data, list->draw_info_allocator);
+            continue;
+        }
+        renderer_encode_accessor(accessor, resolved->encoding, src, src_stride, resolved->data, resolved->dequantize);
+    }
+
+    // Interleaved attributes are read from the gltf buffer where they can be, otherwise they are encoded
+    // (or sparse resolved) into temp first, then all four are transposed into the gpu allocation.
+    Renderer_Interleaved_Primitive *interleaved;
+    Vertex_Stream streams[4];
+    Renderer_Vertex_Encoding encoding;
+    int encoded_size;
+    u64 primitive_mark;
+    const u8 *positions;
+    int position_stride;
+    int vertex_count;
+    for(int i = 0; i < list->interleaved_count; ++i) {
+        interleaved = &list->interleaved[i];
+        primitive_mark = get_mark_temp();
+        positions = NULL;
+        position_stride = 0;
+        for(int k = 0; k < 4; ++k) {
+            accessor = gltf_accessor_by_index(model, interleaved->accessors[k]);
+            encoding = interleaved->encodings[k];
+            element_size = renderer_get_byte_stride(accessor->format);
+            renderer_get_encoded_format(encoding, accessor->format, &encoded_size);
+
+            if (accessor->sparse_count > 0) {
+                u8 *tmp = (u8*)memory_allocate_temp((u64)accessor->count * element_size, 16);
+                gltf_resolve_sparse_accessor(model, accessor, element_size, gltf_buffer, tmp);
+                src = tmp;
+                src_stride = element_size;
+            } else {
+                gltf_view = gltf_buffer_view_by_index(model, accessor->buffer_view);
+                src = gltf_buffer + gltf_view->byte_offset + accessor->byte_offset;
+                src_stride = accessor->byte_stride;
+            }
+            if (k == 0) { // overdraw optimization wants the float positions, not the encoded ones
+                positions = src;
+                position_stride = src_stride;
+            }
+            if (encoding != RENDERER_VERTEX_ENCODING_NONE) {
+                u8 *tmp = (u8*)memory_allocate_temp((u64)accessor->count * encoded_size, 16);
+                renderer_encode_accessor(accessor, encoding, src, src_stride, tmp, interleaved->dequantize);
+                src = tmp;
+                src_stride = encoded_size;
+            }
+            streams[k] = {src, src_stride, encoded_size, interleaved->offsets[k]};
+        }
+
+        vertex_count = interleaved->count;
+        if (interleaved->index_data) {
+            vertex_count = renderer_optimize_interleaved_primitive(model, interleaved, gltf_buffer, streams,
+                                                                   positions, position_stride,
+                                                                   list->draw_info_allocator);
+            renderer_add_optimize_stats(model, interleaved, &ret.optimize_stats);
+        }
+        vertex_interleave((u8*)interleaved->data, interleaved->stride, vertex_count, 4, streams);
+
+        // The position stream is one more transpose out of whatever the positions were read from
+        if (interleaved->position_data) {
+            streams[0].offset = 0;
+            vertex_interleave((u8*)interleaved->position_data, streams[0].size, vertex_count, 1, streams);
+        }
+        reset_to_mark_temp(primitive_mark);
+    }
+    renderer_finish_optimize_stats(&ret.optimize_stats);
+
+    // Meshlets of primitives which were not optimized are built from the gltf data as it is
+    Gltf_Mesh *mesh = model->meshes;
+    Gltf_Mesh_Primitive *primitive;
+    Renderer_Meshlets *meshlets;
+    Gltf_Accessor *position_accessor;
+    for(int i = 0; i < list->mesh_count; ++i) {
+        primitive = mesh->primitives;
+        for(int j = 0; list->meshes[i].primitive_meshlets && j < mesh->primitive_count; ++j) {
+            meshlets = &list->meshes[i].primitive_meshlets[j];
+            if (!meshlets->meshlets) {
+                primitive_mark = get_mark_temp();
+                accessor = gltf_accessor_by_index(model, primitive->indices);
+                position_accessor = gltf_accessor_by_index(model, primitive->position);
+                ASSERT(position_accessor->format == GLTF_ACCESSOR_FORMAT_VEC3_FLOAT32,
+                       "Meshlet bounds need float positions");
+
+                u32 *indices = (u32*)memory_allocate_temp(sizeof(u32) * accessor->count, 4);
+                src = renderer_get_accessor_data(model, accessor, gltf_buffer, &src_stride);
+                renderer_read_indices(indices, src, src_stride, accessor->count, accessor->format);
+
+                src = renderer_get_accessor_data(model, position_accessor, gltf_buffer, &src_stride);
+                renderer_build_meshlets(meshlets, indices, accessor->count, src, src_stride, position_accessor->count,
+                                        list->draw_info_allocator);
+                reset_to_mark_temp(primitive_mark);
+            }
+            primitive = (Gltf_Mesh_Primitive*)((u8*)primitive + primitive->stride);
+        }
+        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
+    }
+
     // @Note I could flush the memory range here, to make sure that these memcpys are all visible,
     // but for now I am just assuming that there is no need, because Nvidia, Intel and AMD drivers
     // have for a while had coherent memory for device local.
     reset_to_mark_temp(mark);
     return ret;
 }
+// `Scene
+static constexpr int RENDERER_SCENE_PATH_SIZE = 127;
+
+// Copy [start, start + size) of the host allocation into the same offsets of the device allocation, merging
+// it into the last region when the two abut. Returns the region count.
+static int renderer_add_scene_copy_region(VkBufferCopy2 *regions, int region_count, u64 start, u64 size) {
+    if (size == 0)
+        return region_count;
+    if (region_count > 0 && regions[region_count - 1].srcOffset + regions[region_count - 1].size == start) {
+        regions[region_count - 1].size += size;
+        return region_count;
+    }
+    regions[region_count] = {VK_STRUCTURE_TYPE_BUFFER_COPY_2};
+    regions[region_count].srcOffset = start;
+    regions[region_count].dstOffset = start;
+    regions[region_count].size      = size;
+    return region_count + 1;
+}
+
+// Add a model's allocation range as one region per block it covers. 'regions' has 'region_cap' regions per
+// block, 'region_counts' one count per block.
+static void renderer_add_scene_copy_range(Gpu_Buf_Allocator *allocator, VkBufferCopy2 *regions, int *region_counts,
+                                          int region_cap, int start_block, u64 start, int end_block, u64 end)
+{
+    u64 block_start, block_end;
+    for(int i = start_block; i <= end_block; ++i) {
+        block_start = i == start_block ? start : 0;
+        block_end   = i == end_block   ? end   : allocator->block_used[i];
+        region_counts[i] = renderer_add_scene_copy_region(regions + region_cap * i, region_counts[i],
+                                                          block_start, block_end - block_start);
+    }
+}
+
+// One copy per block with regions. Returns the copy count.
+static int renderer_setup_scene_copies(Gpu_Buf_Allocator *to_allocator, Gpu_Buf_Allocator *from_allocator,
+                                       VkBufferCopy2 *regions, int *region_counts, int region_cap,
+                                       VkCopyBufferInfo2 *copy_infos, VkBuffer *copy_buffers)
+{
+    // Uma: the models were set up straight into device memory
+    if (to_allocator == from_allocator)
+        return 0;
+
+    int copy_count = 0;
+    VkBufferCopy2 *block_regions;
+    for(int i = 0; i < from_allocator->block_count; ++i) {
+        if (region_counts[i] == 0)
+            continue;
+
+        // The draw infos hold host blocks and offsets, so the device allocation must sit at the same ones
+        gpu_buf_allocator_mirror_block(to_allocator, from_allocator, i);
+        block_regions = regions + region_cap * i;
+        for(int j = 0; j < region_counts[i]; ++j) {
+            ASSERT(to_allocator->used <= block_regions[j].dstOffset, "Device allocator is ahead of the host allocator");
+            to_allocator->used = block_regions[j].dstOffset;
+            gpu_make_buf_allocation(to_allocator, block_regions[j].size, NULL);
+        }
+        ASSERT(to_allocator->block == i, "Device block is smaller than the host block");
+
+        copy_infos[copy_count] = {VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2};
+        copy_infos[copy_count].srcBuffer   = from_allocator->block_bufs[i];
+        copy_infos[copy_count].dstBuffer   = to_allocator->block_bufs[i];
+        copy_infos[copy_count].regionCount = region_counts[i];
+        copy_infos[copy_count].pRegions    = block_regions;
+        copy_buffers[copy_count] = to_allocator->block_bufs[i];
+        copy_count++;
+    }
+    return copy_count;
+}
+
+// With device memory: one copy per pair of staging and device memory blocks, holding the regions of every model
+// staged in the one and allocated in the other. 'copies' are the models'. Returns the copy count.
+static int renderer_setup_scene_device_copies(Renderer_Gpu_Allocator_Group *allocators, int model_count,
+                                              int *copy_counts, Renderer_Device_Copy **copies,
+                                              VkCopyBufferInfo2 *copy_infos, VkBuffer *copy_buffers)
+{
+    int region_count = 0;
+    for(int i = 0; i < model_count; ++i)
+        region_count += copy_counts[i];
+    VkBufferCopy2 *regions = (VkBufferCopy2*)memory_allocate_temp(sizeof(VkBufferCopy2) * region_count, 8);
+
+    Gpu_Memory_Allocator *memory = allocators->device_memory;
+    Gpu_Buf_Allocator *host;
+    Renderer_Device_Copy *copy;
+    int first_region;
+    int copy_count = 0;
+    region_count = 0;
+    for(u32 destination = RENDERER_VIEW_DESTINATION_INDEX; destination <= RENDERER_VIEW_DESTINATION_VERTEX;
+        ++destination)
+    {
+        host = destination == RENDERER_VIEW_DESTINATION_INDEX ?
+                   allocators->index_allocator : allocators->vertex_allocator;
+        for(int i = 0; i < host->block_count; ++i)
+            for(int j = 0; j < memory->block_count; ++j) {
+                first_region = region_count;
+                for(int k = 0; k < model_count; ++k)
+                    for(int l = 0; l < copy_counts[k]; ++l) {
+                        copy = &copies[k][l];
+                        if (copy->destination != destination || copy->host_block != i || copy->device_block != j)
+                            continue;
+                        regions[region_count] = {VK_STRUCTURE_TYPE_BUFFER_COPY_2};
+                        regions[region_count].srcOffset = copy->host_offset;
+                        regions[region_count].dstOffset = copy->device_offset;
+                        regions[region_count].size      = copy->size;
+                        region_count++;
+                    }
+                if (region_count == first_region)
+                    continue;
+
+                copy_infos[copy_count] = {VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2};
+                copy_infos[copy_count].srcBuffer   = host->block_bufs[i];
+                copy_infos[copy_count].dstBuffer   = memory->blocks[j].buffer;
+                copy_infos[copy_count].regionCount = region_count - first_region;
+                copy_infos[copy_count].pRegions    = regions + first_region;
+                copy_buffers[copy_count] = memory->blocks[j].buffer;
+                copy_count++;
+            }
+    }
+    return copy_count;
+}
+
+Renderer_Scene renderer_load_scene(
+    int model_count, Renderer_Scene_Model_Info *infos, Renderer_Gpu_Allocator_Group *allocators,
+    Gpu_Buf_Allocator *device_index_allocator, Gpu_Buf_Allocator *device_vertex_allocator,
+    Renderer_Vertex_Layout layout, Renderer_Model_Flags flags, Renderer_Residency_Table *residency)
+{
+    /* Method:
+
+       1. Load every model and find the part of its buffer file it reads.
+       2. Group the models by buffer file and read the range covering all of a file's models once. Set up and
+          download each model of the group out of it; setup hashes the views against the residency table, so
+          content already uploaded (by this scene or an earlier one) gets no allocation.
+       3. Models are set up into the same allocators one after another, so their allocation ranges mostly abut:
+          merge them into one copy per allocator block. With device memory, every allocation has its own place
+          there instead: the staged ones become one copy per pair of staging and device memory blocks.
+    */
+    Renderer_Scene ret = {};
+    ret.model_count = model_count;
+    ret.residency = residency;
+    ret.device_memory = allocators->device_memory;
+    ret.models = (Gltf_Baked*)linear_allocator_allocate(
+                     allocators->draw_info_allocator, sizeof(Gltf_Baked) * model_count, 8);
+    ret.draws = (Renderer_Draws*)linear_allocator_allocate(
+                    allocators->draw_info_allocator, sizeof(Renderer_Draws) * model_count, 8);
+
+    ret.vertex_state_infos =
+        (Gpu_Vertex_Input_State***)memory_allocate_temp(sizeof(Gpu_Vertex_Input_State**) * model_count, 8);
+    ret.position_state_infos = NULL;
+    if (layout == RENDERER_VERTEX_LAYOUT_INTERLEAVED_POSITION_STREAM)
+        ret.position_state_infos =
+            (Gpu_Vertex_Input_State***)memory_allocate_temp(sizeof(Gpu_Vertex_Input_State**) * model_count, 8);
+
+    // A model adds at most one region to each block
+    u64 region_size = sizeof(VkBufferCopy2) * model_count * GPU_BUF_ALLOCATOR_MAX_BLOCKS;
+    VkBufferCopy2 *index_regions  = (VkBufferCopy2*)memory_allocate_temp(region_size, 8);
+    VkBufferCopy2 *vertex_regions = (VkBufferCopy2*)memory_allocate_temp(region_size, 8);
+    int index_region_counts [GPU_BUF_ALLOCATOR_MAX_BLOCKS] = {};
+    int vertex_region_counts[GPU_BUF_ALLOCATOR_MAX_BLOCKS] = {};
+    // With device memory, the models' own copies are gathered instead
+    int *device_copy_counts = (int*)memory_allocate_temp(sizeof(int) * model_count, 4);
+    Renderer_Device_Copy **device_copies =
+        (Renderer_Device_Copy**)memory_allocate_temp(sizeof(Renderer_Device_Copy*) * model_count, 8);
+
+    // Only needed until download is done, but setup results are allocated after it so it stays until the
+    // caller resets temp
+    char *paths       = (char*)memory_allocate_temp(RENDERER_SCENE_PATH_SIZE * model_count, 1);
+    u64  *read_ranges = (u64*)memory_allocate_temp(sizeof(u64) * 2 * model_count, 8);
+    bool *loaded      = (bool*)memory_allocate_temp(sizeof(bool) * model_count, 1);
+    memset(loaded, 0, sizeof(bool) * model_count);
+
+    for(int i = 0; i < model_count; ++i) {
+        ret.models[i] = gltf_load_or_bake(infos[i].gltf_file_name, infos[i].bake_file_name);
+        renderer_get_buffer_path(&ret.models[i].gltf, infos[i].dir_path, paths + RENDERER_SCENE_PATH_SIZE * i,
+                                 RENDERER_SCENE_PATH_SIZE);
+        renderer_get_read_range(&ret.models[i].gltf, &read_ranges[i * 2], &read_ranges[i * 2 + 1]);
+    }
+
+    char *path;
+    u64 start, end;
+    const u8 *range;
+    Renderer_Vertex_Attribute_Resources list;
+    for(int i = 0; i < model_count; ++i) {
+        if (loaded[i])
+            continue;
+        path = paths + RENDERER_SCENE_PATH_SIZE * i;
+
+        start = Max_u64;
+        end   = 0;
+        for(int j = i; j < model_count; ++j) {
+            if (strcmp(paths + RENDERER_SCENE_PATH_SIZE * j, path) != 0)
+                continue;
+            if (read_ranges[j * 2] < start)
+                start = read_ranges[j * 2];
+            if (read_ranges[j * 2 + 1] > end)
+                end = read_ranges[j * 2 + 1];
+        }
+
+        // Heap, as the setup results that come after it in temp outlive it
+        range = end > start ? file_read_bin_heap_range(path, start, end - start) : NULL;
+        for(int j = i; j < model_count; ++j) {
+            if (strcmp(paths + RENDERER_SCENE_PATH_SIZE * j, path) != 0)
+                continue;
+            list = renderer_setup_vertex_attribute_resources_static_model(
+                       &ret.models[j].gltf, allocators, layout, flags, residency, range - start);
+            ret.draws[j] = renderer_download_model_data_from_buffer(&ret.models[j].gltf, &list, range - start);
+            loaded[j] = true;
+
+            ret.vertex_state_infos[j] = list.vertex_state_infos;
+            if (ret.position_state_infos)
+                ret.position_state_infos[j] = list.position_state_infos;
+
+            device_copy_counts[j] = list.device_copy_count;
+            device_copies[j]      = list.device_copies;
+            if (ret.device_memory)
+                continue;
+
+            renderer_add_scene_copy_range(allocators->index_allocator, index_regions, index_region_counts,
+                                          model_count, list.index_allocation_start_block,
+                                          list.index_allocation_start, list.index_allocation_end_block,
+                                          list.index_allocation_end);
+            renderer_add_scene_copy_range(allocators->vertex_allocator, vertex_regions, vertex_region_counts,
+                                          model_count, list.vertex_allocation_start_block,
+                                          list.vertex_allocation_start, list.vertex_allocation_end_block,
+                                          list.vertex_allocation_end);
+        }
+        if (range)
+            memory_free_heap((void*)range);
+    }
+
+    if (ret.device_memory) {
+        int copy_cap = GPU_BUF_ALLOCATOR_MAX_BLOCKS * GPU_MEMORY_ALLOCATOR_MAX_BLOCKS * 2;
+        ret.copy_infos   = (VkCopyBufferInfo2*)memory_allocate_temp(sizeof(VkCopyBufferInfo2) * copy_cap, 8);
+        ret.copy_buffers = (VkBuffer*)memory_allocate_temp(sizeof(VkBuffer) * copy_cap, 8);
+        ret.copy_count   = renderer_setup_scene_device_copies(allocators, model_count, device_copy_counts,
+                                                              device_copies, ret.copy_infos, ret.copy_buffers);
+        return ret;
+    }
+
+    ret.copy_infos = (VkCopyBufferInfo2*)memory_allocate_temp(
+                         sizeof(VkCopyBufferInfo2) * GPU_BUF_ALLOCATOR_MAX_BLOCKS * 2, 8);
+    ret.copy_buffers = (VkBuffer*)memory_allocate_temp(sizeof(VkBuffer) * GPU_BUF_ALLOCATOR_MAX_BLOCKS * 2, 8);
+    ret.copy_count = renderer_setup_scene_copies(device_index_allocator, allocators->index_allocator,
+                                                 index_regions, index_region_counts, model_count,
+                                                 ret.copy_infos, ret.copy_buffers);
+    ret.copy_count += renderer_setup_scene_copies(device_vertex_allocator, allocators->vertex_allocator,
+                                                  vertex_regions, vertex_region_counts, model_count,
+                                                  ret.copy_infos + ret.copy_count, ret.copy_buffers + ret.copy_count);
+    return ret;
+}
+
+void renderer_unload_scene(Renderer_Scene *scene) {
+    for(int i = 0; i < scene->model_count; ++i) {
+        if (scene->residency)
+            renderer_release_resident(scene->residency, &scene->draws[i], scene->device_memory);
+        for(int j = 0; j < scene->draws[i].allocation_count; ++j)
+            gpu_free_memory(scene->device_memory, &scene->draws[i].allocations[j]);
+        scene->draws[i].allocation_count = 0;
+        gltf_unload_baked(&scene->models[i]);
+    }
+    scene->model_count = 0;
+}
+
 Gpu_Vertex_Input_State renderer_define_vertex_input_state_static_model(
     Gltf_Mesh_Primitive *mesh_primitive, Gltf *model)
 {
     Gpu_Vertex_Input_State state = {};
-    // Enough memory for each array field in 'state' (5 int pointers for 4 bindings)
-    int *memory_block = (int*)memory_allocate_temp(sizeof(int) * 5 * 4, 4); // @Todo dont just use 4, set this dynamically with max == supported attribute count
+    // Enough memory for each array field in 'state' (6 int pointers for 4 bindings)
+    int *memory_block = (int*)memory_allocate_temp(sizeof(int) * 6 * 4, 4); // @Todo dont just use 4, set this dynamically with max == supported attribute count
     state.binding_description_bindings    = memory_block;
     state.binding_description_strides     = memory_block + 4;
     state.attribute_description_locations = memory_block + 8;
     state.attribute_description_bindings  = memory_block + 12;
-    state.formats = (VkFormat*)(memory_block + 16);
+    state.attribute_description_offsets   = memory_block + 16;
+    state.formats = (VkFormat*)(memory_block + 20);
+    memset(state.attribute_description_offsets, 0, sizeof(int) * 4);
 
     // @Todo account for varying attribute count
-    // @Todo account for sparse accessors (replace the correct vertices at draw time)
+    // Sparse accessors are resolved into tightly packed allocations of their own, see renderer_download_model_data()
     state.topology = (VkPrimitiveTopology)mesh_primitive->topology;
 
     // pos, norm, tang, tex_coord_0
@@ -339,19 +2354,49 @@ Gpu_Vertex_Input_State renderer_define_vertex_input_state_static_model(
 
     // position
     state.formats[0] = (VkFormat)accessors[0]->format;
-    state.binding_description_strides     [0] = accessors[0]->byte_stride;
+    state.binding_description_strides     [0] = accessors[0]->sparse_count > 0 ?
+        renderer_get_byte_stride(accessors[0]->format) : accessors[0]->byte_stride;
 
     // normal
     state.formats[1] = (VkFormat)accessors[1]->format;
-    state.binding_description_strides     [1] = accessors[1]->byte_stride;
+    state.binding_description_strides     [1] = accessors[1]->sparse_count > 0 ?
+        renderer_get_byte_stride(accessors[1]->format) : accessors[1]->byte_stride;
 
     // tangent
     state.formats[2] = (VkFormat)accessors[2]->format;
-    state.binding_description_strides     [2] = accessors[2]->byte_stride;
+    state.binding_description_strides     [2] = accessors[2]->sparse_count > 0 ?
+        renderer_get_byte_stride(accessors[2]->format) : accessors[2]->byte_stride;
 
     // tex_coord_0
     state.formats[3] = (VkFormat)accessors[3]->format;
-    state.binding_description_strides     [3] = accessors[3]->byte_stride;
+    state.binding_description_strides     [3] = accessors[3]->sparse_count > 0 ?
+        renderer_get_byte_stride(accessors[3]->format) : accessors[3]->byte_stride;
+
+    return state;
+}
+
+Gpu_Vertex_Input_State renderer_define_vertex_input_state_position_stream(
+    Gltf_Mesh_Primitive *mesh_primitive, VkFormat format, int stride)
+{
+    Gpu_Vertex_Input_State state = {};
+    int *memory_block = (int*)memory_allocate_temp(sizeof(int) * 6, 4);
+    state.binding_description_bindings    = memory_block;
+    state.binding_description_strides     = memory_block + 1;
+    state.attribute_description_locations = memory_block + 2;
+    state.attribute_description_bindings  = memory_block + 3;
+    state.attribute_description_offsets   = memory_block + 4;
+    state.formats = (VkFormat*)(memory_block + 5);
+
+    state.topology = (VkPrimitiveTopology)mesh_primitive->topology;
+    state.input_binding_description_count   = 1;
+    state.input_attribute_description_count = 1;
+
+    state.binding_description_bindings   [0] = 0;
+    state.binding_description_strides    [0] = stride;
+    state.attribute_description_locations[0] = 0;
+    state.attribute_description_bindings [0] = 0;
+    state.attribute_description_offsets  [0] = 0;
+    state.formats[0] = format;
 
     return state;
 }
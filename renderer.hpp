@@ -5,6 +5,9 @@
 #include "gpu.hpp"
 #include "gltf.hpp"
 #include "string.hpp"
+#include "vertex.hpp"
+#include "mesh.hpp"
+#include "tex_streamer.hpp"
 
 struct Renderer_Gpu_Allocator_Group {
     Linear_Allocator  *draw_info_allocator;
@@ -12,58 +15,411 @@ struct Renderer_Gpu_Allocator_Group {
     Gpu_Buf_Allocator *vertex_allocator;
     Gpu_Buf_Allocator *uniform_allocator;
     Gpu_Tex_Allocator *tex_allocator;
+    // Optional: index and vertex data gets allocations of its own in here (see renderer_create_vertex_memory()),
+    // which the draw infos point at, so that models can be freed one at a time and the memory defragmented. The
+    // index and vertex allocators then only stage it (and not at all if the memory is host visible).
+    Gpu_Memory_Allocator *device_memory;
 };
 
 // @Todo Renderer_Draw_Info_Skinned
 
+// A primitive with more vertices than 16 bit indices reach, drawn as one vkCmdDrawIndexed per range
+struct Renderer_Index_Split {
+    int range_count;
+    Mesh_Index_Range *ranges; // filled in at download
+};
 struct Renderer_Draw_Info_Static {
     int draw_count;
+    VkIndexType index_type;
+    Renderer_Index_Split *index_split; // NULL unless split, see renderer_setup_vertex_attribute_resources_static_model
+    int vertex_buffer_count; // 4 separate attributes, or 1 interleaved stream
     u64 index_buffer_offset;
-    u64 vertex_buffer_offsets[4]; // position, normal, tangent, tex_coord_0
+    u64 vertex_buffer_offsets[4]; // position, normal, tangent, tex_coord_0 (or just the interleaved stream)
+    u64 position_buffer_offset; // position only stream for depth passes, see Renderer_Vertex_Layout
+    // The Gpu_Buf_Allocator blocks the offsets are in: bind the device allocator's 'block_bufs' of these. With
+    // device memory they are its blocks instead: bind their 'buffer'.
+    int index_buffer_block;
+    int vertex_buffer_blocks[4];
+    int position_buffer_block;
+    Vertex_Dequantize *position_dequantize; // NULL unless positions were quantized
+};
+// Clusters of a primitive's triangles for culling, see mesh.hpp. The vertices are the primitive's vertex
+// indices as drawn (after any optimization).
+struct Renderer_Meshlets {
+    int meshlet_count;
+    Mesh_Meshlet *meshlets;
+    Mesh_Meshlet_Bounds *bounds;
+    u32 *vertices;
+    u8 *triangles;
+};
+// Levels of detail share the primitive's vertices. Their indices follow one another in the primitive's index
+// allocation: level i is 'index_counts[i]' indices from 'first_indices[i]' (counted from
+// Renderer_Draw_Info_Static::index_buffer_offset). Level 0 is the full primitive.
+static constexpr int RENDERER_MAX_LOD_COUNT = 6;
+struct Renderer_Lods {
+    int lod_count;
+    u32 first_indices[RENDERER_MAX_LOD_COUNT];
+    u32 index_counts[RENDERER_MAX_LOD_COUNT];
+    float errors[RENDERER_MAX_LOD_COUNT]; // object space bound on how far the surface moved, increasing
 };
 struct Renderer_Mesh {
     int primitive_count;
     Renderer_Draw_Info_Static *primitive_draw_infos;
+    Renderer_Meshlets *primitive_meshlets; // NULL without RENDERER_MODEL_BUILD_MESHLETS_BIT, filled in at download
+    Renderer_Lods *primitive_lods; // NULL without RENDERER_MODEL_GENERATE_LODS_BIT, filled in at download
+};
+// The post transform cache over a model's optimized primitives, as if they were one mesh: ACMR is weighted by
+// triangles and ATVR by vertices. All zero if nothing was optimized (RENDERER_MODEL_OPTIMIZE_MESHES_BIT).
+struct Renderer_Optimize_Stats {
+    int primitive_count;
+    int triangle_count;
+    int vertex_count;           // before deduplication
+    int optimized_vertex_count; // after
+    Mesh_Cache_Stats cache_before;
+    Mesh_Cache_Stats cache_after;
 };
 struct Renderer_Draws {
     int mesh_count;
     Renderer_Mesh *meshes;
+
+    int resident_count;
+    u64 *resident_keys; // the residency entries this model holds a reference to, see Renderer_Residency_Table
+
+    // With device memory, the allocations the model owns: everything but its resident copies, which belong to
+    // their residency entry
+    int allocation_count;
+    Gpu_Memory_Allocation *allocations; // points into the draw info allocator
+
+    Renderer_Optimize_Stats optimize_stats; // filled in at download
 };
+// A range of the gltf buffer copied as it is: one buffer view, or several neighbouring ones coalesced
 struct Renderer_Buffer_View {
     u64 byte_length;
     u64 byte_offset;
     void *data;
 };
+// How an accessor's elements are written to the gpu. Anything other than NONE (and sparse accessors) gets a
+// tightly packed allocation of its own, written as the model data is downloaded.
+enum Renderer_Vertex_Encoding {
+    RENDERER_VERTEX_ENCODING_NONE          = 0, // as in the gltf buffer
+    RENDERER_VERTEX_ENCODING_UNORM_FLOAT32 = 1, // normalized u8/u16 to float32
+    RENDERER_VERTEX_ENCODING_FLOAT16       = 2, // float32 vec2/vec4 to float16
+    RENDERER_VERTEX_ENCODING_OCTAHEDRAL    = 3, // float32 vec3 normal to two snorm16
+    RENDERER_VERTEX_ENCODING_SNORM16       = 4, // float32 vec3 position to four snorm16, see Vertex_Dequantize
+    RENDERER_VERTEX_ENCODING_INDEX_U16     = 5, // u8 or u32 indices to u16 (per range when split)
+};
+struct Renderer_Resolved_Accessor {
+    int accessor;
+    Renderer_Vertex_Encoding encoding;
+    void *data; // gpu allocation the resolved elements are written to
+    Vertex_Dequantize *dequantize; // SNORM16 only, points into the draw info allocator
+    Renderer_Index_Split *split; // INDEX_U16 of a split primitive only, points into the draw info allocator
+};
+enum Renderer_Vertex_Layout {
+    RENDERER_VERTEX_LAYOUT_SEPARATE    = 0, // a binding per attribute, like the gltf buffer views
+    RENDERER_VERTEX_LAYOUT_INTERLEAVED = 1, // one binding, the attributes of a vertex side by side
+    RENDERER_VERTEX_LAYOUT_INTERLEAVED_POSITION_STREAM = 2, // plus a position only binding for depth passes
+};
+// Transposed from the primitive's attribute accessors (after encoding) at download time
+struct Renderer_Interleaved_Primitive {
+    int count;
+    int stride;
+    int accessors[4]; // position, normal, tangent, tex_coord_0
+    int offsets[4];
+    Renderer_Vertex_Encoding encodings[4];
+    void *data;
+    void *position_data; // NULL without a position stream
+    Vertex_Dequantize *dequantize; // position encoded as SNORM16 only
+
+    // Optimized primitives get a copy of their indices, rewritten for the reordered and deduplicated vertices
+    int indices;
+    Gltf_Accessor_Format index_format; // SCALAR_U16 or SCALAR_U32
+    void *index_data; // NULL unless optimized
+    Renderer_Meshlets *meshlets; // NULL unless built, which optimized primitives do from their rewritten data
+    Renderer_Lods *lods; // NULL unless generated
+
+    // Filled by download for optimized primitives and summed into Renderer_Draws::optimize_stats: the post
+    // transform cache before and after, and the vertex count left by deduplication
+    Mesh_Cache_Stats cache_before;
+    Mesh_Cache_Stats cache_after;
+    int optimized_count;
+};
+// Buffer view copies shared between models by content, so that a prop referenced by many gltf files is uploaded
+// once. Entries are keyed by the wyhash of the copied bytes (seeded with the destination) and hold the copy's
+// offset in the index or vertex allocator (or in device memory, whose allocation the entry then owns). A hit
+// must match the copy's length and destination as well; copies that collide with an entry of another length or
+// destination are uploaded unshared. Equal-length 64 bit collisions are not worth a compare against the resident
+// bytes.
+struct Renderer_Residency_Entry {
+    u64 key;
+    u64 size; // zero when the slot has never been used
+    u64 offset;
+    int block; // of the allocator, see Gpu_Buf_Allocator
+    u32 ref_count; // zero when the entry was released (the slot can be reused)
+    u32 destination; // 1 index, 2 vertex
+    u32 handle; // of the device memory allocation, see Gpu_Memory_Allocation
+};
+struct Renderer_Residency_Table {
+    int capacity; // power of two
+    int count;
+    Renderer_Residency_Entry *entries; // Heap allocated
+};
+Renderer_Residency_Table renderer_create_residency_table(int capacity);
+void renderer_destroy_residency_table(Renderer_Residency_Table *table);
+// Returns NULL if no model holds the key
+Renderer_Residency_Entry* renderer_find_resident(Renderer_Residency_Table *table, u64 key);
+// Drop the model's references. Returns how many entries were released: their allocations are no longer used by
+// any model. They are freed if they are in 'device_memory'; the linear gpu allocators only get the space back
+// when they are reset.
+int renderer_release_resident(Renderer_Residency_Table *table, Renderer_Draws *draws,
+                              Gpu_Memory_Allocator *device_memory = NULL);
+
+// Device memory for index and vertex data (Renderer_Gpu_Allocator_Group::device_memory), with block buffers
+// which can be bound as either and defragmented. It is host visible under uma, so that data is written in place.
+Gpu_Memory_Allocator renderer_create_vertex_memory(u64 block_size, int block_allocation_cap);
+// Repoint the draw infos, allocations and residency entries (if 'residency' is not NULL) whose data a
+// Gpu_Defragmenter of 'device_memory' moved, see gpu_defrag_complete()
+void renderer_apply_defrag_moves(int draw_count, Renderer_Draws *draws, Renderer_Residency_Table *residency,
+                                 Gpu_Memory_Allocator *device_memory, int move_count, Gpu_Defrag_Move *moves);
+
+// Staged index or vertex data to copy into its device memory allocation
+struct Renderer_Device_Copy {
+    u32 destination; // 1 index, 2 vertex: which host allocator it is staged in
+    int host_block;
+    u64 host_offset;
+    int device_block;
+    u64 device_offset;
+    u64 size;
+};
+
 struct Renderer_Vertex_Attribute_Resources {
-    int buffer_view_count;
+    int buffer_view_count; // copies, after coalescing
     int mesh_count;
-    Renderer_Buffer_View *buffer_views;
+    Renderer_Buffer_View *buffer_views; // Temp allocated
+
+    int resolved_accessor_count;
+    Renderer_Resolved_Accessor *resolved_accessors; // Temp allocated
 
-    // Buffer areas to sync for transfer
+    int interleaved_count;
+    Renderer_Interleaved_Primitive *interleaved; // Temp allocated
+
+    // Buffer areas to sync for transfer: from the start offset in the start block to the end offset in the end
+    // block, taking in the whole used part of any block in between
     u64 index_allocation_start;
     u64 index_allocation_end;
     u64 vertex_allocation_start;
     u64 vertex_allocation_end;
+    int index_allocation_start_block;
+    int index_allocation_end_block;
+    int vertex_allocation_start_block;
+    int vertex_allocation_end_block;
+
+    // The part of the gltf buffer that download reads
+    u64 buffer_read_start;
+    u64 buffer_read_end;
+
+    // Copies found in the residency table get no allocation and have NULL data
+    int resident_count;
+    u64 *resident_keys; // points into the draw info allocator
+
+    // With device memory: the model's allocations (see Renderer_Draws), and the copies of whatever was staged
+    int device_allocation_count;
+    Gpu_Memory_Allocation *device_allocations; // points into the draw info allocator
+    int device_copy_count;
+    Renderer_Device_Copy *device_copies; // Temp allocated
 
     Renderer_Mesh *meshes;
+    Linear_Allocator *draw_info_allocator; // index split ranges are only known at download
     Gpu_Vertex_Input_State **vertex_state_infos; // Temp allocated
+    Gpu_Vertex_Input_State **position_state_infos; // Temp allocated, NULL without a position stream
 };
+// Per gltf image: its image in the texture allocator, VK_NULL_HANDLE if it could not be loaded. The images made
+// are allocations [allocation_first, allocation_first + allocation_count), to pass to gpu_cmd_tex_allocator_upload().
 struct Renderer_Texture_Resources {
     u32 texture_count;
-    VkImage *textures;
-    u64 *offsets;
+    VkImage *textures; // Draw info allocator
+    u64 *offsets;      // Draw info allocator, staging offsets of the mip chains
+    u32 *decode_us;    // Draw info allocator, time to decode and build the mip chain (0 for KTX2 or on failure)
+    u32 decode_job_count;   // images decoded on the job threads, failures included
+    u32 decode_retry_count; // decodes rerun with more scratch, see image_decode_jobs()
+    u32 allocation_first;
+    u32 allocation_count;
+};
+
+enum Renderer_Model_Flag_Bits {
+    // Encode float positions as snorm16 (see Renderer_Draw_Info_Static::position_dequantize), normals as
+    // octahedral snorm16, and tangents and tex coords as float16; shaders must decode the first two.
+    RENDERER_MODEL_QUANTIZE_VERTICES_BIT = 0x01,
+    // Interleaved layouts only: deduplicate vertices and reorder triangles and vertices for the post transform
+    // cache, overdraw and fetch as the data is downloaded, see mesh.hpp.
+    RENDERER_MODEL_OPTIMIZE_MESHES_BIT   = 0x02,
+    // Narrow the indices of primitives with more vertices than u16 reaches too, splitting them into ranges
+    // (Renderer_Index_Split).
+    RENDERER_MODEL_SPLIT_INDICES_BIT     = 0x04,
+    // Fill Renderer_Mesh::primitive_meshlets
+    RENDERER_MODEL_BUILD_MESHLETS_BIT    = 0x08,
+    // Requires RENDERER_MODEL_OPTIMIZE_MESHES_BIT: simplify each primitive into a chain of levels of detail,
+    // each about half the triangles of the last (Renderer_Mesh::primitive_lods)
+    RENDERER_MODEL_GENERATE_LODS_BIT     = 0x10,
+    // Textures only: block compress to BC7 (BC5 for normal maps, whose z shaders must reconstruct), if the device
+    // samples BCn at all
+    RENDERER_MODEL_COMPRESS_TEXTURES_BIT = 0x20,
 };
+typedef u32 Renderer_Model_Flags;
 
-// Get list of required resources from gltf model
+// Get list of required resources from gltf model. Normalized u8/u16 attributes are always converted to float.
+// 'layout' chooses between a binding per attribute and interleaved vertices; vertex_state_infos match it.
+// Indices are narrowed to u16 whenever the primitive has few enough vertices (u8 indices are always widened);
+// Renderer_Draw_Info_Static::index_type says which to bind.
+// With a residency table, buffer view copies whose content is already resident are pointed at the existing
+// allocation; 'gltf_buffer' (addressed like renderer_download_model_data_from_buffer()'s) must then hold the
+// bytes to hash, see renderer_get_read_range().
 Renderer_Vertex_Attribute_Resources renderer_setup_vertex_attribute_resources_static_model(
-    Gltf *model, Renderer_Gpu_Allocator_Group *allocators);
+    Gltf *model, Renderer_Gpu_Allocator_Group *allocators,
+    Renderer_Vertex_Layout layout = RENDERER_VERTEX_LAYOUT_SEPARATE, Renderer_Model_Flags flags = 0x0,
+    Renderer_Residency_Table *residency = NULL, const u8 *gltf_buffer = NULL);
+// The part of the gltf buffer that setup and download read, available before setup
+void renderer_get_read_range(Gltf *model, u64 *start, u64 *end);
+// Decode every image the gltf references by uri (relative to 'model_dir_path'), in parallel on every core, build
+// its full mip chain and stage it in allocators->tex_allocator. Base color and emissive images are sRGB; the rest are linear.
+// KTX2 images (.ktx2 uris) are staged as stored, mips and format included, without decoding; their format must be
+// R8G8B8A8, BCn or ASTC LDR (see gpu_tex_format_is_supported()), other files are skipped.
+// @Todo images in buffer views
 Renderer_Texture_Resources renderer_setup_textures_static_model(
-    Gltf *model, Renderer_Gpu_Allocator_Group *allocators);
+    Gltf *model, Renderer_Gpu_Allocator_Group *allocators, const char *model_dir_path, Renderer_Model_Flags flags = 0x0);
+
+// A virtual texture streamed from a tile file (see vt_build_tile_file()). The file stays mapped, and tiles are
+// copied from the mapping straight into staging, at most 'tiles_per_frame' a frame.
+static constexpr int RENDERER_VT_REQUEST_CAP = 1024;
+
+struct Renderer_Virtual_Texture {
+    Virtual_Texture vt;
+    Gpu_Virtual_Texture gpu;
+    Vt_Tile_File tiles;
+    u8 *file;
+    u64 file_size;
+    int streamed; // tiles streamed in by the last update
+};
+// The pool ('pool_width' x 'pool_height' slots of VT_TILE_SLOT_SIZE texels) is what is resident, however large
+// the texture. Returns false if the file is not a tile file or its format cannot be sampled.
+bool renderer_create_virtual_texture(const char *tile_file_path, u32 pool_width, u32 pool_height,
+                                     u32 feedback_count, int tiles_per_frame, int frame_count,
+                                     Renderer_Virtual_Texture *ret);
+void renderer_destroy_virtual_texture(Renderer_Virtual_Texture *rvt);
+// Once the fence of 'frame' has been waited on: read back the feedback it wrote, map and stream in the pages it
+// asked for (as many as the pool and the tile budget allow) and record the uploads into 'cmd', ahead of the draws.
+// Record gpu_cmd_vt_feedback_barrier() after them.
+void renderer_update_virtual_texture(Renderer_Virtual_Texture *rvt, int frame, VkCommandBuffer cmd);
+
+// Mip streaming for whole textures (see Tex_Streamer). A streamed texture's image holds only its resident levels,
+// [resident, level_count) of the full chain, so it is sampled like any other texture: its base is just coarser.
+// When levels come in or go out the image is replaced by one of the new size, the levels kept being copied across
+// on the gpu, and the old image is destroyed once the frames which might sample it are done. Loads are uploaded
+// on the transfer queue into a landing buffer and copied into the new image by the graphics queue.
+// The sources stay on the cpu: KTX2 files stay mapped, other chains belong to the caller.
+static constexpr int RENDERER_TEX_STREAM_RETIRE_CAP = 64;
+
+struct Renderer_Streamed_Texture {
+    VkImage image; // VK_NULL_HANDLE until the tail is loaded
+    Gpu_Memory_Allocation memory;
+    VkFormat format;
+    int first_level; // of the full chain, at the image's level 0
+    bool replaced; // 'image' changed in the last update: rewrite its descriptors
+    const u8 *levels[TEX_STREAMER_MAX_LEVELS];
+    u8 *file; // KTX2 mapping, NULL if the caller owns the chain
+    u64 file_size;
+
+    // The pending load's
+    Gpu_Memory_Allocation landing;
+    u64 ticket;
+};
+struct Renderer_Retired_Image {
+    VkImage image; // VK_NULL_HANDLE for a landing buffer allocation
+    Gpu_Memory_Allocation memory;
+    u32 frame;
+};
+struct Renderer_Texture_Streamer {
+    Tex_Streamer streamer;
+    Renderer_Streamed_Texture *textures; // Heap allocated, texture_cap
+    Gpu_Memory_Allocator image_memory;
+    Gpu_Memory_Allocator landing_memory;
+    Gpu_Transfer_Queue *transfer;
+    int frame_count;
+    u32 frame;
+    u64 wait_value; // for the submission of the last update's 'cmd', see gpu_transfer_get_wait_info(), 0 if none
+
+    int retired_count;
+    Renderer_Retired_Image retired[RENDERER_TEX_STREAM_RETIRE_CAP];
+};
+Renderer_Texture_Streamer renderer_create_texture_streamer(Gpu_Transfer_Queue *transfer, u64 budget, int texture_cap,
+                                                           int material_count, int frame_count);
+void renderer_destroy_texture_streamer(Renderer_Texture_Streamer *rs);
+// Stream a KTX2 file's levels (as renderer_setup_textures_static_model() would load them). Returns the texture's
+// index, or -1 if the file cannot be copied as it is.
+int renderer_stream_texture_ktx2(Renderer_Texture_Streamer *rs, const char *path);
+// Stream a tightly packed chain of 'info->mip_levels' levels, which must outlive the streamer
+int renderer_stream_texture(Renderer_Texture_Streamer *rs, const u8 *chain, Gpu_Tex_Info *info);
+// Point the model's materials at the streamed textures: 'image_textures' gives each gltf image's texture index,
+// -1 if the image is not streamed
+void renderer_set_texture_stream_materials(Renderer_Texture_Streamer *rs, Gltf *model, const int *image_textures);
+// An instance per mesh primitive, bounded by its position accessor's min and max. 'node_transforms' are the world
+// transforms of the model's nodes, which the caller resolves. Returns the count; only counts if 'ret' is NULL.
+int renderer_get_texture_stream_instances(Gltf *model, Mat4 *node_transforms, Tex_Stream_Instance *ret);
+// Once per frame, after the fence of the frame 'frame_count' ago has been waited on: finish the loads the transfer
+// queue has completed, decide the frame's loads and evictions, and record the image copies into 'cmd', ahead of
+// the draws. The submission of 'cmd' must wait on 'wait_value' if it is not 0. Submit the transfer queue after.
+void renderer_update_texture_streamer(Renderer_Texture_Streamer *rs, Tex_Stream_View *view, int instance_count,
+                                      Tex_Stream_Instance *instances, VkCommandBuffer cmd);
 Renderer_Draws renderer_download_model_data(
     Gltf *model, Renderer_Vertex_Attribute_Resources *list, const char *model_dir_path);
+// Download from a buffer the caller has already read: 'gltf_buffer' is addressed like the whole gltf buffer, but
+// only [list->buffer_read_start, list->buffer_read_end) is read.
+Renderer_Draws renderer_download_model_data_from_buffer(
+    Gltf *model, Renderer_Vertex_Attribute_Resources *list, const u8 *gltf_buffer);
+
+// A scene is many models loaded as a batch: they are set up into the same allocators, each buffer file is read
+// once (one range covering every model using it), and the host to device copies of the whole scene are merged
+// into one copy per allocator block. With a residency table, content shared with other models is only uploaded once.
+struct Renderer_Scene_Model_Info {
+    const char *gltf_file_name;
+    const char *bake_file_name;
+    const char *dir_path; // buffer uris are relative to this, trailing '/' included
+};
+struct Renderer_Scene {
+    int model_count;
+    Gltf_Baked *models; // points into the draw info allocator, as do the draws
+    Renderer_Draws *draws;
+    Renderer_Residency_Table *residency; // NULL unless given, released from on unload
+    Gpu_Memory_Allocator *device_memory; // NULL unless the allocator group has it, freed from on unload
+    Gpu_Vertex_Input_State ***vertex_state_infos; // Temp allocated, per model as in the resource list
+    Gpu_Vertex_Input_State ***position_state_infos; // Temp allocated, NULL without a position stream
+
+    // One per index and vertex block used (per staging and device memory block pair with device memory); record
+    // them all with gpu_cmd_begin_buf_transfer_graphics() for one submit. 'copy_buffers' are the destinations, for
+    // Gpu_Buffer_Copy_Info::buffers. None with uma, where the host allocators are the device allocators (and
+    // device memory is host visible).
+    int copy_count;
+    VkCopyBufferInfo2 *copy_infos; // Temp allocated, as are the regions
+    VkBuffer *copy_buffers; // Temp allocated
+};
+// 'allocators' are the host allocators the models are set up in. Device blocks and offsets are kept equal to
+// host ones, so the draw infos hold for both. With device memory in 'allocators', the device allocators are not
+// used and may be NULL.
+Renderer_Scene renderer_load_scene(
+    int model_count, Renderer_Scene_Model_Info *infos, Renderer_Gpu_Allocator_Group *allocators,
+    Gpu_Buf_Allocator *device_index_allocator, Gpu_Buf_Allocator *device_vertex_allocator,
+    Renderer_Vertex_Layout layout = RENDERER_VERTEX_LAYOUT_SEPARATE, Renderer_Model_Flags flags = 0x0,
+    Renderer_Residency_Table *residency = NULL);
+void renderer_unload_scene(Renderer_Scene *scene);
 
 // Pl_Stage_1
+// Level to draw at 'distance' from the camera, see mesh_select_lod()
+int renderer_select_lod(Renderer_Lods *lods, float distance, float projection_scale, float max_pixel_error);
+
 Gpu_Vertex_Input_State renderer_define_vertex_input_state_static_model(Gltf_Mesh_Primitive *mesh_primitive, Gltf *model);
+// Position only, binding 0 location 0, for depth passes over RENDERER_VERTEX_LAYOUT_INTERLEAVED_POSITION_STREAM
+Gpu_Vertex_Input_State renderer_define_vertex_input_state_position_stream(
+    Gltf_Mesh_Primitive *mesh_primitive, VkFormat format, int stride);
 
 // Pl_Stage_2
 Gpu_Rasterization_State renderer_define_rasterization_state(Gpu_Polygon_Mode_Flags polygon_mode_flags = GPU_POLYGON_MODE_FILL_BIT, VkCullModeFlags cull_mode_flags = VK_CULL_MODE_FRONT_BIT);
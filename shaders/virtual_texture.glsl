@@ -0,0 +1,56 @@
+// Virtual texture lookup and feedback, the shader half of virtual_texture.hpp (the encodings must match it).
+// Declare before including:
+//     readonly buffer ... { uint vt_page_table[]; };  - Gpu_Virtual_Texture::page_table
+//     buffer ... { uint vt_feedback[]; };             - gpu_vt_get_feedback_info()
+// The pool is sampled at its only level: filtering is bilinear within the level the page table gives.
+
+#define VT_TILE_SIZE      128.0
+#define VT_TILE_BORDER    4.0
+#define VT_TILE_SLOT_SIZE 136.0
+#define VT_NULL_FEEDBACK  0xffffffffu
+
+vec2 vt_get_level_size(vec2 size, int level) {
+    return max(floor(size / exp2(float(level))), vec2(1.0));
+}
+
+uint vt_get_page_index(vec2 size, int level, uvec2 tile) {
+    uint first = 0;
+    for(int l = 0; l < level; ++l) {
+        uvec2 tiles = uvec2(ceil(vt_get_level_size(size, l) / VT_TILE_SIZE));
+        first += tiles.x * tiles.y;
+    }
+    uint tiles_x = uint(ceil(vt_get_level_size(size, level).x / VT_TILE_SIZE));
+    return first + tile.y * tiles_x + tile.x;
+}
+
+uvec2 vt_get_tile(vec2 size, int level, vec2 uv) {
+    vec2 tiles = ceil(vt_get_level_size(size, level) / VT_TILE_SIZE);
+    return uvec2(clamp(floor(uv * tiles), vec2(0.0), tiles - 1.0));
+}
+
+// 'size' is the texture's in texels at level 0, 'pool_size' the pool image's. 'feedback' gets the page wanted.
+vec4 vt_sample(sampler2D pool, vec2 uv, vec2 size, vec2 pool_size, int level_count, out uint feedback) {
+    uv = fract(uv);
+    vec2 dx = dFdx(uv * size);
+    vec2 dy = dFdy(uv * size);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    int level = clamp(int(lod), 0, level_count - 1);
+
+    uvec2 tile = vt_get_tile(size, level, uv);
+    feedback = (uint(level) << 28) | (tile.y << 14) | tile.x;
+
+    // The entry may point at an ancestor: find uv within that level's tile
+    uint entry  = vt_page_table[vt_get_page_index(size, level, tile)];
+    uvec2 slot  = uvec2(entry & 0xfffu, (entry >> 12) & 0xfffu);
+    int mapped  = int(entry >> 24);
+    vec2 texel  = uv * vt_get_level_size(size, mapped) - vec2(vt_get_tile(size, mapped, uv)) * VT_TILE_SIZE;
+    vec2 pooled = vec2(slot) * VT_TILE_SLOT_SIZE + VT_TILE_BORDER + texel;
+    return textureLod(pool, pooled / pool_size, 0.0);
+}
+
+// One fragment in each 'scale' x 'scale' block writes, into a feedback image 'width' wide
+void vt_write_feedback(uint feedback, uint width, uint scale) {
+    uvec2 coord = uvec2(gl_FragCoord.xy);
+    if (coord.x % scale == 0 && coord.y % scale == 0)
+        vt_feedback[(coord.y / scale) * width + coord.x / scale] = feedback;
+}
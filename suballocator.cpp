@@ -0,0 +1,617 @@
+#include "suballocator.hpp"
+#include <immintrin.h>
+
+#if TEST
+#include "test.hpp"
+#endif
+
+// Sizes below 2^(SL_LOG2 + 4) are one class per 16 bytes (first level 0); above, each power of two is cut into
+// SL_COUNT classes
+static inline void suballocator_mapping(u64 size, int *fl, int *sl) {
+    if (size < ((u64)SUBALLOCATOR_SL_COUNT << 4)) {
+        *fl = 0;
+        *sl = (int)(size >> 4);
+        return;
+    }
+    int msb = 63 - (int)_lzcnt_u64(size);
+    *fl = msb - (SUBALLOCATOR_SL_LOG2 + 4) + 1;
+    *sl = (int)(size >> (msb - SUBALLOCATOR_SL_LOG2)) - SUBALLOCATOR_SL_COUNT;
+}
+
+// The class whose every block is at least 'size': round up to the next class boundary first
+static inline void suballocator_mapping_search(u64 size, int *fl, int *sl) {
+    if (size >= ((u64)SUBALLOCATOR_SL_COUNT << 4))
+        size += ((u64)1 << (63 - (int)_lzcnt_u64(size) - SUBALLOCATOR_SL_LOG2)) - 1;
+    suballocator_mapping(size, fl, sl);
+}
+
+static void suballocator_insert_free(Suballocator *alloc, u32 index) {
+    Suballocator_Block *block = &alloc->blocks[index];
+    int fl, sl;
+    suballocator_mapping(block->size, &fl, &sl);
+
+    block->free = true;
+    block->prev_free = SUBALLOCATOR_NULL_BLOCK;
+    block->next_free = alloc->free_lists[fl][sl];
+    if (block->next_free != SUBALLOCATOR_NULL_BLOCK)
+        alloc->blocks[block->next_free].prev_free = index;
+    alloc->free_lists[fl][sl] = index;
+
+    alloc->fl_bitmap      |= (u64)1 << fl;
+    alloc->sl_bitmaps[fl] |= 1 << sl;
+}
+
+static void suballocator_remove_free(Suballocator *alloc, u32 index) {
+    Suballocator_Block *block = &alloc->blocks[index];
+    int fl, sl;
+    suballocator_mapping(block->size, &fl, &sl);
+
+    if (block->prev_free != SUBALLOCATOR_NULL_BLOCK)
+        alloc->blocks[block->prev_free].next_free = block->next_free;
+    else
+        alloc->free_lists[fl][sl] = block->next_free;
+    if (block->next_free != SUBALLOCATOR_NULL_BLOCK)
+        alloc->blocks[block->next_free].prev_free = block->prev_free;
+
+    if (alloc->free_lists[fl][sl] == SUBALLOCATOR_NULL_BLOCK) {
+        alloc->sl_bitmaps[fl] &= ~(1 << sl);
+        if (!alloc->sl_bitmaps[fl])
+            alloc->fl_bitmap &= ~((u64)1 << fl);
+    }
+    block->free = false;
+}
+
+static u32 suballocator_get_record(Suballocator *alloc) {
+    u32 ret = alloc->unused_records;
+    ASSERT(ret != SUBALLOCATOR_NULL_BLOCK, "Suballocator block records exhausted");
+    alloc->unused_records = alloc->blocks[ret].next_free;
+    return ret;
+}
+static void suballocator_put_record(Suballocator *alloc, u32 index) {
+    alloc->blocks[index].next_free = alloc->unused_records;
+    alloc->unused_records = index;
+}
+
+// Cut 'size' bytes off the front of 'index' into a new block, which takes its place in the physical list
+static u32 suballocator_split_front(Suballocator *alloc, u32 index, u64 size) {
+    u32 front = suballocator_get_record(alloc);
+    Suballocator_Block *block = &alloc->blocks[index];
+    Suballocator_Block *ret   = &alloc->blocks[front];
+
+    ret->offset = block->offset;
+    ret->size   = size;
+    ret->prev_physical = block->prev_physical;
+    ret->next_physical = index;
+    if (block->prev_physical != SUBALLOCATOR_NULL_BLOCK)
+        alloc->blocks[block->prev_physical].next_physical = front;
+    else
+        alloc->first_physical = front;
+
+    block->offset += size;
+    block->size   -= size;
+    block->prev_physical = front;
+    return front;
+}
+
+// Absorb the physical successor 'next' into 'index'
+static void suballocator_merge_next(Suballocator *alloc, u32 index, u32 next) {
+    Suballocator_Block *block = &alloc->blocks[index];
+    Suballocator_Block *absorbed = &alloc->blocks[next];
+
+    block->size += absorbed->size;
+    block->next_physical = absorbed->next_physical;
+    if (absorbed->next_physical != SUBALLOCATOR_NULL_BLOCK)
+        alloc->blocks[absorbed->next_physical].prev_physical = index;
+    suballocator_put_record(alloc, next);
+}
+
+Suballocator create_suballocator(u64 size, u64 granularity, int allocation_cap) {
+    ASSERT(size < ((u64)1 << SUBALLOCATOR_MAX_SIZE_LOG2), "Suballocator too large");
+    ASSERT(granularity && (granularity & (granularity - 1)) == 0, "Granularity must be a power of two");
+
+    Suballocator ret = {};
+    ret.size = size & ~(SUBALLOCATOR_MIN_ALIGNMENT - 1);
+    ret.granularity = granularity;
+    ret.allocation_cap = allocation_cap;
+
+    // Free blocks are always merged, so there is at most one more of them than there are allocations
+    ret.block_cap = allocation_cap * 2 + 1;
+    ret.blocks = (Suballocator_Block*)memory_allocate_heap(sizeof(Suballocator_Block) * ret.block_cap, 8);
+    reset_suballocator(&ret);
+    return ret;
+}
+void destroy_suballocator(Suballocator *alloc) {
+    memory_free_heap(alloc->blocks);
+    *alloc = {};
+}
+void reset_suballocator(Suballocator *alloc) {
+    alloc->used = 0;
+    alloc->allocation_count = 0;
+    alloc->fl_bitmap = 0;
+    memset(alloc->sl_bitmaps, 0, sizeof(alloc->sl_bitmaps));
+    memset(alloc->free_lists, 0xff, sizeof(alloc->free_lists));
+
+    for(u32 i = 0; i < alloc->block_cap; ++i)
+        alloc->blocks[i].next_free = i + 1 < alloc->block_cap ? i + 1 : SUBALLOCATOR_NULL_BLOCK;
+    alloc->unused_records = 0;
+    alloc->first_physical = SUBALLOCATOR_NULL_BLOCK;
+
+    if (alloc->size == 0)
+        return;
+    u32 index = suballocator_get_record(alloc);
+    alloc->first_physical = index;
+    alloc->blocks[index].offset = 0;
+    alloc->blocks[index].size   = alloc->size;
+    alloc->blocks[index].prev_physical = SUBALLOCATOR_NULL_BLOCK;
+    alloc->blocks[index].next_physical = SUBALLOCATOR_NULL_BLOCK;
+    suballocator_insert_free(alloc, index);
+}
+
+bool suballocator_allocate(Suballocator *alloc, u64 size, u64 alignment, Suballocation_Kind kind, Suballocation *ret) {
+    ASSERT(alignment && (alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+    if (alloc->allocation_count == alloc->allocation_cap)
+        return false;
+
+    if (alignment < SUBALLOCATOR_MIN_ALIGNMENT)
+        alignment = SUBALLOCATOR_MIN_ALIGNMENT;
+    size = align(size ? size : 1, SUBALLOCATOR_MIN_ALIGNMENT);
+    if (kind == SUBALLOCATION_KIND_OPTIMAL && alloc->granularity > SUBALLOCATOR_MIN_ALIGNMENT) {
+        if (alloc->granularity > alignment)
+            alignment = alloc->granularity;
+        size = align(size, alloc->granularity);
+    }
+
+    // Enough for the worst case padding: block offsets are always SUBALLOCATOR_MIN_ALIGNMENT aligned
+    u64 search_size = size + alignment - SUBALLOCATOR_MIN_ALIGNMENT;
+    if (search_size >= ((u64)1 << SUBALLOCATOR_MAX_SIZE_LOG2))
+        return false;
+
+    int fl, sl;
+    suballocator_mapping_search(search_size, &fl, &sl);
+    if (fl >= SUBALLOCATOR_FL_COUNT)
+        return false;
+
+    u32 sl_map = alloc->sl_bitmaps[fl] & (Max_u32 << sl);
+    if (!sl_map) {
+        u64 fl_map = alloc->fl_bitmap & (Max_u64 << (fl + 1));
+        if (!fl_map)
+            return false;
+        fl = (int)_tzcnt_u64(fl_map);
+        sl_map = alloc->sl_bitmaps[fl];
+    }
+    sl = (int)_tzcnt_u32(sl_map);
+
+    u32 index = alloc->free_lists[fl][sl];
+    suballocator_remove_free(alloc, index);
+
+    // The padding in front goes back as a free block of its own; its physical predecessor cannot be free (it
+    // would have been merged), so there is nothing to merge it with.
+    Suballocator_Block *block = &alloc->blocks[index];
+    u64 padding = align(block->offset, alignment) - block->offset;
+    if (padding) {
+        u32 front = suballocator_split_front(alloc, index, padding);
+        suballocator_insert_free(alloc, front);
+    }
+
+    // The same goes for the tail
+    block = &alloc->blocks[index];
+    if (block->size > size) {
+        u32 front = suballocator_split_front(alloc, index, size);
+        suballocator_insert_free(alloc, index);
+        index = front;
+    }
+
+    block = &alloc->blocks[index];
+    block->free = false;
+    alloc->used += block->size;
+    alloc->allocation_count++;
+
+    ret->offset = block->offset;
+    ret->size   = block->size;
+    ret->block  = index;
+    return true;
+}
+
+void suballocator_free(Suballocator *alloc, u32 index) {
+    Suballocator_Block *block = &alloc->blocks[index];
+    ASSERT(!block->free, "Double free");
+
+    alloc->used -= block->size;
+    alloc->allocation_count--;
+
+    u32 next = block->next_physical;
+    if (next != SUBALLOCATOR_NULL_BLOCK && alloc->blocks[next].free) {
+        suballocator_remove_free(alloc, next);
+        suballocator_merge_next(alloc, index, next);
+    }
+    u32 prev = alloc->blocks[index].prev_physical;
+    if (prev != SUBALLOCATOR_NULL_BLOCK && alloc->blocks[prev].free) {
+        suballocator_remove_free(alloc, prev);
+        suballocator_merge_next(alloc, prev, index);
+        index = prev;
+    }
+    suballocator_insert_free(alloc, index);
+}
+
+u64 suballocator_get_largest_free(Suballocator *alloc) {
+    if (!alloc->fl_bitmap)
+        return 0;
+    int fl = 63 - (int)_lzcnt_u64(alloc->fl_bitmap);
+    int sl = 31 - (int)_lzcnt_u32(alloc->sl_bitmaps[fl]);
+
+    u64 ret = 0;
+    for(u32 i = alloc->free_lists[fl][sl]; i != SUBALLOCATOR_NULL_BLOCK; i = alloc->blocks[i].next_free)
+        if (alloc->blocks[i].size > ret)
+            ret = alloc->blocks[i].size;
+    return ret;
+}
+
+bool suballocator_find_allocation(Suballocator *alloc, u64 offset, Suballocation *ret) {
+    Suballocator_Block *block;
+    for(u32 i = alloc->first_physical; i != SUBALLOCATOR_NULL_BLOCK; i = block->next_physical) {
+        block = &alloc->blocks[i];
+        if (block->free || block->offset < offset)
+            continue;
+        ret->offset = block->offset;
+        ret->size   = block->size;
+        ret->block  = i;
+        return true;
+    }
+    return false;
+}
+
+int suballocator_plan_moves(int count, Suballocator **allocs, int source, u64 *cursor, u64 budget, u64 alignment,
+                            int move_cap, Suballocation_Move *moves)
+{
+    Suballocation src;
+    Suballocation dst;
+    int dst_block;
+    int move_count = 0;
+    while(move_count < move_cap && suballocator_find_allocation(allocs[source], *cursor, &src)) {
+        if (src.size > budget && move_count > 0)
+            break;
+        *cursor = src.offset + src.size;
+
+        dst_block = -1;
+        for(int i = 0; i < count; ++i) {
+            if (i == source || !allocs[i])
+                continue;
+            if (suballocator_allocate(allocs[i], src.size, alignment, SUBALLOCATION_KIND_LINEAR, &dst)) {
+                dst_block = i;
+                break;
+            }
+        }
+        if (dst_block == -1)
+            continue;
+
+        moves[move_count] = {
+            .src_block  = source,
+            .dst_block  = dst_block,
+            .src_offset = src.offset,
+            .dst_offset = dst.offset,
+            .size       = src.size,
+            .src_handle = src.block,
+            .dst_handle = dst.block,
+        };
+        move_count++;
+        budget -= src.size < budget ? src.size : budget;
+    }
+    return move_count;
+}
+
+// Moves come in source offset order, so the one holding an offset is found by binary search
+bool suballocator_apply_move(int *block, u64 *offset, u32 *handle, int move_count, Suballocation_Move *moves) {
+    if (move_count == 0 || *block != moves[0].src_block)
+        return false;
+    int lo = 0;
+    int hi = move_count - 1;
+    int mid;
+    while(lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (*offset < moves[mid].src_offset) {
+            hi = mid - 1;
+        } else if (*offset >= moves[mid].src_offset + moves[mid].size) {
+            lo = mid + 1;
+        } else {
+            *block   = moves[mid].dst_block;
+            *offset += moves[mid].dst_offset - moves[mid].src_offset;
+            if (handle) {
+                ASSERT(*offset == moves[mid].dst_offset, "Only the start of an allocation has a handle");
+                *handle = moves[mid].dst_handle;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+#if TEST
+static void test_suballocator_basic();
+static void test_suballocator_alignment();
+static void test_suballocator_granularity();
+static void test_suballocator_random();
+static void test_suballocator_walk();
+static void test_suballocator_moves();
+
+void test_suballocator() {
+    test_suballocator_basic();
+    test_suballocator_alignment();
+    test_suballocator_granularity();
+    test_suballocator_random();
+    test_suballocator_walk();
+    test_suballocator_moves();
+}
+
+// Walk the physical list: blocks tile [0, size), no two neighbours are free, and the used bytes add up
+static bool test_suballocator_consistent(Suballocator *alloc) {
+    u32 index = SUBALLOCATOR_NULL_BLOCK;
+    for(u32 i = 0; i < alloc->block_cap; ++i) {
+        bool unused = false;
+        for(u32 j = alloc->unused_records; j != SUBALLOCATOR_NULL_BLOCK; j = alloc->blocks[j].next_free)
+            unused |= j == i;
+        if (!unused && alloc->blocks[i].offset == 0 && alloc->blocks[i].prev_physical == SUBALLOCATOR_NULL_BLOCK)
+            index = i;
+    }
+    u64 offset = 0;
+    u64 used   = 0;
+    bool prev_free = false;
+    while(index != SUBALLOCATOR_NULL_BLOCK) {
+        Suballocator_Block *block = &alloc->blocks[index];
+        if (block->offset != offset || (prev_free && block->free))
+            return false;
+        offset += block->size;
+        used   += block->free ? 0 : block->size;
+        prev_free = block->free;
+        index = block->next_physical;
+    }
+    return offset == alloc->size && used == alloc->used;
+}
+
+static void test_suballocator_basic() {
+    BEGIN_TEST_MODULE("Suballocator_Basic", true, false);
+
+    Suballocator alloc = create_suballocator(1024 * 1024, 1, 64);
+    Suballocation a, b, c;
+    TEST_EQ("allocate a", suballocator_allocate(&alloc, 1000, 16, SUBALLOCATION_KIND_LINEAR, &a), true, false);
+    TEST_EQ("allocate b", suballocator_allocate(&alloc, 5000, 16, SUBALLOCATION_KIND_LINEAR, &b), true, false);
+    TEST_EQ("allocate c", suballocator_allocate(&alloc, 200,  16, SUBALLOCATION_KIND_LINEAR, &c), true, false);
+    TEST_EQ("a offset", a.offset, 0, false);
+    TEST_EQ("a size rounded", a.size, 1008, false);
+    TEST_EQ("b after a", b.offset, 1008, false);
+    TEST_EQ("c after b", c.offset, 1008 + 5008, false);
+    TEST_EQ("consistent", test_suballocator_consistent(&alloc), true, false);
+
+    // b's hole is reused for something that fits, and merges back when everything goes
+    suballocator_free(&alloc, b.block);
+    TEST_EQ("consistent after free", test_suballocator_consistent(&alloc), true, false);
+    Suballocation d;
+    suballocator_allocate(&alloc, 4000, 16, SUBALLOCATION_KIND_LINEAR, &d);
+    TEST_EQ("hole reused", d.offset, b.offset, false);
+
+    suballocator_free(&alloc, a.block);
+    suballocator_free(&alloc, c.block);
+    suballocator_free(&alloc, d.block);
+    TEST_EQ("empty", alloc.used, 0, false);
+    TEST_EQ("merged back", suballocator_get_largest_free(&alloc), alloc.size, false);
+    TEST_EQ("consistent when empty", test_suballocator_consistent(&alloc), true, false);
+
+    // Too large, and out of allocations
+    TEST_EQ("too large", suballocator_allocate(&alloc, alloc.size + 16, 16, SUBALLOCATION_KIND_LINEAR, &a), false, false);
+    TEST_EQ("whole range", suballocator_allocate(&alloc, alloc.size, 16, SUBALLOCATION_KIND_LINEAR, &a), true, false);
+    TEST_EQ("full", suballocator_allocate(&alloc, 16, 16, SUBALLOCATION_KIND_LINEAR, &b), false, false);
+
+    destroy_suballocator(&alloc);
+    END_TEST_MODULE();
+}
+
+static void test_suballocator_alignment() {
+    BEGIN_TEST_MODULE("Suballocator_Alignment", true, false);
+
+    Suballocator alloc = create_suballocator(1024 * 1024, 1, 64);
+    Suballocation a, b, c;
+    suballocator_allocate(&alloc, 48, 16, SUBALLOCATION_KIND_LINEAR, &a);
+    suballocator_allocate(&alloc, 100, 4096, SUBALLOCATION_KIND_LINEAR, &b);
+    TEST_EQ("aligned", b.offset % 4096, 0, false);
+    TEST_EQ("aligned after a", b.offset, 4096, false);
+
+    // the padding in front of b is free again
+    suballocator_allocate(&alloc, 1024, 16, SUBALLOCATION_KIND_LINEAR, &c);
+    TEST_LT("padding reused", c.offset, b.offset, false);
+    TEST_EQ("consistent", test_suballocator_consistent(&alloc), true, false);
+
+    suballocator_free(&alloc, b.block);
+    suballocator_free(&alloc, a.block);
+    suballocator_free(&alloc, c.block);
+    TEST_EQ("consistent after free", test_suballocator_consistent(&alloc), true, false);
+    TEST_EQ("merged back", suballocator_get_largest_free(&alloc), alloc.size, false);
+
+    destroy_suballocator(&alloc);
+    END_TEST_MODULE();
+}
+
+static void test_suballocator_granularity() {
+    BEGIN_TEST_MODULE("Suballocator_Granularity", true, false);
+
+    const u64 granularity = 1024;
+    Suballocator alloc = create_suballocator(1024 * 1024, granularity, 64);
+    Suballocation buffer, image, next;
+    suballocator_allocate(&alloc, 100, 16, SUBALLOCATION_KIND_LINEAR, &buffer);
+    suballocator_allocate(&alloc, 3000, 256, SUBALLOCATION_KIND_OPTIMAL, &image);
+    suballocator_allocate(&alloc, 100, 16, SUBALLOCATION_KIND_LINEAR, &next);
+
+    TEST_EQ("image on its own page", image.offset % granularity, 0, false);
+    TEST_EQ("image whole pages", image.size % granularity, 0, false);
+    // 'next' fits in the padding in front of the image, which is fine as long as it is on another page
+    u64 first_page = image.offset / granularity;
+    u64 last_page  = (image.offset + image.size - 1) / granularity;
+    TEST_EQ("buffer off the image pages", (buffer.offset + buffer.size - 1) / granularity < first_page, true, false);
+    TEST_EQ("next off the image pages",
+            (next.offset + next.size - 1) / granularity < first_page || next.offset / granularity > last_page,
+            true, false);
+    TEST_EQ("consistent", test_suballocator_consistent(&alloc), true, false);
+
+    destroy_suballocator(&alloc);
+    END_TEST_MODULE();
+}
+
+// Random allocations and frees against a byte map of the range: no two live allocations may overlap
+static void test_suballocator_random() {
+    BEGIN_TEST_MODULE("Suballocator_Random", true, false);
+
+    const u64 size = 4 << 20;
+    const int cap = 256;
+    Suballocator alloc = create_suballocator(size, 256, cap);
+
+    u8 *owners = (u8*)memory_allocate_temp(size / 16, 1);
+    memset(owners, 0, size / 16);
+    Suballocation live[cap];
+    bool is_live[cap] = {};
+
+    u32 seed = 777;
+    bool overlap = false;
+    bool aligned = true;
+    bool consistent = true;
+    int failures = 0;
+    for(int step = 0; step < 4000; ++step) {
+        seed = seed * 1664525 + 1013904223;
+        int slot = (seed >> 8) % cap;
+        if (is_live[slot]) {
+            for(u64 i = live[slot].offset / 16; i < (live[slot].offset + live[slot].size) / 16; ++i)
+                owners[i] = 0;
+            suballocator_free(&alloc, live[slot].block);
+            is_live[slot] = false;
+        } else {
+            seed = seed * 1664525 + 1013904223;
+            u64 bytes = 1 + (seed >> 8) % 8192;
+            u64 alignment = (u64)16 << ((seed >> 4) % 6);
+            Suballocation_Kind kind = (seed & 1) ? SUBALLOCATION_KIND_OPTIMAL : SUBALLOCATION_KIND_LINEAR;
+            if (!suballocator_allocate(&alloc, bytes, alignment, kind, &live[slot])) {
+                failures++;
+                continue;
+            }
+            aligned &= live[slot].offset % alignment == 0 && live[slot].size >= bytes;
+            for(u64 i = live[slot].offset / 16; i < (live[slot].offset + live[slot].size) / 16; ++i) {
+                overlap |= owners[i] != 0;
+                owners[i] = 1;
+            }
+            is_live[slot] = true;
+        }
+        if (step % 100 == 0)
+            consistent &= test_suballocator_consistent(&alloc);
+    }
+    TEST_EQ("no overlap", overlap, false, false);
+    TEST_EQ("aligned", aligned, true, false);
+    TEST_EQ("consistent", consistent, true, false);
+    TEST_EQ("never out of space", failures, 0, false);
+
+    for(int i = 0; i < cap; ++i)
+        if (is_live[i])
+            suballocator_free(&alloc, live[i].block);
+    TEST_EQ("merged back", suballocator_get_largest_free(&alloc), size, false);
+
+    destroy_suballocator(&alloc);
+    END_TEST_MODULE();
+}
+// Allocations are found in address order, skipping free blocks, and stop at the end
+static void test_suballocator_walk() {
+    BEGIN_TEST_MODULE("Suballocator_Walk", true, false);
+
+    Suballocator alloc = create_suballocator(64 * 1024, 1, 16);
+    Suballocation a, b, c, found;
+    suballocator_allocate(&alloc, 100, 16, SUBALLOCATION_KIND_LINEAR, &a);
+    suballocator_allocate(&alloc, 200, 16, SUBALLOCATION_KIND_LINEAR, &b);
+    suballocator_allocate(&alloc, 300, 16, SUBALLOCATION_KIND_LINEAR, &c);
+    suballocator_free(&alloc, b.block);
+
+    TEST_EQ("first", suballocator_find_allocation(&alloc, 0, &found), true, false);
+    TEST_EQ("first is a", found.block, a.block, false);
+    TEST_EQ("a size", found.size, a.size, false);
+    TEST_EQ("second", suballocator_find_allocation(&alloc, found.offset + found.size, &found), true, false);
+    TEST_EQ("free b skipped", found.block, c.block, false);
+    TEST_EQ("c offset", found.offset, c.offset, false);
+    TEST_EQ("end", suballocator_find_allocation(&alloc, found.offset + found.size, &found), false, false);
+
+    // The front of the range is split off by a new allocation in a's old place
+    suballocator_free(&alloc, a.block);
+    suballocator_allocate(&alloc, 16, 16, SUBALLOCATION_KIND_LINEAR, &a);
+    TEST_EQ("new first", suballocator_find_allocation(&alloc, 0, &found), true, false);
+    TEST_EQ("new first is a", found.offset, 0, false);
+    TEST_EQ("consistent", test_suballocator_consistent(&alloc), true, false);
+
+    destroy_suballocator(&alloc);
+    END_TEST_MODULE();
+}
+
+// A sparse block is emptied into the others over two budgets, skipping a released one, and ranges in it are
+// repointed to where their allocation went
+static void test_suballocator_moves() {
+    BEGIN_TEST_MODULE("Suballocator_Moves", true, false);
+
+    Suballocator blocks[3];
+    blocks[0] = create_suballocator(64 * 1024, 1, 16);
+    blocks[2] = create_suballocator(64 * 1024, 1, 16);
+    Suballocator *allocs[] = {&blocks[0], NULL, &blocks[2]};
+
+    Suballocation a, b, c, taken;
+    suballocator_allocate(&blocks[0], 1024, 16, SUBALLOCATION_KIND_LINEAR, &a);
+    suballocator_allocate(&blocks[0], 2048, 16, SUBALLOCATION_KIND_LINEAR, &b);
+    suballocator_allocate(&blocks[0], 4096, 16, SUBALLOCATION_KIND_LINEAR, &c);
+    suballocator_allocate(&blocks[2], 512,  16, SUBALLOCATION_KIND_LINEAR, &taken);
+
+    Suballocation_Move moves[4];
+    u64 cursor = 0;
+    int move_count = suballocator_plan_moves(3, allocs, 0, &cursor, 3072, 256, 4, moves);
+    TEST_EQ("first budget", move_count, 2, false);
+    TEST_EQ("a moved", moves[0].src_offset, a.offset, false);
+    TEST_EQ("into the live block", moves[0].dst_block, 2, false);
+    TEST_EQ("aligned", moves[0].dst_offset % 256, 0, false);
+    TEST_EQ("b moved", moves[1].src_offset, b.offset, false);
+    TEST_EQ("b size", moves[1].size, b.size, false);
+    TEST_EQ("cursor after b", cursor, b.offset + b.size, false);
+
+    int block = 0;
+    u64 offset = b.offset + 100;
+    TEST_EQ("inside b", suballocator_apply_move(&block, &offset, NULL, move_count, moves), true, false);
+    TEST_EQ("inside b block", block, 2, false);
+    TEST_EQ("inside b offset", offset, moves[1].dst_offset + 100, false);
+    block = 0;
+    offset = c.offset;
+    TEST_EQ("c not yet", suballocator_apply_move(&block, &offset, NULL, move_count, moves), false, false);
+    TEST_EQ("c in place", offset, c.offset, false);
+    block = 2;
+    offset = a.offset;
+    TEST_EQ("other block", suballocator_apply_move(&block, &offset, NULL, move_count, moves), false, false);
+
+    // a is given its new handle, and freeing it after the move frees the destination range
+    int a_block = 0;
+    u64 a_offset = a.offset;
+    TEST_EQ("a repointed", suballocator_apply_move(&a_block, &a_offset, &a.block, move_count, moves), true, false);
+    TEST_EQ("a handle", a.block, moves[0].dst_handle, false);
+    for(int i = 0; i < move_count; ++i)
+        suballocator_free(&blocks[0], moves[i].src_handle);
+    u64 used = blocks[2].used;
+    suballocator_free(allocs[a_block], a.block);
+    TEST_EQ("moved a freed", blocks[2].used, used - moves[0].size, false);
+    TEST_EQ("consistent after freeing a", test_suballocator_consistent(&blocks[2]), true, false);
+
+    move_count = suballocator_plan_moves(3, allocs, 0, &cursor, 3072, 256, 4, moves);
+    TEST_EQ("over budget still moves", move_count, 1, false);
+    TEST_EQ("c moved", moves[0].src_offset, c.offset, false);
+    suballocator_free(&blocks[0], moves[0].src_handle);
+    TEST_EQ("emptied", blocks[0].allocation_count, 0, false);
+    TEST_EQ("nothing left", suballocator_plan_moves(3, allocs, 0, &cursor, 3072, 256, 4, moves), 0, false);
+    TEST_EQ("consistent", test_suballocator_consistent(&blocks[2]), true, false);
+
+    // Nowhere to go: the allocation stays, and the walk still ends
+    Suballocation big;
+    suballocator_allocate(&blocks[0], 60 * 1024, 16, SUBALLOCATION_KIND_LINEAR, &big);
+    cursor = 0;
+    TEST_EQ("no room", suballocator_plan_moves(3, allocs, 0, &cursor, 1 << 20, 256, 4, moves), 0, false);
+    TEST_EQ("walked past", cursor, big.offset + big.size, false);
+
+    destroy_suballocator(&blocks[0]);
+    destroy_suballocator(&blocks[2]);
+    END_TEST_MODULE();
+}
+
+#endif
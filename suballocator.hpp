@@ -0,0 +1,105 @@
+#ifndef SOL_SUBALLOCATOR_HPP_INCLUDE_GUARD_
+#define SOL_SUBALLOCATOR_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+
+//
+// Two level segregated fit (Masmano et al., "TLSF: a New Dynamic Memory Allocator for Real-Time Systems") over
+// a range of offsets, for carving VkDeviceMemory into buffers and images. The managed range is never touched:
+// block records live in a pool of their own, so this runs (and is tested) without a gpu. Allocation and free are
+// O(1); adjacent free blocks are always merged.
+//
+// Offsets and sizes are kept multiples of SUBALLOCATOR_MIN_ALIGNMENT.
+//
+
+static constexpr u64 SUBALLOCATOR_MIN_ALIGNMENT   = 16;
+static constexpr int SUBALLOCATOR_SL_LOG2         = 4; // second level lists per power of two: 16
+static constexpr int SUBALLOCATOR_SL_COUNT        = 1 << SUBALLOCATOR_SL_LOG2;
+static constexpr int SUBALLOCATOR_MAX_SIZE_LOG2   = 48;
+static constexpr int SUBALLOCATOR_FL_COUNT        = SUBALLOCATOR_MAX_SIZE_LOG2 - SUBALLOCATOR_SL_LOG2 - 4 + 1;
+static constexpr u32 SUBALLOCATOR_NULL_BLOCK      = Max_u32;
+
+// bufferImageGranularity: linear resources (buffers, linear images) and optimal images must not share a page
+// of this size. Optimal allocations are given whole pages (offset and size aligned to the granularity), so a
+// linear neighbour can never end up on one of their pages.
+enum Suballocation_Kind {
+    SUBALLOCATION_KIND_LINEAR  = 0,
+    SUBALLOCATION_KIND_OPTIMAL = 1,
+};
+
+struct Suballocator_Block {
+    u64 offset;
+    u64 size;
+    u32 prev_physical;
+    u32 next_physical;
+    u32 prev_free; // links of the size class free list, or of the unused records (next only)
+    u32 next_free;
+    bool free;
+};
+struct Suballocator {
+    u64 size;
+    u64 used; // bytes in allocated blocks, alignment padding of optimal allocations included
+    u64 granularity;
+
+    int allocation_count;
+    int allocation_cap;
+
+    u32 block_cap;
+    u32 unused_records;
+    u32 first_physical; // the block at offset 0
+    Suballocator_Block *blocks; // Heap allocated
+
+    u64 fl_bitmap;
+    u16 sl_bitmaps[SUBALLOCATOR_FL_COUNT];
+    u32 free_lists[SUBALLOCATOR_FL_COUNT][SUBALLOCATOR_SL_COUNT];
+};
+struct Suballocation {
+    u64 offset;
+    u64 size;
+    u32 block; // handle to free with
+};
+
+// 'granularity' is VkPhysicalDeviceLimits::bufferImageGranularity (a power of two), 'allocation_cap' the most
+// allocations live at once
+Suballocator create_suballocator(u64 size, u64 granularity, int allocation_cap);
+void destroy_suballocator(Suballocator *alloc);
+void reset_suballocator(Suballocator *alloc);
+
+// 'alignment' must be a power of two. Returns false if no free block is large enough.
+bool suballocator_allocate(Suballocator *alloc, u64 size, u64 alignment, Suballocation_Kind kind, Suballocation *ret);
+void suballocator_free(Suballocator *alloc, u32 block);
+
+// Largest block an allocation could be made from, for deciding between this and a new VkDeviceMemory
+u64 suballocator_get_largest_free(Suballocator *alloc);
+
+// Walk the allocations in address order (for moving them elsewhere): get the first one starting at or after
+// 'offset'. Returns false if there is none.
+bool suballocator_find_allocation(Suballocator *alloc, u64 offset, Suballocation *ret);
+
+// Moving allocations out of one of a set of suballocators into the others (see Gpu_Defragmenter). Blocks are
+// indices into the set.
+struct Suballocation_Move {
+    int src_block;
+    int dst_block;
+    u64 src_offset;
+    u64 dst_offset;
+    u64 size;
+    u32 src_handle;
+    u32 dst_handle;
+};
+// Walk 'allocs[source]' from '*cursor', giving each allocation a range in the first other suballocator with room,
+// until 'budget' bytes or 'move_cap' moves (the first allocation is moved whatever its size). NULL entries are
+// skipped. Allocations with nowhere to go are left in place. The source ranges are not freed. Returns the move
+// count, with the moves in source offset order.
+int suballocator_plan_moves(int count, Suballocator **allocs, int source, u64 *cursor, u64 budget, u64 alignment,
+                            int move_cap, Suballocation_Move *moves);
+// Repoint a (block, offset) pair which lies in a range of 'moves', as returned by suballocator_plan_moves().
+// 'handle' may be NULL; if not, the pair is the start of an allocation and it is given the allocation's new
+// handle (the old one is freed once the move completes). Returns false if no move covers it.
+bool suballocator_apply_move(int *block, u64 *offset, u32 *handle, int move_count, Suballocation_Move *moves);
+
+#if TEST
+void test_suballocator();
+#endif
+
+#endif // include guard
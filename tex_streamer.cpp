@@ -0,0 +1,365 @@
+#include "tex_streamer.hpp"
+#include <math.h>
+#include <float.h> // FLT_MAX
+
+#if TEST
+#include "test.hpp"
+#endif
+
+Tex_Streamer create_tex_streamer(u64 budget, int texture_cap, int material_count) {
+    Tex_Streamer ret = {};
+    ret.budget         = budget;
+    ret.texture_cap    = texture_cap;
+    ret.textures       = (Tex_Stream_Texture*)memory_allocate_heap(sizeof(Tex_Stream_Texture) * texture_cap, 8);
+    ret.evictions      = (Tex_Stream_Eviction*)memory_allocate_heap(sizeof(Tex_Stream_Eviction) * texture_cap, 4);
+    ret.material_count = material_count;
+    ret.materials      = (int*)memory_allocate_heap(sizeof(int) * TEX_STREAMER_MATERIAL_SLOTS * material_count, 4);
+    memset(ret.materials, 0xff, sizeof(int) * TEX_STREAMER_MATERIAL_SLOTS * material_count);
+    return ret;
+}
+void destroy_tex_streamer(Tex_Streamer *streamer) {
+    memory_free_heap(streamer->textures);
+    memory_free_heap(streamer->evictions);
+    memory_free_heap(streamer->materials);
+    *streamer = {};
+}
+
+int tex_streamer_add_texture(Tex_Streamer *streamer, u32 width, u32 height, int level_count, const u64 *level_sizes) {
+    ASSERT(streamer->texture_count < streamer->texture_cap, "Tex streamer texture cap exceeded");
+    ASSERT(level_count <= TEX_STREAMER_MAX_LEVELS, "Too many levels");
+
+    Tex_Stream_Texture *texture = &streamer->textures[streamer->texture_count];
+    *texture = {};
+    texture->width       = width;
+    texture->height      = height;
+    texture->level_count = level_count;
+    memcpy(texture->level_sizes, level_sizes, sizeof(u64) * level_count);
+
+    texture->tail_level = level_count - 1;
+    for(int i = 0; i < level_count; ++i) {
+        if (width <= TEX_STREAMER_TAIL_SIZE && height <= TEX_STREAMER_TAIL_SIZE) {
+            texture->tail_level = i;
+            break;
+        }
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    texture->resident = level_count;
+    texture->pending  = -1;
+    texture->wanted   = texture->tail_level;
+    return streamer->texture_count++;
+}
+
+int tex_streamer_get_wanted_level(float size, float pixels, int level_count, float lod_bias) {
+    if (pixels <= 0)
+        return level_count - 1;
+    int ret = (int)floorf(log2f(size / pixels) + lod_bias);
+    if (ret < 0)
+        return 0;
+    return ret < level_count ? ret : level_count - 1;
+}
+
+float tex_streamer_get_pixels(Tex_Stream_Instance *instance, Tex_Stream_View *view) {
+    Mat4 *m = &instance->transform;
+    Vec3 c  = instance->center;
+    float x = m->row0.x * c.x + m->row1.x * c.y + m->row2.x * c.z + m->row3.x - view->position.x;
+    float y = m->row0.y * c.x + m->row1.y * c.y + m->row2.y * c.z + m->row3.y - view->position.y;
+    float z = m->row0.z * c.x + m->row1.z * c.y + m->row2.z * c.z + m->row3.z - view->position.z;
+
+    // The longest basis vector scales the sphere
+    float s0 = m->row0.x * m->row0.x + m->row0.y * m->row0.y + m->row0.z * m->row0.z;
+    float s1 = m->row1.x * m->row1.x + m->row1.y * m->row1.y + m->row1.z * m->row1.z;
+    float s2 = m->row2.x * m->row2.x + m->row2.y * m->row2.y + m->row2.z * m->row2.z;
+    float scale = s0 > s1 ? s0 : s1;
+    scale = sqrtf(scale > s2 ? scale : s2);
+
+    float radius   = instance->radius * scale;
+    float distance = sqrtf(x * x + y * y + z * z);
+    if (distance <= radius)
+        return FLT_MAX;
+    return radius * view->proj_scale * view->viewport_height / distance;
+}
+
+static u64 tex_streamer_get_load_size(Tex_Stream_Texture *texture, int level) {
+    u64 ret = 0;
+    for(int i = level; i < texture->resident; ++i)
+        ret += texture->level_sizes[i];
+    return ret;
+}
+
+// Drop a level of whichever texture has held a level it does not want the longest. Returns false if there is none.
+static bool tex_streamer_evict_one(Tex_Streamer *streamer) {
+    Tex_Stream_Texture *texture;
+    int victim = -1;
+    u32 oldest = Max_u32;
+    for(int i = 0; i < streamer->texture_count; ++i) {
+        texture = &streamer->textures[i];
+        if (texture->pending != -1 || texture->resident >= texture->wanted || texture->last_needed >= oldest)
+            continue;
+        victim = i;
+        oldest = texture->last_needed;
+    }
+    if (victim == -1)
+        return false;
+
+    texture = &streamer->textures[victim];
+    streamer->resident_bytes -= texture->level_sizes[texture->resident];
+    texture->resident++;
+
+    for(int i = 0; i < streamer->eviction_count; ++i)
+        if (streamer->evictions[i].texture == victim) {
+            streamer->evictions[i].resident = texture->resident;
+            return true;
+        }
+    streamer->evictions[streamer->eviction_count++] = {victim, texture->resident};
+    return true;
+}
+
+int tex_streamer_update(Tex_Streamer *streamer, Tex_Stream_View *view, int instance_count,
+                        Tex_Stream_Instance *instances)
+{
+    streamer->frame++;
+    streamer->load_count     = 0;
+    streamer->eviction_count = 0;
+
+    Tex_Stream_Texture *texture;
+    for(int i = 0; i < streamer->texture_count; ++i)
+        streamer->textures[i].wanted = streamer->textures[i].tail_level;
+
+    Tex_Stream_Instance *instance;
+    const int *slots;
+    float pixels;
+    int wanted;
+    for(int i = 0; i < instance_count; ++i) {
+        instance = &instances[i];
+        pixels   = tex_streamer_get_pixels(instance, view);
+        slots    = streamer->materials + instance->material * TEX_STREAMER_MATERIAL_SLOTS;
+        for(int j = 0; j < TEX_STREAMER_MATERIAL_SLOTS; ++j) {
+            if (slots[j] == -1)
+                continue;
+            texture = &streamer->textures[slots[j]];
+            wanted  = tex_streamer_get_wanted_level(
+                          (float)(texture->width > texture->height ? texture->width : texture->height) *
+                          instance->uv_scale, pixels, texture->level_count, view->lod_bias);
+            if (wanted < texture->wanted)
+                texture->wanted = wanted;
+        }
+    }
+    for(int i = 0; i < streamer->texture_count; ++i) {
+        texture = &streamer->textures[i];
+        if (texture->wanted <= texture->resident)
+            texture->last_needed = streamer->frame;
+    }
+
+    // The budget may have shrunk
+    while(streamer->resident_bytes + streamer->pending_bytes > streamer->budget && tex_streamer_evict_one(streamer))
+        ;
+
+    // Tails first, then whichever texture is furthest from what it wants. A load that does not fit stops the rest:
+    // smaller ones behind it must not starve it.
+    int best, best_gap, gap, level;
+    u64 size;
+    while(streamer->load_count < TEX_STREAMER_LOADS_PER_FRAME) {
+        best     = -1;
+        best_gap = 0;
+        for(int i = 0; i < streamer->texture_count; ++i) {
+            texture = &streamer->textures[i];
+            if (texture->pending != -1 || texture->wanted >= texture->resident)
+                continue;
+            gap = texture->resident == texture->level_count ? TEX_STREAMER_MAX_LEVELS + 1 :
+                                                              texture->resident - texture->wanted;
+            if (gap > best_gap) {
+                best     = i;
+                best_gap = gap;
+            }
+        }
+        if (best == -1)
+            break;
+
+        texture = &streamer->textures[best];
+        level   = texture->resident == texture->level_count ? texture->tail_level : texture->resident - 1;
+        size    = tex_streamer_get_load_size(texture, level);
+        if (level != texture->tail_level) {
+            while(streamer->resident_bytes + streamer->pending_bytes + size > streamer->budget &&
+                  tex_streamer_evict_one(streamer))
+                ;
+            if (streamer->resident_bytes + streamer->pending_bytes + size > streamer->budget)
+                break;
+        }
+        texture->pending = level;
+        streamer->pending_bytes += size;
+        streamer->loads[streamer->load_count++] = {best, level, size};
+    }
+    return streamer->load_count;
+}
+
+void tex_streamer_complete_load(Tex_Streamer *streamer, int index) {
+    Tex_Stream_Texture *texture = &streamer->textures[index];
+    ASSERT(texture->pending != -1, "No load pending");
+    u64 size = tex_streamer_get_load_size(texture, texture->pending);
+    streamer->pending_bytes  -= size;
+    streamer->resident_bytes += size;
+    texture->resident    = texture->pending;
+    texture->pending     = -1;
+    texture->last_needed = streamer->frame;
+}
+void tex_streamer_cancel_load(Tex_Streamer *streamer, int index) {
+    Tex_Stream_Texture *texture = &streamer->textures[index];
+    ASSERT(texture->pending != -1, "No load pending");
+    streamer->pending_bytes -= tex_streamer_get_load_size(texture, texture->pending);
+    texture->pending = -1;
+}
+
+#if TEST
+static void test_tex_streamer_levels();
+static void test_tex_streamer_loads();
+static void test_tex_streamer_budget();
+
+void test_tex_streamer() {
+    test_tex_streamer_levels();
+    test_tex_streamer_loads();
+    test_tex_streamer_budget();
+}
+
+static Tex_Stream_Instance test_tex_streamer_instance(float x, float y, float z, int material) {
+    Tex_Stream_Instance ret = {};
+    ret.transform.row0 = {1, 0, 0, 0};
+    ret.transform.row1 = {0, 1, 0, 0};
+    ret.transform.row2 = {0, 0, 1, 0};
+    ret.transform.row3 = {x, y, z, 1};
+    ret.radius   = 1;
+    ret.uv_scale = 1;
+    ret.material = material;
+    return ret;
+}
+
+// 1024 square rgba8: levels 0-10, the tail from level 3 (128)
+static int test_tex_streamer_add(Tex_Streamer *streamer) {
+    u64 sizes[11];
+    for(int i = 0; i < 11; ++i)
+        sizes[i] = (u64)(1024 >> i) * (1024 >> i) * 4;
+    return tex_streamer_add_texture(streamer, 1024, 1024, 11, sizes);
+}
+
+static void test_tex_streamer_levels() {
+    BEGIN_TEST_MODULE("Tex_Streamer_Levels", true, false);
+
+    TEST_EQ("one to one", tex_streamer_get_wanted_level(1024, 1024, 11, 0), 0, false);
+    TEST_EQ("quarter", tex_streamer_get_wanted_level(1024, 256, 11, 0), 2, false);
+    TEST_EQ("rounds finer", tex_streamer_get_wanted_level(1024, 300, 11, 0), 1, false);
+    TEST_EQ("bias", tex_streamer_get_wanted_level(1024, 300, 11, 1), 2, false);
+    TEST_EQ("magnified", tex_streamer_get_wanted_level(1024, 4096, 11, 0), 0, false);
+    TEST_EQ("tiny", tex_streamer_get_wanted_level(1024, 0.01f, 11, 0), 10, false);
+
+    Tex_Stream_View view = {{0, 0, 10}, 1, 1000, 0};
+    Tex_Stream_Instance instance = test_tex_streamer_instance(0, 0, 0, 0);
+    TEST_EQ("pixels", (int)tex_streamer_get_pixels(&instance, &view), 100, false);
+    instance.transform.row0.x = 2;
+    TEST_EQ("scaled", (int)tex_streamer_get_pixels(&instance, &view), 200, false);
+    instance.transform.row3.z = 5;
+    TEST_EQ("translated", (int)tex_streamer_get_pixels(&instance, &view), 400, false);
+    instance.transform.row3.z = 9;
+    TEST_EQ("inside", tex_streamer_get_pixels(&instance, &view) == FLT_MAX, true, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_tex_streamer_loads() {
+    BEGIN_TEST_MODULE("Tex_Streamer_Loads", true, false);
+
+    Tex_Streamer streamer = create_tex_streamer(Max_u64, 4, 2);
+    int a = test_tex_streamer_add(&streamer);
+    int b = test_tex_streamer_add(&streamer);
+    tex_streamer_set_material(&streamer, 0, 0, a);
+    tex_streamer_set_material(&streamer, 1, 0, b);
+    TEST_EQ("tail level", streamer.textures[a].tail_level, 3, false);
+
+    // Nothing drawn: only the tails load
+    Tex_Stream_View view = {{0, 0, 0}, 1, 1000, 0};
+    TEST_EQ("tails", tex_streamer_update(&streamer, &view, 0, NULL), 2, false);
+    TEST_EQ("tail level", streamer.loads[0].level, 3, false);
+    u64 tail_size = 0;
+    for(int i = 3; i < 11; ++i)
+        tail_size += streamer.textures[a].level_sizes[i];
+    TEST_EQ("tail size", streamer.loads[0].size, tail_size, false);
+    TEST_EQ("pending bytes", streamer.pending_bytes, tail_size * 2, false);
+    TEST_EQ("nothing more", tex_streamer_update(&streamer, &view, 0, NULL), 0, false);
+    tex_streamer_complete_load(&streamer, a);
+    tex_streamer_complete_load(&streamer, b);
+    TEST_EQ("resident bytes", streamer.resident_bytes, tail_size * 2, false);
+    TEST_EQ("resident", streamer.textures[a].resident, 3, false);
+
+    // a wants level 0 (1000 pixels across), b level 2 (250): a is further off, so loads first; a level at a time
+    Tex_Stream_Instance instances[] = {
+        test_tex_streamer_instance(0, 0, -1.001f, 0), test_tex_streamer_instance(0, 0, -4, 1),
+    };
+    tex_streamer_update(&streamer, &view, 2, instances);
+    TEST_EQ("a wants", streamer.textures[a].wanted, 0, false);
+    TEST_EQ("b wants", streamer.textures[b].wanted, 2, false);
+    TEST_EQ("load count", streamer.load_count, 2, false);
+    TEST_EQ("furthest first", streamer.loads[0].texture, a, false);
+    TEST_EQ("one level", streamer.loads[0].level, 2, false);
+
+    tex_streamer_cancel_load(&streamer, b);
+    TEST_EQ("cancelled", streamer.pending_bytes, streamer.loads[0].size, false);
+    tex_streamer_complete_load(&streamer, a);
+    tex_streamer_update(&streamer, &view, 2, instances);
+    TEST_EQ("next level", streamer.loads[0].level, 1, false);
+    TEST_EQ("b again", streamer.loads[1].texture, b, false);
+
+    destroy_tex_streamer(&streamer);
+    END_TEST_MODULE();
+}
+
+static void test_tex_streamer_budget() {
+    BEGIN_TEST_MODULE("Tex_Streamer_Budget", true, false);
+
+    // Room for both tails and one 256 level
+    u64 sizes[11];
+    u64 tail_size = 0;
+    for(int i = 0; i < 11; ++i) {
+        sizes[i] = (u64)(1024 >> i) * (1024 >> i) * 4;
+        tail_size += i >= 3 ? sizes[i] : 0;
+    }
+    Tex_Streamer streamer = create_tex_streamer(tail_size * 2 + sizes[2], 4, 2);
+    int a = tex_streamer_add_texture(&streamer, 1024, 1024, 11, sizes);
+    int b = tex_streamer_add_texture(&streamer, 1024, 1024, 11, sizes);
+    tex_streamer_set_material(&streamer, 0, 0, a);
+    tex_streamer_set_material(&streamer, 1, 0, b);
+
+    Tex_Stream_View view = {{0, 0, 0}, 1, 1000, 0};
+    tex_streamer_update(&streamer, &view, 0, NULL);
+    tex_streamer_complete_load(&streamer, a);
+    tex_streamer_complete_load(&streamer, b);
+
+    // Both want level 2: one fits
+    Tex_Stream_Instance instances[] = {
+        test_tex_streamer_instance(0, 0, -4, 0), test_tex_streamer_instance(0, 0, -4, 1),
+    };
+    TEST_EQ("one fits", tex_streamer_update(&streamer, &view, 2, instances), 1, false);
+    TEST_EQ("no evictions", streamer.eviction_count, 0, false);
+    tex_streamer_complete_load(&streamer, streamer.loads[0].texture);
+    int first  = streamer.loads[0].texture;
+    int second = first == a ? b : a;
+    TEST_EQ("full", tex_streamer_update(&streamer, &view, 2, instances), 0, false);
+    TEST_EQ("kept", streamer.textures[first].resident, 2, false);
+
+    // Only the second is drawn: the first's level is surplus, and gives way
+    TEST_EQ("swap", tex_streamer_update(&streamer, &view, 1, &instances[second]), 1, false);
+    TEST_EQ("evicted", streamer.eviction_count, 1, false);
+    TEST_EQ("evicted texture", streamer.evictions[0].texture, first, false);
+    TEST_EQ("evicted to tail", streamer.evictions[0].resident, 3, false);
+    TEST_EQ("loading", streamer.loads[0].texture, second, false);
+    TEST_EQ("within budget", streamer.resident_bytes + streamer.pending_bytes <= streamer.budget, true, false);
+
+    // A shrunk budget evicts the surplus straight away
+    tex_streamer_complete_load(&streamer, second);
+    streamer.budget = tail_size * 2;
+    tex_streamer_update(&streamer, &view, 0, NULL);
+    TEST_EQ("shrunk", streamer.textures[second].resident, 3, false);
+    TEST_EQ("shrunk bytes", streamer.resident_bytes, tail_size * 2, false);
+
+    destroy_tex_streamer(&streamer);
+    END_TEST_MODULE();
+}
+#endif
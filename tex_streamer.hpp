@@ -0,0 +1,103 @@
+#ifndef SOL_TEX_STREAMER_HPP_INCLUDE_GUARD_
+#define SOL_TEX_STREAMER_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "math.hpp"
+
+//
+// Texture mip residency: which levels of each texture to keep on the gpu, under a byte budget. Every frame, each
+// instance's bounds are projected to find how many pixels its textures cover, and so the finest level any of its
+// material's textures needs. Textures which want finer levels load them one at a time (the ones furthest from what
+// they want first); when the budget is full, levels finer than wanted are evicted, least recently needed first.
+// The coarse tail of each texture is always resident.
+//
+// Nothing here touches the gpu: it decides, the caller moves the bytes (see Renderer_Texture_Streamer).
+//
+
+static constexpr int TEX_STREAMER_MAX_LEVELS       = 16;
+static constexpr u32 TEX_STREAMER_TAIL_SIZE        = 128; // levels no larger than this are always resident
+static constexpr int TEX_STREAMER_MATERIAL_SLOTS   = 5;   // textures per material
+static constexpr int TEX_STREAMER_LOADS_PER_FRAME  = 8;
+
+struct Tex_Stream_Texture {
+    u32 width;
+    u32 height;
+    int level_count;
+    int tail_level; // first level of the always resident tail
+    u64 level_sizes[TEX_STREAMER_MAX_LEVELS];
+
+    int resident;     // levels [resident, level_count) are on the gpu; level_count before the tail is
+    int pending;      // the level being loaded (with every level down to 'resident'), -1 if none
+    int wanted;       // the finest level this frame needs
+    u32 last_needed;  // frame in which the finest resident level was last needed
+};
+struct Tex_Stream_Instance {
+    Mat4 transform; // object to world, as gltf stores it: row0-row2 are the basis, row3 the translation
+    Vec3 center;    // bounding sphere, object space
+    float radius;
+    float uv_scale; // texture repeats across the bounds' diameter, 1 when it spans the object once
+    int material;
+};
+struct Tex_Stream_View {
+    Vec3 position;         // camera, world space
+    float proj_scale;      // cot(vertical fov / 2)
+    float viewport_height; // pixels
+    float lod_bias;        // levels added to every wanted level
+};
+struct Tex_Stream_Load {
+    int texture;
+    int level; // load levels [level, resident)
+    u64 size;
+};
+struct Tex_Stream_Eviction {
+    int texture;
+    int resident; // the texture's new finest level
+};
+
+struct Tex_Streamer {
+    u64 budget;
+    u64 resident_bytes;
+    u64 pending_bytes;
+    u32 frame;
+
+    int texture_cap;
+    int texture_count;
+    Tex_Stream_Texture *textures; // Heap allocated
+
+    int material_count;
+    int *materials; // Heap allocated, TEX_STREAMER_MATERIAL_SLOTS texture indices per material, -1 if unused
+
+    // This frame's work, filled by tex_streamer_update()
+    int load_count;
+    int eviction_count;
+    Tex_Stream_Load loads[TEX_STREAMER_LOADS_PER_FRAME];
+    Tex_Stream_Eviction *evictions; // Heap allocated, texture_cap
+};
+
+Tex_Streamer create_tex_streamer(u64 budget, int texture_cap, int material_count);
+void destroy_tex_streamer(Tex_Streamer *streamer);
+
+// 'level_sizes' are the bytes of each level. Returns the texture's index; its tail is the first load.
+int tex_streamer_add_texture(Tex_Streamer *streamer, u32 width, u32 height, int level_count, const u64 *level_sizes);
+inline static void tex_streamer_set_material(Tex_Streamer *streamer, int material, int slot, int texture) {
+    streamer->materials[material * TEX_STREAMER_MATERIAL_SLOTS + slot] = texture;
+}
+
+// The finest level a texture of 'size' texels across needs on an instance whose bounds cover 'pixels' pixels
+int tex_streamer_get_wanted_level(float size, float pixels, int level_count, float lod_bias);
+// Pixels across the instance's bounds on screen, FLT_MAX if the camera is inside them
+float tex_streamer_get_pixels(Tex_Stream_Instance *instance, Tex_Stream_View *view);
+
+// Work out the frame's wanted levels and fill 'loads' and 'evictions' (which are applied to the residency at once:
+// the caller must stop sampling the evicted levels). Loads stay pending until tex_streamer_complete_load(), or
+// tex_streamer_cancel_load() if the caller could not start them. Returns the load count.
+int tex_streamer_update(Tex_Streamer *streamer, Tex_Stream_View *view, int instance_count,
+                        Tex_Stream_Instance *instances);
+void tex_streamer_complete_load(Tex_Streamer *streamer, int texture);
+void tex_streamer_cancel_load(Tex_Streamer *streamer, int texture);
+
+#if TEST
+void test_tex_streamer();
+#endif
+
+#endif // include guard
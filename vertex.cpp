@@ -0,0 +1,494 @@
+#include "vertex.hpp"
+#include "simd.hpp"
+
+#include <float.h> // FLT_MAX
+
+#if TEST
+#include "test.hpp"
+#endif
+
+// @Note Every kernel has a packed path, where the source components are one flat run and are done eight
+// at a time, and a per element path for interleaved views. The vec3 kernels gather instead, so that
+// interleaved sources do not fall off the vector path.
+
+void vertex_unorm8_to_f32(float *dst, const u8 *src, int src_stride, int count, int components) {
+    const float unorm = 1.0f / 255.0f;
+    if (src_stride != components) {
+        for(int i = 0; i < count; ++i)
+            for(int j = 0; j < components; ++j)
+                dst[i * components + j] = src[i * src_stride + j] * unorm;
+        return;
+    }
+
+    int total = count * components;
+    __m256 scale = _mm256_set1_ps(unorm);
+    __m256 a;
+    int i;
+    for(i = 0; i + 8 <= total; i += 8) {
+        a = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i))));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(a, scale));
+    }
+    for(; i < total; ++i)
+        dst[i] = src[i] * unorm;
+}
+
+void vertex_unorm16_to_f32(float *dst, const u8 *src, int src_stride, int count, int components) {
+    const float unorm = 1.0f / 65535.0f;
+    const u16 *comp;
+    if (src_stride != components * 2) {
+        for(int i = 0; i < count; ++i) {
+            comp = (const u16*)(src + i * src_stride);
+            for(int j = 0; j < components; ++j)
+                dst[i * components + j] = comp[j] * unorm;
+        }
+        return;
+    }
+
+    int total = count * components;
+    comp = (const u16*)src;
+    __m256 scale = _mm256_set1_ps(unorm);
+    __m256 a;
+    int i;
+    for(i = 0; i + 8 <= total; i += 8) {
+        a = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(comp + i))));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(a, scale));
+    }
+    for(; i < total; ++i)
+        dst[i] = comp[i] * unorm;
+}
+
+void vertex_f32_to_f16(u16 *dst, const u8 *src, int src_stride, int count, int components) {
+    const float *comp;
+    if (src_stride != components * 4) {
+        for(int i = 0; i < count; ++i) {
+            comp = (const float*)(src + i * src_stride);
+            for(int j = 0; j < components; ++j)
+                dst[i * components + j] = _cvtss_sh(comp[j], _MM_FROUND_TO_NEAREST_INT);
+        }
+        return;
+    }
+
+    int total = count * components;
+    comp = (const float*)src;
+    int i;
+    for(i = 0; i + 8 <= total; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(comp + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(dst + i), h);
+    }
+    for(; i < total; ++i)
+        dst[i] = _cvtss_sh(comp[i], _MM_FROUND_TO_NEAREST_INT);
+}
+
+static inline float vertex_abs(float x) {
+    return x < 0 ? -x : x;
+}
+
+// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the diagonals
+static inline void vertex_octahedral(float x, float y, float z, float *ox, float *oy) {
+    float sum = vertex_abs(x) + vertex_abs(y) + vertex_abs(z);
+    float inv = sum > 0 ? 1.0f / sum : 0;
+    x *= inv;
+    y *= inv;
+    if (z < 0) {
+        float fx = (1 - vertex_abs(y)) * (x < 0 ? -1 : 1);
+        float fy = (1 - vertex_abs(x)) * (y < 0 ? -1 : 1);
+        x = fx;
+        y = fy;
+    }
+    *ox = x;
+    *oy = y;
+}
+
+void vertex_encode_octahedral_snorm16(u32 *dst, const u8 *src, int src_stride, int count) {
+    ASSERT(src_stride % 4 == 0, "Octahedral source must be float aligned");
+
+    __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(src_stride / 4));
+    __m256 abs_mask  = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one  = _mm256_set1_ps(1);
+    __m256 snorm = _mm256_set1_ps(32767);
+    __m256i low = _mm256_set1_epi32(0xffff);
+
+    __m256 x, y, z, sum, fx, fy, folded;
+    const float *base;
+    int i;
+    for(i = 0; i + 8 <= count; i += 8) {
+        base = (const float*)(src + (u64)i * src_stride);
+        x = _mm256_i32gather_ps(base,     idx, 4);
+        y = _mm256_i32gather_ps(base + 1, idx, 4);
+        z = _mm256_i32gather_ps(base + 2, idx, 4);
+
+        sum = _mm256_add_ps(_mm256_and_ps(x, abs_mask), _mm256_and_ps(y, abs_mask));
+        sum = _mm256_add_ps(sum, _mm256_and_ps(z, abs_mask));
+        sum = _mm256_blendv_ps(_mm256_div_ps(one, sum), zero, _mm256_cmp_ps(sum, zero, _CMP_LE_OQ));
+        x = _mm256_mul_ps(x, sum);
+        y = _mm256_mul_ps(y, sum);
+
+        // the sign of zero is positive, to match the scalar path
+        fx = _mm256_sub_ps(one, _mm256_and_ps(y, abs_mask));
+        fy = _mm256_sub_ps(one, _mm256_and_ps(x, abs_mask));
+        fx = _mm256_or_ps(fx, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), sign_mask));
+        fy = _mm256_or_ps(fy, _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), sign_mask));
+
+        folded = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+        x = _mm256_blendv_ps(x, fx, folded);
+        y = _mm256_blendv_ps(y, fy, folded);
+
+        __m256i qx = _mm256_cvtps_epi32(_mm256_mul_ps(x, snorm));
+        __m256i qy = _mm256_cvtps_epi32(_mm256_mul_ps(y, snorm));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_and_si256(qx, low), _mm256_slli_epi32(qy, 16)));
+    }
+    float ox, oy;
+    const float *comp;
+    for(; i < count; ++i) {
+        comp = (const float*)(src + (u64)i * src_stride);
+        vertex_octahedral(comp[0], comp[1], comp[2], &ox, &oy);
+        dst[i] = ((u32)_mm_cvtss_si32(_mm_set_ss(ox * 32767)) & 0xffff) |
+                 ((u32)_mm_cvtss_si32(_mm_set_ss(oy * 32767)) << 16);
+    }
+}
+
+Vertex_Dequantize vertex_quantize_positions_snorm16(s16 *dst, const u8 *src, int src_stride, int count,
+                                                    const float *min, const float *max)
+{
+    ASSERT(src_stride % 4 == 0, "Position source must be float aligned");
+
+    const float *comp;
+    float lo[3];
+    float hi[3];
+    if (min && max) {
+        memcpy(lo, min, sizeof(lo));
+        memcpy(hi, max, sizeof(hi));
+    } else {
+        lo[0] = lo[1] = lo[2] =  FLT_MAX;
+        hi[0] = hi[1] = hi[2] = -FLT_MAX;
+        for(int i = 0; i < count; ++i) {
+            comp = (const float*)(src + (u64)i * src_stride);
+            for(int j = 0; j < 3; ++j) {
+                lo[j] = comp[j] < lo[j] ? comp[j] : lo[j];
+                hi[j] = comp[j] > hi[j] ? comp[j] : hi[j];
+            }
+        }
+    }
+
+    // A flat axis gets a scale of one so that nothing is divided by zero; every value on it is the offset.
+    Vertex_Dequantize ret;
+    float inv_scale[3];
+    for(int j = 0; j < 3; ++j) {
+        ret.offset[j] = (lo[j] + hi[j]) * 0.5f;
+        ret.scale[j]  = (hi[j] - lo[j]) * 0.5f;
+        if (ret.scale[j] <= 0)
+            ret.scale[j] = 1;
+        inv_scale[j] = 32767 / ret.scale[j];
+    }
+
+    __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(src_stride / 4));
+    __m256 offset[3];
+    __m256 scale[3];
+    for(int j = 0; j < 3; ++j) {
+        offset[j] = _mm256_set1_ps(ret.offset[j]);
+        scale[j]  = _mm256_set1_ps(inv_scale[j]);
+    }
+    __m256 snorm_max = _mm256_set1_ps(32767);
+    __m256 snorm_min = _mm256_set1_ps(-32767);
+    __m256i low = _mm256_set1_epi32(0xffff);
+    __m256i w   = _mm256_set1_epi32(32767);
+
+    __m256i q[3];
+    __m256i xy, zw, a, b;
+    const float *base;
+    int i;
+    for(i = 0; i + 8 <= count; i += 8) {
+        base = (const float*)(src + (u64)i * src_stride);
+        for(int j = 0; j < 3; ++j) {
+            __m256 p = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(base + j, idx, 4), offset[j]), scale[j]);
+            p = _mm256_min_ps(_mm256_max_ps(p, snorm_min), snorm_max);
+            q[j] = _mm256_cvtps_epi32(p);
+        }
+        xy = _mm256_or_si256(_mm256_and_si256(q[0], low), _mm256_slli_epi32(q[1], 16));
+        zw = _mm256_or_si256(_mm256_and_si256(q[2], low), _mm256_slli_epi32(w, 16));
+
+        // unpack works within 128 bit lanes: a = {0, 1 | 4, 5}, b = {2, 3 | 6, 7}
+        a = _mm256_unpacklo_epi32(xy, zw);
+        b = _mm256_unpackhi_epi32(xy, zw);
+        _mm256_storeu_si256((__m256i*)(dst + i * 4),     _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4 + 16), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    float p;
+    for(; i < count; ++i) {
+        comp = (const float*)(src + (u64)i * src_stride);
+        for(int j = 0; j < 3; ++j) {
+            p = (comp[j] - ret.offset[j]) * inv_scale[j];
+            p = p < -32767 ? -32767 : (p > 32767 ? 32767 : p);
+            dst[i * 4 + j] = (s16)_mm_cvtss_si32(_mm_set_ss(p));
+        }
+        dst[i * 4 + 3] = 32767;
+    }
+    return ret;
+}
+
+// Each attribute is moved with one 16 byte load and store, whatever its size. The store runs over into the
+// attributes after it, which are written after it (vertex by vertex, in offset order), so only padding is
+// left dirty. The last few vertices would read past a stream or write past 'dst', so they are copied exactly.
+void vertex_interleave(u8 *dst, int dst_stride, int count, int stream_count, const Vertex_Stream *streams) {
+    int vector_count = count;
+    int limit, span;
+    for(int s = 0; s < stream_count; ++s) {
+        ASSERT(s == 0 || streams[s].offset >= streams[s - 1].offset + streams[s - 1].size,
+               "Interleaved streams must be in offset order");
+        if (streams[s].size > 16) {
+            vector_count = 0;
+            break;
+        }
+        // i * stride + 16 <= (count - 1) * stride + size, and the same for the destination. The spans are checked
+        // before dividing: division truncates toward zero, so a short negative span would still allow one vertex.
+        span  = (count - 1) * streams[s].stride + streams[s].size - 16;
+        limit = streams[s].stride && span >= 0 ? span / streams[s].stride + 1 : 0;
+        vector_count = limit < vector_count ? limit : vector_count;
+        span  = count * dst_stride - streams[s].offset - 16;
+        limit = span >= 0 ? span / dst_stride + 1 : 0;
+        vector_count = limit < vector_count ? limit : vector_count;
+    }
+
+    u8 *vertex;
+    int i;
+    for(i = 0; i < vector_count; ++i) {
+        vertex = dst + (u64)i * dst_stride;
+        for(int s = 0; s < stream_count; ++s) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(streams[s].src + (u64)i * streams[s].stride));
+            _mm_storeu_si128((__m128i*)(vertex + streams[s].offset), a);
+        }
+    }
+    for(; i < count; ++i) {
+        vertex = dst + (u64)i * dst_stride;
+        for(int s = 0; s < stream_count; ++s)
+            memcpy(vertex + streams[s].offset, streams[s].src + (u64)i * streams[s].stride, streams[s].size);
+    }
+}
+
+#if TEST
+static void test_unorm();
+static void test_f16();
+static void test_octahedral();
+static void test_positions();
+static void test_interleave();
+
+void test_vertex() {
+    test_unorm();
+    test_f16();
+    test_octahedral();
+    test_positions();
+    test_interleave();
+}
+
+static void test_unorm() {
+    BEGIN_TEST_MODULE("Vertex_Unorm", true, false);
+
+    // 11 vec2 elements: two vector iterations and a tail in the packed path
+    u8 bytes[22];
+    u16 shorts[22];
+    for(int i = 0; i < 22; ++i) {
+        bytes[i]  = (u8)(i * 12);
+        shorts[i] = (u16)(i * 3000);
+    }
+    bytes[21]  = 255;
+    shorts[21] = 65535;
+
+    float out[22];
+    bool ok = true;
+    vertex_unorm8_to_f32(out, bytes, 2, 11, 2);
+    for(int i = 0; i < 22; ++i)
+        ok &= vertex_abs(out[i] - bytes[i] / 255.0f) < 1e-6f;
+    TEST_EQ("unorm8 packed", ok, true, false);
+    TEST_FEQ("unorm8 one", out[21], 1.0f, false);
+
+    ok = true;
+    vertex_unorm16_to_f32(out, (const u8*)shorts, 4, 11, 2);
+    for(int i = 0; i < 22; ++i)
+        ok &= vertex_abs(out[i] - shorts[i] / 65535.0f) < 1e-6f;
+    TEST_EQ("unorm16 packed", ok, true, false);
+    TEST_FEQ("unorm16 one", out[21], 1.0f, false);
+
+    // interleaved: take the first component of each pair as a scalar attribute
+    ok = true;
+    vertex_unorm16_to_f32(out, (const u8*)shorts, 4, 11, 1);
+    for(int i = 0; i < 11; ++i)
+        ok &= vertex_abs(out[i] - shorts[i * 2] / 65535.0f) < 1e-6f;
+    TEST_EQ("unorm16 strided", ok, true, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_f16() {
+    BEGIN_TEST_MODULE("Vertex_F16", true, false);
+
+    float values[12] = {0, 1, -2, 0.5f, 65504, 1e-8f, 3.14159f, -0.25f, 100000, 0.1f, -1, 2048};
+    u16 expected[12] = {0x0000, 0x3c00, 0xc000, 0x3800, 0x7bff, 0x0000, 0x4248, 0xb400, 0x7c00, 0x2e66, 0xbc00, 0x6800};
+
+    u16 out[12];
+    vertex_f32_to_f16(out, (const u8*)values, 12, 4, 3);
+    TEST_EQ("packed", memcmp(out, expected, sizeof(out)), 0, false);
+
+    // vec2 out of a vec3 stride
+    vertex_f32_to_f16(out, (const u8*)values, 12, 4, 2);
+    bool ok = true;
+    for(int i = 0; i < 4; ++i)
+        ok &= out[i * 2] == expected[i * 3] && out[i * 2 + 1] == expected[i * 3 + 1];
+    TEST_EQ("strided", ok, true, false);
+
+    END_TEST_MODULE();
+}
+
+static void vertex_decode_octahedral(u32 packed, float *n) {
+    float x = (float)(s16)(packed & 0xffff) / 32767;
+    float y = (float)(s16)(packed >> 16) / 32767;
+    float z = 1 - vertex_abs(x) - vertex_abs(y);
+    if (z < 0) {
+        float fx = (1 - vertex_abs(y)) * (x < 0 ? -1 : 1);
+        float fy = (1 - vertex_abs(x)) * (y < 0 ? -1 : 1);
+        x = fx;
+        y = fy;
+    }
+    float len = _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x * x + y * y + z * z)));
+    n[0] = x / len;
+    n[1] = y / len;
+    n[2] = z / len;
+}
+
+static void test_octahedral() {
+    BEGIN_TEST_MODULE("Vertex_Octahedral", true, false);
+
+    // 19 normals over the sphere (both hemispheres and the axes), interleaved with a uv so the stride is 20
+    const int count = 19;
+    float src[count * 5];
+    for(int i = 0; i < count; ++i) {
+        float theta = i * 0.7f;
+        float phi = -1.5f + i * (3.0f / (count - 1));
+        src[i * 5 + 0] = cosf(phi) * cosf(theta);
+        src[i * 5 + 1] = cosf(phi) * sinf(theta);
+        src[i * 5 + 2] = sinf(phi);
+        src[i * 5 + 3] = 0;
+        src[i * 5 + 4] = 0;
+    }
+    src[0] = 0; src[1] = 0; src[2] = -1;
+    src[5] = 1; src[6] = 0; src[7] = 0;
+
+    u32 out[count];
+    vertex_encode_octahedral_snorm16(out, (const u8*)src, 20, count);
+
+    float n[3];
+    float max_err = 0;
+    for(int i = 0; i < count; ++i) {
+        vertex_decode_octahedral(out[i], n);
+        for(int j = 0; j < 3; ++j) {
+            float err = vertex_abs(n[j] - src[i * 5 + j]);
+            max_err = err > max_err ? err : max_err;
+        }
+    }
+    TEST_LT("decoded error", max_err, 0.0002f, false);
+
+    // vector and tail paths agree: encode the second element on its own
+    u32 single;
+    vertex_encode_octahedral_snorm16(&single, (const u8*)(src + 5), 20, 1);
+    TEST_EQ("vector matches scalar", single, out[1], false);
+
+    END_TEST_MODULE();
+}
+
+static void test_positions() {
+    BEGIN_TEST_MODULE("Vertex_Quantize_Positions", true, false);
+
+    const int count = 13;
+    float src[count * 3];
+    for(int i = 0; i < count; ++i) {
+        src[i * 3 + 0] = -4.0f + i * 0.75f;
+        src[i * 3 + 1] = 10.0f + (i % 5) * 0.125f;
+        src[i * 3 + 2] = 2.5f; // flat axis
+    }
+
+    s16 out[count * 4];
+    Vertex_Dequantize dq = vertex_quantize_positions_snorm16(out, (const u8*)src, 12, count, NULL, NULL);
+    TEST_FEQ("offset.x", dq.offset[0], 0.5f, false);
+    TEST_FEQ("scale.x",  dq.scale[0],  4.5f, false);
+    TEST_FEQ("scale.z",  dq.scale[2],  1.0f, false);
+
+    float max_err = 0;
+    bool w = true;
+    for(int i = 0; i < count; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            float p = out[i * 4 + j] / 32767.0f * dq.scale[j] + dq.offset[j];
+            float err = vertex_abs(p - src[i * 3 + j]);
+            max_err = err > max_err ? err : max_err;
+        }
+        w &= out[i * 4 + 3] == 32767;
+    }
+    TEST_LT("dequantized error", max_err, 4.5f / 32767, false);
+    TEST_EQ("w", w, true, false);
+    TEST_EQ("min.x", out[0], (s16)-32767, false);
+    TEST_EQ("max.x", out[(count - 1) * 4], (s16)32767, false);
+
+    // accessor bounds wider than the data are used as given
+    float min[3] = {-8, 0, 0};
+    float max[3] = { 8, 20, 5};
+    dq = vertex_quantize_positions_snorm16(out, (const u8*)src, 12, count, min, max);
+    TEST_FEQ("given offset.y", dq.offset[1], 10.0f, false);
+    TEST_EQ("given x[0]", out[0], (s16)-16384, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_interleave() {
+    BEGIN_TEST_MODULE("Vertex_Interleave", true, false);
+
+    // position vec3, octahedral normal, float16 tangent, and a uv read out of a 20 byte stride
+    const int count = 11;
+    u8 positions[count * 12];
+    u8 normals[count * 4];
+    u8 tangents[count * 8];
+    u8 uvs[count * 20];
+    for(int i = 0; i < (int)sizeof(positions); ++i) positions[i] = (u8)(i * 7 + 1);
+    for(int i = 0; i < (int)sizeof(normals);   ++i) normals[i]   = (u8)(i * 5 + 2);
+    for(int i = 0; i < (int)sizeof(tangents);  ++i) tangents[i]  = (u8)(i * 3 + 3);
+    for(int i = 0; i < (int)sizeof(uvs);       ++i) uvs[i]       = (u8)(i * 11 + 4);
+
+    Vertex_Stream streams[] = {
+        {positions, 12, 12,  0},
+        {normals,    4,  4, 12},
+        {tangents,   8,  8, 16},
+        {uvs,       20,  8, 24},
+    };
+    const int stride = 32;
+    u8 out[count * stride];
+    u8 expected[count * stride];
+    for(int i = 0; i < count; ++i)
+        for(int s = 0; s < 4; ++s)
+            memcpy(expected + i * stride + streams[s].offset, streams[s].src + i * streams[s].stride, streams[s].size);
+
+    vertex_interleave(out, stride, count, 4, streams);
+    TEST_EQ("four streams", memcmp(out, expected, sizeof(out)), 0, false);
+
+    // positions pulled back out as their own stream, padded to 16 bytes: nothing is written past the end
+    u8 position_stream[count * 16];
+    memset(position_stream, 0xcd, sizeof(position_stream));
+    Vertex_Stream position = {expected, stride, 12, 0};
+    vertex_interleave(position_stream, 16, count, 1, &position);
+    bool ok = true;
+    for(int i = 0; i < count; ++i)
+        ok &= memcmp(position_stream + i * 16, positions + i * 12, 12) == 0;
+    ok &= position_stream[count * 16 - 1] == 0xcd;
+    TEST_EQ("position stream", ok, true, false);
+
+    // a single vertex narrower than a vector: copied exactly, nothing written past it
+    u8 single[28];
+    memset(single, 0xcd, sizeof(single));
+    Vertex_Stream one = {positions, 12, 12, 0};
+    vertex_interleave(single, 12, 1, 1, &one);
+    ok = memcmp(single, positions, 12) == 0;
+    for(int i = 12; i < (int)sizeof(single); ++i)
+        ok &= single[i] == 0xcd;
+    TEST_EQ("single vertex", ok, true, false);
+
+    END_TEST_MODULE();
+}
+#endif
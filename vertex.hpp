@@ -0,0 +1,54 @@
+#ifndef SOL_VERTEX_HPP_INCLUDE_GUARD_
+#define SOL_VERTEX_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+
+//
+// Vertex attribute conversion kernels. These are run as accessor data is copied into the gpu allocation,
+// so they read straight out of the gltf buffer: 'src' points at the first element, 'src_stride' is the
+// byte distance between elements (the buffer view's byteStride when interleaved), 'count' is the element
+// count. The destination is always tightly packed.
+//
+
+// A quantized position is read by the vertex shader as snorm ([-1, 1]) and recovered with
+// 'position = quantized * scale + offset'.
+struct Vertex_Dequantize {
+    float offset[3];
+    float scale[3];
+};
+
+// Normalized unsigned integer components to float ([0, 1])
+void vertex_unorm8_to_f32(float *dst, const u8 *src, int src_stride, int count, int components);
+void vertex_unorm16_to_f32(float *dst, const u8 *src, int src_stride, int count, int components);
+
+// Float32 components to float16 (round to nearest even)
+void vertex_f32_to_f16(u16 *dst, const u8 *src, int src_stride, int count, int components);
+
+// Float32 vec3 unit vectors to two snorm16 octahedral coordinates, packed x low y high (VK_FORMAT_R16G16_SNORM).
+// 'src_stride' must be a multiple of 4.
+void vertex_encode_octahedral_snorm16(u32 *dst, const u8 *src, int src_stride, int count);
+
+// Float32 vec3 positions to four snorm16 components each, w set to 1.0 (VK_FORMAT_R16G16B16A16_SNORM). The
+// bounds are the accessor's min and max; when either is NULL they are found from the data. 'src_stride'
+// must be a multiple of 4.
+Vertex_Dequantize vertex_quantize_positions_snorm16(s16 *dst, const u8 *src, int src_stride, int count,
+                                                    const float *min, const float *max);
+
+// One attribute of an interleaved vertex: 'size' bytes read every 'stride' bytes from 'src', written at
+// 'offset' in each vertex.
+struct Vertex_Stream {
+    const u8 *src;
+    int stride;
+    int size;
+    int offset;
+};
+
+// Transpose attribute streams into one interleaved buffer, 'dst_stride' bytes per vertex. Streams must be in
+// increasing 'offset' order and must not overlap.
+void vertex_interleave(u8 *dst, int dst_stride, int count, int stream_count, const Vertex_Stream *streams);
+
+#if TEST
+void test_vertex();
+#endif
+
+#endif // include guard
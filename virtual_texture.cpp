@@ -0,0 +1,592 @@
+#include "virtual_texture.hpp"
+#include "image.hpp"
+
+#if TEST
+#include "test.hpp"
+#endif
+
+int vt_get_level_count(u32 width, u32 height) {
+    int ret = 1;
+    while((width > VT_TILE_SIZE || height > VT_TILE_SIZE) && ret < VT_MAX_LEVELS) {
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+        ret++;
+    }
+    return ret;
+}
+
+// The parent of a page. Odd level dimensions leave a last row or column whose tiles lie past the parent level's
+// last tile: they belong to that last tile.
+static inline void vt_get_parent(Virtual_Texture *vt, int level, u32 *x, u32 *y) {
+    *x >>= 1;
+    *y >>= 1;
+    if (*x >= vt->level_tiles_x[level + 1])
+        *x = vt->level_tiles_x[level + 1] - 1;
+    if (*y >= vt->level_tiles_y[level + 1])
+        *y = vt->level_tiles_y[level + 1] - 1;
+}
+
+static inline void vt_lru_unlink(Virtual_Texture *vt, u32 slot) {
+    Vt_Slot *s = &vt->slots[slot];
+    if (s->prev != VT_NULL_SLOT)
+        vt->slots[s->prev].next = s->next;
+    else
+        vt->lru_head = s->next;
+    if (s->next != VT_NULL_SLOT)
+        vt->slots[s->next].prev = s->prev;
+    else
+        vt->lru_tail = s->prev;
+}
+static inline void vt_lru_push_head(Virtual_Texture *vt, u32 slot) {
+    Vt_Slot *s = &vt->slots[slot];
+    s->prev = VT_NULL_SLOT;
+    s->next = vt->lru_head;
+    if (vt->lru_head != VT_NULL_SLOT)
+        vt->slots[vt->lru_head].prev = slot;
+    else
+        vt->lru_tail = slot;
+    vt->lru_head = slot;
+}
+
+static void vt_touch_slot(Virtual_Texture *vt, u32 slot) {
+    Vt_Slot *s = &vt->slots[slot];
+    if (s->last_used != vt->frame) {
+        s->last_used = vt->frame;
+        vt->used_slots++;
+    }
+    if (s->pinned || vt->lru_head == slot)
+        return;
+    vt_lru_unlink(vt, slot);
+    vt_lru_push_head(vt, slot);
+}
+
+// Write 'entry' over the page table entries of the page at (level, x, y) and of every finer page under it which
+// either fell back to something coarser than 'level' (mapping), or to the page itself (unmapping)
+static void vt_retarget_subtree(Virtual_Texture *vt, int level, u32 x, u32 y, u32 entry, bool mapping) {
+    u32 old = vt->page_table[vt_get_page_index(vt, level, x, y)];
+    bool last_x = x + 1 == vt->level_tiles_x[level];
+    bool last_y = y + 1 == vt->level_tiles_y[level];
+
+    u32 x0, x1, y0, y1, index;
+    u32 *e;
+    for(int l = level; l >= 0; --l) {
+        int shift = level - l;
+        x0 = x << shift;
+        y0 = y << shift;
+        x1 = last_x ? vt->level_tiles_x[l] : (x + 1) << shift;
+        y1 = last_y ? vt->level_tiles_y[l] : (y + 1) << shift;
+        for(u32 j = y0; j < y1; ++j) {
+            index = vt_get_page_index(vt, l, x0, j);
+            for(u32 i = x0; i < x1; ++i, ++index) {
+                e = &vt->page_table[index];
+                if (mapping ? vt_get_page_table_entry_level(*e) <= level : *e != old)
+                    continue;
+                *e = entry;
+                if (index < vt->dirty_first)
+                    vt->dirty_first = index;
+                if (index + 1 > vt->dirty_end)
+                    vt->dirty_end = index + 1;
+            }
+        }
+    }
+}
+
+// Evict the page in 'slot', pointing everything which used it at its parent's entry
+static void vt_unmap_slot(Virtual_Texture *vt, u32 slot) {
+    u32 page = vt->slots[slot].page;
+    int level;
+    u32 x, y, px, py;
+    vt_get_page_coords(vt, page, &level, &x, &y);
+    px = x;
+    py = y;
+    vt_get_parent(vt, level, &px, &py);
+    u32 parent_entry = vt->page_table[vt_get_page_index(vt, level + 1, px, py)];
+    vt_retarget_subtree(vt, level, x, y, parent_entry, false);
+
+    vt->pages[page].slot = VT_NULL_SLOT;
+    vt->slots[slot].page = VT_NULL_PAGE;
+    vt_lru_unlink(vt, slot);
+}
+
+Virtual_Texture create_virtual_texture(u32 width, u32 height, u32 pool_width, u32 pool_height, int request_cap) {
+    ASSERT(pool_width <= 4096 && pool_height <= 4096, "Slot coordinates are 12 bits in the page table");
+    ASSERT(pool_width * pool_height > 1, "The pool needs a slot besides the pinned one");
+
+    Virtual_Texture ret = {};
+    ret.width       = width;
+    ret.height      = height;
+    ret.level_count = vt_get_level_count(width, height);
+
+    u32 w = width;
+    u32 h = height;
+    for(int i = 0; i < ret.level_count; ++i) {
+        ret.level_tiles_x[i] = (w + VT_TILE_SIZE - 1) / VT_TILE_SIZE;
+        ret.level_tiles_y[i] = (h + VT_TILE_SIZE - 1) / VT_TILE_SIZE;
+        ret.level_first[i]   = ret.page_count;
+        ret.page_count      += ret.level_tiles_x[i] * ret.level_tiles_y[i];
+        w = w > 1 ? w >> 1 : 1;
+        h = h > 1 ? h >> 1 : 1;
+    }
+    ASSERT(ret.level_tiles_x[0] <= 0x3fff && ret.level_tiles_y[0] <= 0x3fff, "Tile coordinates are 14 bits in feedback");
+
+    ret.pages      = (Vt_Page*)memory_allocate_heap(sizeof(Vt_Page) * ret.page_count, 8);
+    ret.page_table = (u32*)memory_allocate_heap(sizeof(u32) * ret.page_count, 4);
+    for(u32 i = 0; i < ret.page_count; ++i) {
+        ret.pages[i].slot      = VT_NULL_SLOT;
+        ret.pages[i].requested = 0;
+    }
+    // No entry's level is ever this coarse, so mapping the top page claims every entry
+    memset(ret.page_table, 0xff, sizeof(u32) * ret.page_count);
+
+    ret.pool_width  = pool_width;
+    ret.pool_height = pool_height;
+    ret.slot_count  = pool_width * pool_height;
+    ret.slots       = (Vt_Slot*)memory_allocate_heap(sizeof(Vt_Slot) * ret.slot_count, 8);
+    for(u32 i = 0; i < ret.slot_count; ++i) {
+        ret.slots[i] = {};
+        ret.slots[i].page = VT_NULL_PAGE;
+        ret.slots[i].prev = VT_NULL_SLOT;
+        ret.slots[i].next = i + 1 < ret.slot_count ? i + 1 : VT_NULL_SLOT;
+    }
+    ret.free_slots = 0;
+    ret.lru_head   = VT_NULL_SLOT;
+    ret.lru_tail   = VT_NULL_SLOT;
+
+    ret.frame       = 1;
+    ret.request_cap = request_cap;
+    ret.requests    = (u32*)memory_allocate_heap(sizeof(u32) * request_cap, 4);
+    vt_clear_dirty(&ret);
+
+    u32 slot;
+    vt_map_page(&ret, ret.page_count - 1, &slot);
+    vt_lru_unlink(&ret, slot);
+    ret.slots[slot].pinned = true;
+    return ret;
+}
+void destroy_virtual_texture(Virtual_Texture *vt) {
+    memory_free_heap(vt->pages);
+    memory_free_heap(vt->page_table);
+    memory_free_heap(vt->slots);
+    memory_free_heap(vt->requests);
+    *vt = {};
+}
+
+void vt_get_page_coords(Virtual_Texture *vt, u32 page, int *level, u32 *x, u32 *y) {
+    int l = vt->level_count - 1;
+    while(vt->level_first[l] > page)
+        --l;
+    u32 i = page - vt->level_first[l];
+    *level = l;
+    *x = i % vt->level_tiles_x[l];
+    *y = i / vt->level_tiles_x[l];
+}
+
+int vt_process_feedback(Virtual_Texture *vt, const u32 *feedback, u32 count) {
+    // Back off while the pool is over subscribed, and sharpen again once it is half idle
+    if (vt->starved) {
+        if (vt->mip_bias < vt->level_count - 1)
+            vt->mip_bias++;
+    } else if (vt->mip_bias > 0 && vt->used_slots * 2 < vt->slot_count) {
+        vt->mip_bias--;
+    }
+    vt->starved    = false;
+    vt->used_slots = 0;
+    vt->frame++;
+
+    u32 level_counts[VT_MAX_LEVELS] = {};
+    int request_count = 0;
+
+    u32 fb, x, y, page, want;
+    int level, shift;
+    for(u32 i = 0; i < count; ++i) {
+        fb = feedback[i];
+        if (fb == VT_NULL_FEEDBACK)
+            continue;
+        level = (int)(fb >> 28);
+        x     = fb & 0x3fff;
+        y     = (fb >> 14) & 0x3fff;
+        if (level >= vt->level_count)
+            continue;
+
+        shift = vt->level_count - 1 - level;
+        shift = vt->mip_bias < shift ? vt->mip_bias : shift;
+        level += shift;
+        x >>= shift;
+        y >>= shift;
+        if (x >= vt->level_tiles_x[level])
+            x = vt->level_tiles_x[level] - 1;
+        if (y >= vt->level_tiles_y[level])
+            y = vt->level_tiles_y[level] - 1;
+
+        // The top page is pinned, so this always ends
+        page = vt_get_page_index(vt, level, x, y);
+        want = VT_NULL_PAGE;
+        while(vt->pages[page].slot == VT_NULL_SLOT) {
+            want = page;
+            vt_get_parent(vt, level, &x, &y);
+            level++;
+            page = vt_get_page_index(vt, level, x, y);
+        }
+        vt_touch_slot(vt, vt->pages[page].slot);
+
+        if (want == VT_NULL_PAGE || vt->pages[want].requested == vt->frame || request_count == vt->request_cap)
+            continue;
+        vt->pages[want].requested = vt->frame;
+        vt->requests[request_count++] = want;
+        level_counts[level - 1]++;
+    }
+
+    // Coarsest first: a counting sort on level
+    u32 starts[VT_MAX_LEVELS];
+    u32 start = 0;
+    for(int l = vt->level_count - 1; l >= 0; --l) {
+        starts[l] = start;
+        start += level_counts[l];
+    }
+    u64 mark = get_mark_temp();
+    u32 *unsorted = (u32*)memory_allocate_temp(sizeof(u32) * request_count, 4);
+    memcpy(unsorted, vt->requests, sizeof(u32) * request_count);
+    for(int i = 0; i < request_count; ++i) {
+        level = vt->level_count - 1;
+        while(vt->level_first[level] > unsorted[i])
+            --level;
+        vt->requests[starts[level]++] = unsorted[i];
+    }
+    reset_to_mark_temp(mark);
+
+    vt->request_count = request_count;
+    return request_count;
+}
+
+bool vt_map_page(Virtual_Texture *vt, u32 page, u32 *slot) {
+    ASSERT(vt->pages[page].slot == VT_NULL_SLOT, "Page is already resident");
+
+    u32 s = vt->free_slots;
+    if (s != VT_NULL_SLOT) {
+        vt->free_slots = vt->slots[s].next;
+    } else {
+        s = vt->lru_tail;
+        if (s == VT_NULL_SLOT || vt->slots[s].last_used == vt->frame) {
+            vt->starved = true;
+            return false;
+        }
+        vt_unmap_slot(vt, s);
+    }
+
+    vt->slots[s].page      = page;
+    vt->slots[s].last_used = vt->frame;
+    vt->used_slots++;
+    vt->pages[page].slot   = s;
+    vt_lru_push_head(vt, s);
+
+    int level;
+    u32 x, y, slot_x, slot_y;
+    vt_get_page_coords(vt, page, &level, &x, &y);
+    vt_get_slot_coords(vt, s, &slot_x, &slot_y);
+    vt_retarget_subtree(vt, level, x, y, vt_make_page_table_entry(slot_x, slot_y, level), true);
+
+    *slot = s;
+    return true;
+}
+
+u64 vt_get_tile_size(Vt_Tile_Format format) {
+    if (format == VT_TILE_FORMAT_BC7)
+        return image_get_bc_size(VT_TILE_SLOT_SIZE, VT_TILE_SLOT_SIZE);
+    return (u64)VT_TILE_SLOT_SIZE * VT_TILE_SLOT_SIZE * 4;
+}
+
+static u32 vt_get_total_page_count(u32 width, u32 height) {
+    int level_count = vt_get_level_count(width, height);
+    u32 ret = 0;
+    for(int i = 0; i < level_count; ++i) {
+        ret += ((width + VT_TILE_SIZE - 1) / VT_TILE_SIZE) * ((height + VT_TILE_SIZE - 1) / VT_TILE_SIZE);
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    return ret;
+}
+
+u64 vt_get_tile_file_size(u32 width, u32 height, Vt_Tile_Format format) {
+    return VT_TILE_FILE_DATA_OFFSET + vt_get_total_page_count(width, height) * vt_get_tile_size(format);
+}
+
+void vt_build_tile_file(u8 *dst, const u8 *mips, u32 width, u32 height, Vt_Tile_Format format, bool srgb) {
+    Vt_Tile_File_Header *header = (Vt_Tile_File_Header*)dst;
+    *header = {};
+    header->magic       = VT_TILE_FILE_MAGIC;
+    header->width       = width;
+    header->height      = height;
+    header->level_count = vt_get_level_count(width, height);
+    header->page_count  = vt_get_total_page_count(width, height);
+    header->format      = format;
+    header->srgb        = srgb;
+    header->tile_size   = vt_get_tile_size(format);
+
+    u64 mark = get_mark_temp();
+    u8 *texels = (u8*)memory_allocate_temp(VT_TILE_SLOT_SIZE * VT_TILE_SLOT_SIZE * 4, 16);
+
+    u8 *tile = dst + VT_TILE_FILE_DATA_OFFSET;
+    const u32 *src;
+    u32 *row;
+    u32 tiles_x, tiles_y, sx, sy;
+    s32 tx, ty;
+    for(u32 level = 0; level < header->level_count; ++level) {
+        tiles_x = (width  + VT_TILE_SIZE - 1) / VT_TILE_SIZE;
+        tiles_y = (height + VT_TILE_SIZE - 1) / VT_TILE_SIZE;
+        src = (const u32*)mips;
+        for(u32 y = 0; y < tiles_y; ++y)
+            for(u32 x = 0; x < tiles_x; ++x) {
+                row = format == VT_TILE_FORMAT_RGBA8 ? (u32*)tile : (u32*)texels;
+                for(u32 j = 0; j < VT_TILE_SLOT_SIZE; ++j, row += VT_TILE_SLOT_SIZE) {
+                    ty = (s32)(y * VT_TILE_SIZE + j) - (s32)VT_TILE_BORDER;
+                    sy = ty < 0 ? 0 : ((u32)ty >= height ? height - 1 : (u32)ty);
+                    for(u32 i = 0; i < VT_TILE_SLOT_SIZE; ++i) {
+                        tx = (s32)(x * VT_TILE_SIZE + i) - (s32)VT_TILE_BORDER;
+                        sx = tx < 0 ? 0 : ((u32)tx >= width ? width - 1 : (u32)tx);
+                        memcpy(&row[i], &src[sy * width + sx], 4);
+                    }
+                }
+                if (format == VT_TILE_FORMAT_BC7)
+                    image_encode_bc7(tile, texels, VT_TILE_SLOT_SIZE, VT_TILE_SLOT_SIZE);
+                tile += header->tile_size;
+            }
+        mips  += (u64)width * height * 4;
+        width  = width  > 1 ? width  >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+    reset_to_mark_temp(mark);
+}
+
+bool vt_parse_tile_file(const u8 *data, u64 size, Vt_Tile_File *ret) {
+    if (size < VT_TILE_FILE_DATA_OFFSET)
+        return false;
+    memcpy(&ret->header, data, sizeof(Vt_Tile_File_Header));
+    Vt_Tile_File_Header *header = &ret->header;
+    if (header->magic != VT_TILE_FILE_MAGIC || header->format > VT_TILE_FORMAT_BC7 ||
+        header->tile_size != vt_get_tile_size((Vt_Tile_Format)header->format) ||
+        header->level_count != (u32)vt_get_level_count(header->width, header->height) ||
+        header->page_count != vt_get_total_page_count(header->width, header->height) ||
+        size < VT_TILE_FILE_DATA_OFFSET + header->page_count * header->tile_size)
+    {
+        return false;
+    }
+    ret->tiles = data + VT_TILE_FILE_DATA_OFFSET;
+    return true;
+}
+
+#if TEST
+static void test_vt_page_table();
+static void test_vt_feedback();
+static void test_vt_lru();
+static void test_vt_tile_file();
+
+void test_virtual_texture() {
+    test_vt_page_table();
+    test_vt_feedback();
+    test_vt_lru();
+    test_vt_tile_file();
+}
+
+static u32 test_vt_entry(Virtual_Texture *vt, int level, u32 x, u32 y) {
+    return vt->page_table[vt_get_page_index(vt, level, x, y)];
+}
+
+// 1024 square: levels of 8x8, 4x4, 2x2 and 1x1 tiles
+static void test_vt_page_table() {
+    BEGIN_TEST_MODULE("Virtual_Texture_Page_Table", true, false);
+
+    Virtual_Texture vt = create_virtual_texture(1024, 1024, 4, 4, 64);
+    TEST_EQ("level count", vt.level_count, 4, false);
+    TEST_EQ("page count", vt.page_count, 64 + 16 + 4 + 1, false);
+
+    u32 top = vt_make_page_table_entry(0, 0, 3);
+    bool all_top = true;
+    for(u32 i = 0; i < vt.page_count; ++i)
+        all_top &= vt.page_table[i] == top;
+    TEST_EQ("everything falls back to the top", all_top, true, false);
+    TEST_EQ("top pinned", vt.slots[vt.pages[vt.page_count - 1].slot].pinned, true, false);
+
+    u32 slot;
+    vt_clear_dirty(&vt);
+    vt_map_page(&vt, vt_get_page_index(&vt, 1, 1, 1), &slot);
+    TEST_EQ("slot", slot, 1, false);
+    u32 mapped = vt_make_page_table_entry(1, 0, 1);
+    TEST_EQ("self", test_vt_entry(&vt, 1, 1, 1), mapped, false);
+    TEST_EQ("child", test_vt_entry(&vt, 0, 3, 3), mapped, false);
+    TEST_EQ("child first", test_vt_entry(&vt, 0, 2, 2), mapped, false);
+    TEST_EQ("outside", test_vt_entry(&vt, 0, 4, 3), top, false);
+    TEST_EQ("sibling", test_vt_entry(&vt, 1, 0, 1), top, false);
+    TEST_EQ("parent", test_vt_entry(&vt, 2, 0, 0), top, false);
+    TEST_EQ("dirty first", vt.dirty_first, vt_get_page_index(&vt, 0, 2, 2), false);
+    TEST_EQ("dirty end", vt.dirty_end, vt_get_page_index(&vt, 1, 1, 1) + 1, false);
+
+    // A finer page takes its own entry, and the coarser page does not take it back
+    vt_map_page(&vt, vt_get_page_index(&vt, 0, 2, 2), &slot);
+    u32 fine = vt_make_page_table_entry(2, 0, 0);
+    vt_map_page(&vt, vt_get_page_index(&vt, 2, 0, 0), &slot);
+    TEST_EQ("fine kept", test_vt_entry(&vt, 0, 2, 2), fine, false);
+    TEST_EQ("level 1 kept", test_vt_entry(&vt, 0, 3, 3), mapped, false);
+    TEST_EQ("level 2 fills", test_vt_entry(&vt, 0, 0, 0), vt_make_page_table_entry(3, 0, 2), false);
+
+    int level;
+    u32 x, y;
+    vt_get_page_coords(&vt, vt_get_page_index(&vt, 1, 3, 2), &level, &x, &y);
+    TEST_EQ("coords level", level, 1, false);
+    TEST_EQ("coords x", x, 3, false);
+    TEST_EQ("coords y", y, 2, false);
+
+    // Odd sizes: 300 wide is 3 tiles at level 0 but 2 at level 1, so the last column falls back to the last parent
+    Virtual_Texture odd = create_virtual_texture(300, 130, 4, 4, 64);
+    TEST_EQ("odd levels", odd.level_count, 3, false);
+    vt_map_page(&odd, vt_get_page_index(&odd, 1, 1, 0), &slot);
+    TEST_EQ("odd last column", test_vt_entry(&odd, 0, 2, 1), vt_make_page_table_entry(1, 0, 1), false);
+
+    destroy_virtual_texture(&odd);
+    destroy_virtual_texture(&vt);
+    END_TEST_MODULE();
+}
+
+static void test_vt_feedback() {
+    BEGIN_TEST_MODULE("Virtual_Texture_Feedback", true, false);
+
+    Virtual_Texture vt = create_virtual_texture(1024, 1024, 4, 4, 64);
+    u32 feedback[] = {
+        vt_make_feedback(0, 5, 5), VT_NULL_FEEDBACK, vt_make_feedback(0, 5, 5), vt_make_feedback(0, 4, 4),
+        vt_make_feedback(1, 0, 0), vt_make_feedback(0, 0, 0), vt_make_feedback(9, 0, 0),
+    };
+    int count = vt_process_feedback(&vt, feedback, sizeof(feedback) / sizeof(feedback[0]));
+
+    // Only the top is resident, so everything asks for the level 2 page under it, once per page
+    TEST_EQ("request count", count, 2, false);
+    TEST_EQ("request 0", vt.requests[0], vt_get_page_index(&vt, 2, 1, 1), false);
+    TEST_EQ("request 1", vt.requests[1], vt_get_page_index(&vt, 2, 0, 0), false);
+    TEST_EQ("top used", vt.used_slots, 1, false);
+
+    u32 slot;
+    for(int i = 0; i < count; ++i)
+        vt_map_page(&vt, vt.requests[i], &slot);
+    count = vt_process_feedback(&vt, feedback, sizeof(feedback) / sizeof(feedback[0]));
+    TEST_EQ("next level count", count, 2, false);
+    TEST_EQ("next level 0", vt.requests[0], vt_get_page_index(&vt, 1, 2, 2), false);
+    TEST_EQ("next level 1", vt.requests[1], vt_get_page_index(&vt, 1, 0, 0), false);
+
+    // Whatever order the feedback is in
+    vt_map_page(&vt, vt_get_page_index(&vt, 1, 2, 2), &slot);
+    u32 mixed[] = {vt_make_feedback(0, 5, 5), vt_make_feedback(1, 0, 0)};
+    count = vt_process_feedback(&vt, mixed, 2);
+    TEST_EQ("mixed count", count, 2, false);
+    TEST_EQ("coarsest first", vt.requests[0], vt_get_page_index(&vt, 1, 0, 0), false);
+    TEST_EQ("finest last", vt.requests[1], vt_get_page_index(&vt, 0, 5, 5), false);
+
+    destroy_virtual_texture(&vt);
+    END_TEST_MODULE();
+}
+
+// Top pinned in slot 0, and two slots to share
+static void test_vt_lru() {
+    BEGIN_TEST_MODULE("Virtual_Texture_Lru", true, false);
+
+    Virtual_Texture vt = create_virtual_texture(1024, 1024, 3, 1, 64);
+    u32 a = vt_get_page_index(&vt, 2, 0, 0);
+    u32 b = vt_get_page_index(&vt, 2, 1, 0);
+    u32 c = vt_get_page_index(&vt, 2, 0, 1);
+    u32 d = vt_get_page_index(&vt, 2, 1, 1);
+    u32 slot_a, slot_b, slot_c, slot;
+
+    vt_process_feedback(&vt, NULL, 0);
+    TEST_EQ("map a", vt_map_page(&vt, a, &slot_a), true, false);
+    TEST_EQ("map b", vt_map_page(&vt, b, &slot_b), true, false);
+
+    u32 feedback[] = {vt_make_feedback(2, 0, 0), vt_make_feedback(0, 0, 6), vt_make_feedback(0, 6, 6)};
+    vt_process_feedback(&vt, feedback, 1);
+    TEST_EQ("map c", vt_map_page(&vt, c, &slot_c), true, false);
+    TEST_EQ("b evicted", slot_c, slot_b, false);
+    TEST_EQ("b not resident", vt.pages[b].slot, VT_NULL_SLOT, false);
+    TEST_EQ("b falls back", test_vt_entry(&vt, 0, 5, 1), vt_make_page_table_entry(0, 0, 3), false);
+    TEST_EQ("a resident", vt.pages[a].slot, slot_a, false);
+
+    // a and c are both sampled: there is nothing to evict for d
+    vt_process_feedback(&vt, feedback, 2);
+    TEST_EQ("map d starves", vt_map_page(&vt, d, &slot), false, false);
+    TEST_EQ("starved", vt.starved, true, false);
+    TEST_EQ("a kept", vt.pages[a].slot, slot_a, false);
+    TEST_EQ("c kept", vt.pages[c].slot, slot_c, false);
+
+    // Starving coarsens the next frame's requests; an idle frame sharpens them again
+    vt_process_feedback(&vt, feedback + 2, 1);
+    TEST_EQ("bias up", vt.mip_bias, 1, false);
+    TEST_EQ("biased request", vt.requests[0], d, false);
+    vt_process_feedback(&vt, NULL, 0);
+    vt_process_feedback(&vt, NULL, 0);
+    TEST_EQ("bias down", vt.mip_bias, 0, false);
+
+    destroy_virtual_texture(&vt);
+    END_TEST_MODULE();
+}
+
+static void test_vt_tile_file() {
+    BEGIN_TEST_MODULE("Virtual_Texture_Tile_File", true, false);
+
+    const u32 width = 300;
+    const u32 height = 200;
+    int mip_count = image_get_mip_count(width, height);
+    u64 mark = get_mark_temp();
+    u8 *mips = (u8*)memory_allocate_temp(image_get_mip_chain_size_rgba8(width, height, mip_count), 16);
+
+    // Each texel holds its own coordinates and level
+    u8 *level = mips;
+    u32 w = width;
+    u32 h = height;
+    for(int l = 0; l < mip_count; ++l) {
+        for(u32 y = 0; y < h; ++y)
+            for(u32 x = 0; x < w; ++x) {
+                u8 *texel = level + (y * w + x) * 4;
+                texel[0] = (u8)x;
+                texel[1] = (u8)y;
+                texel[2] = (u8)l;
+                texel[3] = (u8)(x >> 8);
+            }
+        level += (u64)w * h * 4;
+        w = w > 1 ? w >> 1 : 1;
+        h = h > 1 ? h >> 1 : 1;
+    }
+
+    u64 size = vt_get_tile_file_size(width, height, VT_TILE_FORMAT_RGBA8);
+    u8 *file = (u8*)memory_allocate_temp(size, 16);
+    vt_build_tile_file(file, mips, width, height, VT_TILE_FORMAT_RGBA8, true);
+
+    Vt_Tile_File tiles;
+    TEST_EQ("parse", vt_parse_tile_file(file, size, &tiles), true, false);
+    TEST_EQ("truncated", vt_parse_tile_file(file, size - 1, &tiles), false, false);
+    vt_parse_tile_file(file, size, &tiles);
+    TEST_EQ("levels", tiles.header.level_count, 3, false);
+    TEST_EQ("pages", tiles.header.page_count, 3 * 2 + 2 * 1 + 1, false);
+
+    Virtual_Texture vt = create_virtual_texture(width, height, 4, 4, 64);
+    TEST_EQ("pages match", vt.page_count, tiles.header.page_count, false);
+
+    // Level 0 tile (1, 0): slot texel (b, b) is texel (128, 0); the top border clamps to row 0
+    const u8 *tile = vt_get_tile(&tiles, vt_get_page_index(&vt, 0, 1, 0));
+    const u8 *texel = tile + (VT_TILE_BORDER * VT_TILE_SLOT_SIZE + VT_TILE_BORDER) * 4;
+    TEST_EQ("interior x", texel[0], 128, false);
+    TEST_EQ("interior y", texel[1], 0, false);
+    TEST_EQ("border clamped", tile[1], 0, false);
+    TEST_EQ("border x", tile[0], 124, false);
+
+    // The last tile of level 0 clamps at the right edge (x 299 has its low byte 43)
+    tile  = vt_get_tile(&tiles, vt_get_page_index(&vt, 0, 2, 1));
+    texel = tile + ((VT_TILE_SLOT_SIZE - 1) * VT_TILE_SLOT_SIZE + VT_TILE_SLOT_SIZE - 1) * 4;
+    TEST_EQ("edge x", texel[0], 299 & 0xff, false);
+    TEST_EQ("edge y", texel[1], 199, false);
+
+    tile  = vt_get_tile(&tiles, vt.page_count - 1);
+    TEST_EQ("top level", tile[2], 2, false);
+
+    file[0] = 0;
+    TEST_EQ("bad magic", vt_parse_tile_file(file, size, &tiles), false, false);
+
+    destroy_virtual_texture(&vt);
+    reset_to_mark_temp(mark);
+    END_TEST_MODULE();
+}
+#endif
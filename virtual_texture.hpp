@@ -0,0 +1,152 @@
+#ifndef SOL_VIRTUAL_TEXTURE_HPP_INCLUDE_GUARD_
+#define SOL_VIRTUAL_TEXTURE_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+
+//
+// Virtual texturing, for texture sets larger than device memory. The texture is cut into tiles (pages), every mip
+// level down to a single tile, and only the pages a frame samples are kept in a physical tile pool: one image,
+// a grid of tile slots. Shaders find a texel's slot through the page table, and write the pages they wanted into
+// a feedback buffer; the cpu reads that back (vt_process_feedback()), keeps the wanted pages resident in an LRU
+// cache and streams the missing ones in from a tile file. A page which is not resident is drawn from its nearest
+// resident ancestor, and the coarsest level is pinned, so every lookup hits.
+//
+// Nothing here touches the gpu (see Gpu_Virtual_Texture for the pool and the page table buffer).
+//
+// Thrashing: a page used this frame is never evicted for another one, and missing pages are loaded one level at a
+// time, coarsest first. If a frame wants more pages than there are slots, the requests of the following frames
+// are made coarser ('mip_bias') until they fit again.
+//
+
+static constexpr u32 VT_TILE_SIZE      = 128; // texels, borders excluded
+static constexpr u32 VT_TILE_BORDER    = 4;   // on each side, so that filtering never reads a neighbouring slot
+static constexpr u32 VT_TILE_SLOT_SIZE = VT_TILE_SIZE + 2 * VT_TILE_BORDER;
+static constexpr int VT_MAX_LEVELS     = 15;
+static constexpr u32 VT_NULL_SLOT      = Max_u32;
+static constexpr u32 VT_NULL_PAGE      = Max_u32;
+static constexpr u32 VT_NULL_FEEDBACK  = Max_u32; // feedback texels which sampled nothing
+
+// Feedback, as the shaders write it: level in the top 4 bits, then 14 bits each of tile y and x
+inline static u32 vt_make_feedback(int level, u32 x, u32 y) {
+    return ((u32)level << 28) | (y << 14) | x;
+}
+// Page table entries, as the shaders read them: the slot (x, y in the pool grid) holding the page to sample, and
+// that page's level, which is coarser than the looked up one if it fell back to an ancestor
+inline static u32 vt_make_page_table_entry(u32 slot_x, u32 slot_y, int level) {
+    return slot_x | (slot_y << 12) | ((u32)level << 24);
+}
+inline static int vt_get_page_table_entry_level(u32 entry) {
+    return (int)(entry >> 24);
+}
+
+struct Vt_Page {
+    u32 slot;      // VT_NULL_SLOT unless resident
+    u32 requested; // frame of the last request, so a page is requested once per frame
+};
+struct Vt_Slot {
+    u32 page;      // VT_NULL_PAGE if free
+    u32 last_used; // frame
+    u32 prev;      // LRU list links (most recent first), or the free list (next only); pinned slots are in neither
+    u32 next;
+    bool pinned;
+};
+struct Virtual_Texture {
+    u32 width; // texels at level 0
+    u32 height;
+    int level_count;
+    u32 level_tiles_x[VT_MAX_LEVELS];
+    u32 level_tiles_y[VT_MAX_LEVELS];
+    u32 level_first[VT_MAX_LEVELS]; // index of the level's first page: pages are ordered by level, then row
+
+    u32 page_count;
+    Vt_Page *pages;  // Heap allocated
+    u32 *page_table; // Heap allocated, page_count entries, laid out like 'pages'
+    u32 dirty_first; // page table entries [dirty_first, dirty_end) changed since the last vt_clear_dirty()
+    u32 dirty_end;
+
+    u32 pool_width; // in slots
+    u32 pool_height;
+    u32 slot_count;
+    Vt_Slot *slots; // Heap allocated
+    u32 lru_head;
+    u32 lru_tail;
+    u32 free_slots;
+
+    u32 frame;
+    u32 used_slots; // slots sampled this frame
+    bool starved;   // a page could not be mapped this frame: every slot was in use
+    int mip_bias;   // levels the requests are made coarser by
+
+    int request_cap;
+    int request_count;
+    u32 *requests; // Heap allocated, page indices of this frame's requests, coarsest first
+};
+
+// Levels down to (and including) the one which fits in a single tile
+int vt_get_level_count(u32 width, u32 height);
+
+// The coarsest level's page is mapped to a pinned slot: stream it in (vt_get_slot_coords()) before sampling.
+Virtual_Texture create_virtual_texture(u32 width, u32 height, u32 pool_width, u32 pool_height, int request_cap);
+void destroy_virtual_texture(Virtual_Texture *vt);
+
+inline static u32 vt_get_page_index(Virtual_Texture *vt, int level, u32 x, u32 y) {
+    return vt->level_first[level] + y * vt->level_tiles_x[level] + x;
+}
+void vt_get_page_coords(Virtual_Texture *vt, u32 page, int *level, u32 *x, u32 *y);
+inline static void vt_get_slot_coords(Virtual_Texture *vt, u32 slot, u32 *x, u32 *y) {
+    *x = slot % vt->pool_width;
+    *y = slot / vt->pool_width;
+}
+
+// Start a frame from the feedback of a finished one: touch the resident pages it sampled and fill 'requests' with
+// the pages to load next (for a missing page, the one below its nearest resident ancestor). Returns the request
+// count.
+int vt_process_feedback(Virtual_Texture *vt, const u32 *feedback, u32 count);
+// Give 'page' a slot (a free one, or the least recently used one not sampled this frame) and point the page table
+// at it; the caller streams the tile in. Returns false, and marks the frame starved, if every slot is in use.
+bool vt_map_page(Virtual_Texture *vt, u32 page, u32 *slot);
+inline static void vt_clear_dirty(Virtual_Texture *vt) {
+    vt->dirty_first = vt->page_count;
+    vt->dirty_end   = 0;
+}
+
+// Tile files: every page of every level, level 0 first, each a VT_TILE_SLOT_SIZE square with its borders (clamped
+// at the edges of the texture), so that a tile is streamed with a single copy into its slot.
+static constexpr u32 VT_TILE_FILE_MAGIC       = 0x31545653; // "SVT1"
+static constexpr u64 VT_TILE_FILE_DATA_OFFSET = 64;
+
+enum Vt_Tile_Format {
+    VT_TILE_FORMAT_RGBA8 = 0,
+    VT_TILE_FORMAT_BC7   = 1,
+};
+struct Vt_Tile_File_Header {
+    u32 magic;
+    u32 width;
+    u32 height;
+    u32 level_count;
+    u32 page_count;
+    u32 format; // Vt_Tile_Format
+    u32 srgb;
+    u32 pad;
+    u64 tile_size;
+};
+struct Vt_Tile_File {
+    Vt_Tile_File_Header header;
+    const u8 *tiles;
+};
+
+u64 vt_get_tile_size(Vt_Tile_Format format);
+u64 vt_get_tile_file_size(u32 width, u32 height, Vt_Tile_Format format);
+// 'mips' is a tightly packed rgba8 chain (see image_generate_mips_rgba8()) of at least vt_get_level_count() levels
+void vt_build_tile_file(u8 *dst, const u8 *mips, u32 width, u32 height, Vt_Tile_Format format, bool srgb);
+// Returns false if 'data' is not a whole tile file
+bool vt_parse_tile_file(const u8 *data, u64 size, Vt_Tile_File *ret);
+inline static const u8* vt_get_tile(Vt_Tile_File *file, u32 page) {
+    return file->tiles + page * file->header.tile_size;
+}
+
+#if TEST
+void test_virtual_texture();
+#endif
+
+#endif // include guard